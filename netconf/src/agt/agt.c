@@ -167,6 +167,11 @@ static void
     agt_profile.agt_accesscontrol_enum = AGT_ACMOD_ENFORCING;
     agt_profile.agt_system_sorted = AGT_DEF_SYSTEM_SORTED;
     agt_profile.agt_max_sessions = 1024;
+    agt_profile.agt_max_outbuff_size = SES_MSG_MAX_BUFFSIZE;
+    agt_profile.agt_eventlog_dir = NULL;
+    agt_profile.agt_eventlog_segsize = 16777216;
+    agt_profile.agt_eventlog_segage = 86400;
+    agt_profile.agt_eventlog_segcount = 32;
 
 } /* init_server_profile */
 
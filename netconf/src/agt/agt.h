@@ -267,6 +267,11 @@ typedef struct agt_profile_t_ {
 
     /* yuma123 extended parameters */
     uint32              agt_max_sessions;
+    uint32              agt_max_outbuff_size;
+    const xmlChar      *agt_eventlog_dir;
+    uint32              agt_eventlog_segsize;
+    uint32              agt_eventlog_segage;
+    uint32              agt_eventlog_segcount;
     const xmlChar      *agt_tcp_direct_address;
     int32               agt_tcp_direct_port;
     const xmlChar      *agt_ncxserver_sockname;
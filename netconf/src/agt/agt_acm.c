@@ -42,6 +42,7 @@ date         init     comment
 #include "agt_ses.h"
 #include "agt_util.h"
 #include "agt_val.h"
+#include "cfg.h"
 #include "def_reg.h"
 #include "dlq.h"
 #include "ncx.h"
@@ -137,6 +138,10 @@ static uint32         denied_data_writes_count;
 
 static agt_acm_cache_t  *notif_cache;
 
+static agt_acm_datarule_cache_t datarule_cache;
+
+static uint32 acm_msgseq;
+
 static boolean log_reads;
 
 static boolean log_writes;
@@ -601,16 +606,13 @@ static agt_acm_cache_t  *
     new_acm_cache (void)
 {
     agt_acm_cache_t  *acm_cache;
-    int i;
+
     acm_cache = m__getObj(agt_acm_cache_t);
     if (!acm_cache) {
         return NULL;
     }
     memset(acm_cache, 0x0, sizeof(agt_acm_cache_t));
     dlq_createSQue(&acm_cache->modruleQ);
-    for(i=0;i<DATA_RULE_QUEUE_NUM;i++) {
-        dlq_createSQue(&acm_cache->dataruleQ[i]);
-    }
     acm_cache->mode = acmode;
     acm_cache->flags = FL_ACM_CACHE_VALID;
     return acm_cache;
@@ -630,8 +632,6 @@ static void
     free_acm_cache (agt_acm_cache_t  *acm_cache)
 {
     agt_acm_modrule_t    *modrule;
-    agt_acm_datarule_t   *datarule;
-    int i;
 
     while (!dlq_empty(&acm_cache->modruleQ)) {
         modrule = (agt_acm_modrule_t *)
@@ -639,21 +639,115 @@ static void
         free_modrule(modrule);
     }
 
+    if (acm_cache->usergroups) {
+        free_usergroups(acm_cache->usergroups);
+    }
+
+    m__free(acm_cache);
+
+} /* free_acm_cache */
+
+
+/********************************************************************
+* FUNCTION clear_datarule_cache
+*
+* Free all the entries in the shared data rule cache
+* so it will be rebuilt the next time it is used
+*
+*********************************************************************/
+static void
+    clear_datarule_cache (void)
+{
+    agt_acm_datarule_t   *datarule;
+    int i;
+
     for(i=0;i<DATA_RULE_QUEUE_NUM;i++) {
-        while (!dlq_empty(&acm_cache->dataruleQ[i])) {
+        while (!dlq_empty(&datarule_cache.dataruleQ[i])) {
             datarule = (agt_acm_datarule_t *)
-            dlq_deque(&acm_cache->dataruleQ[i]);
+            dlq_deque(&datarule_cache.dataruleQ[i]);
             free_datarule(datarule);
         }
     }
+    datarule_cache.flags = 0;
+    datarule_cache.txid = 0;
+    datarule_cache.msgseq = 0;
 
-    if (acm_cache->usergroups) {
-        free_usergroups(acm_cache->usergroups);
+} /* clear_datarule_cache */
+
+
+/********************************************************************
+* FUNCTION datarule_cache_valid
+*
+* Check if the shared data rule cache can be used
+* for the current message
+*
+* INPUTS:
+*    nacmroot == /nacm node
+*
+* RETURNS:
+*    TRUE if the cached data rules are still current
+*    FALSE if they need to be rebuilt
+*********************************************************************/
+static boolean
+    datarule_cache_valid (val_value_t *nacmroot)
+{
+    cfg_template_t  *runningcfg;
+
+    if (!(datarule_cache.flags & FL_ACM_DATARULES_SET)) {
+        return FALSE;
     }
 
-    m__free(acm_cache);
+    /* any edit to running may change the rule results */
+    runningcfg = cfg_get_config_id(NCX_CFGID_RUNNING);
+    if (runningcfg == NULL || runningcfg->root != nacmroot->parent ||
+        runningcfg->last_txid != datarule_cache.txid) {
+        return FALSE;
+    }
 
-} /* free_acm_cache */
+    /* rules that select config=false data are only good for 1 message */
+    if ((datarule_cache.flags & FL_ACM_DATARULES_VOLATILE) &&
+        datarule_cache.msgseq != acm_msgseq) {
+        return FALSE;
+    }
+
+    return TRUE;
+
+} /* datarule_cache_valid */
+
+
+/********************************************************************
+* FUNCTION datarule_is_volatile
+*
+* Check if a read data rule result can change without
+* an edit to the running config
+*
+* INPUTS:
+*    result == converted object node-set result to check
+*
+* RETURNS:
+*    TRUE if the result is empty or selects any config=false object
+*    FALSE otherwise
+*********************************************************************/
+static boolean
+    datarule_is_volatile (xpath_result_t *result)
+{
+    xpath_resnode_t  *resnode;
+
+    if (dlq_empty(&result->r.nodeQ)) {
+        return TRUE;
+    }
+
+    for (resnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+         resnode != NULL;
+         resnode = (xpath_resnode_t *)dlq_nextEntry(resnode)) {
+        if (!obj_is_root(resnode->node.objptr) &&
+            !obj_get_config_flag(resnode->node.objptr)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+
+} /* datarule_is_volatile */
 
 
 /********************************************************************
@@ -1254,50 +1348,33 @@ static unsigned int get_rule_queue_access_id(const char* access_str)
 /********************************************************************
 * FUNCTION cache_data_rules
 *
-* Cache the data rules.
+* Cache the data rules in the shared data rule cache.
+* -- Any old entries are deleted first
 * -- If there is a failure partway through caching the items
 *    all the new datarules will be deleted
 * -- Do not set the flag unless the entire operation succeeds
 * -- On failure remove all added datarules
 *
 * INPUTS:
-*    cache == agt_acm cache to use
 *    nacmroot == /nacm node
 *
 * OUTPUTS:
-*    *cache is modified with the cached datarules items.
+*    datarule_cache is filled in with the cached datarules items.
 *
 * RETURNS:
 *    NO_ERR on success or an error if the operation failed.
 *
 *********************************************************************/
 static status_t
-    cache_data_rules( agt_acm_cache_t *cache,
-                      val_value_t *nacmroot)
+    cache_data_rules (val_value_t *nacmroot)
 {
     status_t            res = NO_ERR;
     val_value_t         *rule, *rule_list;
     val_value_t         *valroot;
+    cfg_template_t      *runningcfg;
     int                 i;
 
-    if (cache->flags & FL_ACM_DATARULES_SET) {
-        // datarules have already been already cached, return no error
-        //return NO_ERR;
-
-
-        /* regenerate all cached datarules since no mechanism for updating config=false rules is in place yet */
-        agt_acm_datarule_t  *freerule;
-        for(i=0;i<DATA_RULE_QUEUE_NUM;i++) {
-            while (!dlq_empty(&cache->dataruleQ[i])) {
-                freerule = (agt_acm_datarule_t *)dlq_deque(&cache->dataruleQ[i]);
-                if (freerule) {
-                    free_datarule(freerule);
-                } else {
-                    return SET_ERROR(ERR_INTERNAL_VAL);
-                }
-            }
-        }
-    }
+    clear_datarule_cache();
 
     /* the /nacm node is supposed to be a child of <config> */
     valroot = nacmroot->parent;
@@ -1306,6 +1383,11 @@ static status_t
         return SET_ERROR(ERR_INTERNAL_VAL);
     }
 
+    runningcfg = cfg_get_config_id(NCX_CFGID_RUNNING);
+    if (runningcfg == NULL) {
+        return SET_ERROR(ERR_INTERNAL_VAL);
+    }
+
 for ( rule_list = val_find_child( nacmroot, AGT_ACM_MODULE, 
                                      nacm_N_ruleList );
           rule_list != NULL;
@@ -1360,12 +1442,27 @@ for ( rule_list = val_find_child( nacmroot, AGT_ACM_MODULE,
                 break;
             }
 
+            if ( res == NO_ERR ) {
+                /* drop the value node pointers so the result
+                 * stays usable after the data tree changes
+                 */
+                xpath1_convert_nodeset_to_objects(pcb, result);
+                if ( i == DATA_RULE_QUEUE_READ &&
+                     datarule_is_volatile(result) ) {
+                    datarule_cache.flags |= FL_ACM_DATARULES_VOLATILE;
+                }
+
+                /* every checked node is looked up in the result */
+                res = xpath1_index_nodeset(pcb, result);
+            }
+
             if ( res == NO_ERR) {
-                agt_acm_datarule_t  *datarule_cache;
-                datarule_cache = new_datarule(pcb, result, rule);
-                if ( datarule_cache ) {
+                agt_acm_datarule_t  *datarule_entry;
+                datarule_entry = new_datarule(pcb, result, rule);
+                if ( datarule_entry ) {
                     /* pass off 'pcb' and 'result' memory here */
-                    dlq_enque( datarule_cache, &cache->dataruleQ[i] );
+                    dlq_enque( datarule_entry,
+                               &datarule_cache.dataruleQ[i] );
                 } else {
                     res = ERR_INTERNAL_MEM;
                 }
@@ -1380,22 +1477,13 @@ for ( rule_list = val_find_child( nacmroot, AGT_ACM_MODULE,
     }
 }
     if (res == NO_ERR) {
-        cache->flags |= FL_ACM_DATARULES_SET;
+        datarule_cache.flags |= FL_ACM_DATARULES_SET;
+        datarule_cache.txid = runningcfg->last_txid;
+        datarule_cache.msgseq = acm_msgseq;
     } else {
-        for(i=0;i<DATA_RULE_QUEUE_NUM;i++) {
-
-            agt_acm_datarule_t  *freerule;
-            while (!dlq_empty(&cache->dataruleQ[i])) {
-                freerule = (agt_acm_datarule_t *)dlq_deque(&cache->dataruleQ[i]);
-                if (freerule) {
-                    free_datarule(freerule);
-                } else {
-                    SET_ERROR(ERR_INTERNAL_VAL);
-                }
-            }
-            log_error("\nError: cache NACM data rules failed! (%s)",
-                      get_error_string(res));
-        }
+        clear_datarule_cache();
+        log_error("\nError: cache NACM data rules failed! (%s)",
+                  get_error_string(res));
     }
 
     return res;
@@ -1409,7 +1497,6 @@ for ( rule_list = val_find_child( nacmroot, AGT_ACM_MODULE,
 * user is allowed access the specified data object
 *
 * INPUTS:
-*    cache == agt_acm cache to use
 *    nacmroot == /nacm node prefetched
 *    val == value node requested
 *    access == string (enum name) for the requested access
@@ -1428,28 +1515,22 @@ for ( rule_list = val_find_child( nacmroot, AGT_ACM_MODULE,
 *      FALSE if authorization to access data is not granted
 *********************************************************************/
 static boolean
-    check_data_rules (agt_acm_cache_t *cache,
-                      val_value_t *nacmroot,
+    check_data_rules (val_value_t *nacmroot,
                       const val_value_t *val,
                       const xmlChar *access,
                       agt_acm_usergroups_t *usergroups,
                       boolean *done)
 {
-    dlq_hdr_t           *resnodeQ;
-    agt_acm_datarule_t  *datarule_cache;
+    agt_acm_datarule_t  *datarule;
     boolean              granted = FALSE;
     status_t             res = NO_ERR;
     int                  access_id;
     *done = FALSE;
 
-    /* fill the dataruleQ in the cache if needed */
-#if 0
-    if (!(cache->flags & FL_ACM_DATARULES_SET)) 
-#else
-    if (1)
-#endif
+    /* fill the shared dataruleQ if needed */
+    if (!datarule_cache_valid(nacmroot))
     {
-        res = cache_data_rules( cache, nacmroot);
+        res = cache_data_rules(nacmroot);
     }
 
     if ( res != NO_ERR )
@@ -1462,23 +1543,20 @@ static boolean
     {
 
         /* go through the cache and exit if any matches are found */
-        for ( datarule_cache = (agt_acm_datarule_t *) 
-                  dlq_firstEntry(&cache->dataruleQ[access_id]);
-              datarule_cache != NULL && !*done;
-              datarule_cache = (agt_acm_datarule_t *) 
-                  dlq_nextEntry(datarule_cache)) 
+        for ( datarule = (agt_acm_datarule_t *) 
+                  dlq_firstEntry(&datarule_cache.dataruleQ[access_id]);
+              datarule != NULL && !*done;
+              datarule = (agt_acm_datarule_t *) 
+                  dlq_nextEntry(datarule)) 
         {
-            if(!check_rule_group (datarule_cache->datarule, usergroups)) {
+            if(!check_rule_group (datarule->datarule, usergroups)) {
                 continue;
             }
 
-            resnodeQ = xpath_get_resnodeQ(datarule_cache->result);
-            assert(resnodeQ);
-
-            if ( ((access_id==DATA_RULE_QUEUE_READ) && xpath1_check_node_child_exists_slow( datarule_cache->pcb,resnodeQ, val )) ||
+            if ( ((access_id==DATA_RULE_QUEUE_READ) && xpath1_check_result_node_child_exists( datarule->pcb, datarule->result, val )) ||
                  ((access_id==DATA_RULE_QUEUE_UPDATE) && !obj_is_leaf(val->obj)) ||
-                 xpath1_check_node_exists_slow( datarule_cache->pcb,
-                                                resnodeQ, val ))
+                 xpath1_check_result_node_exists( datarule->pcb,
+                                                  datarule->result, val ))
             {
                 *done = TRUE;
                 granted = TRUE;
@@ -1639,7 +1717,7 @@ static boolean
 
         /* there is a rules node so check the dataRule list */
         if (!done) {
-            retval = check_data_rules(cache, nacmroot, val, access,
+            retval = check_data_rules(nacmroot, val, (const xmlChar *)access,
                                       usergroups, &done);
             if (done) {
                 substr = (const xmlChar *)"data-rule";
@@ -1976,6 +2054,7 @@ static status_t
             free_acm_cache(notif_cache);
             notif_cache = NULL;
         }
+        clear_datarule_cache();
         agt_ses_invalidate_session_acm_caches();
     }
 
@@ -2085,6 +2164,7 @@ status_t
 {
     status_t  res;
     agt_profile_t  *agt_profile;
+    int i;
 
     if (agt_acm_init_done) {
         return SET_ERROR(ERR_INTERNAL_INIT_SEQ);
@@ -2096,6 +2176,11 @@ status_t
 
     nacmmod = NULL;
     notif_cache = NULL;
+    memset(&datarule_cache, 0x0, sizeof(agt_acm_datarule_cache_t));
+    for (i = 0; i < DATA_RULE_QUEUE_NUM; i++) {
+        dlq_createSQue(&datarule_cache.dataruleQ[i]);
+    }
+    acm_msgseq = 0;
 
     /* load in the access control parameters */
     res = ncxmod_load_module(AGT_ACM_MODULE, NULL, &agt_profile->agt_savedevQ,
@@ -2234,6 +2319,7 @@ void
     if (notif_cache != NULL) {
         free_acm_cache(notif_cache);
     }
+    clear_datarule_cache();
     agt_acm_init_done = FALSE;
 
 }   /* agt_acm_cleanup */
@@ -2637,6 +2723,9 @@ status_t
 
     msg->acm_cbfn = agt_acm_val_read_allowed;
 
+    /* start a new message for any volatile data rules */
+    acm_msgseq++;
+
     if (agt_acm_session_cache_valid(scb)) {
         msg->acm_cache = scb->acm_cache;
     } else {
@@ -38,6 +38,10 @@ date	     init     comment
 #include "agt.h"
 #endif
 
+#ifndef _H_cfg
+#include "cfg.h"
+#endif
+
 #ifndef _H_dlq
 #include "dlq.h"
 #endif
@@ -90,6 +94,7 @@ extern "C" {
 #define FL_ACM_MODRULES_SET     bit6
 #define FL_ACM_DATARULES_SET    bit7
 #define FL_ACM_CACHE_VALID      bit8
+#define FL_ACM_DATARULES_VOLATILE bit9
 
 
 /********************************************************************
@@ -118,7 +123,10 @@ typedef struct agt_acm_modrule_t_ {
     val_value_t    *modrule;  /* back-ptr */
 } agt_acm_modrule_t;
 
-/* cache for 1 NACM dataRule entry */
+/* cache for 1 NACM dataRule entry
+ * the result is an object node-set so it does not
+ * point into the data tree it was evaluated against
+ */
 typedef struct agt_acm_datarule_t_ {
     dlq_hdr_t           qhdr;
     xpath_pcb_t        *pcb;
@@ -141,9 +149,20 @@ typedef struct agt_acm_cache_t_ {
     uint32                flags;
     agt_acmode_t          mode;
     dlq_hdr_t             modruleQ;     /* Q of agt_acm_modrule_t */
-    dlq_hdr_t             dataruleQ[4];    /* Q of agt_acm_datarule_t */
 } agt_acm_cache_t;
 
+/* NACM data rule cache shared by all sessions
+ * The rules are evaluated against running once and reused
+ * until /nacm or running changes.  If any read rule selects
+ * config=false data, the cache is rebuilt once per message instead
+ */
+typedef struct agt_acm_datarule_cache_t_ {
+    uint32                flags;
+    cfg_transaction_id_t  txid;         /* running txid when built */
+    uint32                msgseq;       /* msg sequence when built */
+    dlq_hdr_t             dataruleQ[DATA_RULE_QUEUE_NUM];
+} agt_acm_datarule_cache_t;
+
     
 /********************************************************************
 *								    *
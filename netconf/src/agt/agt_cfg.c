@@ -838,6 +838,7 @@ agt_cfg_commit_test_t *
     agt_cfg_commit_test_t *commit_test = m__getObj(agt_cfg_commit_test_t);
     if (commit_test) {
         memset(commit_test, 0x0, sizeof(agt_cfg_commit_test_t));
+        dlq_createSQue(&commit_test->depQ);
     }
     return commit_test;
 
@@ -866,11 +867,66 @@ void
     if (commit_test->result) {
         xpath_free_result(commit_test->result);
     }
+    while (!dlq_empty(&commit_test->depQ)) {
+        agt_cfg_commit_dep_t *commit_dep = (agt_cfg_commit_dep_t *)
+            dlq_deque(&commit_test->depQ);
+        agt_cfg_free_commit_dep(commit_dep);
+    }
     m__free(commit_test);
 
 } /* agt_cfg_free_commit_test */
 
 
+/********************************************************************
+* FUNCTION agt_cfg_new_commit_dep
+*
+* Malloc and initialize a agt_cfg_commit_dep_t struct
+*
+* INPUTS:
+*   obj == data node read by the commit tests
+*   testflags == AGT_TEST_FL_FOO bits for the tests that read obj
+*   local == TRUE if obj is only read in the anchor instance
+*
+* RETURNS:
+*   malloced commit dependency struct or NULL if ERR_INTERNAL_MEM
+*********************************************************************/
+agt_cfg_commit_dep_t *
+    agt_cfg_new_commit_dep (obj_template_t *obj,
+                            uint32 testflags,
+                            boolean local)
+{
+    agt_cfg_commit_dep_t *commit_dep = m__getObj(agt_cfg_commit_dep_t);
+    if (commit_dep) {
+        memset(commit_dep, 0x0, sizeof(agt_cfg_commit_dep_t));
+        commit_dep->obj = obj;
+        commit_dep->testflags = testflags;
+        commit_dep->local = local;
+    }
+    return commit_dep;
+
+} /* agt_cfg_new_commit_dep */
+
+
+/********************************************************************
+* FUNCTION agt_cfg_free_commit_dep
+*
+* Free a previously malloced agt_cfg_commit_dep_t struct
+*
+* INPUTS:
+*    commit_dep == commit dependency record to free
+*
+*********************************************************************/
+void
+    agt_cfg_free_commit_dep (agt_cfg_commit_dep_t *commit_dep)
+{
+    if (commit_dep == NULL) {
+        return;
+    }
+    m__free(commit_dep);
+
+} /* agt_cfg_free_commit_dep */
+
+
 /********************************************************************
 * FUNCTION agt_cfg_new_nodeptr
 *
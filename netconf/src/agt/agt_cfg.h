@@ -195,6 +195,22 @@ typedef struct agt_cfg_audit_rec_t_ {
 } agt_cfg_audit_rec_t;
 
 
+/* struct for 1 data node read by the commit-time tests
+ * for an object; an edit to this node, or to any of its
+ * ancestors or descendants, can change the test results
+ */
+typedef struct agt_cfg_commit_dep_t_ {
+    dlq_hdr_t          qhdr;
+    obj_template_t    *obj;
+    uint32             testflags;  /* AGT_TEST_FL_FOO bits */
+
+    /* TRUE if the node is only read inside the same
+     * instance of the commit test anchor object as the
+     * tested node; FALSE if an edit needs a full test */
+    boolean            local;
+} agt_cfg_commit_dep_t;
+
+
 /* struct for the commit-time tests for a single object */
 typedef struct agt_cfg_commit_test_t_ {
     dlq_hdr_t          qhdr;
@@ -204,6 +220,15 @@ typedef struct agt_cfg_commit_test_t_ {
     cfg_transaction_id_t result_txid;
     ncx_btype_t        btyp;
     uint32             testflags;  /* AGT_TEST_FL_FOO bits */
+
+    /* data nodes read by the tests, found at load time
+     * from the XPath expressions; an edit only needs the
+     * tests in the depQ entries it touches to be run.
+     * The anchor is the ancestor-or-self of obj that
+     * contains all the local depQ nodes  */
+    obj_template_t    *anchor;
+    dlq_hdr_t          depQ;       /* Q of agt_cfg_commit_dep_t */
+    uint32             fullflags;  /* tests with unknown deps */
 } agt_cfg_commit_test_t;
 
 
@@ -403,6 +428,38 @@ extern void
     agt_cfg_free_commit_test (agt_cfg_commit_test_t *commit_test);
 
 
+/********************************************************************
+* FUNCTION agt_cfg_new_commit_dep
+*
+* Malloc and initialize a agt_cfg_commit_dep_t struct
+*
+* INPUTS:
+*   obj == data node read by the commit tests
+*   testflags == AGT_TEST_FL_FOO bits for the tests that read obj
+*   local == TRUE if obj is only read in the anchor instance
+*
+* RETURNS:
+*   malloced commit dependency struct or NULL if ERR_INTERNAL_MEM
+*********************************************************************/
+extern agt_cfg_commit_dep_t *
+    agt_cfg_new_commit_dep (obj_template_t *obj,
+                            uint32 testflags,
+                            boolean local);
+
+
+/********************************************************************
+* FUNCTION agt_cfg_free_commit_dep
+*
+* Free a previously malloced agt_cfg_commit_dep_t struct
+*
+* INPUTS:
+*    commit_dep == commit dependency record to free
+*
+*********************************************************************/
+extern void
+    agt_cfg_free_commit_dep (agt_cfg_commit_dep_t *commit_dep);
+
+
 /********************************************************************
 * FUNCTION agt_cfg_new_nodeptr
 *
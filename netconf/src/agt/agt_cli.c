@@ -324,6 +324,44 @@ static void
         agt_profile->agt_max_sessions = VAL_UINT(val);
     }
 
+    /* get max-output-buffer-size param */
+    val = val_find_child(valset,
+                         AGT_CLI_MODULE_EX,
+                         NCX_EL_MAX_OUTPUT_BUFFER_SIZE);
+    if (val && val->res == NO_ERR) {
+        agt_profile->agt_max_outbuff_size = VAL_UINT(val);
+    }
+
+    /* get eventlog-dir param */
+    val = val_find_child(valset, AGT_CLI_MODULE_EX, NCX_EL_EVENTLOG_DIR);
+    if (val && val->res == NO_ERR) {
+        agt_profile->agt_eventlog_dir = VAL_STR(val);
+    }
+
+    /* get eventlog-segment-size param */
+    val = val_find_child(valset,
+                         AGT_CLI_MODULE_EX,
+                         NCX_EL_EVENTLOG_SEGMENT_SIZE);
+    if (val && val->res == NO_ERR) {
+        agt_profile->agt_eventlog_segsize = VAL_UINT(val);
+    }
+
+    /* get eventlog-segment-age param */
+    val = val_find_child(valset,
+                         AGT_CLI_MODULE_EX,
+                         NCX_EL_EVENTLOG_SEGMENT_AGE);
+    if (val && val->res == NO_ERR) {
+        agt_profile->agt_eventlog_segage = VAL_UINT(val);
+    }
+
+    /* get eventlog-segment-count param */
+    val = val_find_child(valset,
+                         AGT_CLI_MODULE_EX,
+                         NCX_EL_EVENTLOG_SEGMENT_COUNT);
+    if (val && val->res == NO_ERR) {
+        agt_profile->agt_eventlog_segcount = VAL_UINT(val);
+    }
+
     val = val_find_child(valset,
                          AGT_CLI_MODULE_EX,
                          NCX_EL_TCP_DIRECT_PORT);
@@ -34,6 +34,8 @@ date         init     comment
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -43,6 +45,7 @@ date         init     comment
 #include "agt_if.h"
 #include "agt_rpc.h"
 #include "agt_util.h"
+#include "bobhash.h"
 #include "cfg.h"
 #include "getcb.h"
 #include "log.h"
@@ -79,12 +82,45 @@ date         init     comment
 #define interfaces_OID_counters (const xmlChar *)\
     "/interfaces/interface/counters"
 
+/* the interface counters are read from this file */
+#define AGT_IF_PROC_FILE     "/proc/net/dev"
+
+/* number of hash bits for the interface name lookup table */
+#define AGT_IF_HASH_BITS     10
+
+/* max age in seconds of the /proc/net/dev snapshot
+ * before it is read again
+ */
+#define AGT_IF_SNAPSHOT_AGE  1
+
+/* initial size of the /proc/net/dev read buffer */
+#define AGT_IF_INIT_BUFFLEN  8192
+
 /********************************************************************
 *                                                                   *
 *                           T Y P E S                               *
 *                                                                   *
 *********************************************************************/
 
+/* one interface line in the /proc/net/dev snapshot */
+typedef struct agt_if_entry_t_ {
+    struct agt_if_entry_t_ *hashnext;
+    xmlChar                *name;       /* points into snapshot buff */
+    xmlChar                *counters;   /* points into snapshot buff */
+} agt_if_entry_t;
+
+
+/* snapshot of the /proc/net/dev file, shared by all the
+ * counters nodes read within AGT_IF_SNAPSHOT_AGE seconds
+ */
+typedef struct agt_if_snapshot_t_ {
+    time_t            timestamp;
+    xmlChar          *buff;            /* file contents */
+    uint32            entrycount;
+    agt_if_entry_t   *entries;         /* entries in file order */
+    agt_if_entry_t   *hashtab[hashsize(AGT_IF_HASH_BITS)];
+} agt_if_snapshot_t;
+
 
 /********************************************************************
 *                                                                   *
@@ -98,6 +134,8 @@ static boolean              agt_if_not_supported;
 
 static ncx_module_t         *ifmod;
 
+static agt_if_snapshot_t     ifsnap;
+
 
 /********************************************************************
 * FUNCTION is_interfaces_supported
@@ -115,7 +153,7 @@ static boolean
     int              ret;
 
     memset(&statbuf, 0x0, sizeof(statbuf));
-    ret = stat("/proc/net/dev", &statbuf);
+    ret = stat(AGT_IF_PROC_FILE, &statbuf);
     if (ret == 0 && S_ISREG(statbuf.st_mode)) {
         return TRUE;
     }
@@ -183,6 +221,262 @@ static status_t
 } /* get_ifname_string */
 
 
+/********************************************************************
+* FUNCTION hash_ifname
+*
+* Get the hash table index for an interface name
+*
+* INPUTS:
+*   name == zero-terminated interface name
+*
+* RETURNS:
+*    hash table index
+*********************************************************************/
+static uint32
+    hash_ifname (const xmlChar *name)
+{
+    return (uint32)bobhash(name, xml_strlen(name), 0) & 
+        hashmask(AGT_IF_HASH_BITS);
+
+} /* hash_ifname */
+
+
+/********************************************************************
+* FUNCTION clear_snapshot
+*
+* Free the /proc/net/dev snapshot
+*********************************************************************/
+static void
+    clear_snapshot (void)
+{
+    if (ifsnap.buff) {
+        m__free(ifsnap.buff);
+    }
+    if (ifsnap.entries) {
+        m__free(ifsnap.entries);
+    }
+    memset(&ifsnap, 0x0, sizeof(agt_if_snapshot_t));
+
+} /* clear_snapshot */
+
+
+/********************************************************************
+* FUNCTION read_proc_file
+*
+* Read the whole /proc/net/dev file into a malloced buffer
+* The file size is not known until it is read
+*
+* INPUTS:
+*   res == address of return status
+*
+* OUTPUTS:
+*   *res == return status
+*
+* RETURNS:
+*    malloced zero-terminated file contents or NULL if error
+*********************************************************************/
+static xmlChar *
+    read_proc_file (status_t *res)
+{
+    xmlChar   *buff, *newbuff;
+    uint32     bufflen, len;
+    ssize_t    ret;
+    int        fd;
+
+    *res = NO_ERR;
+
+    fd = open(AGT_IF_PROC_FILE, O_RDONLY);
+    if (fd < 0) {
+        *res = errno_to_status();
+        return NULL;
+    }
+
+    bufflen = AGT_IF_INIT_BUFFLEN;
+    buff = m__getMem(bufflen);
+    if (buff == NULL) {
+        close(fd);
+        *res = ERR_INTERNAL_MEM;
+        return NULL;
+    }
+
+    len = 0;
+    for (;;) {
+        if (len == bufflen - 1) {
+            newbuff = m__getMem(bufflen * 2);
+            if (newbuff == NULL) {
+                *res = ERR_INTERNAL_MEM;
+                break;
+            }
+            memcpy(newbuff, buff, len);
+            m__free(buff);
+            buff = newbuff;
+            bufflen *= 2;
+        }
+
+        ret = read(fd, &buff[len], bufflen - len - 1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *res = errno_to_status();
+            break;
+        } else if (ret == 0) {
+            break;
+        }
+        len += (uint32)ret;
+    }
+
+    close(fd);
+
+    if (*res != NO_ERR) {
+        m__free(buff);
+        return NULL;
+    }
+
+    buff[len] = 0;
+    return buff;
+
+} /* read_proc_file */
+
+
+/********************************************************************
+* FUNCTION load_snapshot
+*
+* Read /proc/net/dev and index each interface line by name
+* The old snapshot is replaced
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    load_snapshot (void)
+{
+    agt_if_entry_t  *entry;
+    xmlChar         *buff, *line, *end, *ifname;
+    uint32           linecount, h;
+    int              ifnamelen;
+    status_t         res;
+
+    clear_snapshot();
+
+    buff = read_proc_file(&res);
+    if (buff == NULL) {
+        return res;
+    }
+
+    /* each line after the 2 header lines is 1 interface */
+    linecount = 0;
+    for (line = buff; *line; line++) {
+        if (*line == '\n') {
+            linecount++;
+        }
+    }
+    linecount++;
+
+    ifsnap.entries = m__getMem(linecount * sizeof(agt_if_entry_t));
+    if (ifsnap.entries == NULL) {
+        m__free(buff);
+        return ERR_INTERNAL_MEM;
+    }
+    ifsnap.buff = buff;
+
+    linecount = 0;
+    for (line = buff; *line; line = end) {
+        end = (xmlChar *)strchr((const char *)line, '\n');
+        if (end) {
+            *end++ = 0;
+        } else {
+            end = &line[xml_strlen(line)];
+        }
+
+        if (++linecount < 3) {
+            /* skip the header junk on the first 2 lines */
+            continue;
+        }
+
+        ifname = NULL;
+        ifnamelen = 0;
+        if (get_ifname_string(line, &ifname, &ifnamelen) != NO_ERR) {
+            continue;
+        }
+        ifname[ifnamelen] = 0;
+
+        entry = &ifsnap.entries[ifsnap.entrycount++];
+        entry->name = ifname;
+        entry->counters = &ifname[ifnamelen+1];
+
+        h = hash_ifname(ifname);
+        entry->hashnext = ifsnap.hashtab[h];
+        ifsnap.hashtab[h] = entry;
+    }
+
+    ifsnap.timestamp = time(NULL);
+
+    if (LOGDEBUG3) {
+        log_debug3("\nagt_if: read %u interfaces from " AGT_IF_PROC_FILE,
+                   ifsnap.entrycount);
+    }
+
+    return NO_ERR;
+
+} /* load_snapshot */
+
+
+/********************************************************************
+* FUNCTION refresh_snapshot
+*
+* Make sure the /proc/net/dev snapshot is present and not
+* older than AGT_IF_SNAPSHOT_AGE seconds, so all the counters
+* nodes of one <get> reply are filled from 1 file read
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    refresh_snapshot (void)
+{
+    time_t  now;
+
+    now = time(NULL);
+    if (ifsnap.buff != NULL &&
+        now >= ifsnap.timestamp &&
+        now - ifsnap.timestamp < AGT_IF_SNAPSHOT_AGE) {
+        return NO_ERR;
+    }
+
+    return load_snapshot();
+
+} /* refresh_snapshot */
+
+
+/********************************************************************
+* FUNCTION find_snapshot_entry
+*
+* Find an interface in the /proc/net/dev snapshot
+*
+* INPUTS:
+*   name == interface name to find
+*
+* RETURNS:
+*    pointer to the snapshot entry or NULL if not found
+*********************************************************************/
+static agt_if_entry_t *
+    find_snapshot_entry (const xmlChar *name)
+{
+    agt_if_entry_t  *entry;
+
+    for (entry = ifsnap.hashtab[hash_ifname(name)];
+         entry != NULL;
+         entry = entry->hashnext) {
+        if (!xml_strcmp(entry->name, name)) {
+            return entry;
+        }
+    }
+    return NULL;
+
+} /* find_snapshot_entry */
+
+
 /********************************************************************
 * FUNCTION find_interface_entry
 *
@@ -298,7 +592,8 @@ static val_value_t *
 * INPUTS:
 *   countersobj == object template with all the child node to use
 *   nameval == value node for the <name> key that is desired
-*   buffer == line from the /proc/net/dev file to read
+*   str == start of the counters in the /proc/net/dev line
+*          for the <name> key
 *   dstval == destination value to fill in
 *
 * OUTPUTS:
@@ -306,20 +601,17 @@ static val_value_t *
 *
 * RETURNS:
 *    status
-*    NO_ERR if this is the right line for the <name> key
-*      and everything filled in OK
-*    ERR_NCX_SKIPPED if this is the wrong line for this <name>
+*    NO_ERR if everything filled in OK
 *    some other error like ERR_INTERNAL_MEM
 *********************************************************************/
 static status_t 
     fill_if_counters (obj_template_t *countersobj,
                       val_value_t *nameval,
-                      xmlChar *buffer,
+                      xmlChar *str,
                       val_value_t  *dstval)
 {
     obj_template_t        *childobj;
     val_value_t           *childval;
-    xmlChar               *str, *name;
     char                  *endptr;
     status_t               res;
     uint32                 leafcount;
@@ -330,40 +622,6 @@ static status_t
     leafcount = 0;
     counter = 0;
 
-    /* get the start of the interface name */
-    str = buffer;
-    while (*str && isspace(*str)) {
-        str++;
-    }
-    if (*str == '\0') {
-        /* not expecting a line with just whitespace on it */
-        return ERR_NCX_SKIPPED;
-    } else {
-        name = str++;
-    }
-
-    /* get the end of the interface name */
-    while (*str && *str != ':') {
-        str++;
-    }
-    if (*str == '\0') {
-        /* not expecting a line with just foo on it */
-        return ERR_NCX_SKIPPED;
-    }
-
-    /* is this the requested interface line? */
-    if (xml_strncmp((const xmlChar *)name,
-                    VAL_STR(nameval),
-                    (uint32)(str - name))) {
-        /* not the right interface name */
-        return ERR_NCX_SKIPPED;
-    }
-
-    /* get the str pointed at the first byte of the
-     * 16 ordered counter values
-     */
-    str++;
-
     /* get the first counter object ready */
     childobj = obj_first_child(countersobj);
     if (childobj == NULL) {
@@ -392,7 +650,7 @@ static status_t
         leafcount++;
 
         str = (xmlChar *)endptr;
-        if (*str == '\0' || *str == '\n') {
+        if (*str == '\0') {
             done = TRUE;
         } else {
             childobj = obj_next_child(childobj);
@@ -430,16 +688,12 @@ static status_t
                      val_value_t *virval,
                      val_value_t  *dstval)
 {
-    FILE                  *countersfile;
     obj_template_t        *countersobj;
     val_value_t           *parentval, *nameval;
-    xmlChar               *buffer, *readtest;
-    boolean                done;
+    agt_if_entry_t        *entry;
     status_t               res;
-    uint32                 linecount;
 
     (void)scb;
-    res = NO_ERR;
 
     if (cbmode != GETCB_GET_VALUE) {
         return ERR_NCX_OPERATION_NOT_SUPPORTED;
@@ -463,54 +717,24 @@ static status_t
         return SET_ERROR(ERR_INTERNAL_VAL);
     }        
 
-    /* open the /proc/net/dev file for reading */
-    countersfile = fopen("/proc/net/dev", "r");
-    if (countersfile == NULL) {
-        return errno_to_status();
-    }
-
-    /* get a file read line buffer */
-    buffer = m__getMem(NCX_MAX_LINELEN);
-    if (buffer == NULL) {
-        fclose(countersfile);
-        return ERR_INTERNAL_MEM;
+    /* all the counters in 1 reply share the same snapshot
+     * instead of reading the whole file for each interface
+     */
+    res = refresh_snapshot();
+    if (res != NO_ERR) {
+        return res;
     }
 
-    /* loop through the file until done */
-    res = NO_ERR;
-    done = FALSE;
-    linecount = 0;
-
-    while (!done) {
-      readtest = (xmlChar *)
-	fgets((char *)buffer, NCX_MAX_LINELEN, countersfile);
-        if (readtest == NULL) {
-            done = TRUE;
-            continue;
-        } else {
-            linecount++;
-        }
-
-        if (linecount < 3) {
-            /* skip the header junk on the first 2 lines */
-            continue;
-        } 
-
-        res = fill_if_counters(countersobj,
-                               nameval, 
-                               buffer, 
-                               dstval);
-        if (res == ERR_NCX_SKIPPED) {
-            res = NO_ERR;
-        } else {
-            done = TRUE;
-        }
+    entry = find_snapshot_entry(VAL_STR(nameval));
+    if (entry == NULL) {
+        /* the interface is gone; leave the counters empty */
+        return NO_ERR;
     }
 
-    fclose(countersfile);
-    m__free(buffer);
-
-    return res;
+    return fill_if_counters(countersobj,
+                            nameval, 
+                            entry->counters, 
+                            dstval);
 
 } /* get_if_counters */
 
@@ -533,16 +757,11 @@ static status_t
     add_interface_entries (val_value_t *interfacesval)
 {
 
-    FILE                  *countersfile;
     obj_template_t        *interfaceobj, *countersobj;
     val_value_t           *interfaceval, *countersval;
-    xmlChar               *buffer, *readtest, *ifname;
-    boolean                done;
+    agt_if_entry_t        *entry;
     status_t               res;
-    uint32                 linecount;
-    int                    ifnamelen;
-
-    res = NO_ERR;
+    uint32                 i;
 
     interfaceobj = obj_find_child(interfacesval->obj,
                                   interfaces_MOD,
@@ -558,83 +777,40 @@ static status_t
         return SET_ERROR(ERR_NCX_DEF_NOT_FOUND);
     }
 
-    /* open the /proc/net/dev file for reading */
-    countersfile = fopen("/proc/net/dev", "r");
-    if (countersfile == NULL) {
-        return errno_to_status();
+    res = load_snapshot();
+    if (res != NO_ERR) {
+        return res;
     }
 
-    /* get a file read line buffer */
-    buffer = m__getMem(NCX_MAX_LINELEN);
-    if (buffer == NULL) {
-        fclose(countersfile);
-        return ERR_INTERNAL_MEM;
-    }
-
-    /* loop through the file until done */
-    res = NO_ERR;
-    done = FALSE;
-    linecount = 0;
-
-    while (!done) {
-      readtest = (xmlChar *)
-	fgets((char *)buffer, NCX_MAX_LINELEN, countersfile);
-        if (readtest == NULL) {
-            done = TRUE;
-            continue;
-        } else {
-            linecount++;
-        }
+    for (i = 0; i < ifsnap.entrycount && res == NO_ERR; i++) {
+        entry = &ifsnap.entries[i];
 
-        if (linecount < 3) {
-            /* skip the header junk on the first 2 lines */
-            continue;
-        } 
-
-        ifname = NULL;
-        ifnamelen = 0;
-        res = get_ifname_string(buffer, &ifname, &ifnamelen);
-        if (res != NO_ERR) {
-            done = TRUE;
-        } else {
-            /* got the name string
-             * see if this entry is already present
-             */
-            interfaceval = find_interface_entry(interfacesval,
-                                                ifname,
-                                                ifnamelen);
+        /* see if this entry is already present */
+        interfaceval = find_interface_entry(interfacesval,
+                                            entry->name,
+                                            (int)xml_strlen(entry->name));
+        if (interfaceval == NULL) {
+            /* create a new entry */
+            interfaceval = make_interface_entry(interfaceobj,
+                                                entry->name,
+                                                &res);
             if (interfaceval == NULL) {
-                /* create a new entry */
-                res = NO_ERR;
-                ifname[ifnamelen] = 0;
-                interfaceval = make_interface_entry(interfaceobj,
-                                                    ifname,
-                                                    &res);
-                if (interfaceval == NULL) {
-                    done = TRUE;
-                    continue;
-                } else {
-                    val_add_child(interfaceval, interfacesval);
-                }
-            }
-
-            /* add the counters virtual node to the entry */
-            countersval = val_new_value();
-            if (countersval == NULL) {
-                res = ERR_INTERNAL_MEM;
-                done = TRUE;
                 continue;
-            } else {
-                val_init_virtual(countersval,
-                                 get_if_counters,
-                                 countersobj);
-                val_add_child(countersval, interfaceval);
             }
+            val_add_child(interfaceval, interfacesval);
         }
-    }
 
-    fclose(countersfile);
-    m__free(buffer);
+        /* add the counters virtual node to the entry */
+        countersval = val_new_value();
+        if (countersval == NULL) {
+            res = ERR_INTERNAL_MEM;
+            continue;
+        }
+        val_init_virtual(countersval,
+                         get_if_counters,
+                         countersobj);
+        val_add_child(countersval, interfaceval);
+    }
 
     return res;
 
@@ -668,6 +844,7 @@ status_t
     log_debug2("\nagt: Loading interfaces module");
 
     ifmod = NULL;
+    memset(&ifsnap, 0x0, sizeof(agt_if_snapshot_t));
     agt_if_not_supported = FALSE;
     agt_if_init_done = TRUE;
     agt_profile = agt_get_profile();
@@ -768,6 +945,7 @@ void
     agt_if_cleanup (void)
 {
     if (agt_if_init_done) {
+        clear_snapshot();
         ifmod = NULL;
         agt_if_init_done = FALSE;
     }
@@ -2320,6 +2320,7 @@ static status_t
     val_value_t    *persistval, *persistidval, *errval;
     cfg_template_t *candidate, *running;
     xmlChar        *fname;
+    cfg_transaction_id_t pretxid;
     status_t        res;
     boolean         save_nvstore, errdone, timeout_extended;
 
@@ -2573,6 +2574,7 @@ static status_t
     }
 
     if (res == NO_ERR) {
+        pretxid = running->last_txid;
         res = agt_val_apply_commit(scb, msg, candidate, running, save_nvstore);
         if (res != NO_ERR) {
             errdone = TRUE;
@@ -2593,6 +2595,8 @@ static status_t
                 }
             }
         } else {
+            /* running only changed in the candidate dirty subtrees */
+            cfg_update_candidate_fill_txid(pretxid);
             res = cfg_fill_candidate_from_running();
         }
     }
@@ -43,6 +43,12 @@ date         init     comment
 #include <arpa/inet.h>
 #include <netdb.h>
 
+#ifdef HAVE_EPOLL
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
 #include "procdefs.h"
 #include "agt.h"
 #include "agt_ncxserver.h"
@@ -58,6 +64,7 @@ date         init     comment
 #include "ses.h"
 #include "ses_msg.h"
 #include "status.h"
+#include "val.h"
 #include "xmlns.h"
 
 
@@ -73,10 +80,17 @@ date         init     comment
 /* number of notifications to send out in 1 timeout interval */
 #define MAX_NOTIFICATION_BURST  10
 
+/* max number of epoll events handled per wakeup */
+#define AGT_NCXSERVER_MAX_EVENTS  64
+
 
+#ifdef HAVE_EPOLL
+static int    epfd = -1;
+#else
 static fd_set active_fd_set;
 static fd_set read_fd_set;
 static fd_set write_fd_set;
+#endif
 
 
 /********************************************************************
@@ -243,60 +257,417 @@ static void
 
 
 
-/***********     E X P O R T E D   F U N C T I O N S   *************/
-
-
 /********************************************************************
- * FUNCTION agt_ncxserver_run
+ * FUNCTION accept_session
  * 
- * IO server loop for the ncxserver socket
+ * Accept a connection request on the ncxserver socket
+ * and start a new session for it
  * 
+ * INPUTS:
+ *    ncxsock == listening ncxserver socket
+ *
  * RETURNS:
- *   status
+ *    FD of the new session, or -1 if the session was not started
  *********************************************************************/
-status_t
-    agt_ncxserver_run (void)
+static int
+    accept_session (int ncxsock)
 {
-    ses_cb_t              *scb;
-    agt_profile_t         *profile;
-    int                    ncxsock, maxwrnum, maxrdnum;
-    int                    i, new, ret;
     struct sockaddr_un     clientname;
-    struct timeval         timeout;
     socklen_t              size;
-    status_t               res;
-    boolean                done, done2, stream_output;
-    val_value_t            *clivalset;
-    val_value_t            *val;
+    int                    new;
+
+    size = (socklen_t)sizeof(clientname);
+    new = accept(ncxsock,
+                 (struct sockaddr *)&clientname,
+                 &size);
+    if (new < 0) {
+        if (LOGINFO) {
+            log_info("\nagt_ncxserver accept "
+                     "connection failed (%d)",
+                     new);
+        }
+        return -1;
+    }
 
-    profile = agt_get_profile();
-    if (profile == NULL) {
-        return SET_ERROR(ERR_INTERNAL_VAL);
+    /* get a new session control block */
+    if (!agt_ses_new_session(SES_TRANSPORT_SSH, new)) {
+        close(new);
+        if (LOGINFO) {
+            log_info("\nagt_ncxserver new "
+                     "session failed (%d)", 
+                     new);
+        }
+        return -1;
     }
 
-    if(profile->agt_tcp_direct_port!=-1) {
-        res = make_tcp_socket(profile->agt_tcp_direct_address, profile->agt_tcp_direct_port, &ncxsock);
+    /* set non-blocking IO */
+    if (fcntl(new, F_SETFD, O_NONBLOCK)) {
+        if (LOGINFO) {
+            log_info("\nfnctl failed");
+        }
+    }
+    return new;
+
+} /* accept_session */
+
+
+/********************************************************************
+ * FUNCTION write_session
+ * 
+ * Try to send 1 packet worth of buffers for a session
+ * 
+ * INPUTS:
+ *    scb == session control block to write
+ *
+ * RETURNS:
+ *    TRUE if the session is still active
+ *    FALSE if the session was killed
+ *********************************************************************/
+static boolean
+    write_session (ses_cb_t *scb)
+{
+    status_t               res;
+
+    /* check if anything to write */
+    if (!dlq_empty(&scb->outQ)) {
+        res = ses_msg_send_buffs(scb);
         if (res != NO_ERR) {
-            log_error("\n*** Cannot connect to ncxserver socket listen tcp port: %d\n",profile->agt_tcp_direct_port);
-            return res;
+            if (LOGINFO) {
+                log_info("\nagt_ncxserver write failed; "
+                         "closing session %d ", 
+                         scb->sid);
+            }
+            agt_ses_kill_session(scb, 
+                                 scb->sid,
+                                 SES_TR_OTHER);
+            return FALSE;
+        } else if (scb->state == SES_ST_SHUTDOWN_REQ) {
+            /* close-session reply sent, now kill ses */
+            agt_ses_kill_session(scb, 
+                                 scb->killedbysid,
+                                 scb->termreason);
+            return FALSE;
+        }
+    }
+
+    /* check if any buffers left over for next loop */
+    if (!dlq_empty(&scb->outQ)) {
+        ses_msg_make_outready(scb);
+    }
+    return TRUE;
+
+} /* write_session */
+
+
+/********************************************************************
+ * FUNCTION read_session
+ * 
+ * Accept input for a session and handle any input error
+ * 
+ * INPUTS:
+ *    scb == session control block to read
+ *
+ * RETURNS:
+ *    status of the read; if not NO_ERR the session is
+ *    being closed or was killed
+ *********************************************************************/
+static status_t
+    read_session (ses_cb_t *scb)
+{
+    status_t               res;
+
+    res = ses_accept_input(scb);
+    if (res == NO_ERR) {
+        return res;
+    }
+
+    if (res != ERR_NCX_SESSION_CLOSED) {
+        if (LOGINFO) {
+            log_info("\nagt_ncxserver: input failed"
+                     " for session %d (%s)",
+                     scb->sid, 
+                     get_error_string(res));
         }
+        /* send an error reply instead of
+         * killing the session right now
+         */
+        agt_rpc_send_error_reply(scb, res);
+        agt_ses_request_close(scb, 
+                              0, 
+                              SES_TR_OTHER);
     } else {
-        res = make_named_socket(profile->agt_ncxserver_sockname, &ncxsock);
-        if (res != NO_ERR) {
-            log_error("\n*** Cannot connect to ncxserver socket"
-                      "\n*** If no other instances of netconfd are running,"
-                      "\n*** try deleting %s\n",profile->agt_ncxserver_sockname);
-            return res;
+        /* connection already closed
+         * so kill session right now
+         */
+        agt_ses_kill_session(scb,
+                             scb->sid,
+                             SES_TR_DROPPED);
+    }
+    return res;
+
+} /* read_session */
+
+
+/********************************************************************
+ * FUNCTION process_ready_input
+ * 
+ * Drain the ready queue before accepting new input
+ * 
+ * INPUTS:
+ *    deferfd == FD of the last session read, which may still
+ *               have input deferred until the previous message
+ *               is processed (e.g. <rpc> trailing <hello>)
+ *               -1 if none
+ *
+ * RETURNS:
+ *    TRUE if shutdown was requested; FALSE otherwise
+ *********************************************************************/
+static boolean
+    process_ready_input (int deferfd)
+{
+    ses_cb_t              *scb;
+
+    for (;;) {
+        while (agt_ses_process_first_ready()) {
+            if (agt_shutdown_requested()) {
+                return TRUE;
+            }
+            send_some_notifications();
+        }
+
+        if (deferfd < 0) {
+            return FALSE;
         }
+        scb = def_reg_find_scb(deferfd);
+        if (scb == NULL || scb->indefer_len == 0) {
+            return FALSE;
+        }
+
+        log_debug3("\nagt_ncxserver: deferred trailing input processing.");
+        (void)read_session(scb);
     }
 
-    stream_output = profile->agt_stream_output;
+} /* process_ready_input */
 
-    if (listen(ncxsock, 1) < 0) {
-        log_error("\nError: listen failed");
+
+#ifdef HAVE_EPOLL
+/********************************************************************
+ * FUNCTION set_interest
+ * 
+ * Set the epoll events to wait for on a session socket
+ * 
+ * INPUTS:
+ *    fd == session socket
+ *    events == epoll events to wait for
+ *********************************************************************/
+static void
+    set_interest (int fd,
+                  uint32_t events)
+{
+    struct epoll_event     ev;
+
+    memset(&ev, 0x0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) != 0) {
+        log_error("\nagt_ncxserver: epoll_ctl failed for fd %d (%s)",
+                  fd,
+                  strerror(errno));
+    }
+
+} /* set_interest */
+
+
+/********************************************************************
+ * FUNCTION server_loop
+ * 
+ * epoll based IO loop for the ncxserver socket
+ *
+ * Each session socket waits for input; write interest is only
+ * set while the session has output queued, so idle sessions
+ * do not cost anything per wakeup.  The polling callbacks
+ * are driven by a timerfd instead of the wait timeout.
+ * 
+ * INPUTS:
+ *    ncxsock == listening ncxserver socket
+ *    stream_output == TRUE if the sessions use stream output
+ *
+ * RETURNS:
+ *   status
+ *********************************************************************/
+static status_t
+    server_loop (int ncxsock,
+                 boolean stream_output)
+{
+    ses_cb_t              *scb;
+    struct epoll_event     ev;
+    struct epoll_event     events[AGT_NCXSERVER_MAX_EVENTS];
+    struct itimerspec      tick;
+    uint64_t               expirations;
+    int                    tfd, fd, new, deferfd, cnt, i;
+    status_t               res;
+    boolean                done;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        log_error("\nError: epoll_create failed (%s)", strerror(errno));
         return ERR_NCX_OPERATION_FAILED;
     }
-     
+
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        log_error("\nError: timerfd_create failed (%s)", strerror(errno));
+        close(epfd);
+        epfd = -1;
+        return ERR_NCX_OPERATION_FAILED;
+    }
+
+    memset(&tick, 0x0, sizeof(tick));
+    tick.it_value.tv_sec = AGT_NCXSERVER_TIMEOUT;
+    tick.it_interval.tv_sec = AGT_NCXSERVER_TIMEOUT;
+    (void)timerfd_settime(tfd, 0, &tick, NULL);
+
+    memset(&ev, 0x0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = ncxsock;
+    (void)epoll_ctl(epfd, EPOLL_CTL_ADD, ncxsock, &ev);
+    ev.data.fd = tfd;
+    (void)epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev);
+
+    res = NO_ERR;
+    done = FALSE;
+    while (!done) {
+
+        /* check exit program */
+        if (agt_shutdown_requested()) {
+            done = TRUE;
+            continue;
+        }
+
+        /* wait for output ready on the sessions with output queued */
+        for (scb = agt_ses_next_outready();
+             scb != NULL;
+             scb = agt_ses_next_outready()) {
+            set_interest(scb->fd, EPOLLIN | EPOLLOUT);
+        }
+
+        /* Block until input arrives on one or more active sockets,
+         * an output socket is ready, or the timer expires
+         */
+        cnt = epoll_wait(epfd, events, AGT_NCXSERVER_MAX_EVENTS, -1);
+        if (cnt < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            res = ERR_NCX_OPERATION_FAILED;
+            log_error("\nncxserver epoll_wait failed (%s)", 
+                      strerror(errno));
+            agt_request_shutdown(NCX_SHUT_EXIT);
+            done = TRUE;
+            continue;
+        }
+
+        /* check exit program */
+        if (agt_shutdown_requested()) {
+            done = TRUE;
+            continue;
+        }
+
+        /* Service all the sockets with input and/or output pending */
+        deferfd = -1;
+        for (i = 0; i < cnt; i++) {
+            fd = events[i].data.fd;
+
+            if (fd == tfd) {
+                (void)read(tfd, &expirations, sizeof(expirations));
+
+                /* !! put all polling callbacks here for now !! */
+                agt_ses_check_timeouts();
+                agt_timer_handler();
+                send_some_notifications();
+                val_refresh_virtual_values();
+                continue;
+            }
+
+            if (fd == ncxsock) {
+                /* Connection request on original socket. */
+                new = accept_session(ncxsock);
+                if (new >= 0) {
+                    memset(&ev, 0x0, sizeof(ev));
+                    ev.events = EPOLLIN;
+                    ev.data.fd = new;
+                    if (epoll_ctl(epfd, EPOLL_CTL_ADD, new, &ev) != 0) {
+                        log_error("\nagt_ncxserver: epoll_ctl failed "
+                                  "for fd %d (%s)",
+                                  new,
+                                  strerror(errno));
+                    }
+                }
+                continue;
+            }
+
+            /* check write output to client sessions */
+            if (events[i].events & EPOLLOUT) {
+                scb = def_reg_find_scb(fd);
+                if (scb != NULL && !stream_output) {
+                    if (!write_session(scb)) {
+                        scb = NULL;
+                    }
+                }
+
+                /* stop waiting for output once the outQ is drained */
+                if (scb != NULL && dlq_empty(&scb->outQ)) {
+                    set_interest(fd, EPOLLIN);
+                }
+            }
+
+            /* check read input from client sessions */
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                scb = def_reg_find_scb(fd);
+                if (scb != NULL) {
+                    (void)read_session(scb);
+                    deferfd = fd;
+                }
+            }
+        }
+
+        /* drain the ready queue before accepting new input */
+        if (process_ready_input(deferfd)) {
+            done = TRUE;
+        }
+    }  /* end epoll loop */
+
+    close(tfd);
+    close(epfd);
+    epfd = -1;
+    return res;
+
+}  /* server_loop */
+
+#else
+/********************************************************************
+ * FUNCTION server_loop
+ * 
+ * select based IO loop for the ncxserver socket
+ * 
+ * INPUTS:
+ *    ncxsock == listening ncxserver socket
+ *    stream_output == TRUE if the sessions use stream output
+ *
+ * RETURNS:
+ *   status
+ *********************************************************************/
+static status_t
+    server_loop (int ncxsock,
+                 boolean stream_output)
+{
+    ses_cb_t              *scb;
+    int                    maxwrnum, maxrdnum;
+    int                    i, new, ret, deferfd;
+    struct timeval         timeout;
+    status_t               res;
+    boolean                done, done2;
+
     /* Initialize the set of active sockets. */
     FD_ZERO(&read_fd_set);
     FD_ZERO(&write_fd_set);
@@ -304,6 +675,7 @@ status_t
     FD_SET(ncxsock, &active_fd_set);
     maxwrnum = maxrdnum = ncxsock;
 
+    res = NO_ERR;
     done = FALSE;
     while (!done) {
 
@@ -344,6 +716,7 @@ status_t
                     agt_ses_check_timeouts();
                     agt_timer_handler();
                     send_some_notifications();
+                    val_refresh_virtual_values();
                 }
             } else {
                 /* normal return with some bytes */
@@ -368,42 +741,13 @@ status_t
         }
      
         /* Service all the sockets with input and/or output pending */
-        done2 = FALSE;
-        for (i = 0; i < max(maxrdnum+1, maxwrnum+1) && !done2; i++) {
-            scb=NULL;
+        deferfd = -1;
+        for (i = 0; i < max(maxrdnum+1, maxwrnum+1); i++) {
             /* check write output to client sessions */
             if (!stream_output && FD_ISSET(i, &write_fd_set)) {
-                /* try to send 1 packet worth of buffers for a session */
                 scb = def_reg_find_scb(i);
                 if (scb) {
-                    /* check if anything to write */
-                    if (!dlq_empty(&scb->outQ)) {
-                        res = ses_msg_send_buffs(scb);
-                        if (res != NO_ERR) {
-                            if (LOGINFO) {
-                                log_info("\nagt_ncxserver write failed; "
-                                         "closing session %d ", 
-                                         scb->sid);
-                            }
-                        }
-                        if (res != NO_ERR) {
-                            agt_ses_kill_session(scb, 
-                                                 scb->sid,
-                                                 SES_TR_OTHER);
-                            scb = NULL;
-                        } else if (scb->state == SES_ST_SHUTDOWN_REQ) {
-                            /* close-session reply sent, now kill ses */
-                            agt_ses_kill_session(scb, 
-                                                 scb->killedbysid,
-                                                 scb->termreason);
-                            scb = NULL;
-                        }
-                    }
-
-                    /* check if any buffers left over for next loop */
-                    if (scb && !dlq_empty(&scb->outQ)) {
-                        ses_msg_make_outready(scb);
-                    }
+                    (void)write_session(scb);
                 }
             }
 
@@ -411,34 +755,8 @@ status_t
             if (FD_ISSET(i, &read_fd_set)) {
                 if (i == ncxsock) {
                     /* Connection request on original socket. */
-                    size = (socklen_t)sizeof(clientname);
-                    new = accept(ncxsock,
-                                 (struct sockaddr *)&clientname,
-                                 &size);
-                    if (new < 0) {
-                        if (LOGINFO) {
-                            log_info("\nagt_ncxserver accept "
-                                     "connection failed (%d)",
-                                     new);
-                        }
-                        continue;
-                    }
-
-                    /* get a new session control block */
-                    if (!agt_ses_new_session(SES_TRANSPORT_SSH, new)) {
-                        close(new);
-                        if (LOGINFO) {
-                            log_info("\nagt_ncxserver new "
-                                     "session failed (%d)", 
-                                     new);
-                        }
-                    } else {
-                        /* set non-blocking IO */
-                        if (fcntl(new, F_SETFD, O_NONBLOCK)) {
-                            if (LOGINFO) {
-                                log_info("\nfnctl failed");
-                            }
-                        }
+                    new = accept_session(ncxsock);
+                    if (new >= 0) {
                         FD_SET(new, &active_fd_set);
                         if (new > maxrdnum) {
                             maxrdnum = new;
@@ -449,36 +767,13 @@ status_t
                      * Need to have the xmlreader for this session
                      */
                     scb = def_reg_find_scb(i);
-
-ses_accept_defered_input:
                     if (scb != NULL) {
-                        res = ses_accept_input(scb);
-                        if (res != NO_ERR) {
+                        if (read_session(scb) != NO_ERR) {
                             if (i >= maxrdnum) {
                                 maxrdnum = i-1;
                             }
-                            if (res != ERR_NCX_SESSION_CLOSED) {
-                                if (LOGINFO) {
-                                    log_info("\nagt_ncxserver: input failed"
-                                             " for session %d (%s)",
-                                             scb->sid, 
-                                             get_error_string(res));
-                                }
-                                /* send an error reply instead of
-                                 * killing the session right now
-                                 */
-                                agt_rpc_send_error_reply(scb, res);
-                                agt_ses_request_close(scb, 
-                                                      0, 
-                                                      SES_TR_OTHER);
-                            } else {
-                                /* connection already closed
-                                 * so kill session right now
-                                 */
-                                agt_ses_kill_session(scb,
-                                                     scb->sid,
-                                                     SES_TR_DROPPED);
-                            }
+                        } else {
+                            deferfd = i;
                         }
                     }
                 }
@@ -486,35 +781,69 @@ ses_accept_defered_input:
         }
 
         /* drain the ready queue before accepting new input */
-        if (!done) {
-            done2 = FALSE;
-            while (!done2) {
-                if (!agt_ses_process_first_ready()) {
-                    done2 = TRUE;
-                } else if (agt_shutdown_requested()) {
-                    done = done2 = TRUE;
-                } else {
-                    send_some_notifications();
-                }
-            }
-            if(scb && scb->indefer_len>0) {
-                /*
-                 * input defered until previous message
-                 * is processed e.g. <rpc> trailing <hello>
-                 */
-                log_debug3("\nagt_ncxserver: goto deferred trailing input processing.");
-
-                goto ses_accept_defered_input;
-            }
+        if (process_ready_input(deferfd)) {
+            done = TRUE;
         }
     }  /* end select loop */
 
+    return res;
+
+}  /* server_loop */
+#endif  /* HAVE_EPOLL */
+
+
+/***********     E X P O R T E D   F U N C T I O N S   *************/
+
+
+/********************************************************************
+ * FUNCTION agt_ncxserver_run
+ * 
+ * IO server loop for the ncxserver socket
+ * 
+ * RETURNS:
+ *   status
+ *********************************************************************/
+status_t
+    agt_ncxserver_run (void)
+{
+    agt_profile_t         *profile;
+    int                    ncxsock;
+    status_t               res;
+
+    profile = agt_get_profile();
+    if (profile == NULL) {
+        return SET_ERROR(ERR_INTERNAL_VAL);
+    }
+
+    if(profile->agt_tcp_direct_port!=-1) {
+        res = make_tcp_socket(profile->agt_tcp_direct_address, profile->agt_tcp_direct_port, &ncxsock);
+        if (res != NO_ERR) {
+            log_error("\n*** Cannot connect to ncxserver socket listen tcp port: %d\n",profile->agt_tcp_direct_port);
+            return res;
+        }
+    } else {
+        res = make_named_socket(profile->agt_ncxserver_sockname, &ncxsock);
+        if (res != NO_ERR) {
+            log_error("\n*** Cannot connect to ncxserver socket"
+                      "\n*** If no other instances of netconfd are running,"
+                      "\n*** try deleting %s\n",profile->agt_ncxserver_sockname);
+            return res;
+        }
+    }
+
+    if (listen(ncxsock, 1) < 0) {
+        log_error("\nError: listen failed");
+        return ERR_NCX_OPERATION_FAILED;
+    }
+
+    res = server_loop(ncxsock, profile->agt_stream_output);
+
     /* all open client sockets will be closed as the sessions are
      * torn down, but the original ncxserver socket needs to be closed now
      */
     close(ncxsock);
     unlink(NCXSERVER_SOCKNAME);
-    return NO_ERR;
+    return res;
 
 }  /* agt_ncxserver_run */
 
@@ -530,7 +859,13 @@ ses_accept_defered_input:
 void
     agt_ncxserver_clear_fd (int fd)
 {
+#ifdef HAVE_EPOLL
+    if (epfd >= 0) {
+        (void)epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+    }
+#else
     FD_CLR(fd, &active_fd_set);
+#endif
 
 } /* agt_ncxserver_clear_fd */
 
@@ -54,15 +54,19 @@ date         init     comment
 #include "agt_cap.h"
 #include "agt_cb.h"
 #include "agt_not.h"
+#include "agt_not_store.h"
 #include "agt_rpc.h"
 #include "agt_ses.h"
 #include "agt_tree.h"
 #include "agt_util.h"
+#include "agt_val_parse.h"
+#include "agt_xml.h"
 #include "agt_xpath.h"
 #include "agt_not_queue_notification_cb.h"
 #include "cfg.h"
 #include "getcb.h"
 #include "log.h"
+#include "ncx.h"
 #include "ncxmod.h"
 #include "ncxtypes.h"
 #include "rpc.h"
@@ -113,12 +117,41 @@ date         init     comment
 
 #define AGT_NOT_SEQID_MOD   (const xmlChar *)"yuma123-system"
 
+/* initial number of slots in the replay buffer ring;
+ * doubled as needed, up to the agt_eventlog_size limit
+ */
+#define AGT_NOT_EVENTLOG_MIN   64
+
 /********************************************************************
 *                                                                   *
 *                           T Y P E S                               *
 *                                                                   *
 *********************************************************************/
 
+/* one serialized copy of a notification message, shared by
+ * all the sessions that use the same output settings;
+ * kept in the agt_not_msg_t outQ
+ */
+typedef struct not_out_t_ {
+    dlq_hdr_t          qhdr;
+    ses_mode_t         mode;
+    int32              indent;
+    uint32             linesize;
+    boolean            nons;
+    char              *buff;       /* malloced by open_memstream */
+    const xmlChar     *body;       /* buff after the XML declaration */
+} not_out_t;
+
+
+/* filter test result for one filter group, shared by all
+ * the subscriptions in the group; kept in the agt_not_msg_t filterQ
+ */
+typedef struct not_filtres_t_ {
+    dlq_hdr_t          qhdr;
+    uint32             filterid;
+    boolean            passed;
+} not_filtres_t;
+
 
 /********************************************************************
 *                                                                   *
@@ -143,13 +176,23 @@ static ncx_module_t         *ncnotifmod;
  */
 static dlq_hdr_t             subscriptionQ;
 
-/* Q of agt_not_msg_t 
+/* ring buffer of agt_not_msg_t pointers
  * these are the messages that represent the replay buffer
- * only system-wide notifications are stored in this Q
+ * only system-wide notifications are stored in this ring
  * the replayComplete and notificationComplete events are
  * generated special-case, and not stored for replay
+ *
+ * entry N (0 == oldest) is in slot (eventlog_head + N) % eventlog_max
+ * the entries are in msgid and eventTime order, so the
+ * ring is also the index used to find a replay start point
  */
-static dlq_hdr_t             notificationQ;
+static agt_not_msg_t       **eventlog;
+
+/* number of slots allocated in the eventlog ring */
+static uint32                eventlog_max;
+
+/* slot number of the oldest entry in the eventlog ring */
+static uint32                eventlog_head;
 
 /* cached pointer to the <notification> element template */
 static obj_template_t *notificationobj;
@@ -172,9 +215,12 @@ static boolean               anySubscriptions;
 /* auto-increment message index */
 static uint32                msgid;
 
-/* keep track of eventlog size */
+/* number of entries in the eventlog ring */
 static uint32                notification_count;
 
+/* last filter group ID assigned to a subscription */
+static uint32                filterid;
+
 /********************************************************************
 * FUNCTION free_subscription
 *
@@ -208,6 +254,297 @@ static void
 }  /* free_subscription */
 
 
+/********************************************************************
+* FUNCTION get_eventlog_entry
+*
+* Get the specified entry in the replay buffer
+*
+* INPUTS:
+*    idx == entry number; 0 is the oldest entry
+*
+* RETURNS:
+*    pointer to the notification at this position
+*    NULL if idx is past the last entry
+*********************************************************************/
+static agt_not_msg_t *
+    get_eventlog_entry (uint32 idx)
+{
+    if (idx >= notification_count) {
+        return NULL;
+    }
+    return eventlog[(eventlog_head + idx) % eventlog_max];
+
+} /* get_eventlog_entry */
+
+
+/********************************************************************
+* FUNCTION find_eventlog_time
+*
+* Binary search the replay buffer for the first entry
+* with an eventTime at (or after) the specified time
+*
+* INPUTS:
+*    tstamp == UTC date-time string to find
+*    after == TRUE to skip entries with the same eventTime
+*             FALSE to include entries with the same eventTime
+*
+* RETURNS:
+*    entry number of the first match
+*    notification_count if no entry matches
+*********************************************************************/
+static uint32
+    find_eventlog_time (const xmlChar *tstamp,
+                        boolean after)
+{
+    uint32  lo, hi, mid;
+    int     ret;
+
+    lo = 0;
+    hi = notification_count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        ret = xml_strcmp(get_eventlog_entry(mid)->eventTime, tstamp);
+        if (ret < 0 || (after && ret == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+
+} /* find_eventlog_time */
+
+
+/********************************************************************
+* FUNCTION find_eventlog_msgid
+*
+* Binary search the replay buffer for the first entry
+* with a msgid higher than the specified msgid
+*
+* INPUTS:
+*    thismsgid == msgid to find
+*
+* RETURNS:
+*    entry number of the first match
+*    notification_count if no entry matches
+*********************************************************************/
+static uint32
+    find_eventlog_msgid (uint32 thismsgid)
+{
+    uint32  lo, hi, mid;
+
+    lo = 0;
+    hi = notification_count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (get_eventlog_entry(mid)->msgid <= thismsgid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+
+} /* find_eventlog_msgid */
+
+
+/********************************************************************
+* FUNCTION add_eventlog_entry
+*
+* Add a notification to the end of the replay buffer
+* The ring is grown if it is full; the caller must
+* delete the oldest entry first if the eventlog size
+* limit has been reached
+*
+* INPUTS:
+*    notif == notification to add
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    add_eventlog_entry (agt_not_msg_t *notif)
+{
+    const agt_profile_t  *agt_profile;
+    agt_not_msg_t       **newlog;
+    uint32                newmax, i;
+
+    if (notification_count == eventlog_max) {
+        agt_profile = agt_get_profile();
+
+        newmax = (eventlog_max) ? eventlog_max * 2 : AGT_NOT_EVENTLOG_MIN;
+        if (newmax < eventlog_max) {
+            return ERR_BUFF_OVFL;
+        }
+        if (agt_profile->agt_eventlog_size &&
+            newmax > agt_profile->agt_eventlog_size) {
+            newmax = agt_profile->agt_eventlog_size;
+        }
+
+        newlog = (agt_not_msg_t **)
+            m__getMem(newmax * sizeof(agt_not_msg_t *));
+        if (newlog == NULL) {
+            return ERR_INTERNAL_MEM;
+        }
+
+        /* unwrap the old ring into the start of the new one */
+        for (i = 0; i < notification_count; i++) {
+            newlog[i] = get_eventlog_entry(i);
+        }
+        if (eventlog) {
+            m__free(eventlog);
+        }
+        eventlog = newlog;
+        eventlog_max = newmax;
+        eventlog_head = 0;
+    }
+
+    eventlog[(eventlog_head + notification_count) % eventlog_max] = notif;
+    notification_count++;
+    return NO_ERR;
+
+} /* add_eventlog_entry */
+
+
+/********************************************************************
+* FUNCTION remove_oldest_entry
+*
+* Remove the oldest notification from the replay buffer
+*
+* RETURNS:
+*    pointer to the removed notification
+*    NULL if the replay buffer is empty
+*********************************************************************/
+static agt_not_msg_t *
+    remove_oldest_entry (void)
+{
+    agt_not_msg_t  *msg;
+
+    if (notification_count == 0) {
+        return NULL;
+    }
+
+    msg = eventlog[eventlog_head];
+    eventlog[eventlog_head] = NULL;
+    eventlog_head = (eventlog_head + 1) % eventlog_max;
+    notification_count--;
+    return msg;
+
+} /* remove_oldest_entry */
+
+
+/********************************************************************
+* FUNCTION same_filter_node
+*
+* Check if 2 subtree filter nodes are the same, including
+* all the attributes and child nodes, in the same order
+*
+* INPUTS:
+*    val1 == first filter node to check
+*    val2 == second filter node to check
+*
+* RETURNS:
+*    TRUE if the filter nodes are the same
+*    FALSE if they are different
+*********************************************************************/
+static boolean
+    same_filter_node (val_value_t *val1,
+                      val_value_t *val2)
+{
+    val_value_t  *chval1, *chval2;
+
+    if (val1->nsid != val2->nsid ||
+        val1->btyp != val2->btyp ||
+        xml_strcmp(val1->name, val2->name)) {
+        return FALSE;
+    }
+
+    /* attribute match expressions */
+    chval1 = val_get_first_meta_val(val1);
+    chval2 = val_get_first_meta_val(val2);
+    while (chval1 && chval2) {
+        if (!same_filter_node(chval1, chval2)) {
+            return FALSE;
+        }
+        chval1 = val_get_next_meta(chval1);
+        chval2 = val_get_next_meta(chval2);
+    }
+    if (chval1 || chval2) {
+        return FALSE;
+    }
+
+    if (!typ_is_simple(val1->btyp)) {
+        chval1 = val_get_first_child(val1);
+        chval2 = val_get_first_child(val2);
+        while (chval1 && chval2) {
+            if (!same_filter_node(chval1, chval2)) {
+                return FALSE;
+            }
+            chval1 = val_get_next_child(chval1);
+            chval2 = val_get_next_child(chval2);
+        }
+        return (chval1 || chval2) ? FALSE : TRUE;
+    }
+
+    return (val_compare(val1, val2) == 0) ? TRUE : FALSE;
+
+}  /* same_filter_node */
+
+
+/********************************************************************
+* FUNCTION set_filter_group
+*
+* Put a new subscription in a filter group.  All subscriptions
+* in a group get the same filter test result for a notification,
+* so the filter only needs to be run once for each group.
+*
+* Subtree filters are grouped if the filter and the user are
+* the same.  XPath filters are resolved with the prefixes
+* in the session that sent the filter so each one is
+* kept in its own group.
+*
+* INPUTS:
+*    sub == new subscription, not in the subscriptionQ yet
+*
+* OUTPUTS:
+*    sub->filterid is set
+*********************************************************************/
+static void
+    set_filter_group (agt_not_subscription_t *sub)
+{
+    agt_not_subscription_t  *testsub;
+
+    sub->filterid = 0;
+    if (sub->filterval == NULL) {
+        return;
+    }
+
+    if (sub->filtertyp == OP_FILTER_SUBTREE) {
+        for (testsub = (agt_not_subscription_t *)
+                 dlq_firstEntry(&subscriptionQ);
+             testsub != NULL;
+             testsub = (agt_not_subscription_t *)dlq_nextEntry(testsub)) {
+
+            if (testsub->filterid &&
+                testsub->filtertyp == OP_FILTER_SUBTREE &&
+                testsub->scb && sub->scb &&
+                !xml_strcmp(testsub->scb->username, sub->scb->username) &&
+                same_filter_node(testsub->filterval, sub->filterval)) {
+                sub->filterid = testsub->filterid;
+                return;
+            }
+        }
+    }
+
+    if (++filterid == 0) {
+        /* filter group ID wrapped; 0 means no filter */
+        ++filterid;
+    }
+    sub->filterid = filterid;
+
+}  /* set_filter_group */
+
+
 /********************************************************************
 * FUNCTION new_subscription
 *
@@ -609,9 +946,11 @@ static status_t
                                 xml_node_t *methnode)
 {
     agt_not_subscription_t *sub;
-    agt_not_msg_t          *not, *nextnot;
+    agt_not_msg_t          *not;
+    const xmlChar          *firsttime;
+    uint32                  idx, storeid;
     int                     ret;
-    boolean                 done;
+    xmlChar                 storetime[TSTAMP_MIN_SIZE];
 
     (void)scb;
     (void)methnode;
@@ -619,31 +958,41 @@ static status_t
 
     if (sub->startTime) {
         /* this subscription has requested replay
-         * go through the notificationQ and set
+         * search the replay buffer and set
          * the start replay pointer
          */
         sub->state = AGT_NOT_STATE_REPLAY;
-        done = FALSE;
-        for (not = (agt_not_msg_t *)
-                 dlq_firstEntry(&notificationQ);
-             not != NULL && !done;
-             not = (agt_not_msg_t *)dlq_nextEntry(not)) {
-
-            ret = xml_strcmp(sub->startTime, not->eventTime);
-            if (ret <= 0) {
-                sub->firstreplaymsg = not;
-                sub->firstreplaymsgid = not->msgid;
-                done = TRUE;
+        idx = find_eventlog_time(sub->startTime, FALSE);
+        not = get_eventlog_entry(idx);
+        firsttime = NULL;
+
+        if (idx == 0 && agt_not_store_enabled()) {
+            /* the replay may start with events that are
+             * only in the replay store; these do not have
+             * a back-ptr, just the ID
+             */
+            storeid = agt_not_store_find_time(sub->startTime, FALSE);
+            if (storeid && (not == NULL || storeid < not->msgid) &&
+                agt_not_store_get_entry(storeid, storetime,
+                                        NULL, NULL, NULL) == NO_ERR) {
+                sub->firstreplaymsgid = storeid;
+                firsttime = storetime;
             }
         }
 
-        if (!done) {
+        if (firsttime == NULL && not != NULL) {
+            sub->firstreplaymsg = not;
+            sub->firstreplaymsgid = not->msgid;
+            firsttime = not->eventTime;
+        }
+
+        if (firsttime == NULL) {
             /* the startTime is after the last available
              * notification eventTime, so replay is over
              */
             sub->flags |= AGT_NOT_FL_RC_READY;
         } else if (sub->stopTime) {
-            /* the sub->firstreplaymsg was set;
+            /* the sub->firstreplaymsgid was set;
              * the subscription has requested to be
              * terminated after a specific time
              */
@@ -651,68 +1000,61 @@ static status_t
                 /* just use the last replay buffer entry
                  * as the end-of-replay marker
                  */
-                sub->lastreplaymsg = (agt_not_msg_t *)
-                    dlq_lastEntry(&notificationQ);
-                sub->lastreplaymsgid = 
-                    sub->lastreplaymsg->msgid;
+                if (notification_count) {
+                    sub->lastreplaymsg = 
+                        get_eventlog_entry(notification_count - 1);
+                    sub->lastreplaymsgid = 
+                        sub->lastreplaymsg->msgid;
+                } else {
+                    sub->lastreplaymsgid = agt_not_store_prev_msgid
+                        (AGT_NOT_STORE_LAST_MSGID);
+                }
             } else {
                 /* first check that the start notification
                  * is not already past the requested stopTime
                  */
-                ret = xml_strcmp(sub->stopTime,
-                                 sub->firstreplaymsg->eventTime);
+                ret = xml_strcmp(sub->stopTime, firsttime);
                 if (ret <= 0) {
                     sub->firstreplaymsg = NULL;
                     sub->firstreplaymsgid = 0;
                     sub->flags |= AGT_NOT_FL_RC_READY;
                 } else {
-                    /* check the notifications after the
-                     * start replay node, to find out
-                     * which one should be the last replay 
+                    /* the last replay is the one before the
+                     * first notification after the stopTime;
+                     * this is at or after the start replay node
                      */
-                    done = FALSE;
-                    for (not = sub->firstreplaymsg;
-                         not != NULL && !done;
-                         not = nextnot) {
-                 
-                        nextnot = (agt_not_msg_t *)dlq_nextEntry(not);
-                        if (nextnot) {
-                            ret = xml_strcmp(sub->stopTime, 
-                                             nextnot->eventTime);
-                        } else {
-                            ret = -1;
-                        }
-                        if (ret < 0) {
-                            /* the previous one checked was the winner */
-                            sub->lastreplaymsg = not;
-                            sub->lastreplaymsgid = not->msgid;
-                            done = TRUE;
-                        }
-                    }
-
-                    if (!done) {
-                        sub->lastreplaymsg = (agt_not_msg_t *)
-                            dlq_lastEntry(&notificationQ);
+                    idx = find_eventlog_time(sub->stopTime, TRUE);
+                    if (idx > 0) {
+                        sub->lastreplaymsg = get_eventlog_entry(idx - 1);
                         sub->lastreplaymsgid = 
                             sub->lastreplaymsg->msgid;
+                    } else {
+                        /* the whole replay is in the replay store */
+                        storeid = agt_not_store_find_time(sub->stopTime,
+                                                          TRUE);
+                        if (storeid == 0) {
+                            storeid = AGT_NOT_STORE_LAST_MSGID;
+                        }
+                        sub->lastreplaymsgid = 
+                            agt_not_store_prev_msgid(storeid);
                     }
                 }                       
             }
         }
     } else {
         /* setup live subscription by setting the
-         * lastmsg to the end of the replayQ
+         * lastmsg to the end of the replay buffer
          * so none of the buffered notifications
          * are send to this subscription
          */
         sub->state = AGT_NOT_STATE_LIVE;
-        sub->lastmsg = (agt_not_msg_t *)
-            dlq_lastEntry(&notificationQ);
-        if (sub->lastmsg) {
+        if (notification_count) {
+            sub->lastmsg = get_eventlog_entry(notification_count - 1);
             sub->lastmsgid = sub->lastmsg->msgid;
         }
     }
 
+    set_filter_group(sub);
     dlq_enque(sub, &subscriptionQ);
     anySubscriptions = TRUE;
 
@@ -758,34 +1100,281 @@ static void
 
 
 /********************************************************************
-* FUNCTION get_entry_after
+* FUNCTION clean_notification_cache
 *
-* Get the entry after the specified msgid
+* Free the serialized copies and filter results cached
+* in a notification message
 *
 * INPUTS:
-*    thismsgid == get the first msg with an ID higher than this value
+*    notif == notification to clean
+*********************************************************************/
+static void
+    clean_notification_cache (agt_not_msg_t *notif)
+{
+    not_out_t      *out;
+    not_filtres_t  *filtres;
+
+    while (!dlq_empty(&notif->outQ)) {
+        out = (not_out_t *)dlq_deque(&notif->outQ);
+        if (out->buff) {
+            /* not allocated with m__getMem */
+            free(out->buff);
+        }
+        m__free(out);
+    }
+
+    while (!dlq_empty(&notif->filterQ)) {
+        filtres = (not_filtres_t *)dlq_deque(&notif->filterQ);
+        m__free(filtres);
+    }
+
+}  /* clean_notification_cache */
+
+
+/********************************************************************
+* FUNCTION get_notification_output
+*
+* Get the serialized <notification> for the output settings
+* of the specified session.  The message is written once
+* for each combination of output settings and the copy
+* is reused for every other session with the same settings.
+*
+* INPUTS:
+*    notif == notification with the notif->msg already built
+*    scb == session that will get the notification
 *
 * RETURNS:
-*    pointer to an notification to use
-*    NULL if none found
+*    pointer to the serialized message, owned by notif
+*    NULL if a malloc or open_memstream error occurred
 *********************************************************************/
-static agt_not_msg_t *
-    get_entry_after (uint32 thismsgid)
+static const not_out_t *
+    get_notification_output (agt_not_msg_t *notif,
+                             ses_cb_t *scb)
 {
-    agt_not_msg_t *not;
+    not_out_t      *out;
+    ses_cb_t       *dummy;
+    FILE           *fp;
+    xml_msg_hdr_t   msghdr;
+    size_t          bufflen, startlen;
+    boolean         nons;
+
+    nons = ses_get_xml_nons(scb);
+
+    for (out = (not_out_t *)dlq_firstEntry(&notif->outQ);
+         out != NULL;
+         out = (not_out_t *)dlq_nextEntry(out)) {
+        if (out->mode == scb->mode &&
+            out->indent == scb->indent &&
+            out->linesize == scb->linesize &&
+            out->nons == nons) {
+            return out;
+        }
+    }
+
+    out = m__getObj(not_out_t);
+    if (!out) {
+        return NULL;
+    }
+    memset(out, 0x0, sizeof(not_out_t));
+    out->mode = scb->mode;
+    out->indent = scb->indent;
+    out->linesize = scb->linesize;
+    out->nons = nons;
+
+    dummy = ses_new_dummy_scb();
+    if (!dummy) {
+        m__free(out);
+        return NULL;
+    }
+
+    bufflen = 0;
+    fp = open_memstream(&out->buff, &bufflen);
+    if (!fp) {
+        ses_free_scb(dummy);
+        m__free(out);
+        return NULL;
+    }
+
+    dummy->fp = fp;
+    dummy->mode = scb->mode;
+    dummy->indent = scb->indent;
+    dummy->linesize = scb->linesize;
+    if (nons) {
+        ses_set_xml_nons(dummy);
+    }
+
+    /* write the XML declaration the same way ses_start_msg does,
+     * so the dummy session is in the same state as the real one */
+    ses_putstr(dummy, XML_START_MSG);
+    fflush(fp);
+    startlen = bufflen;
+
+    xml_msg_init_hdr(&msghdr);
+    xml_wr_full_val(dummy, &msghdr, notif->msg, 0);
+    xml_msg_clean_hdr(&msghdr);
+
+    /* ses_free_scb closes dummy->fp; the buffer is complete after that */
+    ses_free_scb(dummy);
+
+    if (out->buff == NULL) {
+        m__free(out);
+        return NULL;
+    }
+    out->body = (const xmlChar *)&out->buff[startlen];
+
+    dlq_enque(out, &notif->outQ);
+    return out;
+
+}  /* get_notification_output */
 
-    for (not = (agt_not_msg_t *)dlq_firstEntry(&notificationQ);
-         not != NULL;
-         not = (agt_not_msg_t *)dlq_nextEntry(not)) {
 
-        if (not->msgid > thismsgid) {
-            return not;
+/********************************************************************
+* FUNCTION test_notification_filter
+*
+* Run the subscription filter for a notification.  The result
+* is cached in the notification for the filter group, so all
+* the subscriptions in the same group only run it once.
+*
+* INPUTS:
+*    sub == subscription with a filter to test
+*    notif == notification with notif->event already set
+*    msghdr == message header to use for the filter
+*
+* RETURNS:
+*    TRUE if the filter passed
+*    FALSE if the filter did not pass
+*********************************************************************/
+static boolean
+    test_notification_filter (agt_not_subscription_t *sub,
+                              agt_not_msg_t *notif,
+                              xml_msg_hdr_t *msghdr)
+{
+    not_filtres_t  *filtres;
+    boolean         filterpassed;
+
+    for (filtres = (not_filtres_t *)dlq_firstEntry(&notif->filterQ);
+         filtres != NULL;
+         filtres = (not_filtres_t *)dlq_nextEntry(filtres)) {
+        if (filtres->filterid == sub->filterid) {
+            return filtres->passed;
         }
     }
 
-    return NULL;
+    switch (sub->filtertyp) {
+    case OP_FILTER_SUBTREE:
+        filterpassed = 
+            agt_tree_test_filter(msghdr,
+                                 sub->scb,
+                                 sub->filterval,
+                                 notif->event);
+        break;
+    case OP_FILTER_XPATH:
+        filterpassed = 
+            agt_xpath_test_filter(msghdr,
+                                  sub->scb,
+                                  sub->selectval,
+                                  notif->event);
+        break;
+    case OP_FILTER_NONE:
+    default:
+        filterpassed = FALSE;
+        SET_ERROR(ERR_INTERNAL_VAL);
+    }
 
-} /* get_entry_after */
+    if (sub->filterid) {
+        filtres = m__getObj(not_filtres_t);
+        if (filtres) {
+            memset(filtres, 0x0, sizeof(not_filtres_t));
+            filtres->filterid = sub->filterid;
+            filtres->passed = filterpassed;
+            dlq_enque(filtres, &notif->filterQ);
+        }
+    }
+
+    return filterpassed;
+
+}  /* test_notification_filter */
+
+
+/********************************************************************
+* FUNCTION build_notification_msg
+*
+* Construct the /notification element for a notification message
+* The payloadQ contents are moved into the new element
+*
+* INPUTS:
+*   notif == notification to use
+*   usemsgid == TRUE to add the sequence-id, if enabled
+*               FALSE for the replayComplete and
+*               notificationComplete events
+*
+* OUTPUTS:
+*   notif->msg and notif->event are set
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    build_notification_msg (agt_not_msg_t *notif,
+                            boolean usemsgid)
+{
+    val_value_t        *topval, *eventTime;
+    val_value_t        *eventType, *payloadval, *sequenceid;
+    status_t            res;
+    xmlChar             numbuff[NCX_MAX_NUMLEN];
+
+    topval = val_new_value();
+    if (!topval) {
+        log_error("\nError: malloc failed: cannot send notification");
+        return ERR_INTERNAL_MEM;
+    }
+    val_init_from_template(topval, notificationobj);
+
+    eventTime = val_make_simval_obj(eventTimeobj, notif->eventTime, &res);
+    if (!eventTime) {
+        log_error("\nError: make simval failed (%s): cannot "
+                  "send notification", 
+                  get_error_string(res));
+        val_free_value(topval);
+        return res;
+    }
+    val_add_child(eventTime, topval);
+
+    eventType = val_new_value();
+    if (!eventType) {
+        log_error("\nError: malloc failed: cannot send notification");
+        val_free_value(topval);
+        return ERR_INTERNAL_MEM;
+    }
+    val_init_from_template(eventType, notif->notobj);
+    val_add_child(eventType, topval);
+    notif->event = eventType;
+
+    /* move the payloadQ: transfer the memory here */
+    while (!dlq_empty(&notif->payloadQ)) {
+        payloadval = (val_value_t *)dlq_deque(&notif->payloadQ);
+        val_add_child(payloadval, eventType);
+    }
+
+    /* only use a msgid on a real event, not replay
+     * also only use if enabled in the agt_profile
+     */
+    agt_profile_t *profile = agt_get_profile();
+    if (usemsgid && profile->agt_notif_sequence_id) { 
+        snprintf((char *)numbuff, sizeof(numbuff), "%u", notif->msgid);
+        sequenceid = val_make_simval_obj(sequenceidobj, numbuff, &res);
+        if (!sequenceid) {
+            log_error("\nError: malloc failed: cannot "
+                      "add sequence-id");
+        } else {
+            val_add_child(sequenceid, topval);
+        }
+    }
+
+    notif->msg = topval;
+    return NO_ERR;
+
+}  /* build_notification_msg */
 
 
 /********************************************************************
@@ -813,13 +1402,11 @@ static status_t
                        agt_not_msg_t *notif,
                        boolean checkfilter)
 {
-    val_value_t        *topval, *eventTime;
-    val_value_t        *eventType, *payloadval, *sequenceid;
+    const not_out_t    *out;
     ses_total_stats_t  *totalstats;
     xml_msg_hdr_t       msghdr;
     status_t            res;
     boolean             filterpassed;
-    xmlChar             numbuff[NCX_MAX_NUMLEN];
 
     filterpassed = TRUE;
 
@@ -827,55 +1414,10 @@ static status_t
 
     if (!notif->msg) {
         /* need to construct the notification msg */
-        topval = val_new_value();
-        if (!topval) {
-            log_error("\nError: malloc failed: cannot send notification");
-            return ERR_INTERNAL_MEM;
-        }
-        val_init_from_template(topval, notificationobj);
-
-        eventTime = val_make_simval_obj(eventTimeobj, notif->eventTime, &res);
-        if (!eventTime) {
-            log_error("\nError: make simval failed (%s): cannot "
-                      "send notification", 
-                      get_error_string(res));
-            val_free_value(topval);
+        res = build_notification_msg(notif, checkfilter);
+        if (res != NO_ERR) {
             return res;
         }
-        val_add_child(eventTime, topval);
-
-        eventType = val_new_value();
-        if (!eventType) {
-            log_error("\nError: malloc failed: cannot send notification");
-            val_free_value(topval);
-            return ERR_INTERNAL_MEM;
-        }
-        val_init_from_template(eventType, notif->notobj);
-        val_add_child(eventType, topval);
-        notif->event = eventType;
-
-        /* move the payloadQ: transfer the memory here */
-        while (!dlq_empty(&notif->payloadQ)) {
-            payloadval = (val_value_t *)dlq_deque(&notif->payloadQ);
-            val_add_child(payloadval, eventType);
-        }
-
-        /* only use a msgid on a real event, not replay
-         * also only use if enabled in the agt_profile
-         */
-        agt_profile_t *profile = agt_get_profile();
-        if (checkfilter && profile->agt_notif_sequence_id) { 
-            snprintf((char *)numbuff, sizeof(numbuff), "%u", notif->msgid);
-            sequenceid = val_make_simval_obj(sequenceidobj, numbuff, &res);
-            if (!sequenceid) {
-                log_error("\nError: malloc failed: cannot "
-                          "add sequence-id");
-            } else {
-                val_add_child(sequenceid, topval);
-            }
-        }
-
-        notif->msg = topval;
     }
 
     /* create an RPC message header struct */
@@ -883,26 +1425,14 @@ static status_t
 
     /* check if any filtering is needed */
     if (checkfilter && sub->filterval) {
-        switch (sub->filtertyp) {
-        case OP_FILTER_SUBTREE:
-            filterpassed = 
-                agt_tree_test_filter(&msghdr,
-                                     sub->scb,
-                                     sub->filterval,
-                                     notif->event);
-            break;
-        case OP_FILTER_XPATH:
-            filterpassed = 
-                agt_xpath_test_filter(&msghdr,
-                                      sub->scb,
-                                      sub->selectval,
-                                      notif->event);
-            break;
-        case OP_FILTER_NONE:
-        default:
-            filterpassed = FALSE;
-            SET_ERROR(ERR_INTERNAL_VAL);
+        /* the filter checks read access to the selected nodes */
+        res = agt_acm_init_msg_cache(sub->scb, &msghdr);
+        if (res != NO_ERR) {
+            xml_msg_clean_hdr(&msghdr);
+            return res;
         }
+        filterpassed = test_notification_filter(sub, notif, &msghdr);
+        agt_acm_clear_msg_cache(&msghdr);
 
         if (filterpassed) {
             if (LOGDEBUG2) {
@@ -923,7 +1453,12 @@ static status_t
             xml_msg_clean_hdr(&msghdr);
             return res;
         }
-        xml_wr_full_val(sub->scb, &msghdr, notif->msg, 0);
+        out = get_notification_output(notif, sub->scb);
+        if (out) {
+            ses_putstr(sub->scb, out->body);
+        } else {
+            xml_wr_full_val(sub->scb, &msghdr, notif->msg, 0);
+        }
         ses_finish_msg(sub->scb);
 
         sub->scb->stats.outNotifications++;
@@ -969,7 +1504,7 @@ static void
     agt_not_subscription_t   *sub;
 
     /* get the oldest message in the replay buffer */
-    msg = (agt_not_msg_t *)dlq_deque(&notificationQ);
+    msg = remove_oldest_entry();
     if (msg == NULL) {
         return;
     }
@@ -1000,12 +1535,6 @@ static void
 
     agt_not_free_notification(msg);
 
-    if (notification_count > 0) {
-        notification_count--;
-    } else {
-        SET_ERROR(ERR_INTERNAL_VAL);
-    }
-
 }  /* delete_oldest_notification */
 
 
@@ -1034,6 +1563,8 @@ static agt_not_msg_t *
     }
     (void)memset(not, 0x0, sizeof(agt_not_msg_t));
     dlq_createSQue(&not->payloadQ);
+    dlq_createSQue(&not->outQ);
+    dlq_createSQue(&not->filterQ);
     if (usemsgid) {
         not->msgid = ++msgid;
         if (msgid == 0) {
@@ -1048,6 +1579,233 @@ static agt_not_msg_t *
 }  /* new_notification */
 
 
+/********************************************************************
+* FUNCTION load_stored_notification
+* 
+* Read a notification from the replay store
+* The event element is parsed back into a payloadQ,
+* so the copy can be filtered and sent like a
+* replay buffer entry
+*
+* INPUTS:
+*   thismsgid == msgid of the stored notification
+*
+* RETURNS:
+*   pointer to the malloced copy with the 'stored' flag set
+*   NULL if the entry could not be read
+*********************************************************************/
+static agt_not_msg_t * 
+    load_stored_notification (uint32 thismsgid)
+{
+    agt_not_msg_t   *not;
+    ncx_module_t    *mod;
+    obj_template_t  *notobj;
+    ses_cb_t        *scb;
+    val_value_t     *eventval, *payloadval;
+    const xmlChar   *modname, *name, *body;
+    xml_node_t       startnode;
+    xml_msg_hdr_t    msghdr;
+    status_t         res;
+    xmlChar          eventTime[TSTAMP_MIN_SIZE];
+
+    res = agt_not_store_get_entry(thismsgid, eventTime,
+                                  &modname, &name, &body);
+    if (res != NO_ERR) {
+        return NULL;
+    }
+
+    notobj = NULL;
+    mod = ncx_find_module(modname, NULL);
+    if (mod) {
+        notobj = ncx_find_object(mod, name);
+    }
+    if (notobj == NULL || !obj_is_notif(notobj)) {
+        log_warn("\nWarning: skipping stored notification <%s:%s> "
+                 "(id: %u); object not found",
+                 modname, name, thismsgid);
+        return NULL;
+    }
+
+    not = new_notification(notobj, FALSE);
+    if (!not) {
+        return NULL;
+    }
+    not->msgid = thismsgid;
+    not->stored = TRUE;
+    xml_strcpy(not->eventTime, eventTime);
+
+    scb = ses_new_dummy_scb();
+    if (!scb) {
+        agt_not_free_notification(not);
+        return NULL;
+    }
+
+    xml_msg_init_hdr(&msghdr);
+    xml_init_node(&startnode);
+    eventval = NULL;
+
+    /* the body points into the store mapping; no other
+     * store calls are made until the parse is done
+     */
+    res = xml_get_reader_from_buffer((const char *)body,
+                                     (int)xml_strlen(body),
+                                     &scb->reader);
+    if (res == NO_ERR) {
+        res = agt_xml_consume_node(scb, &startnode,
+                                   NCX_LAYER_CONTENT, &msghdr);
+    }
+    if (res == NO_ERR) {
+        eventval = val_new_value();
+        if (!eventval) {
+            res = ERR_INTERNAL_MEM;
+        } else {
+            val_init_from_template(eventval, notobj);
+            res = agt_val_parse_nc(scb, &msghdr, notobj, &startnode,
+                                   NCX_DC_STATE, eventval);
+        }
+    }
+    if (res == NO_ERR) {
+        /* the event child nodes are the payload */
+        while ((payloadval = val_get_first_child(eventval)) != NULL) {
+            val_remove_child(payloadval);
+            dlq_enque(payloadval, &not->payloadQ);
+        }
+    }
+
+    if (eventval) {
+        val_free_value(eventval);
+    }
+    xml_clean_node(&startnode);
+    xml_msg_clean_hdr(&msghdr);
+    ses_free_scb(scb);
+
+    if (res != NO_ERR) {
+        log_warn("\nWarning: skipping stored notification <%s> "
+                 "(id: %u) that cannot be parsed (%s)",
+                 obj_get_name(notobj), thismsgid, get_error_string(res));
+        agt_not_free_notification(not);
+        return NULL;
+    }
+    return not;
+
+}  /* load_stored_notification */
+
+
+/********************************************************************
+* FUNCTION get_entry_after
+*
+* Get the entry after the specified msgid
+* Entries older than the replay buffer are read
+* from the replay store, if it is used
+*
+* INPUTS:
+*    thismsgid == get the first msg with an ID higher than this value
+*
+* RETURNS:
+*    pointer to an notification to use
+*    if the 'stored' flag is set then this is a malloced
+*    copy that must be freed by the caller
+*    NULL if none found
+*********************************************************************/
+static agt_not_msg_t *
+    get_entry_after (uint32 thismsgid)
+{
+    agt_not_msg_t  *not, *storednot;
+    uint32          idx, storeid;
+
+    idx = find_eventlog_msgid(thismsgid);
+    not = get_eventlog_entry(idx);
+    if (idx > 0 || !agt_not_store_enabled()) {
+        return not;
+    }
+
+    /* the replay buffer holds the newest stored entries,
+     * so only the entries before it are read from the store
+     */
+    for (storeid = agt_not_store_next_msgid(thismsgid);
+         storeid != 0 && (not == NULL || storeid < not->msgid);
+         storeid = agt_not_store_next_msgid(storeid)) {
+
+        storednot = load_stored_notification(storeid);
+        if (storednot) {
+            return storednot;
+        }
+    }
+    return not;
+
+} /* get_entry_after */
+
+
+/********************************************************************
+* FUNCTION store_notification
+* 
+* Append a notification to the replay store
+*
+* INPUTS:
+*   notif == notification to save
+*********************************************************************/
+static void
+    store_notification (agt_not_msg_t *notif)
+{
+    ses_cb_t        *dummy;
+    FILE            *fp;
+    char            *buff;
+    size_t           bufflen;
+    xml_msg_hdr_t    msghdr;
+    status_t         res;
+
+    if (!notif->msg) {
+        res = build_notification_msg(notif, TRUE);
+        if (res != NO_ERR) {
+            return;
+        }
+    }
+
+    dummy = ses_new_dummy_scb();
+    if (!dummy) {
+        log_error("\nError: malloc failed: cannot store notification");
+        return;
+    }
+
+    buff = NULL;
+    bufflen = 0;
+    fp = open_memstream(&buff, &bufflen);
+    if (!fp) {
+        log_error("\nError: cannot store notification (%s)",
+                  strerror(errno));
+        ses_free_scb(dummy);
+        return;
+    }
+    dummy->fp = fp;
+    dummy->indent = 0;
+
+    xml_msg_init_hdr(&msghdr);
+    xml_wr_full_val(dummy, &msghdr, notif->event, 0);
+    xml_msg_clean_hdr(&msghdr);
+
+    /* ses_free_scb closes dummy->fp; the buffer is complete after that */
+    ses_free_scb(dummy);
+
+    if (buff == NULL) {
+        log_error("\nError: malloc failed: cannot store notification");
+        return;
+    }
+
+    res = agt_not_store_add(notif->msgid,
+                            notif->eventTime,
+                            obj_get_mod_name(notif->notobj),
+                            obj_get_name(notif->notobj),
+                            (const xmlChar *)buff,
+                            (uint32)bufflen);
+    if (res != NO_ERR) {
+        log_error("\nError: cannot store notification (id: %u) (%s)",
+                  notif->msgid, get_error_string(res));
+    }
+    free(buff);
+
+}  /* store_notification */
+
+
 /********************************************************************
 * FUNCTION send_replayComplete
 *
@@ -1128,6 +1886,10 @@ static void
     sequenceidobj = NULL;
     anySubscriptions = FALSE;
     msgid = 0;
+    filterid = 0;
+    eventlog = NULL;
+    eventlog_max = 0;
+    eventlog_head = 0;
     notification_count = 0;
 
 } /* init_static_vars */
@@ -1162,10 +1924,23 @@ status_t
     agt_profile = agt_get_profile();
 
     dlq_createSQue(&subscriptionQ);
-    dlq_createSQue(&notificationQ);
     init_static_vars();
     agt_not_init_done = TRUE;
 
+    /* open the persistent replay store, if configured;
+     * the sequence-id continues from the last stored event
+     */
+    if (agt_profile->agt_eventlog_dir) {
+        res = agt_not_store_init(agt_profile->agt_eventlog_dir,
+                                 agt_profile->agt_eventlog_segsize,
+                                 agt_profile->agt_eventlog_segage,
+                                 agt_profile->agt_eventlog_segcount,
+                                 &msgid);
+        if (res != NO_ERR) {
+            return res;
+        }
+    }
+
     /* load the notifications module */
     res = ncxmod_load_module(AGT_NOT_MODULE1, 
                              NULL, 
@@ -1382,8 +2157,14 @@ status_t
     }
     val_add_child(childval, streamval);
 
-    /* set replay start time to now */
-    tstamp_datetime(tstampbuff);
+    /* set replay start time to the first stored event
+     * or to now if the replay store is not used
+     */
+    res = agt_not_store_get_entry(agt_not_store_next_msgid(0),
+                                  tstampbuff, NULL, NULL, NULL);
+    if (res != NO_ERR) {
+        tstamp_datetime(tstampbuff);
+    }
 
     /* add /netconf/streams/stream/replayLogCreationTime */
     childval = val_make_simval_obj(replayLogCreationTimeobj,
@@ -1416,8 +2197,6 @@ void
     agt_not_msg_t          *msg;
 
     if (agt_not_init_done) {
-        init_static_vars();
-
         agt_rpc_unregister_method(AGT_NOT_MODULE1, 
                                   notifications_N_create_subscription);
 
@@ -1428,11 +2207,16 @@ void
             free_subscription(sub);
         }
 
-        /* clear the notificationQ */
-        while (!dlq_empty(&notificationQ)) {
-            msg = (agt_not_msg_t *)dlq_deque(&notificationQ);
+        /* clear the replay buffer */
+        while ((msg = remove_oldest_entry()) != NULL) {
             agt_not_free_notification(msg);
         }
+        if (eventlog) {
+            m__free(eventlog);
+        }
+
+        agt_not_store_cleanup();
+        init_static_vars();
 
         agt_not_init_done = FALSE;
     }
@@ -1532,8 +2316,7 @@ uint32
                  * figure out which one to send next
                  */
                 if (sub->lastmsg) {
-                    not = (agt_not_msg_t *)
-                        dlq_nextEntry(sub->lastmsg);
+                    not = get_entry_after(sub->lastmsg->msgid);
                 } else if (sub->lastmsgid) {
                     /* use ID, back-ptr was cleared */
                     not = get_entry_after(sub->lastmsgid);
@@ -1542,8 +2325,10 @@ uint32
                     if (sub->firstreplaymsg) {
                         not = sub->firstreplaymsg;
                     } else {
-                        /* use ID, back-ptr was cleared */
-                        not = get_entry_after(sub->firstreplaymsgid);
+                        /* use ID, back-ptr was cleared or
+                         * the entry is in the replay store
+                         */
+                        not = get_entry_after(sub->firstreplaymsgid - 1);
                     }
                 }
                 if (not) {
@@ -1564,7 +2349,7 @@ uint32
                         sub->state = AGT_NOT_STATE_SHUTDOWN;
                     } else {
                         /* msg sent OK; set up next loop through fn */
-                        sub->lastmsg = not;
+                        sub->lastmsg = (not->stored) ? NULL : not;
                         sub->lastmsgid = not->msgid;
                         if (sub->lastreplaymsg == not) {
                             /* this was the last replay to send */
@@ -1575,6 +2360,9 @@ uint32
                             sub->flags |= AGT_NOT_FL_RC_READY;
                         }
                     }
+                    if (not->stored) {
+                        agt_not_free_notification(not);
+                    }
                 } else {
                     /* nothing left in the replay buffer */
                     sub->flags |= AGT_NOT_FL_RC_READY;
@@ -1601,18 +2389,18 @@ uint32
             break;
         case AGT_NOT_STATE_TIMED:
             if (sub->lastmsg) {
-                not = (agt_not_msg_t *)dlq_nextEntry(sub->lastmsg);
+                not = get_entry_after(sub->lastmsg->msgid);
             } else if (sub->lastmsgid) {
                 /* use ID, back-ptr was cleared */
                 not = get_entry_after(sub->lastmsgid);
             } else {
                 /* this is the first notification sent */
-                not = (agt_not_msg_t *)dlq_firstEntry(&notificationQ);
+                not = get_eventlog_entry(0);
             }
 
             res = NO_ERR;
             if (not) {
-                sub->lastmsg = not;
+                sub->lastmsg = (not->stored) ? NULL : not;
                 sub->lastmsgid = not->msgid;
 
                 ret = xml_strcmp(sub->stopTime, not->eventTime);
@@ -1633,6 +2421,9 @@ uint32
                     /* treat as a fatal error */
                     sub->state = AGT_NOT_STATE_SHUTDOWN;
                 }
+                if (not->stored) {
+                    agt_not_free_notification(not);
+                }
             } else {
                 /* there is no notification to send */
                 ret = xml_strcmp(sub->stopTime, nowbuff);
@@ -1649,16 +2440,16 @@ uint32
             break;
         case AGT_NOT_STATE_LIVE:
             if (sub->lastmsg) {
-                not = (agt_not_msg_t *)dlq_nextEntry(sub->lastmsg);
+                not = get_entry_after(sub->lastmsg->msgid);
             } else if (sub->lastmsgid) {
                 /* use ID, back-ptr was cleared */
                 not = get_entry_after(sub->lastmsgid);
             } else {
                 /* this is the first notification sent */
-                not = (agt_not_msg_t *)dlq_firstEntry(&notificationQ);
+                not = get_eventlog_entry(0);
             }
             if (not) {
-                sub->lastmsg = not;
+                sub->lastmsg = (not->stored) ? NULL : not;
                 sub->lastmsgid = not->msgid;
 
                 if (!agt_acm_notif_allowed(sub->scb->username,
@@ -1676,6 +2467,9 @@ uint32
                     /* treat as a fatal error */
                     sub->state = AGT_NOT_STATE_SHUTDOWN;
                 }
+                if (not->stored) {
+                    agt_not_free_notification(not);
+                }
             } /* else don't do anything */
             break;
         case AGT_NOT_STATE_SHUTDOWN:
@@ -1715,7 +2509,7 @@ void
 {
     const agt_profile_t     *agt_profile;
     agt_not_subscription_t  *sub;
-    agt_not_msg_t           *msg, *nextmsg;
+    agt_not_msg_t           *msg;
 
     uint32                   lowestmsgid;
 
@@ -1727,11 +2521,10 @@ void
     }
 
     if (!anySubscriptions) {
-        /* zap everything in the Q, since there
+        /* zap everything in the buffer, since there
          * are no subscriptions right now
          */
-        while (!dlq_empty(&notificationQ)) {
-            msg = (agt_not_msg_t *)dlq_deque(&notificationQ);
+        while ((msg = remove_oldest_entry()) != NULL) {
             agt_not_free_notification(msg);
         }
         return;
@@ -1755,18 +2548,12 @@ void
     /* keep deleting the oldest entries until the
      * lowest msg ID is passed yb in the buffer
      */
-    for (msg = (agt_not_msg_t *)dlq_firstEntry(&notificationQ);
-         msg != NULL;
-         msg = nextmsg) {
+    for (msg = get_eventlog_entry(0);
+         msg != NULL && msg->msgid < lowestmsgid;
+         msg = get_eventlog_entry(0)) {
 
-         nextmsg = (agt_not_msg_t *)dlq_nextEntry(msg);
-
-         if (msg->msgid < lowestmsgid) {
-             dlq_remove(msg);
-             agt_not_free_notification(msg);
-         } else {
-             return;
-         }
+        (void)remove_oldest_entry();
+        agt_not_free_notification(msg);
     }
     
 }  /* agt_not_clean_eventlog */
@@ -1864,6 +2651,8 @@ void
         val_free_value(notif->msg);
     }
 
+    clean_notification_cache(notif);
+
     m__free(notif);
 
 }  /* agt_not_free_notification */
@@ -1918,13 +2707,14 @@ void
 *            !!! AFTER THIS CALL
 *
 * OUTPUTS:
-*   message added to the notificationQ
+*   message added to the replay buffer
 *
 *********************************************************************/
 void
     agt_not_queue_notification (agt_not_msg_t *notif)
 {
     const agt_profile_t    *agt_profile;
+    status_t                res;
 
 #ifdef DEBUG
     if (!notif) {
@@ -1965,17 +2755,26 @@ void
         if (notification_count == agt_profile->agt_eventlog_size) {
             delete_oldest_notification();
         }
-        notification_count++;
-        dlq_enque(notif, &notificationQ);
-    } else {
-        /* not tracking the event log size 
-         * since the entries will get deleted once 
-         * they are sent to all active subscriptions
-         */
-        dlq_enque(notif, &notificationQ);
+    } /* else not limiting the event log size 
+       * since the entries will get deleted once 
+       * they are sent to all active subscriptions
+       */
+
+    res = add_eventlog_entry(notif);
+    if (res != NO_ERR) {
+        log_error("\nError: cannot add notification (id: %u) "
+                  "to the replay buffer (%s)",
+                  notif->msgid,
+                  get_error_string(res));
+        agt_not_free_notification(notif);
+        return;
     }
     agt_not_queue_notification_cb(notif);
 
+    if (agt_not_store_enabled() && notif->msgid) {
+        store_notification(notif);
+    }
+
 }  /* agt_not_queue_notification */
 
 
@@ -128,7 +128,7 @@ typedef enum agt_not_stream_t_ {
 
 
 /* one notification message that will be sent to all
- * subscriptions and kept in the replay buffer (notificationQ)
+ * subscriptions and kept in the replay buffer
  */
 typedef struct agt_not_msg_t_ {
     dlq_hdr_t                qhdr;
@@ -138,6 +138,9 @@ typedef struct agt_not_msg_t_ {
     xmlChar                  eventTime[TSTAMP_MIN_SIZE];
     val_value_t             *msg;     /* /notification element */
     val_value_t             *event;  /* ptr inside msg for filter */
+    dlq_hdr_t                outQ;    /* Q of serialized msg copies */
+    dlq_hdr_t                filterQ;  /* Q of filter group results */
+    boolean                  stored;  /* T: temp copy from replay store */
 } agt_not_msg_t;
 
 
@@ -161,6 +164,7 @@ typedef struct agt_not_subscription_t_ {
     uint32                firstreplaymsgid; /* w/firstreplaymsg is deleted */
     uint32                lastreplaymsgid;  /* w/lastreplaymsg is deleted */
     uint32                lastmsgid;        /* w/ lastmsg is deleted */
+    uint32                filterid;         /* filter group, 0 == none */
     agt_not_state_t       state;
 } agt_not_subscription_t;
 
@@ -332,7 +336,7 @@ extern void
 *            !!! AFTER THIS CALL
 *
 * OUTPUTS:
-*   message added to the notificationQ
+*   message added to the replay buffer
 *
 *********************************************************************/
 extern void
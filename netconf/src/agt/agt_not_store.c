@@ -0,0 +1,1170 @@
+/*  FILE: agt_not_store.c
+
+   Persistent notification replay store
+
+   The store is a directory of append-only segment files.
+   The last segment is open for append; the records are
+   written with one writev call each.  Every segment is
+   memory mapped for reading, and a per-segment array of
+   record offsets is kept, so a record can be found by
+   binary search on msgid or eventTime without reading
+   the event itself into the heap.
+
+   The active segment is mapped with a length of at least
+   the rotation size, so new records become visible through
+   the existing mapping as the file grows.
+
+*********************************************************************
+*                                                                   *
+*                     I N C L U D E    F I L E S                    *
+*                                                                   *
+*********************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <dirent.h>
+#include  <time.h>
+#include  <sys/types.h>
+#include  <sys/stat.h>
+#include  <sys/mman.h>
+#include  <sys/uio.h>
+
+#include "procdefs.h"
+#include "agt_not_store.h"
+#include "dlq.h"
+#include "log.h"
+#include "ncxconst.h"
+#include "status.h"
+#include "tstamp.h"
+#include "xml_util.h"
+
+
+/********************************************************************
+*                                                                   *
+*                       C O N S T A N T S                           *
+*                                                                   *
+*********************************************************************/
+
+#define NOT_STORE_MAGIC        "YUMANOT1"
+#define NOT_STORE_MAGIC_LEN    8
+#define NOT_STORE_PREFIX       "notif-"
+#define NOT_STORE_SUFFIX       ".seg"
+
+/* initial size of the record offset array in a segment */
+#define NOT_STORE_MIN_RECS     256
+
+/* records are padded to keep the headers aligned */
+#define NOT_STORE_ALIGN(L)     (((L) + 7) & ~((uint32)7))
+
+
+/********************************************************************
+*                                                                   *
+*                           T Y P E S                               *
+*                                                                   *
+*********************************************************************/
+
+/* segment file header */
+typedef struct not_store_hdr_t_ {
+    char               magic[NOT_STORE_MAGIC_LEN];
+    int64              created;
+} not_store_hdr_t;
+
+
+/* record header; followed by the modname, name and body strings */
+typedef struct not_store_rec_t_ {
+    uint32             reclen;
+    uint32             msgid;
+    xmlChar            eventTime[TSTAMP_MIN_SIZE];
+} not_store_rec_t;
+
+
+/* one segment file; kept in segQ in msgid order */
+typedef struct not_seg_t_ {
+    dlq_hdr_t          qhdr;
+    char              *filespec;    /* malloced */
+    int                fd;          /* -1 unless the active segment */
+    const uint8       *base;        /* mapping; NULL if not mapped */
+    size_t             mapsize;
+    size_t             filesize;    /* end of the last good record */
+    time_t             created;
+    uint32            *offsets;     /* malloced record offsets */
+    uint32             numrecs;
+    uint32             maxrecs;
+    uint32             firstmsgid;
+    uint32             lastmsgid;
+    xmlChar            lastTime[TSTAMP_MIN_SIZE];
+} not_seg_t;
+
+
+/********************************************************************
+*                                                                   *
+*                       V A R I A B L E S                           *
+*                                                                   *
+*********************************************************************/
+
+static boolean              store_open = FALSE;
+
+/* Q of not_seg_t */
+static dlq_hdr_t            segQ;
+
+/* number of entries in segQ */
+static uint32               segcnt;
+
+/* malloced --eventlog-dir path */
+static char                *store_dir;
+
+static uint32               store_segsize;
+static uint32               store_segage;
+static uint32               store_segcount;
+
+
+/********************************************************************
+* FUNCTION free_segment
+*
+* Unmap and free a segment control block
+*
+* INPUTS:
+*    seg == segment to free
+*********************************************************************/
+static void
+    free_segment (not_seg_t *seg)
+{
+    if (seg->base) {
+        munmap((void *)seg->base, seg->mapsize);
+    }
+    if (seg->fd >= 0) {
+        close(seg->fd);
+    }
+    if (seg->offsets) {
+        m__free(seg->offsets);
+    }
+    if (seg->filespec) {
+        m__free(seg->filespec);
+    }
+    m__free(seg);
+
+}  /* free_segment */
+
+
+/********************************************************************
+* FUNCTION new_segment_cb
+*
+* Malloc and init a segment control block
+*
+* INPUTS:
+*    msgid == first msgid of the segment; used in the file name
+*
+* RETURNS:
+*    malloced segment or NULL if malloc failed
+*********************************************************************/
+static not_seg_t *
+    new_segment_cb (uint32 msgid)
+{
+    not_seg_t  *seg;
+    size_t      len;
+
+    seg = m__getObj(not_seg_t);
+    if (!seg) {
+        return NULL;
+    }
+    memset(seg, 0x0, sizeof(not_seg_t));
+    seg->fd = -1;
+
+    len = strlen(store_dir) + 1 + sizeof(NOT_STORE_PREFIX) +
+        NCX_MAX_NUMLEN + sizeof(NOT_STORE_SUFFIX);
+    seg->filespec = (char *)m__getMem(len);
+    if (!seg->filespec) {
+        m__free(seg);
+        return NULL;
+    }
+    snprintf(seg->filespec, len, "%s/%s%010u%s",
+             store_dir, NOT_STORE_PREFIX, msgid, NOT_STORE_SUFFIX);
+    return seg;
+
+}  /* new_segment_cb */
+
+
+/********************************************************************
+* FUNCTION map_segment
+*
+* Make sure the segment mapping covers the whole file
+* The active segment is mapped up to the rotation size
+* so it does not need to be remapped as it grows
+*
+* INPUTS:
+*    seg == segment to map
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    map_segment (not_seg_t *seg)
+{
+    void      *base;
+    size_t     mapsize;
+    int        fd;
+
+    if (seg->base && seg->mapsize >= seg->filesize) {
+        return NO_ERR;
+    }
+
+    mapsize = seg->filesize;
+    if (seg->fd >= 0 && mapsize < store_segsize) {
+        mapsize = store_segsize;
+    }
+
+    fd = seg->fd;
+    if (fd < 0) {
+        fd = open(seg->filespec, O_RDONLY);
+        if (fd < 0) {
+            log_error("\nError: cannot open replay segment '%s' (%s)",
+                      seg->filespec, strerror(errno));
+            return ERR_FIL_OPEN;
+        }
+    }
+
+    base = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    if (fd != seg->fd) {
+        close(fd);
+    }
+    if (base == MAP_FAILED) {
+        log_error("\nError: cannot map replay segment '%s' (%s)",
+                  seg->filespec, strerror(errno));
+        return ERR_FIL_READ;
+    }
+
+    if (seg->base) {
+        munmap((void *)seg->base, seg->mapsize);
+    }
+    seg->base = (const uint8 *)base;
+    seg->mapsize = mapsize;
+    return NO_ERR;
+
+}  /* map_segment */
+
+
+/********************************************************************
+* FUNCTION get_record
+*
+* Get a record header from a mapped segment
+*
+* INPUTS:
+*    seg == segment to use
+*    idx == record number in the segment
+*
+* RETURNS:
+*    pointer to the record header in the mapping
+*********************************************************************/
+static const not_store_rec_t *
+    get_record (const not_seg_t *seg,
+                uint32 idx)
+{
+    return (const not_store_rec_t *)(seg->base + seg->offsets[idx]);
+
+}  /* get_record */
+
+
+/********************************************************************
+* FUNCTION add_record_offset
+*
+* Add a record to the segment index
+*
+* INPUTS:
+*    seg == segment to use
+*    offset == file offset of the record
+*    rec == record header
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    add_record_offset (not_seg_t *seg,
+                       uint32 offset,
+                       const not_store_rec_t *rec)
+{
+    uint32   *newoffsets;
+    uint32    newmax;
+
+    if (seg->numrecs == seg->maxrecs) {
+        newmax = (seg->maxrecs) ? seg->maxrecs * 2 : NOT_STORE_MIN_RECS;
+        newoffsets = (uint32 *)m__getMem(newmax * sizeof(uint32));
+        if (!newoffsets) {
+            return ERR_INTERNAL_MEM;
+        }
+        if (seg->offsets) {
+            memcpy(newoffsets, seg->offsets,
+                   seg->numrecs * sizeof(uint32));
+            m__free(seg->offsets);
+        }
+        seg->offsets = newoffsets;
+        seg->maxrecs = newmax;
+    }
+
+    if (seg->numrecs == 0) {
+        seg->firstmsgid = rec->msgid;
+    }
+    seg->offsets[seg->numrecs++] = offset;
+    seg->lastmsgid = rec->msgid;
+    memcpy(seg->lastTime, rec->eventTime, TSTAMP_MIN_SIZE);
+    return NO_ERR;
+
+}  /* add_record_offset */
+
+
+/********************************************************************
+* FUNCTION check_record
+*
+* Check that a record in a mapped segment is complete
+*
+* INPUTS:
+*    seg == segment to use
+*    offset == file offset of the record
+*    size == file size
+*    lastmsgid == msgid of the previous record
+*
+* RETURNS:
+*    TRUE if the record is valid; FALSE if not
+*********************************************************************/
+static boolean
+    check_record (const not_seg_t *seg,
+                  size_t offset,
+                  size_t size,
+                  uint32 lastmsgid)
+{
+    const not_store_rec_t  *rec;
+    const uint8            *str, *end;
+    uint32                  i;
+
+    if (offset + sizeof(not_store_rec_t) > size) {
+        return FALSE;
+    }
+    rec = (const not_store_rec_t *)(seg->base + offset);
+    if (rec->reclen < sizeof(not_store_rec_t) ||
+        rec->reclen != NOT_STORE_ALIGN(rec->reclen) ||
+        offset + rec->reclen > size ||
+        rec->msgid <= lastmsgid ||
+        memchr(rec->eventTime, 0, TSTAMP_MIN_SIZE) == NULL) {
+        return FALSE;
+    }
+
+    /* modname, name and body must all be terminated */
+    str = (const uint8 *)&rec[1];
+    end = (const uint8 *)rec + rec->reclen;
+    for (i = 0; i < 3; i++) {
+        str = memchr(str, 0, (size_t)(end - str));
+        if (str == NULL) {
+            return FALSE;
+        }
+        str++;
+    }
+    return TRUE;
+
+}  /* check_record */
+
+
+/********************************************************************
+* FUNCTION open_segment
+*
+* Open, map and index an existing segment file
+*
+* INPUTS:
+*    seg == segment with the filespec set
+*    islast == TRUE if this is the last segment, which will
+*              be opened for append and have any partial
+*              record at the end removed
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    open_segment (not_seg_t *seg,
+                  boolean islast)
+{
+    const not_store_hdr_t  *hdr;
+    const not_store_rec_t  *rec;
+    struct stat             statbuf;
+    size_t                  offset, size;
+    uint32                  lastmsgid;
+    int                     fd;
+    status_t                res;
+
+    fd = open(seg->filespec, (islast) ? (O_RDWR | O_APPEND) : O_RDONLY);
+    if (fd < 0 || fstat(fd, &statbuf) != 0) {
+        log_error("\nError: cannot open replay segment '%s' (%s)",
+                  seg->filespec, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ERR_FIL_OPEN;
+    }
+
+    size = (size_t)statbuf.st_size;
+    if (size < sizeof(not_store_hdr_t)) {
+        log_warn("\nWarning: skipping short replay segment '%s'",
+                 seg->filespec);
+        close(fd);
+        return ERR_NCX_SKIPPED;
+    }
+
+    /* map the file as a read-only segment for the scan */
+    seg->filesize = size;
+    res = map_segment(seg);
+    if (res != NO_ERR) {
+        close(fd);
+        return res;
+    }
+
+    hdr = (const not_store_hdr_t *)seg->base;
+    if (memcmp(hdr->magic, NOT_STORE_MAGIC, NOT_STORE_MAGIC_LEN)) {
+        log_warn("\nWarning: skipping replay segment '%s' "
+                 "with a bad header", seg->filespec);
+        close(fd);
+        return ERR_NCX_SKIPPED;
+    }
+    seg->created = (time_t)hdr->created;
+
+    lastmsgid = 0;
+    offset = sizeof(not_store_hdr_t);
+    while (check_record(seg, offset, size, lastmsgid)) {
+        rec = (const not_store_rec_t *)(seg->base + offset);
+        res = add_record_offset(seg, (uint32)offset, rec);
+        if (res != NO_ERR) {
+            close(fd);
+            return res;
+        }
+        lastmsgid = rec->msgid;
+        offset += rec->reclen;
+    }
+
+    if (offset != size) {
+        log_warn("\nWarning: ignoring %u bytes of partial records "
+                 "at the end of replay segment '%s'",
+                 (uint32)(size - offset), seg->filespec);
+        if (islast && ftruncate(fd, (off_t)offset) != 0) {
+            log_error("\nError: cannot truncate replay segment "
+                      "'%s' (%s)", seg->filespec, strerror(errno));
+            islast = FALSE;
+        }
+    }
+    seg->filesize = offset;
+
+    if (islast) {
+        /* remap with the active segment length */
+        seg->fd = fd;
+        munmap((void *)seg->base, seg->mapsize);
+        seg->base = NULL;
+        seg->mapsize = 0;
+        res = map_segment(seg);
+    } else {
+        close(fd);
+    }
+    return res;
+
+}  /* open_segment */
+
+
+/********************************************************************
+* FUNCTION start_segment
+*
+* Create a new segment file and make it the active segment
+* The previous active segment is closed for writing, and
+* the oldest segments are deleted if there are too many
+*
+* INPUTS:
+*    msgid == msgid of the first record that will be written
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    start_segment (uint32 msgid)
+{
+    not_seg_t        *seg, *oldseg;
+    not_store_hdr_t   hdr;
+    status_t          res;
+
+    seg = new_segment_cb(msgid);
+    if (!seg) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    seg->fd = open(seg->filespec,
+                   O_RDWR | O_APPEND | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR);
+    if (seg->fd < 0) {
+        log_error("\nError: cannot create replay segment '%s' (%s)",
+                  seg->filespec, strerror(errno));
+        free_segment(seg);
+        return ERR_FIL_OPEN;
+    }
+
+    memset(&hdr, 0x0, sizeof(not_store_hdr_t));
+    memcpy(hdr.magic, NOT_STORE_MAGIC, NOT_STORE_MAGIC_LEN);
+    seg->created = time(NULL);
+    hdr.created = (int64)seg->created;
+    if (write(seg->fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+        log_error("\nError: cannot write replay segment '%s' (%s)",
+                  seg->filespec, strerror(errno));
+        unlink(seg->filespec);
+        free_segment(seg);
+        return ERR_FIL_WRITE;
+    }
+    seg->filesize = sizeof(hdr);
+
+    res = map_segment(seg);
+    if (res != NO_ERR) {
+        unlink(seg->filespec);
+        free_segment(seg);
+        return res;
+    }
+
+    /* the old active segment is now read-only
+     * and only needs to be mapped for its real size
+     */
+    oldseg = (not_seg_t *)dlq_lastEntry(&segQ);
+    if (oldseg && oldseg->fd >= 0) {
+        close(oldseg->fd);
+        oldseg->fd = -1;
+        if (oldseg->base) {
+            munmap((void *)oldseg->base, oldseg->mapsize);
+            oldseg->base = NULL;
+            oldseg->mapsize = 0;
+        }
+        /* if this fails it is retried when the segment is read */
+        (void)map_segment(oldseg);
+    }
+
+    dlq_enque(seg, &segQ);
+    segcnt++;
+
+    if (LOGDEBUG) {
+        log_debug("\nagt_not_store: Started replay segment '%s'",
+                  seg->filespec);
+    }
+
+    while (store_segcount && segcnt > store_segcount) {
+        oldseg = (not_seg_t *)dlq_deque(&segQ);
+        segcnt--;
+        if (LOGDEBUG) {
+            log_debug("\nagt_not_store: Deleting replay segment '%s'",
+                      oldseg->filespec);
+        }
+        if (unlink(oldseg->filespec) != 0) {
+            log_warn("\nWarning: cannot delete replay segment "
+                     "'%s' (%s)", oldseg->filespec, strerror(errno));
+        }
+        free_segment(oldseg);
+    }
+    return NO_ERR;
+
+}  /* start_segment */
+
+
+/********************************************************************
+* FUNCTION find_record_msgid
+*
+* Binary search a segment for the first record with a msgid
+* higher than the specified msgid
+*
+* INPUTS:
+*    seg == mapped segment to search
+*    thismsgid == msgid to find
+*
+* RETURNS:
+*    record number of the match; seg->numrecs if none
+*********************************************************************/
+static uint32
+    find_record_msgid (const not_seg_t *seg,
+                       uint32 thismsgid)
+{
+    uint32  lo, hi, mid;
+
+    lo = 0;
+    hi = seg->numrecs;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (get_record(seg, mid)->msgid <= thismsgid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+
+}  /* find_record_msgid */
+
+
+/********************************************************************
+* FUNCTION scan_store_dir
+*
+* Find all the segment files in the store directory and add
+* them to segQ in msgid order
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    scan_store_dir (void)
+{
+    DIR             *dp;
+    struct dirent   *ep;
+    not_seg_t       *seg, *testseg;
+    unsigned int     firstmsgid;
+    int              pos;
+
+    dp = opendir(store_dir);
+    if (dp == NULL) {
+        log_error("\nError: cannot open replay store directory "
+                  "'%s' (%s)", store_dir, strerror(errno));
+        return ERR_FIL_OPEN;
+    }
+
+    while ((ep = readdir(dp)) != NULL) {
+        pos = 0;
+        if (sscanf(ep->d_name, NOT_STORE_PREFIX "%u" NOT_STORE_SUFFIX "%n",
+                   &firstmsgid, &pos) != 1 ||
+            pos == 0 || ep->d_name[pos] != 0) {
+            continue;
+        }
+
+        seg = new_segment_cb((uint32)firstmsgid);
+        if (!seg) {
+            closedir(dp);
+            return ERR_INTERNAL_MEM;
+        }
+        /* the file name is only used to sort the segments */
+        seg->firstmsgid = (uint32)firstmsgid;
+
+        for (testseg = (not_seg_t *)dlq_firstEntry(&segQ);
+             testseg != NULL;
+             testseg = (not_seg_t *)dlq_nextEntry(testseg)) {
+            if (testseg->firstmsgid > seg->firstmsgid) {
+                break;
+            }
+        }
+        if (testseg) {
+            dlq_insertAhead(seg, testseg);
+        } else {
+            dlq_enque(seg, &segQ);
+        }
+    }
+    closedir(dp);
+    return NO_ERR;
+
+}  /* scan_store_dir */
+
+
+/********************************************************************
+* FUNCTION find_entry
+*
+* Find the stored record with the specified msgid
+*
+* INPUTS:
+*    msgid == msgid to find
+*
+* RETURNS:
+*    pointer to the record in the mapping; NULL if not found
+*********************************************************************/
+static const not_store_rec_t *
+    find_entry (uint32 msgid)
+{
+    not_seg_t   *seg;
+    uint32       idx;
+
+    for (seg = (not_seg_t *)dlq_firstEntry(&segQ);
+         seg != NULL;
+         seg = (not_seg_t *)dlq_nextEntry(seg)) {
+
+        if (seg->numrecs == 0 || seg->lastmsgid < msgid) {
+            continue;
+        }
+        if (seg->firstmsgid > msgid || map_segment(seg) != NO_ERR) {
+            return NULL;
+        }
+        idx = find_record_msgid(seg, msgid - 1);
+        if (idx < seg->numrecs && get_record(seg, idx)->msgid == msgid) {
+            return get_record(seg, idx);
+        }
+        return NULL;
+    }
+    return NULL;
+
+}  /* find_entry */
+
+
+/************* E X T E R N A L    F U N C T I O N S ***************/
+
+
+/********************************************************************
+* FUNCTION agt_not_store_init
+*
+* Open the replay store in the --eventlog-dir directory
+* Any existing segment files are mapped and indexed
+*
+* INPUTS:
+*   dir == directory to use for the segment files
+*   segsize == segment rotation size in bytes
+*   segage == segment rotation age in seconds; 0 for none
+*   segcount == max number of segments to keep; 0 for no limit
+*
+* OUTPUTS:
+*   *lastmsgid == msgid of the last stored event; 0 if none
+*
+* RETURNS:
+*   status
+*********************************************************************/
+status_t
+    agt_not_store_init (const xmlChar *dir,
+                        uint32 segsize,
+                        uint32 segage,
+                        uint32 segcount,
+                        uint32 *lastmsgid)
+{
+    not_seg_t   *seg, *nextseg;
+    uint32       prevmsgid;
+    status_t     res;
+
+#ifdef DEBUG
+    if (!dir || !lastmsgid) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    }
+#endif
+
+    if (store_open) {
+        return SET_ERROR(ERR_INTERNAL_INIT_SEQ);
+    }
+
+    *lastmsgid = 0;
+    dlq_createSQue(&segQ);
+    segcnt = 0;
+    store_segsize = segsize;
+    store_segage = segage;
+    store_segcount = segcount;
+
+    store_dir = (char *)xml_strdup(dir);
+    if (!store_dir) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    if (mkdir(store_dir, S_IRWXU) != 0 && errno != EEXIST) {
+        log_error("\nError: cannot create replay store directory "
+                  "'%s' (%s)", store_dir, strerror(errno));
+        m__free(store_dir);
+        store_dir = NULL;
+        return ERR_FIL_OPEN;
+    }
+    store_open = TRUE;
+
+    res = scan_store_dir();
+    if (res != NO_ERR) {
+        agt_not_store_cleanup();
+        return res;
+    }
+
+    /* open all the segments; drop any that cannot be read,
+     * or that would break the msgid order
+     */
+    prevmsgid = 0;
+    for (seg = (not_seg_t *)dlq_firstEntry(&segQ);
+         seg != NULL;
+         seg = nextseg) {
+
+        nextseg = (not_seg_t *)dlq_nextEntry(seg);
+        res = open_segment(seg, (nextseg) ? FALSE : TRUE);
+        if (res == NO_ERR && seg->numrecs &&
+            seg->firstmsgid <= prevmsgid) {
+            log_warn("\nWarning: skipping replay segment '%s' "
+                     "that is out of sequence", seg->filespec);
+            res = ERR_NCX_SKIPPED;
+        }
+        if (res == ERR_INTERNAL_MEM) {
+            agt_not_store_cleanup();
+            return res;
+        }
+        if (res != NO_ERR) {
+            dlq_remove(seg);
+            free_segment(seg);
+            continue;
+        }
+        if (seg->numrecs) {
+            prevmsgid = seg->lastmsgid;
+        }
+        segcnt++;
+    }
+
+    *lastmsgid = prevmsgid;
+
+    if (LOGINFO) {
+        log_info("\nagt_not_store: Opened replay store '%s' with %u "
+                 "segments (last sequence-id: %u)",
+                 store_dir, segcnt, prevmsgid);
+    }
+    return NO_ERR;
+
+}  /* agt_not_store_init */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_cleanup
+*
+* Close the replay store and unmap all the segments
+*
+*********************************************************************/
+void
+    agt_not_store_cleanup (void)
+{
+    not_seg_t   *seg;
+
+    if (!store_open) {
+        return;
+    }
+
+    while (!dlq_empty(&segQ)) {
+        seg = (not_seg_t *)dlq_deque(&segQ);
+        free_segment(seg);
+    }
+    segcnt = 0;
+
+    if (store_dir) {
+        m__free(store_dir);
+        store_dir = NULL;
+    }
+    store_open = FALSE;
+
+}  /* agt_not_store_cleanup */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_enabled
+*
+* Check if the replay store is in use
+*
+* RETURNS:
+*   TRUE if the store is open; FALSE otherwise
+*********************************************************************/
+boolean
+    agt_not_store_enabled (void)
+{
+    return store_open;
+
+}  /* agt_not_store_enabled */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_add
+*
+* Append one notification record to the current segment
+* A new segment is started first if the current one
+* has reached the rotation size or age
+*
+* INPUTS:
+*   msgid == sequence-id of the event; must be higher than
+*            the msgid of the last stored record
+*   eventTime == UTC date-time string of the event
+*   modname == module name of the notification object
+*   name == name of the notification object
+*   body == XML of the event element
+*   bodylen == number of bytes in body
+*
+* RETURNS:
+*   status
+*********************************************************************/
+status_t
+    agt_not_store_add (uint32 msgid,
+                       const xmlChar *eventTime,
+                       const xmlChar *modname,
+                       const xmlChar *name,
+                       const xmlChar *body,
+                       uint32 bodylen)
+{
+    not_seg_t        *seg;
+    not_store_rec_t   rec;
+    struct iovec      iov[5];
+    static const uint8 pad[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    uint32            len, modlen, namelen;
+    ssize_t           retlen;
+    status_t          res;
+
+#ifdef DEBUG
+    if (!eventTime || !modname || !name || !body) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    }
+#endif
+
+    if (!store_open) {
+        return SET_ERROR(ERR_INTERNAL_INIT_SEQ);
+    }
+
+    modlen = xml_strlen(modname) + 1;
+    namelen = xml_strlen(name) + 1;
+    len = sizeof(not_store_rec_t) + modlen + namelen + bodylen + 1;
+
+    memset(&rec, 0x0, sizeof(not_store_rec_t));
+    rec.reclen = NOT_STORE_ALIGN(len);
+    rec.msgid = msgid;
+    xml_strncpy(rec.eventTime, eventTime, TSTAMP_MIN_SIZE - 1);
+
+    seg = (not_seg_t *)dlq_lastEntry(&segQ);
+    if (seg && seg->numrecs && msgid <= seg->lastmsgid) {
+        return SET_ERROR(ERR_NCX_INVALID_VALUE);
+    }
+
+    if (seg == NULL || seg->fd < 0 ||
+        (seg->numrecs &&
+         ((seg->filesize + rec.reclen > store_segsize) ||
+          (store_segage &&
+           time(NULL) - seg->created >= (time_t)store_segage)))) {
+        res = start_segment(msgid);
+        if (res != NO_ERR) {
+            return res;
+        }
+        seg = (not_seg_t *)dlq_lastEntry(&segQ);
+    }
+
+    /* the body includes its terminating zero byte */
+    iov[0].iov_base = &rec;
+    iov[0].iov_len = sizeof(not_store_rec_t);
+    iov[1].iov_base = (void *)modname;
+    iov[1].iov_len = modlen;
+    iov[2].iov_base = (void *)name;
+    iov[2].iov_len = namelen;
+    iov[3].iov_base = (void *)body;
+    iov[3].iov_len = bodylen;
+    iov[4].iov_base = (void *)pad;
+    iov[4].iov_len = 1 + rec.reclen - len;
+
+    retlen = writev(seg->fd, iov, 5);
+    if (retlen != (ssize_t)rec.reclen) {
+        log_error("\nError: cannot write replay segment '%s' (%s)",
+                  seg->filespec,
+                  (retlen < 0) ? strerror(errno) : "short write");
+        if (retlen > 0 && ftruncate(seg->fd, (off_t)seg->filesize) != 0) {
+            /* cannot remove the partial record; stop using
+             * this segment so it is not appended after it
+             */
+            close(seg->fd);
+            seg->fd = -1;
+        }
+        return ERR_FIL_WRITE;
+    }
+
+    res = add_record_offset(seg, (uint32)seg->filesize, &rec);
+    seg->filesize += rec.reclen;
+    return res;
+
+}  /* agt_not_store_add */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_find_time
+*
+* Find the first stored record with an eventTime at
+* (or after) the specified time
+*
+* INPUTS:
+*   tstamp == UTC date-time string to find
+*   after == TRUE to skip records with the same eventTime
+*            FALSE to include records with the same eventTime
+*
+* RETURNS:
+*   msgid of the first match; 0 if no record matches
+*********************************************************************/
+uint32
+    agt_not_store_find_time (const xmlChar *tstamp,
+                             boolean after)
+{
+    not_seg_t   *seg;
+    uint32       lo, hi, mid;
+    int          ret;
+
+    if (!store_open) {
+        return 0;
+    }
+
+    for (seg = (not_seg_t *)dlq_firstEntry(&segQ);
+         seg != NULL;
+         seg = (not_seg_t *)dlq_nextEntry(seg)) {
+
+        if (seg->numrecs == 0) {
+            continue;
+        }
+
+        /* skip the segments that end before the time */
+        ret = xml_strcmp(seg->lastTime, tstamp);
+        if (ret < 0 || (after && ret == 0)) {
+            continue;
+        }
+
+        if (map_segment(seg) != NO_ERR) {
+            return 0;
+        }
+
+        lo = 0;
+        hi = seg->numrecs;
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+            ret = xml_strcmp(get_record(seg, mid)->eventTime, tstamp);
+            if (ret < 0 || (after && ret == 0)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return get_record(seg, lo)->msgid;
+    }
+    return 0;
+
+}  /* agt_not_store_find_time */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_next_msgid
+*
+* Get the msgid of the first stored record after the specified msgid
+*
+* INPUTS:
+*   thismsgid == get the first record with an ID higher than this
+*
+* RETURNS:
+*   msgid of the record; 0 if none found
+*********************************************************************/
+uint32
+    agt_not_store_next_msgid (uint32 thismsgid)
+{
+    not_seg_t   *seg;
+    uint32       idx;
+
+    if (!store_open) {
+        return 0;
+    }
+
+    for (seg = (not_seg_t *)dlq_firstEntry(&segQ);
+         seg != NULL;
+         seg = (not_seg_t *)dlq_nextEntry(seg)) {
+
+        if (seg->numrecs == 0 || seg->lastmsgid <= thismsgid) {
+            continue;
+        }
+        if (seg->firstmsgid > thismsgid) {
+            return seg->firstmsgid;
+        }
+        if (map_segment(seg) != NO_ERR) {
+            return 0;
+        }
+        idx = find_record_msgid(seg, thismsgid);
+        return get_record(seg, idx)->msgid;
+    }
+    return 0;
+
+}  /* agt_not_store_next_msgid */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_prev_msgid
+*
+* Get the msgid of the last stored record before the specified msgid
+*
+* INPUTS:
+*   thismsgid == get the last record with an ID lower than this
+*                AGT_NOT_STORE_LAST_MSGID to get the last record
+*
+* RETURNS:
+*   msgid of the record; 0 if none found
+*********************************************************************/
+uint32
+    agt_not_store_prev_msgid (uint32 thismsgid)
+{
+    not_seg_t   *seg;
+    uint32       idx;
+
+    if (!store_open) {
+        return 0;
+    }
+
+    for (seg = (not_seg_t *)dlq_lastEntry(&segQ);
+         seg != NULL;
+         seg = (not_seg_t *)dlq_prevEntry(seg)) {
+
+        if (seg->numrecs == 0 || seg->firstmsgid >= thismsgid) {
+            continue;
+        }
+        if (thismsgid == AGT_NOT_STORE_LAST_MSGID ||
+            seg->lastmsgid < thismsgid) {
+            return seg->lastmsgid;
+        }
+        if (map_segment(seg) != NO_ERR) {
+            return 0;
+        }
+        idx = find_record_msgid(seg, thismsgid - 1);
+        return get_record(seg, idx - 1)->msgid;
+    }
+    return 0;
+
+}  /* agt_not_store_prev_msgid */
+
+
+/********************************************************************
+* FUNCTION agt_not_store_get_entry
+*
+* Get the contents of the stored record with the specified msgid
+* The returned strings point into the segment mapping and
+* are only valid until the next agt_not_store call
+*
+* INPUTS:
+*   msgid == msgid of the record to get
+*   eventTime == buffer of TSTAMP_MIN_SIZE bytes to get the
+*                eventTime string; NULL if not needed
+*   modname == address of return module name; NULL if not needed
+*   name == address of return notification name; NULL if not needed
+*   body == address of return event XML; NULL if not needed
+*
+* OUTPUTS:
+*   non-NULL return parameters are set
+*
+* RETURNS:
+*   status; ERR_NCX_NOT_FOUND if the record is not in the store
+*********************************************************************/
+status_t
+    agt_not_store_get_entry (uint32 msgid,
+                             xmlChar *eventTime,
+                             const xmlChar **modname,
+                             const xmlChar **name,
+                             const xmlChar **body)
+{
+    const not_store_rec_t  *rec;
+    const xmlChar          *str;
+
+    if (!store_open) {
+        return ERR_NCX_NOT_FOUND;
+    }
+
+    rec = find_entry(msgid);
+    if (rec == NULL) {
+        return ERR_NCX_NOT_FOUND;
+    }
+
+    if (eventTime) {
+        memcpy(eventTime, rec->eventTime, TSTAMP_MIN_SIZE);
+    }
+
+    str = (const xmlChar *)&rec[1];
+    if (modname) {
+        *modname = str;
+    }
+    str += xml_strlen(str) + 1;
+    if (name) {
+        *name = str;
+    }
+    str += xml_strlen(str) + 1;
+    if (body) {
+        *body = str;
+    }
+    return NO_ERR;
+
+}  /* agt_not_store_get_entry */
+
+
+/* END file agt_not_store.c */
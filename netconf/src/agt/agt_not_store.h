@@ -0,0 +1,224 @@
+#ifndef _H_agt_not_store
+#define _H_agt_not_store
+/*  FILE: agt_not_store.h
+*********************************************************************
+*                                                                   *
+*                         P U R P O S E                             *
+*                                                                   *
+*********************************************************************
+
+   Persistent notification replay store
+
+   Notifications are appended to segment files in the
+   --eventlog-dir directory.  The segments are memory mapped
+   to replay old events, so the replay log can hold more
+   events than the in-memory --eventlog-size buffer and
+   survive a server restart.
+
+   Each segment file is named notif-<first msgid>.seg and
+   holds a file header (magic string and creation time)
+   followed by a sequence of records:
+
+      uint32   reclen       total record length, 8-byte aligned
+      uint32   msgid        sequence-id of the event
+      xmlChar  eventTime[TSTAMP_MIN_SIZE]  UTC date-time string
+      xmlChar  modname[]    module of the notification object
+      xmlChar  name[]       name of the notification object
+      xmlChar  body[]       XML of the event element
+
+   All the strings are zero-terminated.  The last segment is
+   the only one that is written, and only with append.  The records in all
+   the segments are in msgid and eventTime order.
+
+*/
+
+#include <xmlstring.h>
+
+#ifndef _H_ncxconst
+#include "ncxconst.h"
+#endif
+
+#ifndef _H_status
+#include "status.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************************************************************
+*                                                                   *
+*                         C O N S T A N T S                         *
+*                                                                   *
+*********************************************************************/
+
+/* last msgid value; used to find the last record in the store */
+#define AGT_NOT_STORE_LAST_MSGID   NCX_MAX_UINT
+
+
+/********************************************************************
+*                                                                   *
+*                        F U N C T I O N S                          *
+*                                                                   *
+*********************************************************************/
+
+
+/********************************************************************
+* FUNCTION agt_not_store_init
+*
+* Open the replay store in the --eventlog-dir directory
+* Any existing segment files are mapped and indexed
+*
+* INPUTS:
+*   dir == directory to use for the segment files
+*   segsize == segment rotation size in bytes
+*   segage == segment rotation age in seconds; 0 for none
+*   segcount == max number of segments to keep; 0 for no limit
+*
+* OUTPUTS:
+*   *lastmsgid == msgid of the last stored event; 0 if none
+*
+* RETURNS:
+*   status
+*********************************************************************/
+extern status_t
+    agt_not_store_init (const xmlChar *dir,
+                        uint32 segsize,
+                        uint32 segage,
+                        uint32 segcount,
+                        uint32 *lastmsgid);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_cleanup
+*
+* Close the replay store and unmap all the segments
+*
+*********************************************************************/
+extern void
+    agt_not_store_cleanup (void);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_enabled
+*
+* Check if the replay store is in use
+*
+* RETURNS:
+*   TRUE if the store is open; FALSE otherwise
+*********************************************************************/
+extern boolean
+    agt_not_store_enabled (void);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_add
+*
+* Append one notification record to the current segment
+* A new segment is started first if the current one
+* has reached the rotation size or age
+*
+* INPUTS:
+*   msgid == sequence-id of the event; must be higher than
+*            the msgid of the last stored record
+*   eventTime == UTC date-time string of the event
+*   modname == module name of the notification object
+*   name == name of the notification object
+*   body == XML of the event element
+*   bodylen == number of bytes in body
+*
+* RETURNS:
+*   status
+*********************************************************************/
+extern status_t
+    agt_not_store_add (uint32 msgid,
+                       const xmlChar *eventTime,
+                       const xmlChar *modname,
+                       const xmlChar *name,
+                       const xmlChar *body,
+                       uint32 bodylen);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_find_time
+*
+* Find the first stored record with an eventTime at
+* (or after) the specified time
+*
+* INPUTS:
+*   tstamp == UTC date-time string to find
+*   after == TRUE to skip records with the same eventTime
+*            FALSE to include records with the same eventTime
+*
+* RETURNS:
+*   msgid of the first match; 0 if no record matches
+*********************************************************************/
+extern uint32
+    agt_not_store_find_time (const xmlChar *tstamp,
+                             boolean after);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_next_msgid
+*
+* Get the msgid of the first stored record after the specified msgid
+*
+* INPUTS:
+*   thismsgid == get the first record with an ID higher than this
+*
+* RETURNS:
+*   msgid of the record; 0 if none found
+*********************************************************************/
+extern uint32
+    agt_not_store_next_msgid (uint32 thismsgid);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_prev_msgid
+*
+* Get the msgid of the last stored record before the specified msgid
+*
+* INPUTS:
+*   thismsgid == get the last record with an ID lower than this
+*                AGT_NOT_STORE_LAST_MSGID to get the last record
+*
+* RETURNS:
+*   msgid of the record; 0 if none found
+*********************************************************************/
+extern uint32
+    agt_not_store_prev_msgid (uint32 thismsgid);
+
+
+/********************************************************************
+* FUNCTION agt_not_store_get_entry
+*
+* Get the contents of the stored record with the specified msgid
+* The returned strings point into the segment mapping and
+* are only valid until the next agt_not_store call
+*
+* INPUTS:
+*   msgid == msgid of the record to get
+*   eventTime == buffer of TSTAMP_MIN_SIZE bytes to get the
+*                eventTime string; NULL if not needed
+*   modname == address of return module name; NULL if not needed
+*   name == address of return notification name; NULL if not needed
+*   body == address of return event XML; NULL if not needed
+*
+* OUTPUTS:
+*   non-NULL return parameters are set
+*
+* RETURNS:
+*   status; ERR_NCX_NOT_FOUND if the record is not in the store
+*********************************************************************/
+extern status_t
+    agt_not_store_get_entry (uint32 msgid,
+                             xmlChar *eventTime,
+                             const xmlChar **modname,
+                             const xmlChar **name,
+                             const xmlChar **body);
+
+#ifdef __cplusplus
+}  /* end extern 'C' */
+#endif
+
+#endif            /* _H_agt_not_store */
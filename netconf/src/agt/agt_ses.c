@@ -290,6 +290,9 @@ status_t
     next_sesid = 1;
     mysesmod = NULL;
 
+    /* limit for the adaptive output buffer size */
+    ses_msg_set_max_outbuff_size(agt_profile->agt_max_outbuff_size);
+
     agttotals = ses_get_total_stats();
     memset(agttotals, 0x0, sizeof(ses_total_stats_t));
     tstamp_datetime(agttotals->startTime);
@@ -1093,6 +1096,36 @@ void
 
 }  /* agt_ses_fill_writeset */
 
+
+/********************************************************************
+* FUNCTION agt_ses_next_outready
+*
+* Drain one session from the ses_msg outreadyQ
+* Used by the agt_ncxserver epoll loop instead of
+* agt_ses_fill_writeset
+*
+* RETURNS:
+*    pointer to the next session with output pending
+*    NULL if the outreadyQ is empty
+*********************************************************************/
+ses_cb_t *
+    agt_ses_next_outready (void)
+{
+    ses_ready_t *rdy;
+    ses_cb_t *scb;
+
+    for (rdy = ses_msg_get_first_outready();
+         rdy != NULL;
+         rdy = ses_msg_get_first_outready()) {
+        scb = agtses[rdy->sid];
+        if (scb && scb->state <= SES_ST_SHUTDOWN_REQ) {
+            return scb;
+        }
+    }
+    return NULL;
+
+}  /* agt_ses_next_outready */
+
 /********************************************************************
 * FUNCTION agt_ses_get_inSessions
 *
@@ -292,6 +292,21 @@ extern void
 			   int *maxfdnum);
 
 
+/********************************************************************
+* FUNCTION agt_ses_next_outready
+*
+* Drain one session from the ses_msg outreadyQ
+* Used by the agt_ncxserver epoll loop instead of
+* agt_ses_fill_writeset
+*
+* RETURNS:
+*    pointer to the next session with output pending
+*    NULL if the outreadyQ is empty
+*********************************************************************/
+extern ses_cb_t *
+    agt_ses_next_outready (void);
+
+
 /********************************************************************
 * FUNCTION agt_ses_get_inSessions
 *
@@ -2494,6 +2494,53 @@ status_t
 }  /* agt_add_top_virtual */
 
 
+/********************************************************************
+* FUNCTION agt_add_top_virtual_stream
+*
+* make a val_value_t struct for a specified virtual 
+* top-level container or list whose child entries are
+* returned one at a time by the callback function
+* (see ncx/getcb.h getcb_stream_fn_t)
+*
+* INPUTS:
+*   obj == object node of the virtual data node to create
+*   callbackfn == streaming get callback function to install
+*
+* RETURNS:
+*   status
+*********************************************************************/
+status_t
+    agt_add_top_virtual_stream (obj_template_t *obj,
+                                getcb_stream_fn_t callbackfn)
+{
+    val_value_t     *rootval, *nodeval;
+
+#ifdef DEBUG
+    if (obj == NULL || callbackfn == NULL) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    }
+#endif
+
+    if (!obj_has_children(obj)) {
+        return ERR_NCX_WRONG_TYPE;
+    }
+
+    rootval = cfg_get_root(NCX_CFGID_RUNNING);
+    if (rootval == NULL) {
+        return ERR_NCX_OPERATION_FAILED;
+    }
+
+    nodeval = val_new_value();
+    if (!nodeval) {
+        return ERR_INTERNAL_MEM;
+    }
+    val_init_virtual_stream(nodeval, (void *)callbackfn, obj);
+    val_add_child_sorted(nodeval, rootval);
+    return NO_ERR;
+
+}  /* agt_add_top_virtual_stream */
+
+
 /********************************************************************
 * FUNCTION agt_add_top_container
 *
@@ -871,6 +871,26 @@ extern status_t
                          getcb_fn_t callbackfn);
 
 
+/********************************************************************
+* FUNCTION agt_add_top_virtual_stream
+*
+* make a val_value_t struct for a specified virtual 
+* top-level container or list whose child entries are
+* returned one at a time by the callback function
+* (see ncx/getcb.h getcb_stream_fn_t)
+*
+* INPUTS:
+*   obj == object node of the virtual data node to create
+*   callbackfn == streaming get callback function to install
+*
+* RETURNS:
+*   status
+*********************************************************************/
+extern status_t
+    agt_add_top_virtual_stream (obj_template_t *obj,
+                                getcb_stream_fn_t callbackfn);
+
+
 /********************************************************************
 * FUNCTION agt_add_top_container
 *
@@ -32,6 +32,7 @@ date         init     comment
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <string.h>
 #include <assert.h>
 
 #include "procdefs.h"
@@ -45,6 +46,7 @@ date         init     comment
 #include "agt_util.h"
 #include "agt_val.h"
 #include "agt_val_parse.h"
+#include "bobhash.h"
 #include "cap.h"
 #include "cfg.h"
 #include "dlq.h"
@@ -74,6 +76,23 @@ date         init     comment
 *                                                                   *
 *********************************************************************/
 
+/* minimum hash table size for the unique-stmt test sets,
+ * expressed as the number of hash bits
+ */
+#define UNIQUE_HASH_MIN_BITS     4
+
+#define UNIQUE_HASH_INIT         0x3a9f15c7
+
+/* max number of edited nodes to check before all the
+ * commit tests are run for every instance
+ */
+#define COMMIT_TEST_MAX_EDITS    1024
+
+/* max number of edited anchor instances to test one at a time
+ * before a commit test is run for every instance
+ */
+#define COMMIT_TEST_MAX_ANCHORS  256
+
 /* recursive callback function forward decls */
 static status_t
     invoke_btype_cb (agt_cbtyp_t cbtyp,
@@ -114,9 +133,29 @@ typedef struct unique_set_t_ {
     dlq_hdr_t  qhdr;
     dlq_hdr_t  uniqueQ;   /* Q of val_unique_t */
     val_value_t *valnode;  /* value tree back-ptr */
+    struct unique_set_t_ *hashnext;  /* hash bucket chain */
+    uint32     hash;       /* hash of the canonical tuple values */
+    boolean    nomatch;    /* cannot match any other test set */
+    boolean    isdup;      /* a later test set has the same tuple */
 } unique_set_t;
 
 
+/* edited nodes of 1 object, for commit test pruning */
+typedef struct commit_edit_t_ {
+    dlq_hdr_t        qhdr;
+    obj_template_t  *obj;
+    dlq_hdr_t        nodeQ;    /* Q of agt_cfg_nodeptr_t */
+} commit_edit_t;
+
+
+/* all the edited nodes for a commit test run */
+typedef struct commit_edits_t_ {
+    dlq_hdr_t        editQ;    /* Q of commit_edit_t */
+    uint32           nodecount;
+    boolean          fulltest;   /* edits not known; run all tests */
+} commit_edits_t;
+
+
 /********************************************************************
 *                                                                   *
 *                       V A R I A B L E S                           *
@@ -228,6 +267,37 @@ static void
 }  /* clean_node */
 
 
+/********************************************************************
+* FUNCTION node_in_config
+* 
+* Check if a value node is in the data tree of a config
+*
+* INPUTS:
+*   val == node to check
+*   cfgid == config ID to check
+*
+* RETURNS:
+*   TRUE if the topmost ancestor of val is the config root
+*   FALSE otherwise
+*********************************************************************/
+static boolean
+    node_in_config (const val_value_t *val,
+                    ncx_cfg_t cfgid)
+{
+    const cfg_template_t *cfg = cfg_get_config_id(cfgid);
+
+    if (val == NULL || cfg == NULL) {
+        return FALSE;
+    }
+
+    while (val->parent) {
+        val = val->parent;
+    }
+    return (val == cfg->root) ? TRUE : FALSE;
+
+}  /* node_in_config */
+
+
 /********************************************************************
  * Create and store a change-audit record, if needed
  * this function generates a log message if log level 
@@ -858,6 +928,7 @@ static status_t
                                      child->name);
             if (testval) {
                 dlq_insertAhead(child, testval);
+                val_clear_child_index(parent);
             } else {
                 val_add_child_sorted(child, parent);
             }
@@ -882,6 +953,7 @@ static status_t
                     } else {
                         dlq_insertAfter(child, testval);
                     }
+                    val_clear_child_index(parent);
                 } else {
                     SET_ERROR(ERR_NCX_INSERT_MISSING_INSTANCE);
                     val_add_child_sorted(child, parent);
@@ -2617,9 +2689,14 @@ static void
         }
     }
 
+    /* a leaf merged by <commit> can be restored to the candidate;
+     * it has to stay dirty there, so the refill from running
+     * copies it back   */
     if (undo->newnode) {
         if (msg->rpc_txcb->cfg_id == NCX_CFGID_RUNNING) {
-            val_clear_dirty_flag(undo->newnode);
+            if (node_in_config(undo->newnode, NCX_CFGID_RUNNING)) {
+                val_clear_dirty_flag(undo->newnode);
+            }
         } else {
             val_set_dirty_flag(undo->newnode);
         }
@@ -2627,7 +2704,9 @@ static void
 
     if (undo->curnode) {
         if (msg->rpc_txcb->cfg_id == NCX_CFGID_RUNNING) {
-            val_clear_dirty_flag(undo->curnode);
+            if (node_in_config(undo->curnode, NCX_CFGID_RUNNING)) {
+                val_clear_dirty_flag(undo->curnode);
+            }
         } else {
             val_set_dirty_flag(undo->curnode);
         }
@@ -3479,6 +3558,287 @@ static status_t
 } /* make_unique_testset */
 
 
+/********************************************************************
+* FUNCTION hash_unique_testset
+* 
+* Hash the canonical string values of a unique test set.
+* The hash is only consistent with compare_unique_testsets
+* if each val_unique_t result is exactly 1 simple node
+*
+* INPUTS:
+*   uset == unique test set to hash
+*
+* OUTPUTS:
+*   uset->hash is set if NO_ERR
+*
+* RETURNS:
+*   NO_ERR if the test set has been hashed
+*   ERR_NCX_SKIPPED if the test set can never match (password)
+*   ERR_NCX_CANCELED if the test set cannot be hashed and
+*     the brute force compare has to be used instead
+*********************************************************************/
+static status_t
+    hash_unique_testset (unique_set_t *uset)
+{
+    ub4 h = UNIQUE_HASH_INIT;
+
+    val_unique_t *unival = (val_unique_t *)dlq_firstEntry(&uset->uniqueQ);
+    for (; unival; unival = (val_unique_t *)dlq_nextEntry(unival)) {
+        xpath_resnode_t *resnode = 
+            xpath_get_first_resnode(unival->pcb->result);
+        if (resnode == NULL || xpath_get_next_resnode(resnode) != NULL) {
+            return ERR_NCX_CANCELED;
+        }
+
+        val_value_t *val = xpath_get_resnode_valptr(resnode);
+        if (val == NULL || !typ_is_simple(val->btyp)) {
+            return ERR_NCX_CANCELED;
+        }
+
+        /* the XPath compare never matches a password */
+        if (obj_is_password(val->obj)) {
+            return ERR_NCX_SKIPPED;
+        }
+
+        val_value_t *useval = val;
+        if (val_is_virtual(val)) {
+            status_t res = NO_ERR;
+            useval = val_get_virtual_value(NULL, val, &res);
+            if (useval == NULL) {
+                return res;
+            }
+        }
+
+        /* use the same string the XPath compare will use */
+        xmlChar *buffer = NULL;
+        const xmlChar *str = NULL;
+        if (typ_is_string(val->btyp)) {
+            str = VAL_STR(useval);
+        } else {
+            buffer = val_make_sprintf_string(useval);
+            if (buffer == NULL) {
+                return ERR_INTERNAL_MEM;
+            }
+            str = buffer;
+        }
+        if (str == NULL) {
+            str = EMPTY_STRING;
+        }
+
+        /* hash the terminating zero to separate the components */
+        h = bobhash(str, xml_strlen(str) + 1, h);
+
+        if (buffer) {
+            m__free(buffer);
+        }
+    }
+
+    uset->hash = (uint32)h;
+    return NO_ERR;
+
+} /* hash_unique_testset */
+
+
+/********************************************************************
+* FUNCTION record_unique_dups
+* 
+* Record a unique-stmt error for each test set that has
+* been flagged as a duplicate of a later test set
+*
+* INPUTS:
+*   scb == session control block (may be NULL; no session stats)
+*   msg == xml_msg_hdr t from msg in progress 
+*       == NULL MEANS NO RPC-ERRORS ARE RECORDED
+*   usetQ == Q of unique_set_t to check
+*
+* RETURNS:
+*   status of the operation, NO_ERR if no duplicates found
+*********************************************************************/
+static status_t 
+    record_unique_dups (ses_cb_t *scb,
+                        xml_msg_hdr_t *msg,
+                        dlq_hdr_t *usetQ)
+{
+    status_t retres = NO_ERR;
+
+    unique_set_t *uset = (unique_set_t *)dlq_firstEntry(usetQ);
+    for (; uset; uset = (unique_set_t *)dlq_nextEntry(uset)) {
+        if (uset->isdup) {
+            agt_record_unique_error(scb, msg, uset->valnode,
+                                    &uset->uniqueQ);
+            uset->valnode->res = ERR_NCX_UNIQUE_TEST_FAILED;
+            retres = ERR_NCX_UNIQUE_TEST_FAILED;
+        }
+    }
+    return retres;
+
+} /* record_unique_dups */
+
+
+/********************************************************************
+* FUNCTION hashed_unique_check
+* 
+* Find the duplicate test sets with a hash table keyed by the
+* canonical values of each tuple; O(n) expected instead of
+* comparing every pair of test sets.  Hash matches are confirmed
+* with compare_unique_testsets so the test is unchanged.
+*
+* Each test set is flagged if any later test set has the same
+* tuple, so the errors are the same as the brute force compare
+*
+* INPUTS:
+*   scb == session control block (may be NULL; no session stats)
+*   msg == xml_msg_hdr t from msg in progress 
+*       == NULL MEANS NO RPC-ERRORS ARE RECORDED
+*   usetQ == Q of unique_set_t to check
+*   usetcnt == number of entries in usetQ
+*
+* OUTPUTS:
+*   if msg not NULL:
+*      msg->msg_errQ may have rpc_err_rec_t structs added to it 
+*
+* RETURNS:
+*   status of the operation, NO_ERR if no validation errors found
+*   ERR_NCX_CANCELED if the test sets cannot be hashed; no errors
+*     have been recorded in this case
+*********************************************************************/
+static status_t 
+    hashed_unique_check (ses_cb_t *scb,
+                         xml_msg_hdr_t *msg,
+                         dlq_hdr_t *usetQ,
+                         uint32 usetcnt)
+{
+    unique_set_t *uset;
+
+    /* hash all the test sets before anything is flagged so
+     * the brute force compare can still be used instead */
+    for (uset = (unique_set_t *)dlq_firstEntry(usetQ); uset;
+         uset = (unique_set_t *)dlq_nextEntry(uset)) {
+
+        uset->hashnext = NULL;
+        uset->isdup = FALSE;
+        uset->nomatch = FALSE;
+
+        if (uset->valnode->res == ERR_NCX_UNIQUE_TEST_FAILED) {
+            /* already flagged by another unique-stmt */
+            uset->nomatch = TRUE;
+            continue;
+        }
+
+        status_t res = hash_unique_testset(uset);
+        if (res == ERR_NCX_SKIPPED) {
+            uset->nomatch = TRUE;
+        } else if (res != NO_ERR) {
+            return res;
+        }
+    }
+
+    uint32 bits = UNIQUE_HASH_MIN_BITS;
+    while (hashsize(bits) < usetcnt && bits < 24) {
+        bits++;
+    }
+
+    unique_set_t **hashtab = 
+        (unique_set_t **)m__getMem(hashsize(bits) * sizeof(unique_set_t *));
+    if (hashtab == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(hashtab, 0x0, hashsize(bits) * sizeof(unique_set_t *));
+
+    /* each bucket chain keeps only the latest test set for each
+     * tuple; an earlier test set is flagged when it is replaced */
+    for (uset = (unique_set_t *)dlq_firstEntry(usetQ); uset;
+         uset = (unique_set_t *)dlq_nextEntry(uset)) {
+
+        if (uset->nomatch) {
+            continue;
+        }
+
+        unique_set_t **prevptr = &hashtab[uset->hash & hashmask(bits)];
+        unique_set_t *testset = *prevptr;
+        for (; testset; testset = testset->hashnext) {
+            if (testset->hash == uset->hash &&
+                compare_unique_testsets(&testset->uniqueQ, 
+                                        &uset->uniqueQ)) {
+                break;
+            }
+            prevptr = &testset->hashnext;
+        }
+
+        if (testset) {
+            testset->isdup = TRUE;
+            uset->hashnext = testset->hashnext;
+        } else {
+            prevptr = &hashtab[uset->hash & hashmask(bits)];
+            uset->hashnext = *prevptr;
+        }
+        *prevptr = uset;
+    }
+
+    m__free(hashtab);
+
+    return record_unique_dups(scb, msg, usetQ);
+
+} /* hashed_unique_check */
+
+
+/********************************************************************
+* FUNCTION brute_force_unique_check
+* 
+* Compare all the test sets to each other; used if the
+* test sets cannot be hashed
+*
+* INPUTS:
+*   scb == session control block (may be NULL; no session stats)
+*   msg == xml_msg_hdr t from msg in progress 
+*       == NULL MEANS NO RPC-ERRORS ARE RECORDED
+*   usetQ == Q of unique_set_t to check
+*
+* OUTPUTS:
+*   if msg not NULL:
+*      msg->msg_errQ may have rpc_err_rec_t structs added to it 
+*
+* RETURNS:
+*   status of the operation, NO_ERR if no validation errors found
+*********************************************************************/
+static status_t 
+    brute_force_unique_check (ses_cb_t *scb,
+                              xml_msg_hdr_t *msg,
+                              dlq_hdr_t *usetQ)
+{
+    unique_set_t *set1, *set2;
+
+    /* go through all the test sets and compare them to each other
+     * this is a brute force compare N to N+1 .. last moving N
+     * through the list until all entries have been compared to
+     * each other and all unique violations recorded */
+    for (set1 = (unique_set_t *)dlq_firstEntry(usetQ); set1;
+         set1 = (unique_set_t *)dlq_nextEntry(set1)) {
+
+        set1->isdup = FALSE;
+        if (set1->valnode->res == ERR_NCX_UNIQUE_TEST_FAILED) {
+            continue;
+        }
+
+        for (set2 = (unique_set_t *)dlq_nextEntry(set1); set2; 
+             set2 = (unique_set_t *)dlq_nextEntry(set2)) {
+            if (set2->valnode->res == ERR_NCX_UNIQUE_TEST_FAILED) {
+                // already compared this to rest of list instances
+                // if it is flagged with a unique-test failed error
+                continue;
+            }
+            if (compare_unique_testsets(&set1->uniqueQ, &set2->uniqueQ)) {
+                set1->isdup = TRUE;
+                break;
+            }
+        }
+    }
+
+    return record_unique_dups(scb, msg, usetQ);
+
+} /* brute_force_unique_check */
+
+
 /********************************************************************
 * FUNCTION one_unique_stmt_check
 * 
@@ -3513,6 +3873,7 @@ static status_t
     dlq_hdr_t        uniQ, freeQ, usetQ;
     val_unique_t    *unival;
     unique_set_t    *uset;
+    uint32           usetcnt = 0;
 
     assert( ct && "ct is NULL!" );
     assert( ct->result && "result is NULL!" );
@@ -3551,6 +3912,7 @@ static status_t
             dlq_block_enque(&uniQ, &uset->uniqueQ);
             uset->valnode = valnode;
             dlq_enque(uset, &usetQ);
+            usetcnt++;
         } else if (res == ERR_NCX_CANCELED) {
             dlq_block_enque(&uniQ, &freeQ);
         } else {
@@ -3568,33 +3930,16 @@ static status_t
         val_free_unique(unival);
     }
 
-    if (retres == NO_ERR) {
-        /* go through all the test sets and compare them to each other
-         * this is a brute force compare N to N+1 .. last moving N
-         * through the list until all entries have been compared to
-         * each other and all unique violations recorded;
-         * As compare is done, delete old set1 since no longer needed */
-        while (!dlq_empty(&usetQ)) {
-            unique_set_t *set1 = (unique_set_t *)dlq_deque(&usetQ);
-            if (set1 && set1->valnode->res != ERR_NCX_UNIQUE_TEST_FAILED) {
-                unique_set_t *set2 = (unique_set_t *)dlq_firstEntry(&usetQ);
-                for (; set2; set2 = (unique_set_t *)dlq_nextEntry(set2)) {
-                    if (set2->valnode->res == ERR_NCX_UNIQUE_TEST_FAILED) {
-                        // already compared this to rest of list instances
-                        // if it is flagged with a unique-test failed error
-                        continue;
-                    }
-                    if (compare_unique_testsets(&set1->uniqueQ, 
-                                                &set2->uniqueQ)) {
-                        /* 2 lists have the same values so generate an error */
-                        agt_record_unique_error(scb, msg, set1->valnode,
-                                                &set1->uniqueQ);
-                        set1->valnode->res = ERR_NCX_UNIQUE_TEST_FAILED;
-                        retres = ERR_NCX_UNIQUE_TEST_FAILED;
-                    }
-                }
+    if (retres == NO_ERR && usetcnt > 1) {
+        retres = hashed_unique_check(scb, msg, &usetQ, usetcnt);
+        if (retres == ERR_NCX_CANCELED) {
+            if (LOGDEBUG3) {
+                log_debug3("\nunique_chk: %s:%s unique # %u using "
+                           "brute force compare", 
+                           obj_get_mod_name(ct->obj), 
+                           obj_get_name(ct->obj), uninum);
             }
-            free_unique_set(set1);
+            retres = brute_force_unique_check(scb, msg, &usetQ);
         }
     }
 
@@ -4577,61 +4922,600 @@ static status_t rpc_must_stmt_check ( ses_cb_t *scb,
 
 
 /********************************************************************
- * FUNCTION prep_commit_test_node
- *
- * Update the commit test instances
- *
- * \param scb session control block
- * \param msghdr XML message header in progress
- * \param txcb transaction control block to use
- * \param ct commit test to use
- * \param root <config> node to check
- *
- * \return status
- *********************************************************************/
-static status_t 
-    prep_commit_test_node ( ses_cb_t  *scb,
-                            xml_msg_hdr_t *msghdr,
-                            agt_cfg_transaction_t *txcb,
-                            agt_cfg_commit_test_t *ct,
-                            val_value_t *root )
+* FUNCTION init_commit_edits
+* 
+* Initialize an edit list for commit test pruning
+*
+* INPUTS:
+*   edits == edit list to initialize
+*********************************************************************/
+static void
+    init_commit_edits (commit_edits_t *edits)
 {
-    status_t res = NO_ERR;
+    dlq_createSQue(&edits->editQ);
+    edits->nodecount = 0;
+    edits->fulltest = FALSE;
 
-   /* first get all the instances of this object if needed */
-    if (ct->result) {
-        if (ct->result_txid == txcb->txid) {
-            log_debug3("\nReusing XPath result for %s", ct->objpcb->exprstr);
-        } else {
-            /* TBD: figure out if older TXIDs are still valid
-             * for this XPath expression  */
-            log_debug3("\nGet all instances of %s", ct->objpcb->exprstr);
-            xpath_free_result(ct->result);
-            ct->result = NULL;
+} /* init_commit_edits */
+
+
+/********************************************************************
+* FUNCTION clean_commit_edits
+* 
+* Clean an edit list for commit test pruning
+*
+* INPUTS:
+*   edits == edit list to clean
+*********************************************************************/
+static void
+    clean_commit_edits (commit_edits_t *edits)
+{
+    while (!dlq_empty(&edits->editQ)) {
+        commit_edit_t *edit = (commit_edit_t *)dlq_deque(&edits->editQ);
+        while (!dlq_empty(&edit->nodeQ)) {
+            agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+                dlq_deque(&edit->nodeQ);
+            agt_cfg_free_nodeptr(nodeptr);
         }
+        m__free(edit);
     }
+    edits->nodecount = 0;
 
-    if (ct->result == NULL) {
-        ct->result_txid = 0;
-        ct->result = xpath1_eval_expr(ct->objpcb, root, root, FALSE, 
-                                      TRUE, &res);
-        if (res != NO_ERR || ct->result->restype != XP_RT_NODESET) {
-            if (res == NO_ERR) {
-                res = ERR_NCX_WRONG_NODETYP;
-            }
-            agt_record_error(scb, msghdr, NCX_LAYER_CONTENT, res, NULL,
-                             NCX_NT_NONE, NULL, NCX_NT_OBJ, ct->obj);
-        } else {
-            ct->result_txid = txcb->txid;
-        }
+} /* clean_commit_edits */
+
+
+/********************************************************************
+* FUNCTION add_commit_edit
+* 
+* Add an edited node to the edit list for commit test pruning
+* The nodes are grouped by object
+*
+* INPUTS:
+*   edits == edit list in progress
+*   node == edited node in the target tree
+*
+* OUTPUTS:
+*   edits->fulltest is set if the config root was edited
+*   or there are too many edits to check one at a time
+*
+* RETURNS:
+*   status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_commit_edit (commit_edits_t *edits,
+                     val_value_t *node)
+{
+    if (edits->fulltest) {
+        return NO_ERR;
     }
 
-    return res;
+    if (node->obj == NULL || obj_is_root(node->obj) ||
+        edits->nodecount >= COMMIT_TEST_MAX_EDITS) {
+        edits->fulltest = TRUE;
+        return NO_ERR;
+    }
 
-} /* prep_commit_test_node */
+    commit_edit_t *edit = (commit_edit_t *)dlq_firstEntry(&edits->editQ);
+    for (; edit != NULL; edit = (commit_edit_t *)dlq_nextEntry(edit)) {
+        if (edit->obj == node->obj) {
+            break;
+        }
+    }
 
+    if (edit == NULL) {
+        edit = m__getObj(commit_edit_t);
+        if (edit == NULL) {
+            return ERR_INTERNAL_MEM;
+        }
+        memset(edit, 0x0, sizeof(commit_edit_t));
+        dlq_createSQue(&edit->nodeQ);
+        edit->obj = node->obj;
+        dlq_enque(edit, &edits->editQ);
+    }
 
-/********************************************************************
+    agt_cfg_nodeptr_t *nodeptr = agt_cfg_new_nodeptr(node);
+    if (nodeptr == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    dlq_enque(nodeptr, &edit->nodeQ);
+    edits->nodecount++;
+    return NO_ERR;
+
+} /* add_commit_edit */
+
+
+/********************************************************************
+* FUNCTION add_dirty_edits
+* 
+* Add the edited nodes in a dirty subtree to the edit list
+* Only the top VAL_FL_DIRTY node in each subtree is added
+*
+* INPUTS:
+*   edits == edit list in progress
+*   val == parent node to check
+*
+* RETURNS:
+*   status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_dirty_edits (commit_edits_t *edits,
+                     val_value_t *val)
+{
+    status_t res = NO_ERR;
+    val_value_t *chval = val_get_first_child(val);
+    for (; chval != NULL && res == NO_ERR && !edits->fulltest; 
+         chval = val_get_next_child(chval)) {
+        if (val_get_dirty_flag(chval)) {
+            res = add_commit_edit(edits, chval);
+        } else if (val_get_subtree_dirty_flag(chval)) {
+            res = add_dirty_edits(edits, chval);
+        }
+    }
+    return res;
+
+} /* add_dirty_edits */
+
+
+/********************************************************************
+* FUNCTION add_undo_edit
+* 
+* Add an edited node from an undo record to the edit list
+* if it is in the target tree
+*
+* INPUTS:
+*   edits == edit list in progress
+*   node == node from an undo record (may be NULL)
+*   root == root of the target tree
+*
+* RETURNS:
+*   status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_undo_edit (commit_edits_t *edits,
+                   val_value_t *node,
+                   val_value_t *root)
+{
+    if (node == NULL) {
+        return NO_ERR;
+    }
+
+    /* a merged leaf is restored to the PDU after the edit */
+    val_value_t *testval = node;
+    while (testval->parent) {
+        testval = testval->parent;
+    }
+    if (testval != root) {
+        return NO_ERR;
+    }
+    return add_commit_edit(edits, node);
+
+} /* add_undo_edit */
+
+
+/********************************************************************
+* FUNCTION get_commit_edits
+* 
+* Get the list of edited nodes in the target config that can
+* change the result of a commit test
+*
+* The edits come from the dirty flags in the candidate config
+* (for <commit> and the candidate target) and from the txcb->undoQ
+* (for <edit-config>).  Otherwise the edits are not known.
+*
+* INPUTS:
+*   txcb == transaction control block to use
+*   root == root from the target database to use
+*   edits == initialized edit list to fill in
+*
+* OUTPUTS:
+*   edits is filled in; edits->fulltest is set if
+*   every commit test needs to be run
+*
+* RETURNS:
+*   status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    get_commit_edits (agt_cfg_transaction_t *txcb,
+                      val_value_t *root,
+                      commit_edits_t *edits)
+{
+    boolean usedirty = FALSE, useundo = FALSE;
+    status_t res = NO_ERR;
+
+    if (txcb->cfg_id == NCX_CFGID_RUNNING) {
+        if (txcb->commitcheck) {
+            /* called from <commit>; this root is really the
+             * candidate->root so it is OK to check the dirty flags */
+            usedirty = TRUE;
+        } else if (txcb->edit_type == AGT_CFG_EDIT_TYPE_PARTIAL) {
+            /* called from <edit-config> on the running config */
+            useundo = TRUE;
+        } // else <validate> or unknown edit type; force a full test
+    } else if (txcb->cfg_id == NCX_CFGID_CANDIDATE) {
+        if (txcb->edit_type == AGT_CFG_EDIT_TYPE_FULL) {
+            /* called from <validate> on the candidate config */
+            usedirty = TRUE;
+        } else if (txcb->edit_type == AGT_CFG_EDIT_TYPE_PARTIAL) {
+            /* the dirty flags for the edits from this <rpc> 
+             * have not been set yet, so check both  */
+            usedirty = TRUE;
+            useundo = TRUE;
+        }
+    }
+
+    if (!usedirty && !useundo) {
+        edits->fulltest = TRUE;
+        return NO_ERR;
+    }
+
+    if (useundo) {
+        agt_cfg_undo_rec_t *undo = (agt_cfg_undo_rec_t *)
+            dlq_firstEntry(&txcb->undoQ);
+        for (; undo != NULL && res == NO_ERR; 
+             undo = (agt_cfg_undo_rec_t *)dlq_nextEntry(undo)) {
+            res = add_undo_edit(edits, undo->newnode, root);
+            if (res == NO_ERR) {
+                res = add_undo_edit(edits, undo->curnode, root);
+            }
+
+            agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+                dlq_firstEntry(&undo->extra_deleteQ);
+            for (; nodeptr != NULL && res == NO_ERR; 
+                 nodeptr = (agt_cfg_nodeptr_t *)dlq_nextEntry(nodeptr)) {
+                res = add_undo_edit(edits, nodeptr->node, root);
+            }
+        }
+
+        agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+            dlq_firstEntry(&txcb->deadnodeQ);
+        for (; nodeptr != NULL && res == NO_ERR; 
+             nodeptr = (agt_cfg_nodeptr_t *)dlq_nextEntry(nodeptr)) {
+            res = add_undo_edit(edits, nodeptr->node, root);
+        }
+    }
+
+    if (usedirty && res == NO_ERR) {
+        if (val_get_dirty_flag(root)) {
+            /* a top-level node was deleted */
+            edits->fulltest = TRUE;
+        } else {
+            res = add_dirty_edits(edits, root);
+        }
+    }
+
+    return res;
+
+} /* get_commit_edits */
+
+
+/********************************************************************
+* FUNCTION get_commit_test_flags
+* 
+* Check which tests in a commit test record read
+* the edited nodes
+*
+* An edit touches a node read by a test if the edited
+* node is the same as, or an ancestor or descendant of,
+* the node read by the test.
+*
+* INPUTS:
+*   ct == commit test record to check
+*   edits == edit list to use
+*   tests == tests requested
+*   fullflags == address of return tests that need to be
+*                run on every instance
+*   localflags == address of return tests that only need to
+*                run on the instances in the edited anchor instances
+*********************************************************************/
+static void
+    get_commit_test_flags (agt_cfg_commit_test_t *ct,
+                           commit_edits_t *edits,
+                           uint32 tests,
+                           uint32 *fullflags,
+                           uint32 *localflags)
+{
+    *fullflags = tests & ct->fullflags;
+    *localflags = 0;
+
+    commit_edit_t *edit = (commit_edit_t *)dlq_firstEntry(&edits->editQ);
+    for (; edit != NULL; edit = (commit_edit_t *)dlq_nextEntry(edit)) {
+        agt_cfg_commit_dep_t *dep = (agt_cfg_commit_dep_t *)
+            dlq_firstEntry(&ct->depQ);
+        for (; dep != NULL; 
+             dep = (agt_cfg_commit_dep_t *)dlq_nextEntry(dep)) {
+            if (!(dep->testflags & tests)) {
+                continue;
+            }
+            if (obj_is_ancestor_or_self(edit->obj, dep->obj) ||
+                obj_is_ancestor_or_self(dep->obj, edit->obj)) {
+                if (dep->local) {
+                    *localflags |= (dep->testflags & tests);
+                } else {
+                    *fullflags |= (dep->testflags & tests);
+                }
+            }
+        }
+    }
+
+    *localflags &= ~*fullflags;
+
+} /* get_commit_test_flags */
+
+
+/********************************************************************
+* FUNCTION add_obj_instances
+* 
+* Add all the instances of an object in a subtree
+* to a queue of agt_cfg_nodeptr_t
+* Deleted nodes are skipped
+*
+* INPUTS:
+*   val == subtree to check
+*   obj == object to find; descendant-or-self of val->obj
+*   nodeQ == Q of agt_cfg_nodeptr_t to fill
+*   maxcount == max number of nodes in the nodeQ;
+*               0 for no limit and no duplicate checks
+*   count == address of number of nodes in the nodeQ
+*
+* OUTPUTS:
+*   *count is updated
+*
+* RETURNS:
+*   status of the operation
+*   ERR_NCX_RESOURCE_DENIED if maxcount reached
+*********************************************************************/
+static status_t
+    add_obj_instances (val_value_t *val,
+                       obj_template_t *obj,
+                       dlq_hdr_t *nodeQ,
+                       uint32 maxcount,
+                       uint32 *count)
+{
+    if (VAL_IS_DELETED(val)) {
+        return NO_ERR;
+    }
+
+    if (val->obj != obj) {
+        status_t res = NO_ERR;
+        val_value_t *chval = val_get_first_child(val);
+        for (; chval != NULL && res == NO_ERR; 
+             chval = val_get_next_child(chval)) {
+            if (obj_is_ancestor_or_self(chval->obj, obj)) {
+                res = add_obj_instances(chval, obj, nodeQ, maxcount, count);
+            }
+        }
+        return res;
+    }
+
+    agt_cfg_nodeptr_t *nodeptr;
+    if (maxcount) {
+        nodeptr = (agt_cfg_nodeptr_t *)dlq_firstEntry(nodeQ);
+        for (; nodeptr != NULL; 
+             nodeptr = (agt_cfg_nodeptr_t *)dlq_nextEntry(nodeptr)) {
+            if (nodeptr->node == val) {
+                return NO_ERR;
+            }
+        }
+        if (*count >= maxcount) {
+            return ERR_NCX_RESOURCE_DENIED;
+        }
+    }
+
+    nodeptr = agt_cfg_new_nodeptr(val);
+    if (nodeptr == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    dlq_enque(nodeptr, nodeQ);
+    (*count)++;
+    return NO_ERR;
+
+} /* add_obj_instances */
+
+
+/********************************************************************
+* FUNCTION get_local_test_nodes
+* 
+* Get the instances of the commit test object that are
+* in the anchor instances that contain an edit to
+* a node read by the local tests
+*
+* INPUTS:
+*   ct == commit test record to use
+*   edits == edit list to use
+*   localflags == tests that only need the edited anchor instances
+*   nodeQ == Q of agt_cfg_nodeptr_t to fill with the
+*            ct->obj instances to test
+*
+* RETURNS:
+*   status of the operation
+*   ERR_NCX_RESOURCE_DENIED if there are too many anchor
+*   instances to test one at a time
+*********************************************************************/
+static status_t
+    get_local_test_nodes (agt_cfg_commit_test_t *ct,
+                          commit_edits_t *edits,
+                          uint32 localflags,
+                          dlq_hdr_t *nodeQ)
+{
+    dlq_hdr_t anchorQ;
+    uint32 anchorcount = 0, nodecount = 0;
+    status_t res = NO_ERR;
+
+    if (ct->anchor == NULL) {
+        return ERR_NCX_RESOURCE_DENIED;
+    }
+
+    dlq_createSQue(&anchorQ);
+
+    commit_edit_t *edit = (commit_edit_t *)dlq_firstEntry(&edits->editQ);
+    for (; edit != NULL && res == NO_ERR; 
+         edit = (commit_edit_t *)dlq_nextEntry(edit)) {
+
+        /* skip this object if it does not touch any local tests */
+        boolean touched = FALSE;
+        agt_cfg_commit_dep_t *dep = (agt_cfg_commit_dep_t *)
+            dlq_firstEntry(&ct->depQ);
+        for (; dep != NULL && !touched; 
+             dep = (agt_cfg_commit_dep_t *)dlq_nextEntry(dep)) {
+            if (dep->local && (dep->testflags & localflags) &&
+                (obj_is_ancestor_or_self(edit->obj, dep->obj) ||
+                 obj_is_ancestor_or_self(dep->obj, edit->obj))) {
+                touched = TRUE;
+            }
+        }
+        if (!touched) {
+            continue;
+        }
+
+        boolean inanchor = obj_is_ancestor_or_self(ct->anchor, edit->obj);
+        agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+            dlq_firstEntry(&edit->nodeQ);
+        for (; nodeptr != NULL && res == NO_ERR; 
+             nodeptr = (agt_cfg_nodeptr_t *)dlq_nextEntry(nodeptr)) {
+            val_value_t *val = nodeptr->node;
+            if (inanchor) {
+                /* edit is inside an anchor instance */
+                while (val && val->obj != ct->anchor) {
+                    val = val->parent;
+                }
+                if (val == NULL) {
+                    res = ERR_NCX_RESOURCE_DENIED;
+                    continue;
+                }
+            } // else edit contains all the anchor instances under it
+            res = add_obj_instances(val, ct->anchor, &anchorQ, 
+                                    COMMIT_TEST_MAX_ANCHORS, &anchorcount);
+        }
+    }
+
+    while (!dlq_empty(&anchorQ)) {
+        agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+            dlq_deque(&anchorQ);
+        if (res == NO_ERR) {
+            res = add_obj_instances(nodeptr->node, ct->obj, nodeQ, 0,
+                                    &nodecount);
+        }
+        agt_cfg_free_nodeptr(nodeptr);
+    }
+
+    return res;
+
+} /* get_local_test_nodes */
+
+
+/********************************************************************
+* FUNCTION prune_commit_tests
+* 
+* Check which tests in a commit test record need to be run
+* for the current edits, and get the test instances for
+* the tests that only need the edited anchor instances
+*
+* INPUTS:
+*   ct == commit test record to check
+*   edits == edit list to use; NULL if no pruning allowed
+*   tests == tests requested
+*   fullflags == address of return tests to run on every instance
+*   localflags == address of return tests to run on the nodeQ
+*   nodeQ == Q of agt_cfg_nodeptr_t to fill with the
+*            instances for the localflags tests
+*
+* RETURNS:
+*   status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    prune_commit_tests (agt_cfg_commit_test_t *ct,
+                        commit_edits_t *edits,
+                        uint32 tests,
+                        uint32 *fullflags,
+                        uint32 *localflags,
+                        dlq_hdr_t *nodeQ)
+{
+    if (edits == NULL || edits->fulltest) {
+        *fullflags = tests;
+        *localflags = 0;
+        return NO_ERR;
+    }
+
+    get_commit_test_flags(ct, edits, tests, fullflags, localflags);
+    if (*localflags == 0) {
+        return NO_ERR;
+    }
+
+    status_t res = get_local_test_nodes(ct, edits, *localflags, nodeQ);
+    if (res != NO_ERR) {
+        while (!dlq_empty(nodeQ)) {
+            agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+                dlq_deque(nodeQ);
+            agt_cfg_free_nodeptr(nodeptr);
+        }
+    }
+    if (res == ERR_NCX_RESOURCE_DENIED) {
+        /* too many edited instances so test them all */
+        *fullflags |= *localflags;
+        *localflags = 0;
+        res = NO_ERR;
+    }
+    return res;
+
+} /* prune_commit_tests */
+
+
+/********************************************************************
+ * FUNCTION prep_commit_test_node
+ *
+ * Update the commit test instances
+ *
+ * \param scb session control block
+ * \param msghdr XML message header in progress
+ * \param txcb transaction control block to use
+ * \param ct commit test to use
+ * \param root <config> node to check
+ *
+ * \return status
+ *********************************************************************/
+static status_t 
+    prep_commit_test_node ( ses_cb_t  *scb,
+                            xml_msg_hdr_t *msghdr,
+                            agt_cfg_transaction_t *txcb,
+                            agt_cfg_commit_test_t *ct,
+                            val_value_t *root )
+{
+    status_t res = NO_ERR;
+
+   /* first get all the instances of this object if needed */
+    if (ct->result) {
+        if (ct->result_txid == txcb->txid) {
+            log_debug3("\nReusing XPath result for %s", ct->objpcb->exprstr);
+        } else {
+            /* TBD: figure out if older TXIDs are still valid
+             * for this XPath expression  */
+            log_debug3("\nGet all instances of %s", ct->objpcb->exprstr);
+            xpath_free_result(ct->result);
+            ct->result = NULL;
+        }
+    }
+
+    if (ct->result == NULL) {
+        ct->result_txid = 0;
+        ct->result = xpath1_eval_expr(ct->objpcb, root, root, FALSE, 
+                                      TRUE, &res);
+        if (res != NO_ERR || ct->result->restype != XP_RT_NODESET) {
+            if (res == NO_ERR) {
+                res = ERR_NCX_WRONG_NODETYP;
+            }
+            agt_record_error(scb, msghdr, NCX_LAYER_CONTENT, res, NULL,
+                             NCX_NT_NONE, NULL, NCX_NT_OBJ, ct->obj);
+        } else {
+            ct->result_txid = txcb->txid;
+        }
+    }
+
+    return res;
+
+} /* prep_commit_test_node */
+
+
+/********************************************************************
  * 
  * Delete all the nodes that have false when-stmt exprs
  * Also delete empty NP-containers
@@ -4652,19 +5536,68 @@ static status_t delete_dead_nodes ( ses_cb_t  *scb,
     *retcount = 0;
 
     agt_profile_t *profile = agt_get_profile();
+    status_t res = NO_ERR;
+    commit_edits_t edits;
+    dlq_hdr_t nodeQ;
+
+    init_commit_edits(&edits);
+    dlq_createSQue(&nodeQ);
+
+    /* only the when-stmts that read the edited nodes can change
+     * in a valid config; see agt_val_root_check */
+    if (profile->agt_config_state == AGT_CFG_STATE_OK) {
+        res = get_commit_edits(txcb, root, &edits);
+    } else {
+        edits.fulltest = TRUE;
+    }
+
     agt_cfg_commit_test_t *ct = (agt_cfg_commit_test_t *)
         dlq_firstEntry(&profile->agt_commit_testQ);
 
-    for (; ct != NULL; ct = (agt_cfg_commit_test_t *)dlq_nextEntry(ct)) {
-        uint32  tests = ct->testflags & AGT_TEST_FL_WHEN;
-        if (tests == 0) {
-            /* no when-stmt tests needed for this node */
+    for (; ct != NULL && res == NO_ERR; 
+         ct = (agt_cfg_commit_test_t *)dlq_nextEntry(ct)) {
+        uint32  tests = ct->testflags & AGT_TEST_FL_WHEN;
+        if (tests == 0) {
+            /* no when-stmt tests needed for this node */
+            continue;
+        }
+
+        uint32 fulltests = 0, localtests = 0;
+        res = prune_commit_tests(ct, &edits, tests, &fulltests, &localtests,
+                                 &nodeQ);
+        if (res != NO_ERR) {
+            break;
+        }
+
+        /* run the when-stmts in the edited anchor instances */
+        while (!dlq_empty(&nodeQ)) {
+            agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+                dlq_deque(&nodeQ);
+            val_value_t *valnode = nodeptr->node;
+            agt_cfg_free_nodeptr(nodeptr);
+
+            if (res != NO_ERR) {
+                continue;
+            }
+
+            res = run_when_stmt_check(scb, msghdr, txcb, root, valnode);
+            if (res == NO_ERR && VAL_IS_DELETED(valnode)) {
+                /* the saved result may have this node in it */
+                if (ct->result) {
+                    xpath_free_result(ct->result);
+                    ct->result = NULL;
+                }
+                (*retcount)++;
+            }
+        }
+
+        if (fulltests == 0 || res != NO_ERR) {
             continue;
         }
 
-        status_t res = prep_commit_test_node(scb, msghdr, txcb, ct, root);
+        res = prep_commit_test_node(scb, msghdr, txcb, ct, root);
         if (res != NO_ERR) {
-            return res;
+            break;
         }
 
         /* run all relevant tests on each node in the result set */
@@ -4677,7 +5610,7 @@ static status_t delete_dead_nodes ( ses_cb_t  *scb,
             res = run_when_stmt_check(scb, msghdr, txcb, root, valnode);
             if (res != NO_ERR) {
                 /* treat any when delete error as terminate transaction */
-                return res;
+                break;
             } else if (VAL_IS_DELETED(valnode)) {
                 /* this node has just been flagged when=FALSE so
                  * remove this resnode from the result so it will
@@ -4688,7 +5621,9 @@ static status_t delete_dead_nodes ( ses_cb_t  *scb,
         }
     }
 
-    return NO_ERR;
+    clean_commit_edits(&edits);
+
+    return res;
 
 }  /* delete_dead_nodes */
 
@@ -4742,6 +5677,254 @@ static void
 }  /* check_parent_tests */
 
 
+/********************************************************************
+* FUNCTION add_commit_dep
+* 
+* Add a data node read by the commit tests to the depQ
+* of the commit test record
+*
+* INPUTS:
+*  ct == commit test record to use
+*  obj == data node read by the tests
+*  testflags == AGT_TEST_FL_FOO bits for the tests that read obj
+*  local == TRUE if obj is only read in the ct->anchor instance
+*
+* RETURNS:
+*  status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_commit_dep (agt_cfg_commit_test_t *ct,
+                    obj_template_t *obj,
+                    uint32 testflags,
+                    boolean local)
+{
+    agt_cfg_commit_dep_t *dep = (agt_cfg_commit_dep_t *)
+        dlq_firstEntry(&ct->depQ);
+    for (; dep != NULL; dep = (agt_cfg_commit_dep_t *)dlq_nextEntry(dep)) {
+        if (dep->obj == obj && dep->local == local) {
+            dep->testflags |= testflags;
+            return NO_ERR;
+        }
+    }
+
+    dep = agt_cfg_new_commit_dep(obj, testflags, local);
+    if (dep == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    dlq_enque(dep, &ct->depQ);
+    return NO_ERR;
+
+} /* add_commit_dep */
+
+
+/********************************************************************
+* FUNCTION set_commit_anchor
+* 
+* Move the commit test anchor up so it contains
+* the specified object
+*
+* INPUTS:
+*  ct == commit test record to use
+*  obj == object that must be inside the anchor instance
+*  anchorset == address of flag that ct->anchor has been set
+*
+* OUTPUTS:
+*  ct->anchor is set; NULL if only the root contains all the nodes
+*  *anchorset is set to TRUE
+*********************************************************************/
+static void
+    set_commit_anchor (agt_cfg_commit_test_t *ct,
+                       obj_template_t *obj,
+                       boolean *anchorset)
+{
+    if (!*anchorset) {
+        ct->anchor = obj;
+        *anchorset = TRUE;
+    } else if (ct->anchor) {
+        ct->anchor = obj_get_common_ancestor(ct->anchor, obj);
+    }
+
+} /* set_commit_anchor */
+
+
+/********************************************************************
+* FUNCTION add_pcb_commit_deps
+* 
+* Add the data nodes read by a must or when expression
+* to the depQ of the commit test record
+*
+* INPUTS:
+*  ct == commit test record to use
+*  pcb == validated XPath expression to check
+*  testflags == AGT_TEST_FL_FOO bit for this expression
+*  anchorset == address of flag that ct->anchor has been set
+*
+* OUTPUTS:
+*  ct->depQ, ct->anchor or ct->fullflags may be updated
+*
+* RETURNS:
+*  status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_pcb_commit_deps (agt_cfg_commit_test_t *ct,
+                         xpath_pcb_t *pcb,
+                         uint32 testflags,
+                         boolean *anchorset)
+{
+    if (pcb == NULL) {
+        return NO_ERR;
+    }
+
+    if (!(pcb->flags & XP_FL_OBJDEPS) || (pcb->flags & XP_FL_OBJDEPS_ANY)) {
+        /* the nodes read are not known so always test every instance */
+        ct->fullflags |= testflags;
+        return NO_ERR;
+    }
+
+    boolean local = FALSE;
+    if (pcb->depanchor) {
+        set_commit_anchor(ct, pcb->depanchor, anchorset);
+        local = TRUE;
+    }
+
+    xpath_resnode_t *resnode = (xpath_resnode_t *)dlq_firstEntry(&pcb->depQ);
+    for (; resnode != NULL; 
+         resnode = (xpath_resnode_t *)dlq_nextEntry(resnode)) {
+        status_t res = add_commit_dep(ct, resnode->node.objptr, testflags, 
+                                      local);
+        if (res != NO_ERR) {
+            return res;
+        }
+    }
+    return NO_ERR;
+
+} /* add_pcb_commit_deps */
+
+
+/********************************************************************
+* FUNCTION add_commit_test_deps
+* 
+* Find the data nodes read by each test in the commit test
+* record, so a commit only needs to run the tests that
+* read the edited nodes
+*
+* Tests run on an instance always read the instance itself.
+* The must and when expressions read the nodes found when they
+* were validated.  If these nodes are all inside the same
+* ancestor instance then an edit only needs the tests
+* for the instances in the edited ancestor instances.
+* A leafref reads the target node in any instance and a unique
+* test reads the unique nodes in all list instances, so an edit
+* to these nodes needs a full test
+*
+* INPUTS:
+*  ct == commit test record to use
+*
+* OUTPUTS:
+*  ct->depQ, ct->anchor and ct->fullflags are set
+*
+* RETURNS:
+*  status of the operation, NO_ERR unless malloc error
+*********************************************************************/
+static status_t
+    add_commit_test_deps (agt_cfg_commit_test_t *ct)
+{
+    obj_template_t *obj = ct->obj;
+    boolean anchorset = FALSE;
+    status_t res = NO_ERR;
+
+    uint32 selfflags = ct->testflags & ~AGT_TEST_FL_UNIQUE;
+    if (selfflags) {
+        set_commit_anchor(ct, obj, &anchorset);
+        res = add_commit_dep(ct, obj, selfflags, TRUE);
+        if (res != NO_ERR) {
+            return res;
+        }
+    }
+
+    if (ct->testflags & AGT_TEST_FL_MUST) {
+        xpath_pcb_t *must = (xpath_pcb_t *)dlq_firstEntry(obj_get_mustQ(obj));
+        for (; must != NULL && res == NO_ERR; 
+             must = (xpath_pcb_t *)dlq_nextEntry(must)) {
+            res = add_pcb_commit_deps(ct, must, AGT_TEST_FL_MUST, &anchorset);
+        }
+    }
+
+    if (ct->testflags & AGT_TEST_FL_WHEN) {
+        /* same when-stmts as val_check_obj_when */
+        res = add_pcb_commit_deps(ct, obj->when, AGT_TEST_FL_WHEN,
+                                  &anchorset);
+        obj_xpath_ptr_t *xptr = obj_first_xpath_ptr(obj);
+        for (; xptr && res == NO_ERR; xptr = obj_next_xpath_ptr(xptr)) {
+            res = add_pcb_commit_deps(ct, xptr->xpath, AGT_TEST_FL_WHEN,
+                                      &anchorset);
+        }
+
+        /* a choice or case when-stmt is not evaluated with the
+         * context node used to validate it, so always run it */
+        obj_template_t *testobj = obj->parent;
+        while (testobj && (testobj->objtype == OBJ_TYP_CHOICE ||
+                           testobj->objtype == OBJ_TYP_CASE)) {
+            if (testobj->when || obj_first_xpath_ptr(testobj)) {
+                ct->fullflags |= AGT_TEST_FL_WHEN;
+            }
+            testobj = testobj->parent;
+        }
+    }
+
+    if (ct->testflags & AGT_TEST_FL_UNIQUE) {
+        obj_unique_t *unidef = obj_first_unique(obj);
+        for (; unidef && res == NO_ERR; unidef = obj_next_unique(unidef)) {
+            if (!unidef->isconfig) {
+                continue;
+            }
+            obj_unique_comp_t *unicomp = obj_first_unique_comp(unidef);
+            if (unicomp == NULL) {
+                ct->fullflags |= AGT_TEST_FL_UNIQUE;
+            }
+            for (; unicomp && res == NO_ERR; 
+                 unicomp = obj_next_unique_comp(unicomp)) {
+                if (unicomp->unobj) {
+                    res = add_commit_dep(ct, unicomp->unobj,
+                                         AGT_TEST_FL_UNIQUE, FALSE);
+                } else {
+                    ct->fullflags |= AGT_TEST_FL_UNIQUE;
+                }
+            }
+        }
+    }
+
+    if ((ct->testflags & AGT_TEST_FL_XPATH_TYPE) && res == NO_ERR) {
+        obj_template_t *targobj = NULL;
+        const xmlChar *pathstr = NULL;
+        if (ct->btyp == NCX_BT_LEAFREF) {
+            targobj = obj_get_leafref_targobj(obj);
+            pathstr = typ_get_leafref_path(obj_get_typdef(obj));
+        }
+        if (targobj && pathstr && !strchr((const char *)pathstr, '[')) {
+            /* a plain path reads the target node in any instance */
+            res = add_commit_dep(ct, targobj, AGT_TEST_FL_XPATH_TYPE, FALSE);
+        } else {
+            /* instance-identifier or a path with predicates */
+            ct->fullflags |= AGT_TEST_FL_XPATH_TYPE;
+        }
+    }
+
+    if (res == NO_ERR && anchorset && ct->anchor == NULL) {
+        /* the tests read nodes in different top-level instances */
+        agt_cfg_commit_dep_t *dep = (agt_cfg_commit_dep_t *)
+            dlq_firstEntry(&ct->depQ);
+        for (; dep != NULL; 
+             dep = (agt_cfg_commit_dep_t *)dlq_nextEntry(dep)) {
+            dep->local = FALSE;
+        }
+    }
+
+    return res;
+
+} /* add_commit_test_deps */
+
+
 /********************************************************************
 * FUNCTION add_obj_commit_tests
 * 
@@ -4873,10 +6056,20 @@ static status_t
         ct->obj = obj;
         ct->btyp = btyp;
         ct->testflags = testflags;
+
+        res = add_commit_test_deps(ct);
+        if (res != NO_ERR) {
+            agt_cfg_free_commit_test(ct);
+            return res;
+        }
+
         dlq_enque(ct, commit_testQ);
         if (LOGDEBUG4) {
-            log_debug4("\nAdded commit_test record for %s testflags=0x%08X",
-                       ct->objpcb->exprstr, testflags);
+            log_debug4("\nAdded commit_test record for %s testflags=0x%08X "
+                       "fullflags=0x%08X anchor=%s",
+                       ct->objpcb->exprstr, testflags, ct->fullflags,
+                       (ct->anchor) ? obj_get_name(ct->anchor) : 
+                       (const xmlChar *)"/");
         }
     }
 
@@ -4894,221 +6087,6 @@ static status_t
 } /* add_obj_commit_tests */
 
 
-/********************************************************************
-* FUNCTION check_prune_obj
-* 
-* Check if the specified object test can be reduced or eliminated
-* from the current commit test
-*
-* INPUTS:
-*    obj == commit test object to check; must not be root!
-*    rootval == config root to check
-*    curflags == current test flags
-* RETURNS:
-*  new testflags or unchanged test flags
-*********************************************************************/
-static uint32
-    check_prune_obj (obj_template_t *obj,
-                     val_value_t *rootval,
-                     uint32 curflags)
-{
-    /* for now just check the top level object to see if
-     * this subtree could have possibly changed;
-     * TBD: come up with fast way to check more, that does
-     * take as much time as just using XPath to get these objects  */
-    boolean done = FALSE;
-    obj_template_t *testobj = obj;
-    while (!done) {
-        if (testobj->parent && !obj_is_root(testobj->parent)) {
-            testobj = testobj->parent;
-        } else {
-            done = TRUE;
-        }
-    }
-
-    /* find this object in the rootval */
-    val_value_t *testval = val_find_child(rootval, obj_get_mod_name(testobj),
-                                          obj_get_name(testobj));
-    if (testval) {
-        switch (testobj->objtype) {
-        case OBJ_TYP_LEAF:
-        case OBJ_TYP_ANYXML:
-        case OBJ_TYP_CONTAINER:
-            if (val_dirty_subtree(testval)) {
-                /* do not skip this node */
-                return curflags;
-            }
-            break;
-        default:
-            done = FALSE;
-            while (!done) {
-                if (val_dirty_subtree(testval)) {
-                    /* do not skip this node */
-                    return curflags;
-                } else {
-                    testval = 
-                        val_find_next_child(rootval, obj_get_mod_name(testobj),
-                                            obj_get_name(testobj), testval);
-                    if (testval == NULL) {
-                        done = TRUE;
-                    }
-                }
-            }
-        }
-    }
-
-    /* skip this node for all tests, since no instances of
-     * the top-level object exist which might have been changed
-     * Relying on the fact that the root-check is always done for
-     * the root node (on the top-level YANG data nodes, so
-     * any instance or mandatory tests on the top-node will
-     * always be done     */
-    //return 0;
-
-    /* xpath tests can depend on any top level container */
-    return (curflags & AGT_TEST_FL_XPATH_TYPE);
-
-} /* check_prune_obj */
-
-
-/********************************************************************
-* FUNCTION check_no_prune_curedit
-* 
-* Check if the specified object test is needed from the current 
-* commit test, based on the current edit in the undo record
-*
-* INPUTS:
-*   undo == edit operation to check
-*   obj == commit test object to check; must not be root!
-* RETURNS:
-*  TRUE if found and test needed; FALSE if not found
-*********************************************************************/
-static boolean
-    check_no_prune_curedit (agt_cfg_undo_rec_t *undo,
-                            obj_template_t *obj)
-{
-    obj_template_t *editobj = (undo->newnode) ? undo->newnode->obj :
-        ((undo->curnode) ? undo->curnode->obj : NULL);
-    if (editobj == NULL) {
-        return FALSE;
-    }
-
-    /* see if the commit test object is a descendant of
-     * the edit object, but only if not deleting the edit
-     * object; do not trigger descendant test on a delete  */
-    boolean done = (undo->editop == OP_EDITOP_DELETE);
-    obj_template_t *testobj = obj;
-    while (!done) {
-        if (editobj == testobj) {
-            return TRUE;   // do not prune this object test
-        }
-
-        if (testobj->parent && !obj_is_root(testobj->parent)) {
-            testobj = testobj->parent;
-        } else {
-            done = TRUE;
-        }
-    }
-
-    /* see if the edit object is a descendant of the commit test object */
-    done = FALSE;
-    while (!done) {
-        if (editobj == obj) {
-            return TRUE;   // do not prune this object test
-        }
-
-        if (editobj->parent && !obj_is_root(editobj->parent)) {
-            editobj = editobj->parent;
-        } else {
-            done = TRUE;
-        }
-    }
-
-    return FALSE;
-
-} /* check_no_prune_curedit */
-
-
-/********************************************************************
-* FUNCTION prune_obj_commit_tests
-* 
-* Check if the specified object test can be reduced or elimated
-* from the current commit test
-*
-* INPUTS:
-*
-* OUTPUTS:
-*  *testflags will be altered
-* RETURNS:
-*  new (or unchanged) test flags
-*********************************************************************/
-static uint32
-    prune_obj_commit_tests (agt_cfg_transaction_t *txcb,
-                            agt_cfg_commit_test_t *ct,
-                            val_value_t *rootval,
-                            uint32 curflags)
-{
-    if (curflags & AGT_TEST_FL_MUST) {
-        /* do not prune a must-stmt test since the XPath expression
-         * may reference any arbitrary data node    */
-        return curflags;
-    }
-
-    agt_cfg_undo_rec_t *undo = NULL;
-    if (txcb->cfg_id == NCX_CFGID_RUNNING) {
-        if (txcb->commitcheck) {
-            /* called from <commit> 
-             * look for dirty or subtree dirty flags in the rootval
-             * this rootval is reallt candidate->root, so it is
-             * OK to check the dirty flags    */
-            curflags = check_prune_obj(ct->obj, rootval, curflags);
-        } else {
-            if (txcb->edit_type == AGT_CFG_EDIT_TYPE_FULL) {
-                /* called from <validate> on external <config> element;
-                 * <copy-config> is not supported on the running config
-                 * so there is nothing to do for now; do not prune;
-                 * force a full test for <validate>   */
-            } else if (txcb->edit_type == AGT_CFG_EDIT_TYPE_PARTIAL) {
-                /* called from <edit-config> on running config;
-                 * check the edit list; only nodes that have been
-                 * edited need to run a commit test   */
-                undo = (agt_cfg_undo_rec_t *)dlq_firstEntry(&txcb->undoQ);
-                while (undo) {
-                    if (check_no_prune_curedit(undo, ct->obj)) {
-                        return curflags;
-                    }
-                    undo = (agt_cfg_undo_rec_t *)dlq_nextEntry(undo);
-                }
-                curflags = 0;
-            } // else unknown edit-type! do not prune
-        }
-    } else if (txcb->cfg_id == NCX_CFGID_CANDIDATE) {
-        if (txcb->edit_type == AGT_CFG_EDIT_TYPE_FULL) {
-            /* called from <validate> operation on the <candidate> config */
-            curflags = check_prune_obj(ct->obj, rootval, curflags);
-        } else if (txcb->edit_type == AGT_CFG_EDIT_TYPE_PARTIAL) {
-            /* called from <edit-config> with test-option=set-then-test
-             * first check all the current edits; because the dirty flags
-             * for any edits from this <rpc> have not been set yet */
-            undo = (agt_cfg_undo_rec_t *)dlq_firstEntry(&txcb->undoQ);
-            while (undo) {
-                if (check_no_prune_curedit(undo, ct->obj)) {
-                    return curflags;
-                }
-                undo = (agt_cfg_undo_rec_t *)dlq_nextEntry(undo);
-            }
-
-            /* did not find the object in the current edits so check
-             * pending edits (dirty flags) on the candidate->root target */
-            curflags = check_prune_obj(ct->obj, rootval, curflags);
-        } // else unknown edit-type! do not prune!
-    } // else unknown config target! do not prune!
-
-    return curflags;
-
-} /* prune_obj_commit_tests */
-
-
 /********************************************************************
 * FUNCTION run_instance_check
 * 
@@ -5518,7 +6496,11 @@ status_t
 *       AGT_CFG_STATE_BAD: running config validation has been
 *         attempted and it failed; running config is not valid!
 *         The server will shutdown if
-*   The target nodes in the undoQ records
+*   In the OK state only the tests that read the edited nodes
+*   (the target nodes in the undoQ records or the dirty nodes
+*   in the candidate) are run. If all the nodes read by a test
+*   are in the same anchor instance as the tested node, then
+*   only the instances in the edited anchor instances are tested.
 * INPUTS:
 *   scb == session control block (may be NULL; no session stats)
 *   msghdr == XML message header in progress
@@ -5562,6 +6544,30 @@ status_t
         CHK_EXIT(res, retres);
     }
 
+    /* prune tests that have not changed in a valid config
+     * this will only work for <commit> and <edit-config>,
+     * because otherwise there will not be any edits recorded
+     * in the txcb->undoQ or any nodes marked dirty in val->flags */
+    commit_edits_t edits;
+    dlq_hdr_t nodeQ;
+
+    init_commit_edits(&edits);
+    dlq_createSQue(&nodeQ);
+    if (profile->agt_config_state == AGT_CFG_STATE_OK) {
+        res = get_commit_edits(txcb, root, &edits);
+        if (res != NO_ERR) {
+            clean_commit_edits(&edits);
+            return res;
+        }
+        if (LOGDEBUG3) {
+            log_debug3("\nagt_val_root_check: %u edited nodes%s", 
+                       edits.nodecount, 
+                       (edits.fulltest) ? ", full test" : "");
+        }
+    } else {
+        edits.fulltest = TRUE;
+    }
+
     /* go through all the commit test objects that might need
      * to be checked for this commit    */
     agt_cfg_commit_test_t *ct = (agt_cfg_commit_test_t *)
@@ -5569,17 +6575,16 @@ status_t
     for (; ct != NULL; ct = (agt_cfg_commit_test_t *)dlq_nextEntry(ct)) {
 
         uint32  tests = ct->testflags & AGT_TEST_ALL_COMMIT_MASK;
+        uint32  fulltests = 0, localtests = 0;
 
-        /* prune entry that has not changed in a valid config
-         * this will only work for <commit> and <edit-config>
-         * on the running config, because otherwise there will
-         * not be any edits recorded in the txcb->undoQ or any
-         * nodes marked dirty in val->flags     */
-        if (profile->agt_config_state == AGT_CFG_STATE_OK) {
-            tests = prune_obj_commit_tests(txcb, ct, root, tests);
+        res = prune_commit_tests(ct, &edits, tests, &fulltests, &localtests,
+                                 &nodeQ);
+        if (res != NO_ERR) {
+            CHK_EXIT(res, retres);
+            break;
         }
 
-        if (tests == 0) {
+        if (fulltests == 0 && localtests == 0) {
             /* no commit tests needed for this node */
             if (LOGDEBUG3) {
                 log_debug3("\nrun_root_check: skip commit test %s:%s",
@@ -5589,6 +6594,27 @@ status_t
             continue;
         }
 
+        /* run the tests on the instances in the edited anchor instances */
+        while (!dlq_empty(&nodeQ)) {
+            agt_cfg_nodeptr_t *nodeptr = (agt_cfg_nodeptr_t *)
+                dlq_deque(&nodeQ);
+            val_value_t *valnode = nodeptr->node;
+            agt_cfg_free_nodeptr(nodeptr);
+
+            valnode->res = NO_ERR;
+            res = run_obj_commit_tests(profile, scb, msghdr, ct, valnode, 
+                                       root, localtests);
+            if (res != NO_ERR) {
+                valnode->res = res;
+                profile->agt_load_rootcheck_errors = TRUE;
+                CHK_EXIT(res, retres);
+            }
+        }
+
+        if (fulltests == 0) {
+            continue;
+        }
+
         res = prep_commit_test_node(scb, msghdr, txcb, ct, root);
         if (res != NO_ERR) {
             CHK_EXIT(res, retres);
@@ -5602,7 +6628,7 @@ status_t
             val_value_t *valnode = xpath_get_resnode_valptr(resnode);
             valnode->res = NO_ERR;
             res = run_obj_commit_tests(profile, scb, msghdr, ct, valnode, 
-                                       root, tests);
+                                       root, fulltests);
             if (res != NO_ERR) {
                 valnode->res = res;
                 profile->agt_load_rootcheck_errors = TRUE;
@@ -5612,13 +6638,17 @@ status_t
 
         /* check if any unique tests, which are handled all at once
          * instead of one instance at a time  */
-        res = run_obj_unique_tests(scb, msghdr, ct, root);
-        if (res != NO_ERR) {
-            profile->agt_load_rootcheck_errors = TRUE;
-            CHK_EXIT(res, retres);
+        if (fulltests & AGT_TEST_FL_UNIQUE) {
+            res = run_obj_unique_tests(scb, msghdr, ct, root);
+            if (res != NO_ERR) {
+                profile->agt_load_rootcheck_errors = TRUE;
+                CHK_EXIT(res, retres);
+            }
         }
     }
 
+    clean_commit_edits(&edits);
+
     log_debug3("\nagt_val_root_check: end");
 
     return retres;
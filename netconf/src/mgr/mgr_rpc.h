@@ -83,6 +83,7 @@ typedef struct mgr_rpc_req_t_ {
     struct timeval perfstarttime; /* tstamp to perf meas */
     uint32         timeout;       /* timeout in seconds */
     void          *replycb;           /* mgr_rpc_cbfn_t */
+    void          *replydata;     /* owned by replycb user */
 
 } mgr_rpc_req_t;
 
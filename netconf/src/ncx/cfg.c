@@ -242,6 +242,82 @@ static cfg_template_t *
 } /* new_template */
 
 
+/********************************************************************
+* FUNCTION resync_subtree
+*
+* Make a candidate subtree the same as the running subtree
+* again, by copying only the dirty nodes from running.
+* The clean nodes are still the same as in running,
+* so they are just moved into the running order.
+*
+* INPUTS:
+*    candval == candidate root or node with VAL_FL_SUBTREE_DIRTY set
+*    runval == running node for the same instance
+*
+* OUTPUTS:
+*    candval child nodes are replaced or reordered
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    resync_subtree (val_value_t *candval,
+                    val_value_t *runval)
+{
+    val_value_t  *runchild, *candchild;
+    dlq_hdr_t     syncQ;
+    status_t      res;
+
+    dlq_createSQue(&syncQ);
+    res = NO_ERR;
+
+    for (runchild = val_get_first_child(runval);
+         runchild != NULL && res == NO_ERR;
+         runchild = val_get_next_child(runchild)) {
+
+        if (!val_is_config_data(runchild)) {
+            continue;
+        }
+
+        candchild = val_first_child_match(candval, runchild);
+        if (candchild != NULL && !val_get_dirty_flag(candchild)) {
+            val_remove_child(candchild);
+            if (val_get_subtree_dirty_flag(candchild)) {
+                res = resync_subtree(candchild, runchild);
+            }
+        } else {
+            candchild = val_clone_config_data(runchild, &res);
+        }
+        if (candchild != NULL) {
+            candchild->parent = candval;
+            dlq_enque(candchild, &syncQ);
+        }
+    }
+
+    /* anything left was added or replaced in the candidate */
+    while (res == NO_ERR && (candchild = val_get_first_child(candval))) {
+        val_remove_child(candchild);
+        val_free_value(candchild);
+    }
+
+    while (!dlq_empty(&syncQ)) {
+        candchild = (val_value_t *)dlq_deque(&syncQ);
+        if (res == NO_ERR) {
+            val_add_child(candchild, candval);
+        } else {
+            val_free_value(candchild);
+        }
+    }
+
+    candval->flags &= ~(VAL_FL_DIRTY | VAL_FL_SUBTREE_DIRTY);
+    candval->editop = OP_EDITOP_NONE;
+    val_free_editvars(candval);
+
+    return res;
+
+} /* resync_subtree */
+
+
 
 
 /***************** E X P O R T E D    F U N C T I O N S  ***********/
@@ -612,14 +688,37 @@ status_t
         return ERR_NCX_DATA_MISSING;
     }
 
+    res = NO_ERR;
+
+    /* only the dirty subtrees need to be copied again
+     * if running did not change since the last fill
+     */
+    if (candidate->root &&
+        (candidate->flags & CFG_FL_FILLED) &&
+        candidate->fill_txid == running->last_txid &&
+        !val_get_dirty_flag(candidate->root)) {
+        /* the root never gets the VAL_FL_SUBTREE_DIRTY flag */
+        res = resync_subtree(candidate->root, running->root);
+        if (res == NO_ERR) {
+            candidate->flags &= ~CFG_FL_DIRTY;
+            candidate->last_txid = running->last_txid;
+            candidate->cur_txid = 0;
+            return NO_ERR;
+        }
+        res = NO_ERR;
+    }
+
     if (candidate->root) {
         val_free_value(candidate->root);
         candidate->root = NULL;
     }
 
-    res = NO_ERR;
     candidate->root = val_clone_config_data(running->root, &res);
-    candidate->flags &= ~CFG_FL_DIRTY;
+    candidate->flags &= ~(CFG_FL_DIRTY | CFG_FL_FILLED);
+    if (res == NO_ERR && candidate->root) {
+        candidate->flags |= CFG_FL_FILLED;
+        candidate->fill_txid = running->last_txid;
+    }
     candidate->last_txid = running->last_txid;
     candidate->cur_txid = 0;
     return res;
@@ -627,6 +726,36 @@ status_t
 } /* cfg_fill_candidate_from_running */
 
 
+/********************************************************************
+* FUNCTION cfg_update_candidate_fill_txid
+*
+* Keep the <candidate> filled from the <running> config
+* after a commit of the candidate changes to running
+* Only the dirty subtrees need to be copied from running
+* if the commit was the only change since the last fill
+*
+* INPUTS:
+*    pretxid == running last_txid before the commit
+*********************************************************************/
+void
+    cfg_update_candidate_fill_txid (cfg_transaction_id_t pretxid)
+{
+    cfg_template_t  *running, *candidate;
+
+    running = cfg_arr[NCX_CFGID_RUNNING];
+    candidate = cfg_arr[NCX_CFGID_CANDIDATE];
+    if (running == NULL || candidate == NULL) {
+        return;
+    }
+
+    if ((candidate->flags & CFG_FL_FILLED) &&
+        candidate->fill_txid == pretxid) {
+        candidate->fill_txid = running->last_txid;
+    }
+
+} /* cfg_update_candidate_fill_txid */
+
+
 /********************************************************************
 * FUNCTION cfg_fill_candidate_from_startup
 *
@@ -666,7 +795,7 @@ status_t
     if (candidate->root == NULL) {
         res = ERR_INTERNAL_MEM;
     }
-    candidate->flags &= ~CFG_FL_DIRTY;
+    candidate->flags &= ~(CFG_FL_DIRTY | CFG_FL_FILLED);
     candidate->last_txid = startup->last_txid;
     candidate->cur_txid = 0;
 
@@ -711,7 +840,7 @@ status_t
 
     res = NO_ERR;
     candidate->root = val_clone_config_data(newroot, &res);
-    candidate->flags &= ~CFG_FL_DIRTY;
+    candidate->flags &= ~(CFG_FL_DIRTY | CFG_FL_FILLED);
 
     return res;
 
@@ -1367,6 +1496,11 @@ void
     }
     cfg->root = newroot;
 
+    /* the whole running config was replaced */
+    if (cfg->cfg_id == NCX_CFGID_RUNNING && cfg_arr[NCX_CFGID_CANDIDATE]) {
+        cfg_arr[NCX_CFGID_CANDIDATE]->flags &= ~CFG_FL_FILLED;
+    }
+
 } /* cfg_apply_load_root */
 
 
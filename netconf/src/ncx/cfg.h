@@ -127,6 +127,12 @@ extern "C" {
 #define CFG_FL_TARGET       bit0
 #define CFG_FL_DIRTY        bit1
 
+/* set in the candidate if it is a copy of running,
+ * except for the dirty subtrees, as of the running
+ * last_txid saved in fill_txid
+ */
+#define CFG_FL_FILLED       bit2
+
 #define CFG_INITIAL_TXID (cfg_transaction_id_t)0
 
 /********************************************************************
@@ -181,6 +187,7 @@ typedef struct cfg_template_t_ {
     cfg_state_t    cfg_state;
     cfg_transaction_id_t last_txid;
     cfg_transaction_id_t cur_txid;
+    cfg_transaction_id_t fill_txid;
     xmlChar       *name;
     xmlChar       *src_url;
     xmlChar        lock_time[TSTAMP_MIN_SIZE];
@@ -373,6 +380,21 @@ extern status_t
     cfg_fill_candidate_from_running (void);
 
 
+/********************************************************************
+* FUNCTION cfg_update_candidate_fill_txid
+*
+* Keep the <candidate> filled from the <running> config
+* after a commit of the candidate changes to running
+* Only the dirty subtrees need to be copied from running
+* if the commit was the only change since the last fill
+*
+* INPUTS:
+*    pretxid == running last_txid before the commit
+*********************************************************************/
+extern void
+    cfg_update_candidate_fill_txid (cfg_transaction_id_t pretxid);
+
+
 /********************************************************************
 * FUNCTION cfg_fill_candidate_from_startup
 *
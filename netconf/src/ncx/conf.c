@@ -712,7 +712,7 @@ static status_t
             if (!match) {
                 val_add_child(newparm, val);
             } else if (isdefault) {
-                dlq_remove(curparm);
+                val_remove_child(curparm);
                 val_free_value(curparm);
                 val_add_child(newparm, val);
             } else if (keepvals) {
@@ -738,7 +738,7 @@ static status_t
                         log_debug2("\n");
                     }
                 }
-                dlq_remove(curparm);
+                val_remove_child(curparm);
                 val_free_value(curparm);
                 val_add_child(newparm, val);
             }
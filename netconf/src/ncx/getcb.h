@@ -39,6 +39,11 @@
 
       Retrieve the simple value contents of a virtual value leaf node
 
+    Submodes GETCB_GET_NEXT, GETCB_GET_DONE
+
+      Retrieve the child entries of a virtual complex node
+      one at a time (see getcb_stream_fn_t)
+
 
 *********************************************************************
 *								    *
@@ -88,7 +93,9 @@ extern "C" {
 /* placeholder for expansion modes */
 typedef enum getcb_mode_t_ {
     GETCB_NONE,
-    GETCB_GET_VALUE
+    GETCB_GET_VALUE,
+    GETCB_GET_NEXT,            /* getcb_stream_fn_t: next entry */
+    GETCB_GET_DONE             /* getcb_stream_fn_t: free cursor */
 } getcb_mode_t;
 
 
@@ -117,6 +124,44 @@ typedef status_t
 		   const val_value_t *virval,
 		   val_value_t *dstval);
 
+
+/* getcb_stream_fn_t
+ *
+ * Streaming callback function for agent node get handler
+ * Used instead of getcb_fn_t for a complex virtual node
+ * (see val_init_virtual_stream) so the child entries are
+ * returned one at a time and the whole virtual subtree
+ * is never built while a reply is written.
+ *
+ * INPUTS:
+ *   scb    == session that issued the get (may be NULL)
+ *             can be used for access control purposes
+ *   cbmode == reason for the callback
+ *      GETCB_GET_NEXT: return the next child entry
+ *      GETCB_GET_DONE: iteration finished or abandoned;
+ *                      free any state saved in *cursor
+ *   virval == place-holder node in the data model for
+ *              this virtual value node
+ *   cursor == address of the iteration state owned by the callback;
+ *             *cursor is NULL on the first GETCB_GET_NEXT call
+ *   retval == address of return child entry
+ *
+ * OUTPUTS:
+ *  *cursor may be set to any state needed for the next call
+ *  *retval set to a malloced child value node of virval
+ *     for GETCB_GET_NEXT; the caller will free it after use.
+ *     Set to NULL when there are no more entries
+ *
+ * RETURNS:
+ *    status:
+ */
+typedef status_t
+    (*getcb_stream_fn_t) (ses_cb_t *scb,
+                          getcb_mode_t cbmode,
+                          const val_value_t *virval,
+                          void **cursor,
+                          val_value_t **retval);
+
 #ifdef __cplusplus
 }  /* end extern 'C' */
 #endif
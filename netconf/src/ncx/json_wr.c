@@ -57,6 +57,18 @@ date         init     comment
 #endif
 
 
+/* forward declaration for recursive calls */
+static status_t
+    write_full_check_val (ses_cb_t *scb,
+                          xml_msg_hdr_t *msg,
+                          val_value_t *val,
+                          int32  startindent,
+                          val_nodetest_fn_t testfn,
+                          boolean justone,
+                          boolean isfirst,
+                          boolean isfirstchild);
+
+
 /********************************************************************
 * FUNCTION write_json_string_value
 * 
@@ -86,6 +98,96 @@ static status_t
 } /* write_json_string_value */
 
 
+/********************************************************************
+* FUNCTION write_stream_child_vals
+* 
+* Write the child entries of a streaming virtual value
+* Only the current entry and the next entry are held at once;
+* the next entry is needed to decide if an array is used
+*
+* INPUTS:
+*   scb == session control block
+*   msg == xml_msg_hdr_t in progress
+*   out == streaming virtual value to write
+*   indent == indent amount for the child entries
+*   testcb == callback function to use, NULL if not used
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    write_stream_child_vals (ses_cb_t *scb,
+                             xml_msg_hdr_t *msg,
+                             val_value_t *out,
+                             int32 indent,
+                             val_nodetest_fn_t testfn)
+{
+    dlq_hdr_t          entryQ;
+    val_value_t       *chval, *lastch, *nextch;
+    void              *cursor = NULL;
+    status_t           res = NO_ERR, childres;
+
+    /* keep the entries in a temp Q so the end of an
+     * array can be detected with val_get_next_child
+     */
+    dlq_createSQue(&entryQ);
+    lastch = NULL;
+
+    chval = val_get_next_virtual_entry(scb, out, &cursor, &res);
+    if (chval) {
+        dlq_enque(chval, &entryQ);
+    }
+
+    while (chval) {
+        nextch = val_get_next_virtual_entry(scb, out, &cursor, &res);
+        if (nextch) {
+            dlq_enque(nextch, &entryQ);
+        }
+
+        boolean firstchild = 
+            (lastch && !xml_strcmp(lastch->name, chval->name)) ?
+            FALSE : TRUE;
+        boolean justone = (firstchild &&
+            !(nextch && !xml_strcmp(nextch->name, chval->name))) ?
+            TRUE : FALSE;
+
+        childres = write_full_check_val(scb, 
+                                        msg,
+                                        chval,
+                                        indent,
+                                        testfn,
+                                        justone,
+                                        FALSE,
+                                        firstchild);
+        if (childres == NO_ERR && nextch) {
+            ses_putchar(scb, ',');
+            if (indent >= 0 && 
+                (typ_is_simple(nextch->btyp) || 
+                 xml_strcmp(nextch->name, chval->name))) {
+                ses_indent(scb, indent);
+                ses_putchar(scb, ' ');
+            }
+        }
+
+        if (lastch) {
+            dlq_remove(lastch);
+            val_free_value(lastch);
+        }
+        lastch = chval;
+        chval = nextch;
+    }
+
+    if (lastch) {
+        dlq_remove(lastch);
+        val_free_value(lastch);
+    }
+    val_finish_virtual_entries(scb, out, &cursor);
+
+    return res;
+
+}  /* write_stream_child_vals */
+
+
 /********************************************************************
 * FUNCTION write_full_check_val
 * 
@@ -208,9 +310,14 @@ static status_t
         ses_indent(scb, indent);
         ses_putchar(scb, '{');
 
-        for (chval = val_get_first_child(out); 
-             chval != NULL; 
-             chval = nextch) {
+        if (val_is_virtual_stream(out)) {
+            res = write_stream_child_vals(scb, msg, out, indent, testfn);
+            chval = NULL;
+        } else {
+            chval = val_get_first_child(out);
+        }
+
+        for (; chval != NULL; chval = nextch) {
 
             /* JSON ignores XML namespaces, so foo:a and bar:a
              * are both encoded in the same array
@@ -413,6 +413,8 @@ extern "C" {
 #define NCX_EL_BYTE            (const xmlChar *)"byte"
 #define NCX_EL_C               (const xmlChar *)"c"
 #define NCX_EL_CPP_TEST        (const xmlChar *)"cpp_test"
+#define NCX_EL_CACHE_STALE_TIMEOUT (const xmlChar *)"cache-stale-timeout"
+#define NCX_EL_CACHE_TIMEOUT   (const xmlChar *)"cache-timeout"
 #define NCX_EL_CANCEL          (const xmlChar *)"cancel"
 #define NCX_EL_CANCEL_COMMIT   (const xmlChar *)"cancel-commit"
 #define NCX_EL_CANDIDATE       (const xmlChar *)"candidate"
@@ -730,6 +732,15 @@ extern "C" {
 #define NCX_EL_YIN             (const xmlChar *)"yin"
 #define NCX_EL_YUMA_HOME       (const xmlChar *)"yuma-home"
 #define NCX_EL_MAX_SESSIONS    (const xmlChar *)"max-sessions"
+#define NCX_EL_MAX_OUTPUT_BUFFER_SIZE \
+    (const xmlChar *)"max-output-buffer-size"
+#define NCX_EL_EVENTLOG_DIR    (const xmlChar *)"eventlog-dir"
+#define NCX_EL_EVENTLOG_SEGMENT_SIZE \
+    (const xmlChar *)"eventlog-segment-size"
+#define NCX_EL_EVENTLOG_SEGMENT_AGE \
+    (const xmlChar *)"eventlog-segment-age"
+#define NCX_EL_EVENTLOG_SEGMENT_COUNT \
+    (const xmlChar *)"eventlog-segment-count"
 
 /* bit definitions for ncx_lstr_t flags field */
 #define NCX_FL_RANGE_ERR   bit0
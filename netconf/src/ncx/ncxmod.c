@@ -27,18 +27,27 @@ date         init     comment
 *                                                                   *
 *********************************************************************/
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <poll.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <pwd.h>
 #include <dirent.h>
+#include <time.h>
 #include <unistd.h>
 #include <xmlstring.h>
 #include <xmlreader.h>
 
 #include "procdefs.h"
+#include "bobhash.h"
+#include "dlq.h"
 #include "help.h"
 #include "log.h"
 #include "ncx.h"
@@ -46,6 +55,7 @@ date         init     comment
 #include "ncxtypes.h"
 #include "ncxmod.h"
 #include "status.h"
+#include "tk.h"
 #include "tstamp.h"
 #include "xml_util.h"
 #include "yangconst.h"
@@ -78,6 +88,92 @@ typedef enum search_type_t_ {
 } search_type_t;
 
 
+/* number of hash bits for the module search index of one
+ * search directory; the hash key is the module name
+ */
+#define NCXMOD_INDEX_HASH_BITS  10
+
+/* minimum number of seconds between two checks of the
+ * directory mtimes in a module search index
+ */
+#define NCXMOD_INDEX_CHECK_SECS  2
+
+/* first line of a module search index cache file */
+#define NCXMOD_INDEX_CACHE_HDR  "yuma-module-index 2"
+
+/* number of hash bits for the table of modules already
+ * requested from the module prefetch workers
+ */
+#define NCXMOD_PREFETCH_HASH_BITS  10
+
+/* maximum number of module prefetch worker processes */
+#define NCXMOD_MAX_LOAD_JOBS  64
+
+/* size of the reply buffer of a module prefetch worker;
+ * longer module names are not reported by the worker
+ */
+#define NCXMOD_PREFETCH_BUFFLEN  512
+
+
+/* one module file found in a module search index */
+typedef struct ncxmod_idxfile_t_ {
+    struct ncxmod_idxfile_t_ *hashnext;     /* hash bucket chain */
+    xmlChar          *filename;    /* modname[@revision].yang|yin */
+    uint32            modnamelen;
+    const xmlChar    *revision;    /* points into filename or NULL */
+    uint32            revisionlen;
+    uint32            dirnum;      /* index into the dirtab */
+    boolean           isyang;
+    boolean           isreg;       /* FALSE if not a regular file */
+} ncxmod_idxfile_t;
+
+
+/* one directory in a module search index */
+typedef struct ncxmod_idxdir_t_ {
+    xmlChar          *path;        /* ends with NCXMOD_PSCHAR */
+    boolean           found;       /* FALSE if not a directory */
+    long              mtime;
+    long              mtime_nsec;
+} ncxmod_idxdir_t;
+
+
+/* index of the module files in one search directory;
+ * the dirtab is in the order search_subdirs checks
+ * the directories, so a lower dirnum is found first
+ */
+typedef struct ncxmod_index_t_ {
+    dlq_hdr_t          qhdr;
+    xmlChar           *rootpath;   /* ends with NCXMOD_PSCHAR */
+    boolean            dive;       /* TRUE if subdirs are indexed */
+    ncxmod_idxdir_t   *dirtab;
+    uint32             dircnt;
+    uint32             dirmax;
+    time_t             checktime;  /* last mtime check */
+    ncxmod_idxfile_t  *hashtab[hashsize(NCXMOD_INDEX_HASH_BITS)];
+} ncxmod_index_t;
+
+
+/* one module requested from the prefetch workers;
+ * kept in the hash table so it is only requested once
+ */
+typedef struct ncxmod_pfmod_t_ {
+    dlq_hdr_t                qhdr;       /* pending request Q */
+    struct ncxmod_pfmod_t_  *hashnext;   /* hash bucket chain */
+    xmlChar                 *modname;    /* name or filespec */
+    xmlChar                 *revision;   /* NULL if not set */
+} ncxmod_pfmod_t;
+
+
+/* one module prefetch worker process */
+typedef struct ncxmod_pfworker_t_ {
+    pid_t              pid;
+    int                fd;         /* socket to the worker or -1 */
+    boolean            busy;       /* waiting for a reply */
+    uint32             bufflen;    /* bytes of reply in buff */
+    char               buff[NCXMOD_PREFETCH_BUFFLEN];
+} ncxmod_pfworker_t;
+
+
 /********************************************************************
 *                                                                   *
 *                       V A R I A B L E S                           *
@@ -113,6 +209,25 @@ static xmlChar *ncxmod_run_path_cli;
 
 static boolean ncxmod_subdirs;
 
+/* Q of ncxmod_index_t, one entry per module search directory */
+static dlq_hdr_t ncxmod_indexQ;
+
+/* module search index cache file; NULL if not used */
+static xmlChar *ncxmod_index_cache;
+
+static boolean ncxmod_index_cache_loaded;
+
+/* YANG token cache directory; NULL if not used */
+static xmlChar *ncxmod_tkcache;
+
+/* number of module prefetch worker processes;
+ * 0 or 1 if the modules are not prefetched
+ */
+static uint32 ncxmod_load_jobs;
+
+/* modules already requested from the prefetch workers */
+static ncxmod_pfmod_t *ncxmod_pfhashtab[hashsize(NCXMOD_PREFETCH_HASH_BITS)];
+
 
 /********************************************************************
 * FUNCTION is_yang_file
@@ -1064,1556 +1179,3346 @@ static status_t
 
 
 /********************************************************************
-* FUNCTION list_subdirs
+* FUNCTION clean_index
 *
-* List the relevant files in the subdir
+* Free all the directories and files in a module search index
 *
 * INPUTS:
-*    buff == buffer to use for filespec construction
-*            at the start it contains the path string to use;
-*            new directory names will be added to this buffer
-*            as the subdirs are traversed
-*    bufflen == size of buff in bytes
-*    searchtype == enum for the search type to use
-*    helpmode == help mode to use (BRIEF, NORMAL, FULL)
-*    logstdout == TRUE for log_stdout, FALSE for log_write
-*    dive == TRUE to list subdirs; FALSE to list just the
-*            specified directory
+*    idx == module search index to clean
 *
-* RETURNS:
-*    NO_ERR if file found okay, full filespec in the 'buff' variable
-*    OR some error if not found or buffer overflow
 *********************************************************************/
-static status_t
-    list_subdirs (xmlChar *buff,
-                  uint32 bufflen,
-                  search_type_t searchtype,
-                  help_mode_t helpmode,
-                  boolean logstdout,
-                  boolean dive)
+static void
+    clean_index (ncxmod_index_t *idx)
 {
-    DIR           *dp;
-    struct dirent *ep;
-    xmlChar       *str;
-    uint32         pathlen, dentlen;
-    boolean        dirdone, isyang, isyin;
-    status_t       res;
+    ncxmod_idxfile_t  *file;
+    uint32             i;
 
-    res = NO_ERR;
-    dentlen = 0;
-    pathlen = xml_strlen(buff);
+    for (i = 0; i < hashsize(NCXMOD_INDEX_HASH_BITS); i++) {
+        while (idx->hashtab[i] != NULL) {
+            file = idx->hashtab[i];
+            idx->hashtab[i] = file->hashnext;
+            m__free(file->filename);
+            m__free(file);
+        }
+    }
 
-    /* try to open the buffer spec as a directory */
-    dp = opendir((const char *)buff);
-    if (!dp) {
-        return NO_ERR;  /* not done yet */
+    for (i = 0; i < idx->dircnt; i++) {
+        m__free(idx->dirtab[i].path);
     }
+    if (idx->dirtab != NULL) {
+        m__free(idx->dirtab);
+    }
+    idx->dirtab = NULL;
+    idx->dircnt = 0;
+    idx->dirmax = 0;
 
-    /* list top-down:
-     * first all the files first from this directory
-     * then files from any subdirs
-     */
-    dirdone = FALSE;
-    while (!dirdone) {
+}  /* clean_index */
 
-        ep = readdir(dp);
-        if (!ep) {
-            dirdone = TRUE;
-            continue;
-        }
 
-        if (ep->d_type == DT_REG || ep->d_type == DT_UNKNOWN) {
+/********************************************************************
+* FUNCTION free_index
+*
+* Free a module search index
+*
+* INPUTS:
+*    idx == module search index to free
+*
+*********************************************************************/
+static void
+    free_index (ncxmod_index_t *idx)
+{
+    clean_index(idx);
+    if (idx->rootpath != NULL) {
+        m__free(idx->rootpath);
+    }
+    m__free(idx);
 
-            /* skip files that start with a dot char */
-            if (*ep->d_name == '.') {
-                continue;
-            }
+}  /* free_index */
 
-            isyang = is_yang_file((const xmlChar *)ep->d_name);
-            isyin = is_yin_file((const xmlChar *)ep->d_name);
 
-            /* check if this file needs to be listed */
-            switch (searchtype) {
-            case SEARCH_TYPE_MODULE:
-                if (isyang || isyin) {
-                    break;
-                }
-                continue;
-            case SEARCH_TYPE_DATA:
-            case SEARCH_TYPE_SCRIPT:
-                if (isyang || isyin) {
-                    continue;
-                }
-                break;
-            case SEARCH_TYPE_NONE:
-            default:
-                dirdone = TRUE;
-                SET_ERROR(ERR_INTERNAL_VAL);
-                continue;
+/********************************************************************
+* FUNCTION new_index
+*
+* Malloc an empty module search index
+*
+* INPUTS:
+*    rootpath == search directory, ending with NCXMOD_PSCHAR
+*    dive == TRUE if the subdirs are indexed
+*
+* RETURNS:
+*    malloced index or NULL if malloc failed
+*********************************************************************/
+static ncxmod_index_t *
+    new_index (const xmlChar *rootpath,
+               boolean dive)
+{
+    ncxmod_index_t *idx;
 
-            }
+    idx = m__getObj(ncxmod_index_t);
+    if (idx == NULL) {
+        return NULL;
+    }
+    memset(idx, 0x0, sizeof(ncxmod_index_t));
 
-            /* list the file */
-            if (logstdout) {
-                log_stdout_indent(NCX_DEF_INDENT);
-                if (helpmode == HELP_MODE_FULL) {
-                    log_stdout((const char *)buff);
-                }
-                log_stdout(ep->d_name);
-                if (helpmode != HELP_MODE_BRIEF) {
-                    ;
-                }
-            } else {
-                log_indent(NCX_DEF_INDENT);
-                if (helpmode == HELP_MODE_FULL) {
-                    log_write((const char *)buff);
-                }
-                log_write(ep->d_name);
-                if (helpmode != HELP_MODE_BRIEF) {
-                    ;
-                }
-            }
-        }
+    idx->rootpath = xml_strdup(rootpath);
+    if (idx->rootpath == NULL) {
+        m__free(idx);
+        return NULL;
     }
+    idx->dive = dive;
+    return idx;
 
-    (void)closedir(dp);
+}  /* new_index */
 
-    if (!dive) {
-        return NO_ERR;
+
+/********************************************************************
+* FUNCTION index_add_dir
+*
+* Add a directory to the end of a module search index
+*
+* INPUTS:
+*    idx == module search index to use
+*    path == directory path, ending with NCXMOD_PSCHAR
+*    found == TRUE if the directory exists
+*    mtime == directory mtime seconds
+*    mtime_nsec == directory mtime nanoseconds
+*    dirnum == address of return directory number
+*
+* OUTPUTS:
+*    *dirnum == dirtab index of the new entry
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    index_add_dir (ncxmod_index_t *idx,
+                   const xmlChar *path,
+                   boolean found,
+                   long mtime,
+                   long mtime_nsec,
+                   uint32 *dirnum)
+{
+    ncxmod_idxdir_t  *newtab;
+    uint32            newmax;
+
+    if (idx->dircnt == idx->dirmax) {
+        newmax = (idx->dirmax) ? idx->dirmax * 2 : 16;
+        newtab = m__getMem(newmax * sizeof(ncxmod_idxdir_t));
+        if (newtab == NULL) {
+            return ERR_INTERNAL_MEM;
+        }
+        if (idx->dirtab != NULL) {
+            memcpy(newtab, idx->dirtab, 
+                   idx->dircnt * sizeof(ncxmod_idxdir_t));
+            m__free(idx->dirtab);
+        }
+        idx->dirtab = newtab;
+        idx->dirmax = newmax;
     }
 
-    /* try to open the buffer spec as a directory */
-    dp = opendir((const char *)buff);
-    if (!dp) {
-        return NO_ERR;
+    idx->dirtab[idx->dircnt].path = xml_strdup(path);
+    if (idx->dirtab[idx->dircnt].path == NULL) {
+        return ERR_INTERNAL_MEM;
     }
+    idx->dirtab[idx->dircnt].found = found;
+    idx->dirtab[idx->dircnt].mtime = mtime;
+    idx->dirtab[idx->dircnt].mtime_nsec = mtime_nsec;
+    *dirnum = idx->dircnt++;
+    return NO_ERR;
 
-    /* go through again but this time just dive into the subdirs */
-    dirdone = FALSE;
-    while (!dirdone) {
+}  /* index_add_dir */
 
-        ep = readdir(dp);
-        if (!ep) {
-            dirdone = TRUE;
-            continue;
-        }
 
-        /* this field may not be present on all POSIX systems
-         * according to the glibc 2.7 documentation!!
-         * only using dir file which works on linux. 
-         * !!!No support for symbolic links at this time!!!
-         * If d_type == DT_UNKNOWN then guessing this is a file
-         *
-         * Always skip any directory or file that starts with
-         * the dot-char or is named CVS
-         */
-        dentlen = xml_strlen((const xmlChar *)ep->d_name); 
+/********************************************************************
+* FUNCTION index_add_file
+*
+* Add a file to a module search index if the filename
+* has the form modname[@revision].yang or modname[@revision].yin
+*
+* INPUTS:
+*    idx == module search index to use
+*    dirnum == dirtab index of the directory containing the file
+*    filename == name of the file to add
+*    isreg == TRUE if the file is a regular file
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    index_add_file (ncxmod_index_t *idx,
+                    uint32 dirnum,
+                    const xmlChar *filename,
+                    boolean isreg)
+{
+    ncxmod_idxfile_t  *file;
+    const xmlChar     *str;
+    uint32             baselen, h;
+    boolean            isyang;
 
-        /* this dive-first behavior is not really what is desired
-         * but do not have a 'stat' function for partial filenames
-         * so just going through the directory block in order
-         */
-        if (ep->d_type == DT_DIR || ep->d_type == DT_UNKNOWN) {
-            if (*ep->d_name != '.' && strcmp(ep->d_name, "CVS")) {
-                if ((pathlen + dentlen + 2) >= bufflen) {
-                    res = ERR_BUFF_OVFL;
-                    dirdone = TRUE;
-                } else {
-                    /* make sure last dirspec ends witha path-sep-char */
-                    if (pathlen > 0 && buff[pathlen-1] != NCXMOD_PSCHAR) {
-                        buff[pathlen] = NCXMOD_PSCHAR;
-                        str = &buff[pathlen+1];
-                        str += xml_strcpy(str, (const xmlChar *)ep->d_name);
-                    } else {
-                        str = &buff[pathlen];
-                        str += xml_strcpy(str, (const xmlChar *)ep->d_name);
-                    }
-                    *str++ = NCXMOD_PSCHAR;
-                    *str = '\0';
+    if (is_yang_file(filename)) {
+        isyang = TRUE;
+        baselen = xml_strlen(filename) - 5;
+    } else if (is_yin_file(filename)) {
+        isyang = FALSE;
+        baselen = xml_strlen(filename) - 4;
+    } else {
+        return NO_ERR;
+    }
 
-                    res = list_subdirs(buff, bufflen, searchtype, helpmode,
-                                       logstdout, TRUE);
-                    /* erase the filename and keep trying */
-                    buff[pathlen] = 0;
-                    if (res != NO_ERR) {
-                        dirdone = TRUE;
-                        continue;
-                    }
-                }
+    file = m__getObj(ncxmod_idxfile_t);
+    if (file == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(file, 0x0, sizeof(ncxmod_idxfile_t));
+
+    file->filename = xml_strdup(filename);
+    if (file->filename == NULL) {
+        m__free(file);
+        return ERR_INTERNAL_MEM;
+    }
+    file->dirnum = dirnum;
+    file->isyang = isyang;
+    file->isreg = isreg;
+
+    /* same test as search_subdirs: foo@YYYY-MM-DD.yang */
+    file->modnamelen = baselen;
+    for (str = file->filename; str < &file->filename[baselen]; str++) {
+        if (*str == '@') {
+            if (baselen - (uint32)(str - file->filename) == 11) {
+                file->modnamelen = (uint32)(str - file->filename);
+                file->revision = str + 1;
+                file->revisionlen = 10;
             }
+            break;
         }
     }
 
-    (void)closedir(dp);
-    return res;
+    h = bobhash(file->filename, file->modnamelen, 0) & 
+        hashmask(NCXMOD_INDEX_HASH_BITS);
+    file->hashnext = idx->hashtab[h];
+    idx->hashtab[h] = file;
+    return NO_ERR;
 
-}  /* list_subdirs */
+}  /* index_add_file */
 
 
 /********************************************************************
-* FUNCTION list_pathlist
+* FUNCTION index_dir
 *
-* Check the filespec path string and list files in each dir
+* Add a directory and all the module files in it to the
+* module search index; add the subdirs as well if idx->dive
+*
+* The directories are numbered in the order search_subdirs
+* checks them.  Symbolic links to directories are not
+* followed, and directories that start with the dot-char
+* or are named CVS are skipped, the same as search_subdirs
 *
 * INPUTS:
-*    pathstr == pathstring list to check
-*    buff == scratch buffer to use
-*    bufflen == length of buff
-*    searchtype == search type to use
-*    helpmode == verbosity mode (BRIEF, NORMAL, FULL)
-*    logstdout == TRUE for log_stdout, FALSE for log_write
+*    idx == module search index to use
+*    buff == buffer with the directory path; subdir names
+*            are added to this buffer and removed again
+*    bufflen == size of buff in bytes
 *
 * RETURNS:
 *    status
 *********************************************************************/
 static status_t
-    list_pathlist (const xmlChar *pathlist,
-                   xmlChar *buff,
-                   uint32 bufflen,
-                   search_type_t  searchtype,
-                   help_mode_t helpmode,
-                   boolean logstdout)
+    index_dir (ncxmod_index_t *idx,
+               xmlChar *buff,
+               uint32 bufflen)
 {
-    const xmlChar *str, *p;
-    uint32         len;
-    status_t       res;
+    DIR           *dp;
+    struct dirent *ep;
+    struct stat    statbuf;
+    uint32         pathlen, dentlen, dirnum;
+    int            ret;
+    boolean        isdir, isreg, ismod;
+    status_t       res;
 
-    res = NO_ERR;
-    str = pathlist;
+    pathlen = xml_strlen(buff);
+    if (pathlen == 0 || pathlen + 1 >= bufflen) {
+        return ERR_BUFF_OVFL;
+    }
+    if (buff[pathlen-1] != NCXMOD_PSCHAR) {
+        buff[pathlen++] = NCXMOD_PSCHAR;
+        buff[pathlen] = 0;
+    }
 
-    /* go through the path list and check each string */
-    while (*str) {
-        /* find end of path entry or EOS */
-        p = str+1;
-        while (*p && *p != ':') {
-            p++;
-        }
-        len = (uint32)(p-str);
-        if (len >= bufflen) {
-            return ERR_BUFF_OVFL;
-        }
+    memset(&statbuf, 0x0, sizeof(statbuf));
+    ret = stat((const char *)buff, &statbuf);
+    if (ret != 0 || !S_ISDIR(statbuf.st_mode)) {
+        /* record the missing dir so it is noticed if it appears */
+        return index_add_dir(idx, buff, FALSE, 0, 0, &dirnum);
+    }
 
-        /* copy the next string into buff */
-        xml_strncpy(buff, str, len);
+    res = index_add_dir(idx, buff, TRUE, (long)statbuf.st_mtime,
+                        (long)statbuf.st_mtim.tv_nsec, &dirnum);
+    if (res != NO_ERR) {
+        return res;
+    }
 
-        /* make sure string ends with path sep char */
-        if (buff[len-1] != NCXMOD_PSCHAR) {
-            if (len+1 >= bufflen) {
-                return ERR_BUFF_OVFL;
-            } else {
-                buff[len++] = NCXMOD_PSCHAR;
-            }
+    dp = opendir((const char *)buff);
+    if (!dp) {
+        return NO_ERR;
+    }
+
+    while (res == NO_ERR && (ep = readdir(dp)) != NULL) {
+        if (*ep->d_name == '.') {
+            continue;
         }
 
-        /* list all the requested files in this path */
-        res = list_subdirs(buff, bufflen, searchtype, helpmode, logstdout,
-                           FALSE);
+        dentlen = xml_strlen((const xmlChar *)ep->d_name);
+        if (pathlen + dentlen + 1 >= bufflen) {
+            res = ERR_BUFF_OVFL;
+            continue;
+        }
+        xml_strcpy(&buff[pathlen], (const xmlChar *)ep->d_name);
+
+        ismod = (is_yang_file(&buff[pathlen]) || 
+                 is_yin_file(&buff[pathlen]));
+        isdir = FALSE;
+        isreg = FALSE;
+
+        switch (ep->d_type) {
+        case DT_DIR:
+            isdir = TRUE;
+            break;
+        case DT_REG:
+            isreg = TRUE;
+            break;
+        case DT_LNK:
+            /* a module file can be a link; a directory is
+             * not searched through a link   */
+            if (ismod && stat((const char *)buff, &statbuf) == 0) {
+                isreg = S_ISREG(statbuf.st_mode) ? TRUE : FALSE;
+            }
+            break;
+        case DT_UNKNOWN:
+            if (stat((const char *)buff, &statbuf) == 0) {
+                isdir = S_ISDIR(statbuf.st_mode) ? TRUE : FALSE;
+                isreg = S_ISREG(statbuf.st_mode) ? TRUE : FALSE;
+            }
+            break;
+        default:
+            ;
+        }
 
-        if (res != NO_ERR) {
-            return res;
+        if (ismod) {
+            res = index_add_file(idx, dirnum, &buff[pathlen], isreg);
         }
-    
-        /* setup the next path string to try */
-        if (*p) {
-            str = p+1;   /* one past ':' char */
-        } else {
-            str = p;        /* already at EOS */
+
+        if (res == NO_ERR && isdir && idx->dive && 
+            strcmp(ep->d_name, "CVS")) {
+            res = index_dir(idx, buff, bufflen);
         }
+        buff[pathlen] = 0;
     }
 
+    (void)closedir(dp);
+    buff[pathlen] = 0;
     return res;
 
-}  /* list_pathlist */
+}  /* index_dir */
 
 
 /********************************************************************
-* FUNCTION add_failed
+* FUNCTION build_index
 *
-* Add a yang_node_t entry to the pcb->failedQ
+* Read the directories of a module search index again
 *
 * INPUTS:
-*   modname == failed module name
-*   revision == failed revision date (may be NULL)
-*   pcb == parser control block
-*   res == final result status for the failed module
+*    idx == module search index to build
 *
 * RETURNS:
-*   status
+*    status
 *********************************************************************/
-static status_t 
-    add_failed (const xmlChar *modname,
-                const xmlChar *revision,
-                yang_pcb_t *pcb,
-                status_t res)
+static status_t
+    build_index (ncxmod_index_t *idx)
 {
-    yang_node_t *node;
+    xmlChar   *buff;
+    uint32     bufflen;
+    status_t   res;
 
-    /* do not save failed modules based on a failed search
-     * or if the module is not really being added to the registry
-     */
-    if (pcb->searchmode || pcb->parsemode) {
-        return NO_ERR;
-    }
+    clean_index(idx);
 
-    node = yang_new_node();
-    if (!node) {
+    bufflen = NCXMOD_MAX_FSPEC_LEN+1;
+    buff = m__getMem(bufflen);
+    if (!buff) {
         return ERR_INTERNAL_MEM;
     }
+    xml_strncpy(buff, idx->rootpath, NCXMOD_MAX_FSPEC_LEN);
 
-    node->failed = xml_strdup(modname);
-    if (!node->failed) {
-        yang_free_node(node);
-        return ERR_INTERNAL_MEM;
+    res = index_dir(idx, buff, bufflen);
+
+    m__free(buff);
+
+    if (LOGDEBUG2) {
+        log_debug2("\nncxmod: indexed %u dirs in '%s' (%s)",
+                   idx->dircnt, idx->rootpath, get_error_string(res));
     }
+    return res;
 
-    if (revision) {
-        node->failedrev = xml_strdup(revision);
-        if (!node->failed) {
-            yang_free_node(node);
-            return ERR_INTERNAL_MEM;
+}  /* build_index */
+
+
+/********************************************************************
+* FUNCTION check_index
+*
+* Check if the directories in a module search index have changed
+* Adding, removing or renaming a module file or a subdir
+* changes the mtime of the directory containing it
+*
+* INPUTS:
+*    idx == module search index to check
+*
+* RETURNS:
+*    TRUE if the index is still valid
+*    FALSE if the index needs to be built again
+*********************************************************************/
+static boolean
+    check_index (const ncxmod_index_t *idx)
+{
+    const ncxmod_idxdir_t *dir;
+    struct stat            statbuf;
+    uint32                 i;
+    boolean                found;
+
+    for (i = 0; i < idx->dircnt; i++) {
+        dir = &idx->dirtab[i];
+        memset(&statbuf, 0x0, sizeof(statbuf));
+        found = (stat((const char *)dir->path, &statbuf) == 0 &&
+                 S_ISDIR(statbuf.st_mode)) ? TRUE : FALSE;
+        if (found != dir->found) {
+            return FALSE;
+        }
+        if (found && (dir->mtime != (long)statbuf.st_mtime ||
+                      dir->mtime_nsec != (long)statbuf.st_mtim.tv_nsec)) {
+            return FALSE;
         }
     }
+    return TRUE;
 
-    node->name = node->failed;
-    node->revision = node->failedrev;
-    node->res = res;
-    dlq_enque(node, &pcb->failedQ);
-    return NO_ERR;
-
-} /* add_failed */
+}  /* check_index */
 
 
 /********************************************************************
-* FUNCTION check_module_path
+* FUNCTION find_index
 *
-*  Check the specified path for a YANG module file
+* Find a module search index in the ncxmod_indexQ
 *
 * INPUTS:
-*   path == starting path to check
-*   buff == buffer to use for the filespec
-*   bufflen == size of 'buff' in bytes
-*   modname == module name to find (no file suffix)
-*   revision == module revision date (may be NULL)
-*   pcb == parser control block in progress
-*   ptyp == parser source type
-*   usepath == TRUE if path should be used directly
-*              FALSE if the path should be appended with the 'modules' dir
-*   done == address of return done flag
-*
-* OUTPUTS:
-*   *done == TRUE if file found or fatal error
-*    file completely processed in try_module if file found
+*    indexQ == Q of ncxmod_index_t to check
+*    rootpath == search directory
+*    dive == TRUE if the subdirs are indexed
 *
 * RETURNS:
-*   status
+*    pointer to the index or NULL if not found
 *********************************************************************/
-static status_t
-    check_module_path (const xmlChar *path,
-                       xmlChar *buff,
-                       uint32 bufflen,
-                       const xmlChar *modname,
-                       const xmlChar *revision,
-                       yang_pcb_t *pcb,
-                       yang_parsetype_t ptyp,
-                       boolean usepath,
-                       boolean *done)
+static ncxmod_index_t *
+    find_index (dlq_hdr_t *indexQ,
+                const xmlChar *rootpath,
+                boolean dive)
 {
-    const xmlChar  *path2;
-    uint32          total;
-    status_t        res, res2;
+    ncxmod_index_t *idx;
 
-    *done = FALSE;
-    res = NO_ERR;
-    res2 = NO_ERR;
-    /* T == use path directly, leave path2 NULL
-     * F == add 'modules' to end of path by setting path2
-     */
-    path2 = (usepath) ? NULL : NCXMOD_DIR;
+    for (idx = (ncxmod_index_t *)dlq_firstEntry(indexQ);
+         idx != NULL;
+         idx = (ncxmod_index_t *)dlq_nextEntry(idx)) {
+        if (idx->dive == dive && !xml_strcmp(idx->rootpath, rootpath)) {
+            return idx;
+        }
+    }
+    return NULL;
 
-    total = xml_strlen(path);
-    if (total >= bufflen) {
-        *done = TRUE;
-        return ERR_BUFF_OVFL;
+}  /* find_index */
+
+
+/********************************************************************
+* FUNCTION save_index_cache
+*
+* Write all the module search indexes to the cache file
+* The file is written to a temp file and then renamed
+* The last line holds the number of index lines, so
+* a truncated file is not accepted by load_index_cache
+*
+*********************************************************************/
+static void
+    save_index_cache (void)
+{
+    const ncxmod_index_t   *idx;
+    const ncxmod_idxfile_t *file;
+    xmlChar                *tempfile;
+    FILE                   *fp;
+    uint32                  i, linecnt;
+    int                     ret;
+
+    if (ncxmod_index_cache == NULL) {
+        return;
     }
 
-    if (ncxmod_subdirs) {
-        res = prep_dirpath(buff, bufflen, path, path2, &total);
-        if (res != NO_ERR) {
-            *done = TRUE;
-            return res;
-        }
+    tempfile = m__getMem(xml_strlen(ncxmod_index_cache) + 16);
+    if (tempfile == NULL) {
+        return;
+    }
+    sprintf((char *)tempfile, "%s.%u",
+            (const char *)ncxmod_index_cache,
+            (uint32)getpid());
 
-        /* try YANG or YIN file */
-        res = search_subdirs(buff, bufflen, modname, revision, done);
-        if (*done && res == NO_ERR) {
+    fp = fopen((const char *)tempfile, "w");
+    if (fp == NULL) {
+        log_debug("\nncxmod: cannot write module index cache '%s'",
+                  tempfile);
+        m__free(tempfile);
+        return;
+    }
 
-            res = try_module(buff, 
-                             bufflen, 
-                             NULL, 
-                             NULL,
-                             NULL, 
-                             NULL,
-                             yang_fileext_is_yang(buff) ? 
-                             NCXMOD_MODE_FILEYANG : 
-                             NCXMOD_MODE_FILEYIN,
-                             TRUE, 
-                             done, 
-                             pcb, 
-                             ptyp);
-            if (res != NO_ERR) {
-                res2 = add_failed(modname, 
-                                  revision,
-                                  pcb, 
-                                  res);
+    linecnt = 0;
+    ret = fprintf(fp, "%s\n", NCXMOD_INDEX_CACHE_HDR);
+    for (idx = (const ncxmod_index_t *)dlq_firstEntry(&ncxmod_indexQ);
+         idx != NULL && ret >= 0;
+         idx = (const ncxmod_index_t *)dlq_nextEntry(idx)) {
+        ret = fprintf(fp, "R %u %s\n", (uint32)idx->dive, idx->rootpath);
+        linecnt++;
+        for (i = 0; i < idx->dircnt && ret >= 0; i++) {
+            ret = fprintf(fp, "D %u %ld %ld %s\n", 
+                          (uint32)idx->dirtab[i].found,
+                          idx->dirtab[i].mtime,
+                          idx->dirtab[i].mtime_nsec,
+                          idx->dirtab[i].path);
+            linecnt++;
+        }
+        for (i = 0; i < hashsize(NCXMOD_INDEX_HASH_BITS); i++) {
+            for (file = idx->hashtab[i]; 
+                 file != NULL && ret >= 0; 
+                 file = file->hashnext) {
+                ret = fprintf(fp, "F %u %u %s\n", file->dirnum,
+                              (uint32)file->isreg, file->filename);
+                linecnt++;
             }
         }
-        return (res != NO_ERR) ? res : res2;
     }
-
-    /* else subdir searches not allowed
-     * check for YANG file in the current path
-     */
-    res = try_module(buff,
-                     bufflen, 
-                     path,
-                     path2,
-                     modname,
-                     revision,
-                     NCXMOD_MODE_YANG,
-                     FALSE, 
-                     done,
-                     pcb,
-                     ptyp);
-
-    if (!*done && res == NO_ERR) {
-        /* check for YIN file in the current path */
-        res = try_module(buff,
-                         bufflen, 
-                         path,
-                         path2,
-                         modname,
-                         revision,
-                         NCXMOD_MODE_YIN,
-                         FALSE, 
-                         done,
-                         pcb,
-                         ptyp);
+    if (ret >= 0) {
+        ret = fprintf(fp, "E %u\n", linecnt);
     }
 
-    if (*done && res != NO_ERR) {
-        res2 = add_failed(modname,
-                          revision,
-                          pcb,
-                          res);
+    if (fclose(fp) != 0 || ret < 0 ||
+        rename((const char *)tempfile, 
+               (const char *)ncxmod_index_cache) != 0) {
+        log_debug("\nncxmod: cannot write module index cache '%s'",
+                  ncxmod_index_cache);
+        (void)unlink((const char *)tempfile);
     }
-    return (res != NO_ERR) ? res : res2;
+    m__free(tempfile);
 
-}  /* check_module_path */
+}  /* save_index_cache */
 
 
 /********************************************************************
-* FUNCTION check_module_pathlist
-*
-*  Check a list of pathnames for the specified path of 
-*  a YANG module file
-*
-*  Example:   path1:path2:path3
-*
-* INPUTS:
-*   pathlist == formatted string containing list of path strings
-*   buff == buffer to use for the filespec
-*   bufflen == size of 'buff' in bytes
-*   modname == module name to find (no file suffix)
-*   revision == module revision date (may be NULL)
-*   pcb == parser control block in progress
-*   ptyp == parser source type
-*   done == address of return done flag
+* FUNCTION load_index_cache
 *
-* OUTPUTS:
-*   *done == TRUE if file found or fatal error
-*    file completely processed in try_module if file found
+* Read the module search indexes from the cache file
+* The indexes are checked against the directory mtimes
+* the first time they are used
+* The whole file is ignored if the end line is missing
+* or does not match the number of index lines
 *
-* RETURNS:
-*   status
 *********************************************************************/
-static status_t
-    check_module_pathlist (const xmlChar *pathlist,
-                           xmlChar *buff,
-                           uint32 bufflen,
-                           const xmlChar *modname,
-                           const xmlChar *revision,
-                           yang_pcb_t *pcb,
-                           yang_parsetype_t ptyp,
-                           boolean *done)
+static void
+    load_index_cache (void)
 {
-    const xmlChar  *str, *p;
-    xmlChar        *pathbuff;
-    uint32          pathbufflen, pathlen;
-    status_t        res;
+    dlq_hdr_t        tempQ;
+    ncxmod_index_t  *idx;
+    xmlChar         *buff;
+    FILE            *fp;
+    uint32           bufflen, len, dirnum, flag1, flag2;
+    uint32           linecnt, endcnt;
+    long             mtime, mtime_nsec;
+    int              pos;
+    boolean          ok, done;
+
+    if (ncxmod_index_cache == NULL) {
+        return;
+    }
 
-    pathbufflen = NCXMOD_MAX_FSPEC_LEN+1;
-    pathbuff = m__getMem(pathbufflen);
-    if (!pathbuff) {
-        *done = TRUE;
-        return ERR_INTERNAL_MEM;
+    fp = fopen((const char *)ncxmod_index_cache, "r");
+    if (fp == NULL) {
+        return;
     }
 
-    /* go through the path list and check each string */
-    str = pathlist;
-    while (*str) {
-        /* find end of path entry or EOS */
-        p = str+1;
-        while (*p && *p != ':') {
-            p++;
-        }
+    bufflen = NCXMOD_MAX_FSPEC_LEN+64;
+    buff = m__getMem(bufflen);
+    if (buff == NULL) {
+        fclose(fp);
+        return;
+    }
 
-        pathlen = (uint32)(p-str);
-        if (pathlen >= pathbufflen) {
-            *done = TRUE;
-            m__free(pathbuff);
-            return ERR_BUFF_OVFL;
+    dlq_createSQue(&tempQ);
+    idx = NULL;
+    linecnt = 0;
+    done = FALSE;
+    ok = (fgets((char *)buff, (int)bufflen, fp) != NULL &&
+          !xml_strcmp(buff, (const xmlChar *)NCXMOD_INDEX_CACHE_HDR "\n"));
+
+    while (ok && fgets((char *)buff, (int)bufflen, fp) != NULL) {
+        len = xml_strlen(buff);
+        if (done || len == 0 || buff[len-1] != '\n') {
+            ok = FALSE;
+            continue;
         }
+        buff[len-1] = 0;
 
-        /* copy the next string into the path buffer */
-        xml_strncpy(pathbuff, str, pathlen);
-        res = check_module_path(pathbuff, 
-                                buff,
-                                bufflen,
-                                modname, 
-                                revision,
-                                pcb,
-                                ptyp,
-                                TRUE,
-                                done);
-        if (*done) {
-            m__free(pathbuff);
-            return res;
+        pos = 0;
+        if (*buff != 'E') {
+            linecnt++;
         }
-    
-        /* setup the next path string to try */
-        if (*p) {
-            str = p+1;   /* one past ':' char */
+        switch (*buff) {
+        case 'R':
+            if (sscanf((const char *)buff, "R %u %n", &flag1, &pos) < 1 ||
+                pos == 0 || buff[pos] != NCXMOD_PSCHAR) {
+                ok = FALSE;
+                break;
+            }
+            idx = new_index(&buff[pos], flag1 ? TRUE : FALSE);
+            if (idx == NULL) {
+                ok = FALSE;
+                break;
+            }
+            dlq_enque(idx, &tempQ);
+            break;
+        case 'D':
+            if (idx == NULL ||
+                sscanf((const char *)buff, "D %u %ld %ld %n", &flag1,
+                       &mtime, &mtime_nsec, &pos) < 3 || pos == 0 ||
+                index_add_dir(idx, &buff[pos], flag1 ? TRUE : FALSE,
+                              mtime, mtime_nsec, &dirnum) != NO_ERR) {
+                ok = FALSE;
+            }
+            break;
+        case 'F':
+            if (idx == NULL ||
+                sscanf((const char *)buff, "F %u %u %n", &dirnum,
+                       &flag2, &pos) < 2 || pos == 0 ||
+                dirnum >= idx->dircnt ||
+                index_add_file(idx, dirnum, &buff[pos],
+                               flag2 ? TRUE : FALSE) != NO_ERR) {
+                ok = FALSE;
+            }
+            break;
+        case 'E':
+            if (sscanf((const char *)buff, "E %u%n", &endcnt, &pos) < 1 ||
+                pos == 0 || buff[pos] != 0 || endcnt != linecnt) {
+                ok = FALSE;
+            }
+            done = TRUE;
+            break;
+        default:
+            ok = FALSE;
+        }
+    }
+
+    fclose(fp);
+    m__free(buff);
+
+    if (!done) {
+        ok = FALSE;
+    }
+
+    while (!dlq_empty(&tempQ)) {
+        idx = (ncxmod_index_t *)dlq_deque(&tempQ);
+        if (ok && idx->dircnt &&
+            find_index(&ncxmod_indexQ, idx->rootpath, idx->dive) == NULL) {
+            dlq_enque(idx, &ncxmod_indexQ);
         } else {
-            str = p;        /* already at EOS */
+            free_index(idx);
         }
     }
 
-    m__free(pathbuff);
-    *done = FALSE;
-    return NO_ERR;
+    if (!ok) {
+        log_debug("\nncxmod: ignoring bad module index cache '%s'",
+                  ncxmod_index_cache);
+    }
 
-}  /* check_module_pathlist */
+}  /* load_index_cache */
 
 
 /********************************************************************
-* FUNCTION search_module_path
+* FUNCTION get_index
 *
-*  Check the specified path for all YANG files
+* Get the module search index for a search directory
+* Build the index if needed, or build it again if the
+* directory mtimes have changed since it was built
 *
 * INPUTS:
-*   path == starting path to check
-*   buff == buffer to use for the filespec
-*   bufflen == size of 'buff' in bytes
-*   callback == callback function to use for process_subdir
-*   cookie == parameter for the callback
-*
+*    rootpath == search directory, ending with NCXMOD_PSCHAR
+*    dive == TRUE if the subdirs are searched
 *
 * RETURNS:
-*   status
+*    pointer to the index or NULL if the directory is not
+*    indexed and needs to be searched directly
 *********************************************************************/
-static status_t
-    search_module_path (const xmlChar *path,
-                        xmlChar *buff,
-                        uint32 bufflen,
-                        ncxmod_callback_fn_t callback,
-                        void *cookie)
+static ncxmod_index_t *
+    get_index (const xmlChar *rootpath,
+               boolean dive)
+{
+    ncxmod_index_t  *idx;
+    time_t           now;
+    uint32           len;
+    boolean          build;
+
+    /* relative paths depend on the current directory */
+    len = xml_strlen(rootpath);
+    if (*rootpath != NCXMOD_PSCHAR || rootpath[len-1] != NCXMOD_PSCHAR) {
+        return NULL;
+    }
 
+    if (!ncxmod_index_cache_loaded) {
+        ncxmod_index_cache_loaded = TRUE;
+        load_index_cache();
+    }
 
+    (void)time(&now);
+    build = FALSE;
 
-{
-    status_t        res;
-    uint32          total;
+    idx = find_index(&ncxmod_indexQ, rootpath, dive);
+    if (idx == NULL) {
+        idx = new_index(rootpath, dive);
+        if (idx == NULL) {
+            return NULL;
+        }
+        dlq_enque(idx, &ncxmod_indexQ);
+        build = TRUE;
+    } else if (now < idx->checktime ||
+               now - idx->checktime >= NCXMOD_INDEX_CHECK_SECS) {
+        build = !check_index(idx);
+    }
+    idx->checktime = now;
 
-    total = 0;
-    res = prep_dirpath(buff, bufflen, path, NCXMOD_DIR, &total);
-    if (res == NO_ERR) {
-        res = ncxmod_process_subtree((const char *)buff, 
-                                     callback, 
-                                     cookie);
+    if (build) {
+        if (build_index(idx) != NO_ERR) {
+            dlq_remove(idx);
+            free_index(idx);
+            return NULL;
+        }
+        save_index_cache();
     }
-    return res;
+    return idx;
 
-}  /* search_module_path */
+}  /* get_index */
 
 
 /********************************************************************
-* FUNCTION search_module_pathlist
+* FUNCTION index_find_file
 *
-*  Check a list of pathnames for all the YANG files in the path
+* Find the module file that search_subdirs would find
+* in a module search index
 *
-*  Example:   path1:path2/foo/bar:path3
+* The first directory with a match is used.  Within that
+* directory the match order is:
+*    1) modname.yang or modname@revision.yang
+*    2) modname.yin or modname@revision.yin
+*    3) if no revision: highest modname@<??>.yang or .yin
+*       (only if the subdirs are searched)
 *
 * INPUTS:
-*   pathlist == formatted string containing list of path strings
-*   callback == callback function to use for process_subdir
-*   cookie == parameter for the callback
+*    idx == module search index to use
+*    modname == module name
+*    revision == module revision string (may be NULL)
 *
 * RETURNS:
-*   status
+*    pointer to the file entry or NULL if not found
 *********************************************************************/
-static status_t
-    search_module_pathlist (const xmlChar *pathlist,
-                            ncxmod_callback_fn_t callback,
-                            void *cookie)
-
+static const ncxmod_idxfile_t *
+    index_find_file (const ncxmod_index_t *idx,
+                     const xmlChar *modname,
+                     const xmlChar *revision)
 {
-    const xmlChar  *str, *p;
-    xmlChar        *pathbuff;
-    uint32          pathbufflen, pathlen;
-    status_t        res;
-
-    pathbufflen = NCXMOD_MAX_FSPEC_LEN+1;
-    pathbuff = m__getMem(pathbufflen);
-    if (!pathbuff) {
-        return ERR_INTERNAL_MEM;
-    }
+    const ncxmod_idxfile_t *file, *best;
+    uint32                  modnamelen, h;
+    int                     ret;
 
-    /* go through the path list and check each string */
-    str = pathlist;
-    res = NO_ERR;
+    modnamelen = xml_strlen(modname);
+    h = bobhash(modname, modnamelen, 0) & hashmask(NCXMOD_INDEX_HASH_BITS);
 
-    while (*str) {
-        /* find end of path entry or EOS */
-        p = str+1;
-        while (*p && *p != ':') {
-            p++;
+    best = NULL;
+    for (file = idx->hashtab[h]; file != NULL; file = file->hashnext) {
+        if (file->modnamelen != modnamelen ||
+            xml_strncmp(file->filename, modname, modnamelen)) {
+            continue;
         }
 
-        pathlen = (uint32)(p-str);
-        if (pathlen >= pathbufflen) {
-            m__free(pathbuff);
-            return ERR_BUFF_OVFL;
+        if (revision != NULL) {
+            if (file->revision == NULL ||
+                xml_strncmp(file->revision, revision, file->revisionlen) ||
+                revision[file->revisionlen] != 0) {
+                continue;
+            }
+        } else if (file->revision != NULL &&
+                   (!idx->dive || !file->isreg)) {
+            continue;
         }
 
-        /* copy the next string into the path buffer */
-        xml_strncpy(pathbuff, str, pathlen);
+        if (best == NULL || file->dirnum < best->dirnum) {
+            best = file;
+            continue;
+        }
+        if (file->dirnum > best->dirnum) {
+            continue;
+        }
 
-        res = ncxmod_process_subtree((const char *)pathbuff, 
-                                     callback, 
-                                     cookie);
-        if (res != NO_ERR) {
-            m__free(pathbuff);
-            return res;
+        /* same directory; undated filename first */
+        if ((file->revision == NULL) != (best->revision == NULL)) {
+            if (file->revision == NULL) {
+                best = file;
+            }
+            continue;
         }
-    
-        /* setup the next path string to try */
-        if (*p) {
-            str = p+1;   /* one past ':' char */
-        } else {
-            str = p;        /* already at EOS */
+        if (file->revision != NULL && best->revision != NULL) {
+            ret = xml_strncmp(file->revision, best->revision, 
+                              file->revisionlen);
+            if (ret != 0) {
+                if (ret > 0) {
+                    best = file;
+                }
+                continue;
+            }
+        }
+        if (file->isyang) {
+            best = file;
         }
     }
+    return best;
 
-    m__free(pathbuff);
-    return NO_ERR;
-
-}  /* search_module_pathlist */
-
+}  /* index_find_file */
 
 
 /********************************************************************
-* FUNCTION is_module_file
+* FUNCTION find_indexed_module
 *
-* Determine if the module is a file
+* Find a module file in the search index for a directory
 *
 * INPUTS:
-*   modname == module name with no path prefix or file extension
+*    buff == buffer to use for filespec construction
+*            at the start it contains the search directory
+*    bufflen == size of buff in bytes
+*    modname == module name
+*    revision == module revision string (may be NULL)
+*    dive == TRUE if the subdirs are searched
+*    done == address of return search done flag
+*    res == address of return status
 *
 * OUTPUTS:
-
-* RETURNS:
-*   True if the module is a file
+*   *done == TRUE if the file was found in the index;
+*            full filespec in the 'buff' variable
+*            FALSE to keep going
+*   *res == status of the search
 *
+* RETURNS:
+*    TRUE if the search index was used
+*    FALSE if the directory has to be searched without an index
 *********************************************************************/
 static boolean
-    is_module_file( const xmlChar *modname )
+    find_indexed_module (xmlChar *buff,
+                         uint32 bufflen,
+                         const xmlChar *modname,
+                         const xmlChar *revision,
+                         boolean dive,
+                         boolean *done,
+                         status_t *res)
 {
-    boolean isfile = FALSE;
+    const ncxmod_index_t   *idx;
+    const ncxmod_idxfile_t *file;
+    const xmlChar          *dirpath;
+    uint32                  dirlen;
 
-    /* check which form of input is present, module name or filespec */
-    if ((*modname == '.') || (*modname == NCXMOD_PSCHAR)) {
-        return  TRUE;
-    } else {
-        /* if a dir sep char is in the string it is automatically treated as an 
-         * absolute filespec, even if it doesn't have a file suffix */
-        const xmlChar  *str = modname;
-        while (*str && *str != NCXMOD_PSCHAR) {
-            ++str;
-        }
+    *done = FALSE;
+    *res = NO_ERR;
 
-        if (*str) {
-            isfile = TRUE;
-        }
+    idx = get_index(buff, dive);
+    if (idx == NULL) {
+        return FALSE;
     }
 
-    return isfile;
-}
+    file = index_find_file(idx, modname, revision);
+    if (file == NULL) {
+        return TRUE;
+    }
+
+    *done = TRUE;
+    dirpath = idx->dirtab[file->dirnum].path;
+    dirlen = xml_strlen(dirpath);
+    if (dirlen + xml_strlen(file->filename) >= bufflen) {
+        *res = ERR_BUFF_OVFL;
+        return TRUE;
+    }
+    xml_strcpy(buff, dirpath);
+    xml_strcpy(&buff[dirlen], file->filename);
+
+    if (!file->isreg) {
+        *res = ERR_FIL_BAD_FILENAME;
+    }
+    return TRUE;
+
+}  /* find_indexed_module */
+
 
 /********************************************************************
-* FUNCTION determine_mode
-*
-* Determine if the module is a YANG or YIN file extension
-*
-* INPUTS:
-*   modname == module name with no path prefix or file extension
-*   modlen == length of modname string
+* FUNCTION expire_indexes
 *
-* OUTPUTS:
+* Make each module search index check the directory mtimes
+* again the next time it is used
 *
 * RETURNS:
-*   True if teh module is a file
-*
+*    TRUE if any index was expired
+*    FALSE if there are no search indexes
 *********************************************************************/
-static ncxmod_mode_t
-    determine_mode( const xmlChar* modname, 
-                    const uint32 modlen )
+static boolean
+    expire_indexes (void)
 {
-    ncxmod_mode_t   mode = NCXMOD_MODE_NONE;
-    const xmlChar  *str = modname;
+    ncxmod_index_t *idx;
+    boolean         ret = FALSE;
 
-    // find the start of the file suffix, if any
-    str = &modname[modlen];
-    while (str > modname && *str != '.') {
-        --str;
+    for (idx = (ncxmod_index_t *)dlq_firstEntry(&ncxmod_indexQ);
+         idx != NULL;
+         idx = (ncxmod_index_t *)dlq_nextEntry(idx)) {
+        idx->checktime = 0;
+        ret = TRUE;
     }
+    return ret;
 
-    /* try to find a .yang file suffix */
-    if (*str == '.') {
-        /* since the dot-char is allowed in YANG identifier names
-         * only treat this string with a dot in it as a file if
-         * it has a YANG file extension
-         */
-        if (!xml_strcmp(str+1, YANG_SUFFIX)) {
-            mode = NCXMOD_MODE_FILEYANG;
-        } else if (!xml_strcmp(str+1, YIN_SUFFIX)) {
+}  /* expire_indexes */
+
+
+/********************************************************************
+* FUNCTION list_subdirs
+*
+* List the relevant files in the subdir
+*
+* INPUTS:
+*    buff == buffer to use for filespec construction
+*            at the start it contains the path string to use;
+*            new directory names will be added to this buffer
+*            as the subdirs are traversed
+*    bufflen == size of buff in bytes
+*    searchtype == enum for the search type to use
+*    helpmode == help mode to use (BRIEF, NORMAL, FULL)
+*    logstdout == TRUE for log_stdout, FALSE for log_write
+*    dive == TRUE to list subdirs; FALSE to list just the
+*            specified directory
+*
+* RETURNS:
+*    NO_ERR if file found okay, full filespec in the 'buff' variable
+*    OR some error if not found or buffer overflow
+*********************************************************************/
+static status_t
+    list_subdirs (xmlChar *buff,
+                  uint32 bufflen,
+                  search_type_t searchtype,
+                  help_mode_t helpmode,
+                  boolean logstdout,
+                  boolean dive)
+{
+    DIR           *dp;
+    struct dirent *ep;
+    xmlChar       *str;
+    uint32         pathlen, dentlen;
+    boolean        dirdone, isyang, isyin;
+    status_t       res;
+
+    res = NO_ERR;
+    dentlen = 0;
+    pathlen = xml_strlen(buff);
+
+    /* try to open the buffer spec as a directory */
+    dp = opendir((const char *)buff);
+    if (!dp) {
+        return NO_ERR;  /* not done yet */
+    }
+
+    /* list top-down:
+     * first all the files first from this directory
+     * then files from any subdirs
+     */
+    dirdone = FALSE;
+    while (!dirdone) {
+
+        ep = readdir(dp);
+        if (!ep) {
+            dirdone = TRUE;
+            continue;
+        }
+
+        if (ep->d_type == DT_REG || ep->d_type == DT_UNKNOWN) {
+
+            /* skip files that start with a dot char */
+            if (*ep->d_name == '.') {
+                continue;
+            }
+
+            isyang = is_yang_file((const xmlChar *)ep->d_name);
+            isyin = is_yin_file((const xmlChar *)ep->d_name);
+
+            /* check if this file needs to be listed */
+            switch (searchtype) {
+            case SEARCH_TYPE_MODULE:
+                if (isyang || isyin) {
+                    break;
+                }
+                continue;
+            case SEARCH_TYPE_DATA:
+            case SEARCH_TYPE_SCRIPT:
+                if (isyang || isyin) {
+                    continue;
+                }
+                break;
+            case SEARCH_TYPE_NONE:
+            default:
+                dirdone = TRUE;
+                SET_ERROR(ERR_INTERNAL_VAL);
+                continue;
+
+            }
+
+            /* list the file */
+            if (logstdout) {
+                log_stdout_indent(NCX_DEF_INDENT);
+                if (helpmode == HELP_MODE_FULL) {
+                    log_stdout((const char *)buff);
+                }
+                log_stdout(ep->d_name);
+                if (helpmode != HELP_MODE_BRIEF) {
+                    ;
+                }
+            } else {
+                log_indent(NCX_DEF_INDENT);
+                if (helpmode == HELP_MODE_FULL) {
+                    log_write((const char *)buff);
+                }
+                log_write(ep->d_name);
+                if (helpmode != HELP_MODE_BRIEF) {
+                    ;
+                }
+            }
+        }
+    }
+
+    (void)closedir(dp);
+
+    if (!dive) {
+        return NO_ERR;
+    }
+
+    /* try to open the buffer spec as a directory */
+    dp = opendir((const char *)buff);
+    if (!dp) {
+        return NO_ERR;
+    }
+
+    /* go through again but this time just dive into the subdirs */
+    dirdone = FALSE;
+    while (!dirdone) {
+
+        ep = readdir(dp);
+        if (!ep) {
+            dirdone = TRUE;
+            continue;
+        }
+
+        /* this field may not be present on all POSIX systems
+         * according to the glibc 2.7 documentation!!
+         * only using dir file which works on linux. 
+         * !!!No support for symbolic links at this time!!!
+         * If d_type == DT_UNKNOWN then guessing this is a file
+         *
+         * Always skip any directory or file that starts with
+         * the dot-char or is named CVS
+         */
+        dentlen = xml_strlen((const xmlChar *)ep->d_name); 
+
+        /* this dive-first behavior is not really what is desired
+         * but do not have a 'stat' function for partial filenames
+         * so just going through the directory block in order
+         */
+        if (ep->d_type == DT_DIR || ep->d_type == DT_UNKNOWN) {
+            if (*ep->d_name != '.' && strcmp(ep->d_name, "CVS")) {
+                if ((pathlen + dentlen + 2) >= bufflen) {
+                    res = ERR_BUFF_OVFL;
+                    dirdone = TRUE;
+                } else {
+                    /* make sure last dirspec ends witha path-sep-char */
+                    if (pathlen > 0 && buff[pathlen-1] != NCXMOD_PSCHAR) {
+                        buff[pathlen] = NCXMOD_PSCHAR;
+                        str = &buff[pathlen+1];
+                        str += xml_strcpy(str, (const xmlChar *)ep->d_name);
+                    } else {
+                        str = &buff[pathlen];
+                        str += xml_strcpy(str, (const xmlChar *)ep->d_name);
+                    }
+                    *str++ = NCXMOD_PSCHAR;
+                    *str = '\0';
+
+                    res = list_subdirs(buff, bufflen, searchtype, helpmode,
+                                       logstdout, TRUE);
+                    /* erase the filename and keep trying */
+                    buff[pathlen] = 0;
+                    if (res != NO_ERR) {
+                        dirdone = TRUE;
+                        continue;
+                    }
+                }
+            }
+        }
+    }
+
+    (void)closedir(dp);
+    return res;
+
+}  /* list_subdirs */
+
+
+/********************************************************************
+* FUNCTION list_pathlist
+*
+* Check the filespec path string and list files in each dir
+*
+* INPUTS:
+*    pathstr == pathstring list to check
+*    buff == scratch buffer to use
+*    bufflen == length of buff
+*    searchtype == search type to use
+*    helpmode == verbosity mode (BRIEF, NORMAL, FULL)
+*    logstdout == TRUE for log_stdout, FALSE for log_write
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    list_pathlist (const xmlChar *pathlist,
+                   xmlChar *buff,
+                   uint32 bufflen,
+                   search_type_t  searchtype,
+                   help_mode_t helpmode,
+                   boolean logstdout)
+{
+    const xmlChar *str, *p;
+    uint32         len;
+    status_t       res;
+
+    res = NO_ERR;
+    str = pathlist;
+
+    /* go through the path list and check each string */
+    while (*str) {
+        /* find end of path entry or EOS */
+        p = str+1;
+        while (*p && *p != ':') {
+            p++;
+        }
+        len = (uint32)(p-str);
+        if (len >= bufflen) {
+            return ERR_BUFF_OVFL;
+        }
+
+        /* copy the next string into buff */
+        xml_strncpy(buff, str, len);
+
+        /* make sure string ends with path sep char */
+        if (buff[len-1] != NCXMOD_PSCHAR) {
+            if (len+1 >= bufflen) {
+                return ERR_BUFF_OVFL;
+            } else {
+                buff[len++] = NCXMOD_PSCHAR;
+            }
+        }
+
+        /* list all the requested files in this path */
+        res = list_subdirs(buff, bufflen, searchtype, helpmode, logstdout,
+                           FALSE);
+
+        if (res != NO_ERR) {
+            return res;
+        }
+    
+        /* setup the next path string to try */
+        if (*p) {
+            str = p+1;   /* one past ':' char */
+        } else {
+            str = p;        /* already at EOS */
+        }
+    }
+
+    return res;
+
+}  /* list_pathlist */
+
+
+/********************************************************************
+* FUNCTION add_failed
+*
+* Add a yang_node_t entry to the pcb->failedQ
+*
+* INPUTS:
+*   modname == failed module name
+*   revision == failed revision date (may be NULL)
+*   pcb == parser control block
+*   res == final result status for the failed module
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t 
+    add_failed (const xmlChar *modname,
+                const xmlChar *revision,
+                yang_pcb_t *pcb,
+                status_t res)
+{
+    yang_node_t *node;
+
+    /* do not save failed modules based on a failed search
+     * or if the module is not really being added to the registry
+     */
+    if (pcb->searchmode || pcb->parsemode) {
+        return NO_ERR;
+    }
+
+    node = yang_new_node();
+    if (!node) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    node->failed = xml_strdup(modname);
+    if (!node->failed) {
+        yang_free_node(node);
+        return ERR_INTERNAL_MEM;
+    }
+
+    if (revision) {
+        node->failedrev = xml_strdup(revision);
+        if (!node->failed) {
+            yang_free_node(node);
+            return ERR_INTERNAL_MEM;
+        }
+    }
+
+    node->name = node->failed;
+    node->revision = node->failedrev;
+    node->res = res;
+    dlq_enque(node, &pcb->failedQ);
+    return NO_ERR;
+
+} /* add_failed */
+
+
+/********************************************************************
+* FUNCTION check_module_path
+*
+*  Check the specified path for a YANG module file
+*
+* INPUTS:
+*   path == starting path to check
+*   buff == buffer to use for the filespec
+*   bufflen == size of 'buff' in bytes
+*   modname == module name to find (no file suffix)
+*   revision == module revision date (may be NULL)
+*   pcb == parser control block in progress
+*   ptyp == parser source type
+*   usepath == TRUE if path should be used directly
+*              FALSE if the path should be appended with the 'modules' dir
+*   done == address of return done flag
+*
+* OUTPUTS:
+*   *done == TRUE if file found or fatal error
+*    file completely processed in try_module if file found
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    check_module_path (const xmlChar *path,
+                       xmlChar *buff,
+                       uint32 bufflen,
+                       const xmlChar *modname,
+                       const xmlChar *revision,
+                       yang_pcb_t *pcb,
+                       yang_parsetype_t ptyp,
+                       boolean usepath,
+                       boolean *done)
+{
+    const xmlChar  *path2;
+    uint32          total;
+    status_t        res, res2;
+
+    *done = FALSE;
+    res = NO_ERR;
+    res2 = NO_ERR;
+    /* T == use path directly, leave path2 NULL
+     * F == add 'modules' to end of path by setting path2
+     */
+    path2 = (usepath) ? NULL : NCXMOD_DIR;
+
+    total = xml_strlen(path);
+    if (total >= bufflen) {
+        *done = TRUE;
+        return ERR_BUFF_OVFL;
+    }
+
+    if (ncxmod_subdirs) {
+        res = prep_dirpath(buff, bufflen, path, path2, &total);
+        if (res != NO_ERR) {
+            *done = TRUE;
+            return res;
+        }
+
+        /* try YANG or YIN file; use the search index if possible */
+        if (!find_indexed_module(buff, bufflen, modname, revision, 
+                                 TRUE, done, &res)) {
+            res = search_subdirs(buff, bufflen, modname, revision, done);
+        }
+        if (*done && res == NO_ERR) {
+
+            res = try_module(buff, 
+                             bufflen, 
+                             NULL, 
+                             NULL,
+                             NULL, 
+                             NULL,
+                             yang_fileext_is_yang(buff) ? 
+                             NCXMOD_MODE_FILEYANG : 
+                             NCXMOD_MODE_FILEYIN,
+                             TRUE, 
+                             done, 
+                             pcb, 
+                             ptyp);
+            if (res != NO_ERR) {
+                res2 = add_failed(modname, 
+                                  revision,
+                                  pcb, 
+                                  res);
+            }
+        }
+        return (res != NO_ERR) ? res : res2;
+    }
+
+    /* else subdir searches not allowed
+     * check the search index for the current path first
+     */
+    res = prep_dirpath(buff, bufflen, path, path2, &total);
+    if (res == NO_ERR &&
+        find_indexed_module(buff, bufflen, modname, revision, 
+                            FALSE, done, &res)) {
+        if (*done && res == NO_ERR) {
+            res = try_module(buff, 
+                             bufflen, 
+                             NULL, 
+                             NULL,
+                             NULL, 
+                             NULL,
+                             yang_fileext_is_yang(buff) ? 
+                             NCXMOD_MODE_FILEYANG : 
+                             NCXMOD_MODE_FILEYIN,
+                             TRUE, 
+                             done, 
+                             pcb, 
+                             ptyp);
+        }
+    } else {
+        /* check for YANG file in the current path */
+        res = try_module(buff,
+                         bufflen, 
+                         path,
+                         path2,
+                         modname,
+                         revision,
+                         NCXMOD_MODE_YANG,
+                         FALSE, 
+                         done,
+                         pcb,
+                         ptyp);
+
+        if (!*done && res == NO_ERR) {
+            /* check for YIN file in the current path */
+            res = try_module(buff,
+                             bufflen, 
+                             path,
+                             path2,
+                             modname,
+                             revision,
+                             NCXMOD_MODE_YIN,
+                             FALSE, 
+                             done,
+                             pcb,
+                             ptyp);
+        }
+    }
+
+    if (*done && res != NO_ERR) {
+        res2 = add_failed(modname,
+                          revision,
+                          pcb,
+                          res);
+    }
+    return (res != NO_ERR) ? res : res2;
+
+}  /* check_module_path */
+
+
+/********************************************************************
+* FUNCTION check_module_pathlist
+*
+*  Check a list of pathnames for the specified path of 
+*  a YANG module file
+*
+*  Example:   path1:path2:path3
+*
+* INPUTS:
+*   pathlist == formatted string containing list of path strings
+*   buff == buffer to use for the filespec
+*   bufflen == size of 'buff' in bytes
+*   modname == module name to find (no file suffix)
+*   revision == module revision date (may be NULL)
+*   pcb == parser control block in progress
+*   ptyp == parser source type
+*   done == address of return done flag
+*
+* OUTPUTS:
+*   *done == TRUE if file found or fatal error
+*    file completely processed in try_module if file found
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    check_module_pathlist (const xmlChar *pathlist,
+                           xmlChar *buff,
+                           uint32 bufflen,
+                           const xmlChar *modname,
+                           const xmlChar *revision,
+                           yang_pcb_t *pcb,
+                           yang_parsetype_t ptyp,
+                           boolean *done)
+{
+    const xmlChar  *str, *p;
+    xmlChar        *pathbuff;
+    uint32          pathbufflen, pathlen;
+    status_t        res;
+
+    pathbufflen = NCXMOD_MAX_FSPEC_LEN+1;
+    pathbuff = m__getMem(pathbufflen);
+    if (!pathbuff) {
+        *done = TRUE;
+        return ERR_INTERNAL_MEM;
+    }
+
+    /* go through the path list and check each string */
+    str = pathlist;
+    while (*str) {
+        /* find end of path entry or EOS */
+        p = str+1;
+        while (*p && *p != ':') {
+            p++;
+        }
+
+        pathlen = (uint32)(p-str);
+        if (pathlen >= pathbufflen) {
+            *done = TRUE;
+            m__free(pathbuff);
+            return ERR_BUFF_OVFL;
+        }
+
+        /* copy the next string into the path buffer */
+        xml_strncpy(pathbuff, str, pathlen);
+        res = check_module_path(pathbuff, 
+                                buff,
+                                bufflen,
+                                modname, 
+                                revision,
+                                pcb,
+                                ptyp,
+                                TRUE,
+                                done);
+        if (*done) {
+            m__free(pathbuff);
+            return res;
+        }
+    
+        /* setup the next path string to try */
+        if (*p) {
+            str = p+1;   /* one past ':' char */
+        } else {
+            str = p;        /* already at EOS */
+        }
+    }
+
+    m__free(pathbuff);
+    *done = FALSE;
+    return NO_ERR;
+
+}  /* check_module_pathlist */
+
+
+/********************************************************************
+* FUNCTION search_module_path
+*
+*  Check the specified path for all YANG files
+*
+* INPUTS:
+*   path == starting path to check
+*   buff == buffer to use for the filespec
+*   bufflen == size of 'buff' in bytes
+*   callback == callback function to use for process_subdir
+*   cookie == parameter for the callback
+*
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    search_module_path (const xmlChar *path,
+                        xmlChar *buff,
+                        uint32 bufflen,
+                        ncxmod_callback_fn_t callback,
+                        void *cookie)
+
+
+
+{
+    status_t        res;
+    uint32          total;
+
+    total = 0;
+    res = prep_dirpath(buff, bufflen, path, NCXMOD_DIR, &total);
+    if (res == NO_ERR) {
+        res = ncxmod_process_subtree((const char *)buff, 
+                                     callback, 
+                                     cookie);
+    }
+    return res;
+
+}  /* search_module_path */
+
+
+/********************************************************************
+* FUNCTION search_module_pathlist
+*
+*  Check a list of pathnames for all the YANG files in the path
+*
+*  Example:   path1:path2/foo/bar:path3
+*
+* INPUTS:
+*   pathlist == formatted string containing list of path strings
+*   callback == callback function to use for process_subdir
+*   cookie == parameter for the callback
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    search_module_pathlist (const xmlChar *pathlist,
+                            ncxmod_callback_fn_t callback,
+                            void *cookie)
+
+{
+    const xmlChar  *str, *p;
+    xmlChar        *pathbuff;
+    uint32          pathbufflen, pathlen;
+    status_t        res;
+
+    pathbufflen = NCXMOD_MAX_FSPEC_LEN+1;
+    pathbuff = m__getMem(pathbufflen);
+    if (!pathbuff) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    /* go through the path list and check each string */
+    str = pathlist;
+    res = NO_ERR;
+
+    while (*str) {
+        /* find end of path entry or EOS */
+        p = str+1;
+        while (*p && *p != ':') {
+            p++;
+        }
+
+        pathlen = (uint32)(p-str);
+        if (pathlen >= pathbufflen) {
+            m__free(pathbuff);
+            return ERR_BUFF_OVFL;
+        }
+
+        /* copy the next string into the path buffer */
+        xml_strncpy(pathbuff, str, pathlen);
+
+        res = ncxmod_process_subtree((const char *)pathbuff, 
+                                     callback, 
+                                     cookie);
+        if (res != NO_ERR) {
+            m__free(pathbuff);
+            return res;
+        }
+    
+        /* setup the next path string to try */
+        if (*p) {
+            str = p+1;   /* one past ':' char */
+        } else {
+            str = p;        /* already at EOS */
+        }
+    }
+
+    m__free(pathbuff);
+    return NO_ERR;
+
+}  /* search_module_pathlist */
+
+
+
+/********************************************************************
+* FUNCTION is_module_file
+*
+* Determine if the module is a file
+*
+* INPUTS:
+*   modname == module name with no path prefix or file extension
+*
+* OUTPUTS:
+
+* RETURNS:
+*   True if the module is a file
+*
+*********************************************************************/
+static boolean
+    is_module_file( const xmlChar *modname )
+{
+    boolean isfile = FALSE;
+
+    /* check which form of input is present, module name or filespec */
+    if ((*modname == '.') || (*modname == NCXMOD_PSCHAR)) {
+        return  TRUE;
+    } else {
+        /* if a dir sep char is in the string it is automatically treated as an 
+         * absolute filespec, even if it doesn't have a file suffix */
+        const xmlChar  *str = modname;
+        while (*str && *str != NCXMOD_PSCHAR) {
+            ++str;
+        }
+
+        if (*str) {
+            isfile = TRUE;
+        }
+    }
+
+    return isfile;
+}
+
+/********************************************************************
+* FUNCTION determine_mode
+*
+* Determine if the module is a YANG or YIN file extension
+*
+* INPUTS:
+*   modname == module name with no path prefix or file extension
+*   modlen == length of modname string
+*
+* OUTPUTS:
+*
+* RETURNS:
+*   True if teh module is a file
+*
+*********************************************************************/
+static ncxmod_mode_t
+    determine_mode( const xmlChar* modname, 
+                    const uint32 modlen )
+{
+    ncxmod_mode_t   mode = NCXMOD_MODE_NONE;
+    const xmlChar  *str = modname;
+
+    // find the start of the file suffix, if any
+    str = &modname[modlen];
+    while (str > modname && *str != '.') {
+        --str;
+    }
+
+    /* try to find a .yang file suffix */
+    if (*str == '.') {
+        /* since the dot-char is allowed in YANG identifier names
+         * only treat this string with a dot in it as a file if
+         * it has a YANG file extension
+         */
+        if (!xml_strcmp(str+1, YANG_SUFFIX)) {
+            mode = NCXMOD_MODE_FILEYANG;
+        } else if (!xml_strcmp(str+1, YIN_SUFFIX)) {
+            mode = NCXMOD_MODE_FILEYIN;
+        }
+    }
+
+    if ( NCXMOD_MODE_NONE == mode ) {
+        if ( is_module_file ( modname ) ) {
             mode = NCXMOD_MODE_FILEYIN;
         }
-    }
+    }
+
+    return mode;
+}
+
+/********************************************************************
+* FUNCTION try_module_filespec
+*
+* try to load a module from a file
+*
+* INPUTS:
+*   mode the file mode (YANG or YIN)
+*
+* OUTPUTS:
+
+* RETURNS:
+*   True if teh module is a file
+*
+*********************************************************************/
+static status_t
+    try_module_filespec( const ncxmod_mode_t  mode,
+                         const xmlChar       *modname,
+                         const uint32         modlen,
+                         yang_pcb_t          *pcb,
+                         yang_parsetype_t     ptyp,
+                         ncx_module_t       **retmod)
+{
+    status_t res = ERR_NCX_MISSING_FILE;
+    xmlChar *buff;
+    boolean         done = FALSE;
+
+    /* the try_module function expects the first parm to be a writable 
+     * buffer, even though in this case there will be nothing altered in the
+     * module name string.  Need to copy it instead of pass it directly :-( */
+    buff = xml_strdup(modname);
+    if ( !buff ) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    res = try_module( buff, modlen, NULL, NULL, NULL, NULL, 
+                      mode, TRUE, &done, pcb, ptyp);
+
+    if ( ERR_NCX_MISSING_FILE == res ) {
+        log_error("\nError: file not found (%s)\n", modname);
+    } else if ( res == NO_ERR && retmod ) {
+        *retmod = pcb->top;
+    }
+
+    m__free(buff);
+    return res;
+}
+ 
+/********************************************************************
+* FUNCTION search_module_dirs
+*
+* Search the module directories for the specified module
+* and load it into the system if found
+*
+* Module Search order:
+*   2) alt_path variable if set
+*   3) current directory
+*   4) YUMA_MODPATH environment var (or set by modpath CLI var)
+*   5) HOME/modules directory
+*   6) YUMA_HOME/modules directory
+*   7) YUMA_INSTALL/modules directory OR
+*      default install module location, '/usr/share/yuma/modules'
+*
+* INPUTS:
+*   buff == buffer to use for the filespec
+*   bufflen == size of 'buff' in bytes
+*   modname == module name with no path prefix or file extension
+*   revision == optional revision date of 'modname' to find
+*   pcb == parser control block
+*   ptyp == current parser source type
+*   done == address of return done flag
+*
+* OUTPUTS:
+*   *done == TRUE if file found or fatal error
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t 
+    search_module_dirs (xmlChar *buff,
+                        uint32 bufflen,
+                        const xmlChar *modname,
+                        const xmlChar *revision,
+                        yang_pcb_t *pcb,
+                        yang_parsetype_t ptyp,
+                        boolean *done)
+{
+    status_t        res = NO_ERR;
+
+    *done = FALSE;
+
+    /* 2) try alt_path variable if set; used by yangdiff */
+    if ( ncxmod_alt_path) {
+        res = check_module_path( ncxmod_alt_path, buff, bufflen, modname, 
+                                 revision, pcb, ptyp, TRUE, done );
+    }
+
+    if (ncx_get_cwd_subdirs()) {
+        /* CHECK THE CURRENT DIR AND ANY SUBDIRS
+         * 3) try cur working directory and subdirs if the subdirs parameter
+         *    is true
+         * check before the modpath, which can cause the wrong version to be 
+         * picked, depending * on the CWD used by the application.  */
+        if (!*done) {
+            res = check_module_pathlist( (const xmlChar *)".", buff, bufflen,
+                                         modname, revision, pcb, ptyp, done );
+        }
+    } else {
+        /* CHECK THE CURRENT DIR BUT NOT ANY SUBDIRS
+         * 3a) try as module in current dir, YANG format */
+        if (!*done) {
+            res = try_module( buff, bufflen, NULL, NULL, modname, revision, 
+                              NCXMOD_MODE_YANG, FALSE, done, pcb, ptyp );
+        }
+
+        /* 3b) try as module in current dir, YIN format  */
+        if (!*done) {
+            res = try_module( buff, bufflen, NULL, NULL, modname, revision,
+                              NCXMOD_MODE_YIN, FALSE, done, pcb, ptyp);
+        }
+    }
+
+    /* 4) try YUMA_MODPATH environment variable if set */
+    if (!*done && ncxmod_mod_path) {
+        res = check_module_pathlist( ncxmod_mod_path, buff, bufflen, modname, 
+                                     revision, pcb, ptyp, done );
+    }
+
+    /* 5) HOME/modules directory */
+    if (!*done && ncxmod_home) {
+        res = check_module_path( ncxmod_home, buff, bufflen, modname,
+                                 revision, pcb, ptyp, FALSE, done );
+    }
+
+    /* 6) YUMA_HOME/modules directory */
+    if (!*done && ncxmod_yuma_home) {
+        res = check_module_path( ncxmod_yuma_home, buff, bufflen, modname, 
+                                 revision, pcb, ptyp, FALSE, done );
+    }
+
+    /* 7) YUMA_INSTALL/modules directory or default install path
+     *    If this envvar is set then the default install path will not
+     *    be tried
+     */
+    if (!*done) {
+        if (ncxmod_env_install) {
+            res = check_module_path( ncxmod_env_install, buff, bufflen, modname,
+                                     revision, pcb, ptyp, FALSE, done );
+        } else {
+            res = check_module_path( NCXMOD_DEFAULT_INSTALL, buff, bufflen, 
+                                     modname, revision, pcb, ptyp, FALSE, 
+                                     done );
+        }
+    }
+
+    return res;
+
+}  /* search_module_dirs */
+
+
+/********************************************************************
+* FUNCTION load_module
+*
+* Determine the location of the specified module
+* and then load it into the system, if not already loaded
+*
+* Module Search order:
+*   1) filespec == try that only and exit
+*   2) current directory
+*   3) YUMA_MODPATH environment var (or set by modpath CLI var)
+*   4) HOME/modules directory
+*   5) YUMA_HOME/modules directory
+*   6) YUMA_INSTALL/modules directory OR
+*   7) default install module location, which is '/usr/share/yuma/modules'
+*
+* INPUTS:
+*   modname == module name with no path prefix or file extension
+*   revision == optional revision date of 'modname' to find
+*   pcb == parser control block
+*   ptyp == current parser source type
+*   retmod == address of return module (may be NULL)
+*
+* OUTPUTS:
+*   if non-NULL:
+*    *retmod == pointer to requested module version
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t 
+    load_module (const xmlChar *modname,
+                 const xmlChar *revision,
+                 yang_pcb_t *pcb,
+                 yang_parsetype_t ptyp,
+                 ncx_module_t **retmod)
+{
+    ncxmod_mode_t   mode = NCXMOD_MODE_NONE;
+    xmlChar        *buff;
+    uint32          modlen;
+    uint32          bufflen = 0;
+    status_t        res = NO_ERR;
+    boolean         done = FALSE;
+
+    if ( !modname || !pcb )
+    {
+        return ERR_INTERNAL_PTR;
+    }
+
+    if (LOGDEBUG2) {
+        log_debug2("\nAttempting to load module '%s'", modname);
+        if (revision) {
+            log_debug2(" r:%s", revision);
+        }
+    } else if (LOGDEBUG) {
+        log_debug("\nload_module called for '%s'", modname);
+    }
+
+    modlen = xml_strlen(modname);
+
+    if (retmod) {
+        *retmod = NULL;
+    }
+
+    /* find the start of the file name extension, expecting .yang or .yin */
+    mode = determine_mode( modname, modlen );
+    if ( NCXMOD_MODE_FILEYANG == mode || NCXMOD_MODE_FILEYIN == mode ) {
+        /* 1) if parameter is a filespec, then try it and exit if it does not 
+         * work, instead of trying other directories */
+        return try_module_filespec( mode, modname, modlen, pcb, ptyp, retmod );
+    }
+
+    /* the module name is not a file; the revision may be relevant now;
+     * make sure the module name is valid */
+    if ( !ncx_valid_name( modname, modlen ) ) {
+        log_error("\nError: Invalid module name (%s)\n", modname);
+        res = add_failed(modname, revision, pcb, res);
+        if ( NO_ERR != res ) {
+            return res;
+        } else {
+            return ERR_NCX_INVALID_NAME;
+        }
+    }
+
+    /* check if the module is already loaded (in the current ncx_modQ) skip if 
+     * this is yangdump converting a YANG file to a YIN file or 
+     * yangcli_autoload parsing a server module */
+    if ((ptyp != YANG_PT_INCLUDE) &&
+        !(pcb->parsemode && ptyp == YANG_PT_TOP) &&
+        !(pcb->savetkc && pcb->tkc == NULL)) {
+        ncx_module_t   *testmod;
+
+        testmod = ncx_find_module(modname, revision);
+        if (testmod) {
+            log_debug2( "\nncxmod: Using module '%s' already loaded", modname );
+            if (!pcb->top) {
+                pcb->top = testmod;
+                pcb->topfound = TRUE;
+            }
+            if (retmod) {
+                *retmod = testmod;
+            }
+            return testmod->status;
+        } else {
+            /*** hack for now, check if this is ietf-netconf ***/
+            if (!xml_strcmp(modname, NCXMOD_IETF_NETCONF)) {
+                /* check if yuma-netconf already loaded */
+                testmod = ncx_find_module(NCXMOD_YUMA_NETCONF, NULL);
+                if (testmod) {
+                    /* use yuma-netconf instead of ietf-netconf */
+                    log_debug( "\nncxmod: cannot load 'ietf-netconf'; "
+                               "'yuma-netconf' already loaded" );
+                    if (!pcb->top) {
+                        pcb->top = testmod;
+                        pcb->topfound = TRUE;
+                    }
+                    if (retmod) {
+                        *retmod = testmod;
+                    }
+                    return testmod->status;
+                }
+            }
+        }
+    }
+
+    /* get a temp buffer to construct filespecs */
+    bufflen = NCXMOD_MAX_FSPEC_LEN+1;
+    buff = m__getMem(bufflen);
+    if (!buff) {
+        return ERR_INTERNAL_MEM;
+    } else {
+        *buff = 0;
+    }
+
+    /* 2) - 7) search the module directories */
+    res = search_module_dirs(buff, bufflen, modname, revision, pcb, ptyp,
+                             &done);
+    if (!done && expire_indexes()) {
+        /* a module file may have been added or removed since
+         * the search indexes were last checked, so search again */
+        *buff = 0;
+        res = search_module_dirs(buff, bufflen, modname, revision, pcb, 
+                                 ptyp, &done);
+    }
+
+    if (res != NO_ERR || !done) {
+        if (!done) {
+            res = ERR_NCX_MOD_NOT_FOUND;
+        }
+
+        ( void ) add_failed(modname, revision, pcb, res);
+    }
+
+    m__free(buff);
+
+    if (done) {
+        if ( ( res == NO_ERR || ptyp == YANG_PT_INCLUDE ) && retmod ) {
+            if (pcb->retmod != NULL) {
+                *retmod = pcb->retmod;
+            } else if (ptyp == YANG_PT_TOP) {
+                *retmod = pcb->top;
+            } else {
+                SET_ERROR(ERR_INTERNAL_VAL);
+            }
+        } else if (res != NO_ERR && pcb->retmod) {
+            log_debug( "\nFree retmod import %p (%s)", 
+                       pcb->retmod, pcb->retmod->name);
+            ncx_free_module(pcb->retmod);
+            pcb->retmod = NULL;
+        } /* else pcb->top will get deleted in yang_free_pcb */
+    }
+
+    return res;
+}  /* load_module */
+
+
+/********************************************************************
+* FUNCTION has_mod_ext
+*
+* Check if the filespec ends in '.yang' or '.yin'
+*
+* INPUTS:
+*    filespec == file spec string to check
+*
+* RETURNS:
+*    TRUE if YANG file extension found
+*       and non-zero filename\
+*    FALSE otherwise
+*********************************************************************/
+static boolean
+    has_mod_ext (const char *filespec)
+{
+    const char *p;
+
+    p = filespec;
+
+    while (*p) {
+        p++;
+    }
+
+    while (p>filespec && (*p != '.')) {
+        p--;
+    }
+
+    if (p==filespec) {
+        return FALSE;
+    }
+
+    if (!strcmp(p+1, (const char *)YANG_SUFFIX)) {
+        return TRUE;
+    }
+
+    if (!strcmp(p+1, (const char *)YIN_SUFFIX)) {
+        return TRUE;
+    }
+
+    return FALSE;
+    
+}  /* has_mod_ext */
+
+
+/********************************************************************
+* FUNCTION process_subtree
+*
+* Search the entire specified subtree, looking for YANG
+* modules.  Invoke the callback function for each module
+* file found
+*
+* INPUTS:
+*    buff == working filespec buffer containing the dir spec 
+*            to start with
+*    bufflen == maxsize of buff, in bytes
+*    callback == address of the ncxmod_callback_fn_t function
+*         to use for this traveral
+*    cookie == cookie to pass to each invocation of the callback
+*
+* RETURNS:
+*    NO_ERR if file found okay, full filespec in the 'buff' variable
+*    OR some error if not found or buffer overflow
+*********************************************************************/
+static status_t
+    process_subtree (char *buff, 
+                     uint32 bufflen,
+                     ncxmod_callback_fn_t callback,
+                     void *cookie)
+{
+    DIR           *dp;
+    struct dirent *ep;
+    uint32         pathlen;
+    boolean        dirdone;
+    status_t       res;
+
+
+    res = NO_ERR;
+
+    pathlen = xml_strlen((const xmlChar *)buff);
+    if (!pathlen) {
+        return NO_ERR;
+    }
+
+    /* make sure a min-length YANG file can be added (x.yang) */
+    if ((pathlen + 8) >= bufflen) {
+        log_error("\nError: pathspec too long '%s'\n", buff);
+        return ERR_BUFF_OVFL;
+    } 
+
+    /* make sure dir-sep char is in place */
+    if (buff[pathlen-1] != NCXMOD_PSCHAR) {
+        buff[pathlen++] = NCXMOD_PSCHAR;
+        buff[pathlen] = 0;
+    }
+
+    /* try to open the buffer spec as a directory */
+    dp = opendir(buff);
+    if (!dp) {
+#if 0
+        log_error("\nError: open directory '%s' failed\n", buff);
+        return ERR_OPEN_DIR_FAILED;
+#else
+        return NO_ERR;
+#endif
+    }
+
+    dirdone = FALSE;
+    while (!dirdone && res==NO_ERR) {
+
+        ep = readdir(dp);
+        if (!ep) {
+            dirdone = TRUE;
+            continue;
+        }
+
+        /* this field may not be present on all POSIX systems
+         * according to the glibc 2.7 documentation!!
+         * only using dir file which works on linux. 
+         * !!!No support for symbolic links at this time!!!
+         */
+        if (ep->d_type == DT_DIR || ep->d_type == DT_UNKNOWN) {
+            if ((*ep->d_name != '.') && strcmp(ep->d_name, "CVS")) {
+                if ((pathlen + 
+                     xml_strlen((const xmlChar *)ep->d_name)) >=  bufflen) {
+                    res = ERR_BUFF_OVFL;
+                } else {
+                    strncpy(&buff[pathlen], ep->d_name, bufflen-pathlen);
+                    res = process_subtree(buff, bufflen, callback, cookie);
+                    buff[pathlen] = 0;
+                }
+            }
+        }
 
-    if ( NCXMOD_MODE_NONE == mode ) {
-        if ( is_module_file ( modname ) ) {
-            mode = NCXMOD_MODE_FILEYIN;
+        if (ep->d_type == DT_REG || ep->d_type == DT_UNKNOWN) {
+            if ((*ep->d_name != '.') && has_mod_ext(ep->d_name)) {
+                if ((pathlen + 
+                     xml_strlen((const xmlChar *)ep->d_name)) >=  bufflen) {
+                    res = ERR_BUFF_OVFL;
+                } else {
+                    strncpy(&buff[pathlen], ep->d_name, bufflen-pathlen);
+                    res = (*callback)(buff, cookie);
+                }
+            }
         }
     }
 
-    return mode;
-}
+    (void)closedir(dp);
+
+    return res;
+
+}  /* process_subtree */
+
 
 /********************************************************************
-* FUNCTION try_module_filespec
+* FUNCTION try_load_module
 *
-* try to load a module from a file
+* Try 1 to 3 forms of the YANG filespec to
+* locate the specified module
 *
 * INPUTS:
-*   mode the file mode (YANG or YIN)
+*   pcb == parser control block to use
+*   ptyp == parser mode type to use
+*   modname == module name with no path prefix or file extension
+*   revision == optional revision date of 'modname' to find
+*   retmod == address of return module (may be NULL)
 *
 * OUTPUTS:
+*   if non-NULL:
+*    *retmod == pointer to requested module version
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t 
+    try_load_module (yang_pcb_t *pcb,
+                     yang_parsetype_t ptyp,
+                     const xmlChar *modname,
+                     const xmlChar *revision,
+                     ncx_module_t **retmod)
+{
+    ncx_module_t    *testmod;
+    status_t         res;
+
+#ifdef DEBUG
+    if (!modname) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    }
+#endif
+
+    testmod = NULL;
+
+    /* need to choose the correct match mode from the start
+     * so that foo@rev-date.yang early in the search path
+     * does not get passed over for a generic foo.yang
+     * later on in the search path
+     */
+    res = load_module(modname, revision, pcb, ptyp, &testmod);
+
+    if (res == ERR_NCX_MOD_NOT_FOUND) {
+        if (revision && *revision) {
+            /* try filenames without revision dates in them */
+            res = load_module(modname, NULL, pcb, ptyp, &testmod);
+            if (res == NO_ERR && testmod) {
+                if (testmod->version == NULL) {
+                    /* asked for a specific revision; 
+                     * got a generic revision instead
+                     * rejected!; return error
+                     */
+                    res = ERR_NCX_WRONG_VERSION;
+                } else if (yang_compare_revision_dates(revision,
+                                                       testmod->version)) {
+                    /* error should already be reported */
+                    res = ERR_NCX_WRONG_VERSION;
+                } /* else got correct revision */
+            }
+        }
+    }
+
+    if (res == NO_ERR && testmod && testmod->errors) {
+        log_debug("\nParser returned OK but module '%s' has errors",
+                  testmod->name);
+        res = ERR_NCX_OPERATION_FAILED;
+        if (!testmod->ismod && (pcb->top != testmod)) {
+            ncx_free_module(testmod);
+        }
+    } else if (retmod) {
+        *retmod = testmod;
+    }
+
+    return res;
+
+}  /* try_load_module */
+
 
+/********************************************************************
+* FUNCTION new_temp_filcb
+* 
+* Malloc a new temporary file control block
+*
 * RETURNS:
-*   True if teh module is a file
+*  malloced and initialized struct
+*********************************************************************/
+static ncxmod_temp_filcb_t *
+    new_temp_filcb (void)
+
+{
+    ncxmod_temp_filcb_t *newcb;
+
+    newcb = m__getObj(ncxmod_temp_filcb_t);
+    if (newcb == NULL) {
+        return NULL;
+    }
+
+    memset(newcb, 0x0, sizeof(ncxmod_temp_filcb_t));
+    return newcb;
+
+}  /* new_temp_filcb */
+
+
+/********************************************************************
+* FUNCTION free_temp_filcb
+* 
+* Clean and free a temporary file control block
+*
+* INPUTS:
+*    filcb == temporary file control block to free
+*
+*********************************************************************/
+static void
+    free_temp_filcb (ncxmod_temp_filcb_t *filcb)
+{
+    int   retval;
+
+    if (filcb->source) {
+        retval = remove((const char *)filcb->source);
+        if (retval < 0) {
+            log_error("\nError: could not delete temp file '%s' (%s)\n",
+                      filcb->source,
+                      get_error_string(errno_to_status()));
+        }
+        m__free(filcb->source);
+    }
+    m__free(filcb);
+
+}  /* free_temp_filcb */
+
+
+/********************************************************************
+* FUNCTION new_temp_sescb
+* 
+* Malloc a new temporary session files control block
+*
+* RETURNS:
+*  malloced and initialized struct
+*********************************************************************/
+static ncxmod_temp_sescb_t *
+    new_temp_sescb (void)
+
+{
+    ncxmod_temp_sescb_t *newcb;
+
+    newcb = m__getObj(ncxmod_temp_sescb_t);
+    if (newcb == NULL) {
+        return NULL;
+    }
+
+    memset(newcb, 0x0, sizeof(ncxmod_temp_sescb_t));
+    dlq_createSQue(&newcb->temp_filcbQ);
+    return newcb;
+
+}  /* new_temp_sescb */
+
+
+/********************************************************************
+* FUNCTION free_temp_sescb
+* 
+* Clean and free a new temporary session files control block
+*
+* INPUTS:
+*    sescb == temp files session control block to free
+*
+*********************************************************************/
+static void
+    free_temp_sescb (ncxmod_temp_sescb_t *sescb)
+{
+    ncxmod_temp_filcb_t *filcb;
+    int                  retval;
+
+    while (!dlq_empty(&sescb->temp_filcbQ)) {
+        filcb = (ncxmod_temp_filcb_t *)
+            dlq_deque(&sescb->temp_filcbQ);
+        free_temp_filcb(filcb);
+    }
+
+    if (sescb->source) {
+        retval = rmdir((const char *)sescb->source);
+        if (retval < 0) {
+            log_error("\nError: could not delete temp directory '%s' (%s)\n",
+                      sescb->source,
+                      get_error_string(errno_to_status()));
+
+        }
+        m__free(sescb->source);
+    }
+
+    m__free(sescb);
+
+}  /* free_temp_sescb */
+
+
+/********************************************************************
+* FUNCTION new_temp_progcb
+* 
+* Malloc a new temporary program instance control block
+*
+* RETURNS:
+*  malloced and initialized struct
+*********************************************************************/
+static ncxmod_temp_progcb_t *
+    new_temp_progcb (void)
+
+{
+    ncxmod_temp_progcb_t *newcb;
+
+    newcb = m__getObj(ncxmod_temp_progcb_t);
+    if (newcb == NULL) {
+        return NULL;
+    }
+
+    memset(newcb, 0x0, sizeof(ncxmod_temp_progcb_t));
+    dlq_createSQue(&newcb->temp_sescbQ);
+    return newcb;
+
+}  /* new_temp_progcb */
+
+
+/********************************************************************
+* FUNCTION free_temp_progcb
+* 
+* Clean and free a new temporary program instance control block
+*
+* INPUTS:
+*    progcb == temp program instance control block to free
 *
 *********************************************************************/
-static status_t
-    try_module_filespec( const ncxmod_mode_t  mode,
-                         const xmlChar       *modname,
-                         const uint32         modlen,
-                         yang_pcb_t          *pcb,
-                         yang_parsetype_t     ptyp,
-                         ncx_module_t       **retmod)
+static void
+    free_temp_progcb (ncxmod_temp_progcb_t *progcb)
 {
-    status_t res = ERR_NCX_MISSING_FILE;
-    xmlChar *buff;
-    boolean         done = FALSE;
+    ncxmod_temp_sescb_t *sescb;
+    int                  retval;
 
-    /* the try_module function expects the first parm to be a writable 
-     * buffer, even though in this case there will be nothing altered in the
-     * module name string.  Need to copy it instead of pass it directly :-( */
-    buff = xml_strdup(modname);
-    if ( !buff ) {
-        return ERR_INTERNAL_MEM;
+    while (!dlq_empty(&progcb->temp_sescbQ)) {
+        sescb = (ncxmod_temp_sescb_t *)
+            dlq_deque(&progcb->temp_sescbQ);
+        free_temp_sescb(sescb);
     }
 
-    res = try_module( buff, modlen, NULL, NULL, NULL, NULL, 
-                      mode, TRUE, &done, pcb, ptyp);
+    if (progcb->source) {
+        retval = rmdir((const char *)progcb->source);
+        if (retval < 0) {
+            log_error("\nError: could not delete temp directory '%s' (%s)\n",
+                      progcb->source,
+                      get_error_string(errno_to_status()));
 
-    if ( ERR_NCX_MISSING_FILE == res ) {
-        log_error("\nError: file not found (%s)\n", modname);
-    } else if ( res == NO_ERR && retmod ) {
-        *retmod = pcb->top;
+        }
+        m__free(progcb->source);
     }
 
-    m__free(buff);
-    return res;
-}
- 
+    m__free(progcb);
+
+}  /* free_temp_progcb */
+
+
 /********************************************************************
-* FUNCTION load_module
-*
-* Determine the location of the specified module
-* and then load it into the system, if not already loaded
+* FUNCTION make_search_result
 *
-* Module Search order:
-*   1) filespec == try that only and exit
-*   2) current directory
-*   3) YUMA_MODPATH environment var (or set by modpath CLI var)
-*   4) HOME/modules directory
-*   5) YUMA_HOME/modules directory
-*   6) YUMA_INSTALL/modules directory OR
-*   7) default install module location, which is '/usr/share/yuma/modules'
+* Make a ncxmod_search_result_t struct for the given module
 *
 * INPUTS:
-*   modname == module name with no path prefix or file extension
-*   revision == optional revision date of 'modname' to find
-*   pcb == parser control block
-*   ptyp == current parser source type
-*   retmod == address of return module (may be NULL)
-*
-* OUTPUTS:
-*   if non-NULL:
-*    *retmod == pointer to requested module version
+*   mod == module to use
 *
 * RETURNS:
-*   status
+*   == malloced and filled in search result struct
+*      MUST call ncxmod_free_search_result() if the
+*      return value is non-NULL
+*      CHECK result->res TO SEE IF MODULE WAS FOUND
+*      A SEARCH RESULT WILL BE RETURNED IF A SEARCH WAS
+*      ATTEMPTED, EVEN IF NOTHING FOUND
+*   == NULL if any error preventing a search
 *********************************************************************/
-static status_t 
-    load_module (const xmlChar *modname,
-                 const xmlChar *revision,
-                 yang_pcb_t *pcb,
-                 yang_parsetype_t ptyp,
-                 ncx_module_t **retmod)
+static ncxmod_search_result_t *
+    make_search_result (ncx_module_t *mod)
 {
-    ncxmod_mode_t   mode = NCXMOD_MODE_NONE;
-    xmlChar        *buff;
-    uint32          modlen;
-    uint32          bufflen = 0;
-    status_t        res = NO_ERR;
-    boolean         done = FALSE;
-
-    if ( !modname || !pcb )
-    {
-        return ERR_INTERNAL_PTR;
-    }
+    ncxmod_search_result_t   *searchresult;
 
     if (LOGDEBUG2) {
-        log_debug2("\nAttempting to load module '%s'", modname);
-        if (revision) {
-            log_debug2(" r:%s", revision);
-        }
-    } else if (LOGDEBUG) {
-        log_debug("\nload_module called for '%s'", modname);
-    }
-
-    modlen = xml_strlen(modname);
-
-    if (retmod) {
-        *retmod = NULL;
-    }
-
-    /* find the start of the file name extension, expecting .yang or .yin */
-    mode = determine_mode( modname, modlen );
-    if ( NCXMOD_MODE_FILEYANG == mode || NCXMOD_MODE_FILEYIN == mode ) {
-        /* 1) if parameter is a filespec, then try it and exit if it does not 
-         * work, instead of trying other directories */
-        return try_module_filespec( mode, modname, modlen, pcb, ptyp, retmod );
+        log_debug2("\nFound %smodule"
+                   "\n   name:      '%s'"
+                   "\n   revision:  '%s':"
+                   "\n   namespace: '%s'"
+                   "\n   source:    '%s'",
+                   (mod->ismod) ? "" : "sub",
+                   (mod->name) ? mod->name : EMPTY_STRING,
+                   (mod->version) ? mod->version : EMPTY_STRING,
+                   (mod->ns) ? mod->ns : EMPTY_STRING,
+                   (mod->source) ? mod->source : EMPTY_STRING);
     }
 
-    /* the module name is not a file; the revision may be relevant now;
-     * make sure the module name is valid */
-    if ( !ncx_valid_name( modname, modlen ) ) {
-        log_error("\nError: Invalid module name (%s)\n", modname);
-        res = add_failed(modname, revision, pcb, res);
-        if ( NO_ERR != res ) {
-            return res;
-        } else {
-            return ERR_NCX_INVALID_NAME;
-        }
+    searchresult = ncxmod_new_search_result_ex(mod);
+    if (searchresult == NULL) {
+        return NULL;
     }
+    searchresult->res = NO_ERR;
 
-    /* check if the module is already loaded (in the current ncx_modQ) skip if 
-     * this is yangdump converting a YANG file to a YIN file or 
-     * yangcli_autoload parsing a server module */
-    if ((ptyp != YANG_PT_INCLUDE) &&
-        !(pcb->parsemode && ptyp == YANG_PT_TOP) &&
-        !(pcb->savetkc && pcb->tkc == NULL)) {
-        ncx_module_t   *testmod;
+    return searchresult;
 
-        testmod = ncx_find_module(modname, revision);
-        if (testmod) {
-            log_debug2( "\nncxmod: Using module '%s' already loaded", modname );
-            if (!pcb->top) {
-                pcb->top = testmod;
-                pcb->topfound = TRUE;
-            }
-            if (retmod) {
-                *retmod = testmod;
-            }
-            return testmod->status;
-        } else {
-            /*** hack for now, check if this is ietf-netconf ***/
-            if (!xml_strcmp(modname, NCXMOD_IETF_NETCONF)) {
-                /* check if yuma-netconf already loaded */
-                testmod = ncx_find_module(NCXMOD_YUMA_NETCONF, NULL);
-                if (testmod) {
-                    /* use yuma-netconf instead of ietf-netconf */
-                    log_debug( "\nncxmod: cannot load 'ietf-netconf'; "
-                               "'yuma-netconf' already loaded" );
-                    if (!pcb->top) {
-                        pcb->top = testmod;
-                        pcb->topfound = TRUE;
-                    }
-                    if (retmod) {
-                        *retmod = testmod;
-                    }
-                    return testmod->status;
-                }
-            }
-        }
-    }
+}  /* make_search_result */
 
-    /* get a temp buffer to construct filespecs */
-    bufflen = NCXMOD_MAX_FSPEC_LEN+1;
-    buff = m__getMem(bufflen);
-    if (!buff) {
-        return ERR_INTERNAL_MEM;
-    } else {
-        *buff = 0;
-    }
 
-    /* 2) try alt_path variable if set; used by yangdiff */
-    if ( ncxmod_alt_path) {
-        res = check_module_path( ncxmod_alt_path, buff, bufflen, modname, 
-                                 revision, pcb, ptyp, TRUE, &done );
-    }
+/********************************************************************
+* FUNCTION search_subtree_callback
+* 
+* Handle the current filename in the subtree traversal
+* Quick parse and generate a search result for the module
+*
+* INPUTS:
+*   fullspec == absolute or relative path spec, with filename and ext.
+*               this regular file exists, but has not been checked for
+*               read access of 
+*   cookie == resultQ to store malloced search result
+*
+* RETURNS:
+*    status
+*
+*    Return fatal error to stop the traversal or NO_ERR to
+*    keep the traversal going.  Do not return any warning or
+*    recoverable error, just log and move on
+*********************************************************************/
+static status_t
+    search_subtree_callback (const char *fullspec,
+                             void *cookie)
+{
+    dlq_hdr_t               *resultQ;
+    ncx_module_t            *retmod;
+    yang_pcb_t              *pcb;
+    ncxmod_search_result_t  *searchresult;
+    status_t                 res;
 
-    if (ncx_get_cwd_subdirs()) {
-        /* CHECK THE CURRENT DIR AND ANY SUBDIRS
-         * 3) try cur working directory and subdirs if the subdirs parameter
-         *    is true
-         * check before the modpath, which can cause the wrong version to be 
-         * picked, depending * on the CWD used by the application.  */
-        if (!done) {
-            res = check_module_pathlist( (const xmlChar *)".", buff, bufflen,
-                                         modname, revision, pcb, ptyp, &done );
-        }
-    } else {
-        /* CHECK THE CURRENT DIR BUT NOT ANY SUBDIRS
-         * 3a) try as module in current dir, YANG format */
-        if (!done) {
-            res = try_module( buff, bufflen, NULL, NULL, modname, revision, 
-                              NCXMOD_MODE_YANG, FALSE, &done, pcb, ptyp );
-        }
+    resultQ = (dlq_hdr_t *)cookie;
 
-        /* 3b) try as module in current dir, YIN format  */
-        if (!done) {
-            res = try_module( buff, bufflen, NULL, NULL, modname, revision,
-                              NCXMOD_MODE_YIN, FALSE, &done, pcb, ptyp);
-        }
+    if (resultQ == NULL) {
+        return SET_ERROR(ERR_INTERNAL_VAL);
     }
 
-    /* 4) try YUMA_MODPATH environment variable if set */
-    if (!done && ncxmod_mod_path) {
-        res = check_module_pathlist( ncxmod_mod_path, buff, bufflen, modname, 
-                                     revision, pcb, ptyp, &done );
-    }
+    pcb = yang_new_pcb();
+    if (pcb == NULL) {
+        return ERR_INTERNAL_MEM;
+    } 
+    pcb->searchmode = TRUE;
 
-    /* 5) HOME/modules directory */
-    if (!done && ncxmod_home) {
-        res = check_module_path( ncxmod_home, buff, bufflen, modname,
-                                 revision, pcb, ptyp, FALSE, &done );
-    }
+    retmod = NULL;
+    searchresult = NULL;
 
-    /* 6) YUMA_HOME/modules directory */
-    if (!done && ncxmod_yuma_home) {
-        res = check_module_path( ncxmod_yuma_home, buff, bufflen, modname, 
-                                 revision, pcb, ptyp, FALSE, &done );
-    }
+    res = try_load_module(pcb, YANG_PT_TOP, (const xmlChar *)fullspec, 
+                          NULL, &retmod);
 
-    /* 7) YUMA_INSTALL/modules directory or default install path
-     *    If this envvar is set then the default install path will not
-     *    be tried
-     */
-    if (!done) {
-        if (ncxmod_env_install) {
-            res = check_module_path( ncxmod_env_install, buff, bufflen, modname,
-                                     revision, pcb, ptyp, FALSE, &done );
-        } else {
-            res = check_module_path( NCXMOD_DEFAULT_INSTALL, buff, bufflen, 
-                                     modname, revision, pcb, ptyp, FALSE, 
-                                     &done );
+    if (res != NO_ERR || retmod == NULL) {
+        if (LOGDEBUG2) {
+            log_debug2("\nFind module '%s' failed (%s)",
+                       fullspec,
+                       get_error_string(res));
         }
-    }
-
-    if (res != NO_ERR || !done) {
-        if (!done) {
-            res = ERR_NCX_MOD_NOT_FOUND;
+    } else {
+        searchresult = make_search_result(retmod);
+        if (searchresult != NULL) {
+            /* hand off malloced memory here */
+            dlq_enque(searchresult, resultQ);
+        } else {
+            res = ERR_INTERNAL_MEM;
         }
-
-        ( void ) add_failed(modname, revision, pcb, res);
     }
 
-    m__free(buff);
-
-    if (done) {
-        if ( ( res == NO_ERR || ptyp == YANG_PT_INCLUDE ) && retmod ) {
-            if (pcb->retmod != NULL) {
-                *retmod = pcb->retmod;
-            } else if (ptyp == YANG_PT_TOP) {
-                *retmod = pcb->top;
-            } else {
-                SET_ERROR(ERR_INTERNAL_VAL);
-            }
-        } else if (res != NO_ERR && pcb->retmod) {
-            log_debug( "\nFree retmod import %p (%s)", 
-                       pcb->retmod, pcb->retmod->name);
-            ncx_free_module(pcb->retmod);
-            pcb->retmod = NULL;
-        } /* else pcb->top will get deleted in yang_free_pcb */
+    if (pcb) {
+        yang_free_pcb(pcb);
     }
 
     return res;
-}  /* load_module */
+
+}  /* search_subtree_callback */
 
 
 /********************************************************************
-* FUNCTION has_mod_ext
+* FUNCTION find_pfmod
 *
-* Check if the filespec ends in '.yang' or '.yin'
+* Find a module in the table of modules already
+* requested from the module prefetch workers
 *
 * INPUTS:
-*    filespec == file spec string to check
+*    modname == module name or filespec
+*    revision == module revision string (may be NULL)
 *
 * RETURNS:
-*    TRUE if YANG file extension found
-*       and non-zero filename\
-*    FALSE otherwise
+*    pointer to the entry or NULL if not found
 *********************************************************************/
-static boolean
-    has_mod_ext (const char *filespec)
+static ncxmod_pfmod_t *
+    find_pfmod (const xmlChar *modname,
+                const xmlChar *revision)
 {
-    const char *p;
-
-    p = filespec;
-
-    while (*p) {
-        p++;
-    }
-
-    while (p>filespec && (*p != '.')) {
-        p--;
-    }
-
-    if (p==filespec) {
-        return FALSE;
-    }
+    ncxmod_pfmod_t  *pfmod;
+    uint32           h;
 
-    if (!strcmp(p+1, (const char *)YANG_SUFFIX)) {
-        return TRUE;
-    }
+    h = bobhash(modname, xml_strlen(modname), 0) & 
+        hashmask(NCXMOD_PREFETCH_HASH_BITS);
 
-    if (!strcmp(p+1, (const char *)YIN_SUFFIX)) {
-        return TRUE;
+    for (pfmod = ncxmod_pfhashtab[h]; 
+         pfmod != NULL; 
+         pfmod = pfmod->hashnext) {
+        if (xml_strcmp(pfmod->modname, modname)) {
+            continue;
+        }
+        if (revision == NULL) {
+            if (pfmod->revision == NULL) {
+                return pfmod;
+            }
+        } else if (pfmod->revision != NULL &&
+                   !xml_strcmp(pfmod->revision, revision)) {
+            return pfmod;
+        }
     }
+    return NULL;
 
-    return FALSE;
-    
-}  /* has_mod_ext */
+}  /* find_pfmod */
 
 
 /********************************************************************
-* FUNCTION process_subtree
+* FUNCTION queue_pfmod
 *
-* Search the entire specified subtree, looking for YANG
-* modules.  Invoke the callback function for each module
-* file found
+* Add a module to the pending prefetch requests, unless
+* it is already loaded or has been requested before
 *
 * INPUTS:
-*    buff == working filespec buffer containing the dir spec 
-*            to start with
-*    bufflen == maxsize of buff, in bytes
-*    callback == address of the ncxmod_callback_fn_t function
-*         to use for this traveral
-*    cookie == cookie to pass to each invocation of the callback
+*    modname == module name or filespec
+*    revision == module revision string (may be NULL)
+*    pendingQ == Q of ncxmod_pfmod_t to add the request
+*
+* OUTPUTS:
+*    a new entry may be added to the pendingQ
+*    and to the ncxmod_pfhashtab
 *
 * RETURNS:
-*    NO_ERR if file found okay, full filespec in the 'buff' variable
-*    OR some error if not found or buffer overflow
+*    status
 *********************************************************************/
 static status_t
-    process_subtree (char *buff, 
-                     uint32 bufflen,
-                     ncxmod_callback_fn_t callback,
-                     void *cookie)
+    queue_pfmod (const xmlChar *modname,
+                 const xmlChar *revision,
+                 dlq_hdr_t *pendingQ)
 {
-    DIR           *dp;
-    struct dirent *ep;
-    uint32         pathlen;
-    boolean        dirdone;
-    status_t       res;
-
+    ncxmod_pfmod_t  *pfmod;
+    uint32           h;
 
-    res = NO_ERR;
-
-    pathlen = xml_strlen((const xmlChar *)buff);
-    if (!pathlen) {
+    if (find_pfmod(modname, revision) != NULL ||
+        ncx_find_module(modname, revision) != NULL) {
         return NO_ERR;
     }
 
-    /* make sure a min-length YANG file can be added (x.yang) */
-    if ((pathlen + 8) >= bufflen) {
-        log_error("\nError: pathspec too long '%s'\n", buff);
-        return ERR_BUFF_OVFL;
-    } 
-
-    /* make sure dir-sep char is in place */
-    if (buff[pathlen-1] != NCXMOD_PSCHAR) {
-        buff[pathlen++] = NCXMOD_PSCHAR;
-        buff[pathlen] = 0;
+    pfmod = m__getObj(ncxmod_pfmod_t);
+    if (pfmod == NULL) {
+        return ERR_INTERNAL_MEM;
     }
+    memset(pfmod, 0x0, sizeof(ncxmod_pfmod_t));
 
-    /* try to open the buffer spec as a directory */
-    dp = opendir(buff);
-    if (!dp) {
-#if 0
-        log_error("\nError: open directory '%s' failed\n", buff);
-        return ERR_OPEN_DIR_FAILED;
-#else
-        return NO_ERR;
-#endif
+    pfmod->modname = xml_strdup(modname);
+    if (pfmod->modname == NULL) {
+        m__free(pfmod);
+        return ERR_INTERNAL_MEM;
+    }
+    if (revision != NULL) {
+        pfmod->revision = xml_strdup(revision);
+        if (pfmod->revision == NULL) {
+            m__free(pfmod->modname);
+            m__free(pfmod);
+            return ERR_INTERNAL_MEM;
+        }
     }
 
-    dirdone = FALSE;
-    while (!dirdone && res==NO_ERR) {
+    h = bobhash(modname, xml_strlen(modname), 0) & 
+        hashmask(NCXMOD_PREFETCH_HASH_BITS);
+    pfmod->hashnext = ncxmod_pfhashtab[h];
+    ncxmod_pfhashtab[h] = pfmod;
 
-        ep = readdir(dp);
-        if (!ep) {
-            dirdone = TRUE;
-            continue;
-        }
+    dlq_enque(pfmod, pendingQ);
+    return NO_ERR;
 
-        /* this field may not be present on all POSIX systems
-         * according to the glibc 2.7 documentation!!
-         * only using dir file which works on linux. 
-         * !!!No support for symbolic links at this time!!!
-         */
-        if (ep->d_type == DT_DIR || ep->d_type == DT_UNKNOWN) {
-            if ((*ep->d_name != '.') && strcmp(ep->d_name, "CVS")) {
-                if ((pathlen + 
-                     xml_strlen((const xmlChar *)ep->d_name)) >=  bufflen) {
-                    res = ERR_BUFF_OVFL;
-                } else {
-                    strncpy(&buff[pathlen], ep->d_name, bufflen-pathlen);
-                    res = process_subtree(buff, bufflen, callback, cookie);
-                    buff[pathlen] = 0;
-                }
-            }
-        }
+}  /* queue_pfmod */
 
-        if (ep->d_type == DT_REG || ep->d_type == DT_UNKNOWN) {
-            if ((*ep->d_name != '.') && has_mod_ext(ep->d_name)) {
-                if ((pathlen + 
-                     xml_strlen((const xmlChar *)ep->d_name)) >=  bufflen) {
-                    res = ERR_BUFF_OVFL;
-                } else {
-                    strncpy(&buff[pathlen], ep->d_name, bufflen-pathlen);
-                    res = (*callback)(buff, cookie);
-                }
-            }
-        }
-    }
 
-    (void)closedir(dp);
+/********************************************************************
+* FUNCTION free_pfmods
+*
+* Clear the table of modules requested from the
+* module prefetch workers
+*
+*********************************************************************/
+static void
+    free_pfmods (void)
+{
+    ncxmod_pfmod_t  *pfmod;
+    uint32           i;
 
-    return res;
+    for (i = 0; i < hashsize(NCXMOD_PREFETCH_HASH_BITS); i++) {
+        while (ncxmod_pfhashtab[i] != NULL) {
+            pfmod = ncxmod_pfhashtab[i];
+            ncxmod_pfhashtab[i] = pfmod->hashnext;
+            m__free(pfmod->modname);
+            m__free(pfmod->revision);
+            m__free(pfmod);
+        }
+    }
 
-}  /* process_subtree */
+}  /* free_pfmods */
 
 
 /********************************************************************
-* FUNCTION try_load_module
+* FUNCTION search_module_deps
 *
-* Try 1 to 3 forms of the YANG filespec to
-* locate the specified module
+* Find a module and tokenize it into the token cache.
+* The module header and linkage statements are parsed
+* in search mode, so the imports and includes are
+* in the importQ and includeQ of the returned module
 *
 * INPUTS:
-*   pcb == parser control block to use
-*   ptyp == parser mode type to use
-*   modname == module name with no path prefix or file extension
-*   revision == optional revision date of 'modname' to find
-*   retmod == address of return module (may be NULL)
+*    modname == module name or filespec
+*    revision == module revision string (may be NULL)
+*    retmod == address of return module
 *
 * OUTPUTS:
-*   if non-NULL:
-*    *retmod == pointer to requested module version
+*    *retmod == module found, if return value non-NULL
 *
 * RETURNS:
-*   status
+*    parser control block that holds *retmod;
+*    must be freed with yang_free_pcb
+*    NULL if the module was not found
 *********************************************************************/
-static status_t 
-    try_load_module (yang_pcb_t *pcb,
-                     yang_parsetype_t ptyp,
-                     const xmlChar *modname,
-                     const xmlChar *revision,
-                     ncx_module_t **retmod)
-{
-    ncx_module_t    *testmod;
-    status_t         res;
-
-#ifdef DEBUG
-    if (!modname) {
-        return SET_ERROR(ERR_INTERNAL_PTR);
-    }
-#endif
-
-    testmod = NULL;
-
-    /* need to choose the correct match mode from the start
-     * so that foo@rev-date.yang early in the search path
-     * does not get passed over for a generic foo.yang
-     * later on in the search path
-     */
-    res = load_module(modname, revision, pcb, ptyp, &testmod);
-
-    if (res == ERR_NCX_MOD_NOT_FOUND) {
-        if (revision && *revision) {
-            /* try filenames without revision dates in them */
-            res = load_module(modname, NULL, pcb, ptyp, &testmod);
-            if (res == NO_ERR && testmod) {
-                if (testmod->version == NULL) {
-                    /* asked for a specific revision; 
-                     * got a generic revision instead
-                     * rejected!; return error
-                     */
-                    res = ERR_NCX_WRONG_VERSION;
-                } else if (yang_compare_revision_dates(revision,
-                                                       testmod->version)) {
-                    /* error should already be reported */
-                    res = ERR_NCX_WRONG_VERSION;
-                } /* else got correct revision */
-            }
-        }
-    }
+static yang_pcb_t *
+    search_module_deps (const xmlChar *modname,
+                        const xmlChar *revision,
+                        ncx_module_t **retmod)
+{
+    yang_pcb_t  *pcb;
+    status_t     res;
 
-    if (res == NO_ERR && testmod && testmod->errors) {
-        log_debug("\nParser returned OK but module '%s' has errors",
-                  testmod->name);
-        res = ERR_NCX_OPERATION_FAILED;
-        if (!testmod->ismod && (pcb->top != testmod)) {
-            ncx_free_module(testmod);
-        }
-    } else if (retmod) {
-        *retmod = testmod;
+    *retmod = NULL;
+
+    pcb = yang_new_pcb();
+    if (pcb == NULL) {
+        return NULL;
     }
+    pcb->revision = revision;
+    pcb->searchmode = TRUE;
 
-    return res;
+    res = try_load_module(pcb, YANG_PT_TOP, modname, revision, retmod);
+    if (res != NO_ERR || *retmod == NULL) {
+        *retmod = NULL;
+        yang_free_pcb(pcb);
+        return NULL;
+    }
+    return pcb;
 
-}  /* try_load_module */
+}  /* search_module_deps */
 
 
 /********************************************************************
-* FUNCTION new_temp_filcb
-* 
-* Malloc a new temporary file control block
+* FUNCTION valid_module_dep
+*
+* Check an import or include found by the module prefetch
+* before it is passed between the loader and a worker
+*
+* Names that could not be loaded or do not fit
+* in the parent's reply buffer are rejected
+*
+* INPUTS:
+*    modname == module or submodule name
+*    revision == revision-date (may be NULL)
 *
 * RETURNS:
-*  malloced and initialized struct
+*    TRUE if the import or include can be prefetched
 *********************************************************************/
-static ncxmod_temp_filcb_t *
-    new_temp_filcb (void)
-
+static boolean
+    valid_module_dep (const xmlChar *modname,
+                      const xmlChar *revision)
 {
-    ncxmod_temp_filcb_t *newcb;
+    const xmlChar  *str;
+    uint32          len;
 
-    newcb = m__getObj(ncxmod_temp_filcb_t);
-    if (newcb == NULL) {
-        return NULL;
+    if (modname == NULL) {
+        return FALSE;
     }
 
-    memset(newcb, 0x0, sizeof(ncxmod_temp_filcb_t));
-    return newcb;
+    len = xml_strlen(modname);
+    if (len > NCXMOD_PREFETCH_BUFFLEN / 2 || !ncx_valid_name(modname, len)) {
+        return FALSE;
+    }
 
-}  /* new_temp_filcb */
+    if (revision != NULL) {
+        if (xml_strlen(revision) > NCXMOD_PREFETCH_BUFFLEN / 4) {
+            return FALSE;
+        }
+        for (str = revision; *str; str++) {
+            if (!isdigit((int)*str) && *str != '-') {
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+
+}  /* valid_module_dep */
 
 
 /********************************************************************
-* FUNCTION free_temp_filcb
-* 
-* Clean and free a temporary file control block
+* FUNCTION write_module_dep
 *
-* INPUTS:
-*    filcb == temporary file control block to free
+* Write 1 import or include to the parent of a prefetch worker
+*    [<revision>]<TAB><modname><LF>
 *
+* INPUTS:
+*    fp == reply stream to the parent
+*    modname == module or submodule name
+*    revision == revision-date (may be NULL)
 *********************************************************************/
 static void
-    free_temp_filcb (ncxmod_temp_filcb_t *filcb)
+    write_module_dep (FILE *fp,
+                      const xmlChar *modname,
+                      const xmlChar *revision)
 {
-    int   retval;
+    if (!valid_module_dep(modname, revision)) {
+        return;
+    }
 
-    if (filcb->source) {
-        retval = remove((const char *)filcb->source);
-        if (retval < 0) {
-            log_error("\nError: could not delete temp file '%s' (%s)\n",
-                      filcb->source,
-                      get_error_string(errno_to_status()));
-        }
-        m__free(filcb->source);
+    if (revision != NULL) {
+        fputs((const char *)revision, fp);
     }
-    m__free(filcb);
 
-}  /* free_temp_filcb */
+    fputc('\t', fp);
+    fputs((const char *)modname, fp);
+    fputc('\n', fp);
+
+}  /* write_module_dep */
 
 
 /********************************************************************
-* FUNCTION new_temp_sescb
-* 
-* Malloc a new temporary session files control block
+* FUNCTION run_prefetch_worker
+*
+* Main loop of a module prefetch worker process
+*
+* Each request line from the parent names 1 module:
+*    [<revision>]<TAB><modname-or-filespec><LF>
+* The module is found and tokenized into the token cache.
+* The reply has 1 line in the same format for each
+* import and include in the module, and ends with an
+* empty line.  The worker exits at EOF.
+*
+* INPUTS:
+*    fd == socket connected to the parent process
 *
 * RETURNS:
-*  malloced and initialized struct
+*    does not return
 *********************************************************************/
-static ncxmod_temp_sescb_t *
-    new_temp_sescb (void)
-
+static void
+    run_prefetch_worker (int fd)
 {
-    ncxmod_temp_sescb_t *newcb;
+    FILE           *infp, *outfp;
+    yang_pcb_t     *pcb;
+    ncx_module_t   *mod;
+    ncx_import_t   *imp;
+    ncx_include_t  *inc;
+    xmlChar        *buff, *modname, *revision, *str;
+    int             nullfd;
+
+    /* only the parent process writes the log and the
+     * warnings for the modules it loads
+     */
+    log_set_debug_level(LOG_DEBUG_NONE);
+    nullfd = open("/dev/null", O_RDWR);
+    if (nullfd >= 0) {
+        dup2(nullfd, STDOUT_FILENO);
+        dup2(nullfd, STDERR_FILENO);
+        close(nullfd);
+    }
+    ncxmod_load_jobs = 0;
+
+    infp = fdopen(fd, "r");
+    outfp = fdopen(dup(fd), "w");
+    buff = m__getMem(NCXMOD_MAX_FSPEC_LEN+1);
+    if (infp == NULL || outfp == NULL || buff == NULL) {
+        _exit(1);
+    }
+
+    while (fgets((char *)buff, NCXMOD_MAX_FSPEC_LEN+1, infp) != NULL) {
+        str = (xmlChar *)strchr((char *)buff, '\n');
+        if (str == NULL) {
+            break;
+        }
+        *str = 0;
+
+        str = (xmlChar *)strchr((char *)buff, '\t');
+        if (str == NULL) {
+            break;
+        }
+        *str = 0;
+        revision = (*buff) ? buff : NULL;
+        modname = str + 1;
+
+        pcb = search_module_deps(modname, revision, &mod);
+        if (pcb != NULL) {
+            for (imp = (ncx_import_t *)dlq_firstEntry(&mod->importQ);
+                 imp != NULL;
+                 imp = (ncx_import_t *)dlq_nextEntry(imp)) {
+                write_module_dep(outfp, imp->module, imp->revision);
+            }
+            for (inc = (ncx_include_t *)dlq_firstEntry(&mod->includeQ);
+                 inc != NULL;
+                 inc = (ncx_include_t *)dlq_nextEntry(inc)) {
+                write_module_dep(outfp, inc->submodule, inc->revision);
+            }
+            yang_free_pcb(pcb);
+        }
 
-    newcb = m__getObj(ncxmod_temp_sescb_t);
-    if (newcb == NULL) {
-        return NULL;
+        fputc('\n', outfp);
+        if (fflush(outfp) != 0) {
+            break;
+        }
     }
 
-    memset(newcb, 0x0, sizeof(ncxmod_temp_sescb_t));
-    dlq_createSQue(&newcb->temp_filcbQ);
-    return newcb;
+    /* do not flush any stdio output inherited from the parent */
+    _exit(0);
 
-}  /* new_temp_sescb */
+}  /* run_prefetch_worker */
 
 
 /********************************************************************
-* FUNCTION free_temp_sescb
-* 
-* Clean and free a new temporary session files control block
+* FUNCTION start_prefetch_worker
+*
+* Start a module prefetch worker process
 *
 * INPUTS:
-*    sescb == temp files session control block to free
+*    workers == array of prefetch workers
+*    workercnt == number of workers already started;
+*                 workers[workercnt] is the new worker
+*
+* OUTPUTS:
+*    workers[workercnt] is filled in if NO_ERR
 *
+* RETURNS:
+*    status
 *********************************************************************/
-static void
-    free_temp_sescb (ncxmod_temp_sescb_t *sescb)
+static status_t
+    start_prefetch_worker (ncxmod_pfworker_t *workers,
+                           uint32 workercnt)
 {
-    ncxmod_temp_filcb_t *filcb;
-    int                  retval;
+    pid_t   pid;
+    int     fds[2];
+    uint32  i;
 
-    while (!dlq_empty(&sescb->temp_filcbQ)) {
-        filcb = (ncxmod_temp_filcb_t *)
-            dlq_deque(&sescb->temp_filcbQ);
-        free_temp_filcb(filcb);
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return ERR_NCX_OPERATION_FAILED;
     }
 
-    if (sescb->source) {
-        retval = rmdir((const char *)sescb->source);
-        if (retval < 0) {
-            log_error("\nError: could not delete temp directory '%s' (%s)\n",
-                      sescb->source,
-                      get_error_string(errno_to_status()));
+    pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return ERR_NCX_OPERATION_FAILED;
+    }
 
+    if (pid == 0) {
+        /* the other workers must see EOF when the parent
+         * closes its sockets to them
+         */
+        close(fds[0]);
+        for (i = 0; i < workercnt; i++) {
+            if (workers[i].fd >= 0) {
+                close(workers[i].fd);
+            }
         }
-        m__free(sescb->source);
+        run_prefetch_worker(fds[1]);
     }
 
-    m__free(sescb);
+    close(fds[1]);
+    memset(&workers[workercnt], 0x0, sizeof(ncxmod_pfworker_t));
+    workers[workercnt].pid = pid;
+    workers[workercnt].fd = fds[0];
+    return NO_ERR;
 
-}  /* free_temp_sescb */
+}  /* start_prefetch_worker */
 
 
 /********************************************************************
-* FUNCTION new_temp_progcb
-* 
-* Malloc a new temporary program instance control block
+* FUNCTION stop_prefetch_worker
 *
-* RETURNS:
-*  malloced and initialized struct
+* Close the socket to a module prefetch worker
+* and wait for the worker to exit
+*
+* INPUTS:
+*    worker == prefetch worker to stop
 *********************************************************************/
-static ncxmod_temp_progcb_t *
-    new_temp_progcb (void)
-
+static void
+    stop_prefetch_worker (ncxmod_pfworker_t *worker)
 {
-    ncxmod_temp_progcb_t *newcb;
-
-    newcb = m__getObj(ncxmod_temp_progcb_t);
-    if (newcb == NULL) {
-        return NULL;
+    if (worker->fd < 0) {
+        return;
     }
 
-    memset(newcb, 0x0, sizeof(ncxmod_temp_progcb_t));
-    dlq_createSQue(&newcb->temp_sescbQ);
-    return newcb;
+    close(worker->fd);
+    worker->fd = -1;
+    worker->busy = FALSE;
 
-}  /* new_temp_progcb */
+    /* ECHILD if a SIGCHLD handler got the exit status first */
+    while (waitpid(worker->pid, NULL, 0) < 0 && errno == EINTR) {
+        ;
+    }
+
+}  /* stop_prefetch_worker */
 
 
 /********************************************************************
-* FUNCTION free_temp_progcb
-* 
-* Clean and free a new temporary program instance control block
+* FUNCTION send_prefetch_request
+*
+* Send a module request to an idle prefetch worker
 *
 * INPUTS:
-*    progcb == temp program instance control block to free
+*    worker == prefetch worker to use
+*    pfmod == module to request
 *
+* RETURNS:
+*    TRUE if the request was sent
+*    FALSE if the worker has failed
 *********************************************************************/
-static void
-    free_temp_progcb (ncxmod_temp_progcb_t *progcb)
+static boolean
+    send_prefetch_request (ncxmod_pfworker_t *worker,
+                           const ncxmod_pfmod_t *pfmod)
 {
-    ncxmod_temp_sescb_t *sescb;
-    int                  retval;
+    xmlChar  *buff, *str;
+    uint32    len;
+    ssize_t   ret;
+    boolean   ok;
 
-    while (!dlq_empty(&progcb->temp_sescbQ)) {
-        sescb = (ncxmod_temp_sescb_t *)
-            dlq_deque(&progcb->temp_sescbQ);
-        free_temp_sescb(sescb);
+    len = xml_strlen(pfmod->modname) + 2;
+    if (pfmod->revision) {
+        len += xml_strlen(pfmod->revision);
+    }
+    if (len > NCXMOD_MAX_FSPEC_LEN) {
+        /* tell the worker nothing; the module is not prefetched */
+        return TRUE;
     }
 
-    if (progcb->source) {
-        retval = rmdir((const char *)progcb->source);
-        if (retval < 0) {
-            log_error("\nError: could not delete temp directory '%s' (%s)\n",
-                      progcb->source,
-                      get_error_string(errno_to_status()));
+    buff = m__getMem(len + 1);
+    if (buff == NULL) {
+        return FALSE;
+    }
+
+    str = buff;
+    if (pfmod->revision) {
+        str += xml_strcpy(str, pfmod->revision);
+    }
+    *str++ = '\t';
+    str += xml_strcpy(str, pfmod->modname);
+    *str++ = '\n';
+    *str = 0;
 
+    /* MSG_NOSIGNAL: a dead worker must not raise SIGPIPE */
+    ok = TRUE;
+    str = buff;
+    while (ok && len > 0) {
+        ret = send(worker->fd, str, len, MSG_NOSIGNAL);
+        if (ret > 0) {
+            str += ret;
+            len -= (uint32)ret;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else {
+            ok = FALSE;
         }
-        m__free(progcb->source);
     }
 
-    m__free(progcb);
+    m__free(buff);
+    return ok;
 
-}  /* free_temp_progcb */
+}  /* send_prefetch_request */
 
 
 /********************************************************************
-* FUNCTION make_search_result
+* FUNCTION read_prefetch_reply
 *
-* Make a ncxmod_search_result_t struct for the given module
+* Read reply data from a busy prefetch worker and
+* add the modules it reports to the pending requests
 *
 * INPUTS:
-*   mod == module to use
+*    worker == prefetch worker with data ready
+*    pendingQ == Q of ncxmod_pfmod_t to add the new requests
+*
+* OUTPUTS:
+*    worker->busy is cleared if the whole reply was read
 *
 * RETURNS:
-*   == malloced and filled in search result struct
-*      MUST call ncxmod_free_search_result() if the
-*      return value is non-NULL
-*      CHECK result->res TO SEE IF MODULE WAS FOUND
-*      A SEARCH RESULT WILL BE RETURNED IF A SEARCH WAS
-*      ATTEMPTED, EVEN IF NOTHING FOUND
-*   == NULL if any error preventing a search
+*    TRUE if the reply data was OK
+*    FALSE if the worker has failed
 *********************************************************************/
-static ncxmod_search_result_t *
-    make_search_result (ncx_module_t *mod)
+static boolean
+    read_prefetch_reply (ncxmod_pfworker_t *worker,
+                         dlq_hdr_t *pendingQ)
 {
-    ncxmod_search_result_t   *searchresult;
+    char     *line, *end, *str;
+    ssize_t   ret;
+
+    ret = read(worker->fd, 
+               &worker->buff[worker->bufflen],
+               NCXMOD_PREFETCH_BUFFLEN - worker->bufflen - 1);
+    if (ret <= 0) {
+        return (ret < 0 && errno == EINTR) ? TRUE : FALSE;
+    }
+    worker->bufflen += (uint32)ret;
+    worker->buff[worker->bufflen] = 0;
+
+    line = worker->buff;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = 0;
+        if (*line == 0) {
+            /* the empty line ends the reply */
+            worker->busy = FALSE;
+        } else {
+            str = strchr(line, '\t');
+            if (str == NULL) {
+                return FALSE;
+            }
+            *str++ = 0;
+            if (queue_pfmod((const xmlChar *)str,
+                            (*line) ? (const xmlChar *)line : NULL,
+                            pendingQ) != NO_ERR) {
+                return FALSE;
+            }
+        }
+        line = end + 1;
+    }
 
-    if (LOGDEBUG2) {
-        log_debug2("\nFound %smodule"
-                   "\n   name:      '%s'"
-                   "\n   revision:  '%s':"
-                   "\n   namespace: '%s'"
-                   "\n   source:    '%s'",
-                   (mod->ismod) ? "" : "sub",
-                   (mod->name) ? mod->name : EMPTY_STRING,
-                   (mod->version) ? mod->version : EMPTY_STRING,
-                   (mod->ns) ? mod->ns : EMPTY_STRING,
-                   (mod->source) ? mod->source : EMPTY_STRING);
+    /* keep a partial line for the next read */
+    worker->bufflen -= (uint32)(line - worker->buff);
+    memmove(worker->buff, line, worker->bufflen);
+
+    if (worker->bufflen == NCXMOD_PREFETCH_BUFFLEN - 1 ||
+        (worker->bufflen && !worker->busy)) {
+        return FALSE;
     }
+    return TRUE;
+
+}  /* read_prefetch_reply */
+
+
+/********************************************************************
+* FUNCTION queue_chain_deps
+*
+* Find the import and include statements in the token chain
+* of a top module and add the modules to the pending requests
+*
+* The chain is only scanned, not parsed, so statements that
+* are not well-formed are skipped.  The parser reports them
+* when the top module is loaded.
+*
+* INPUTS:
+*    tkc == token chain of the top module
+*    pendingQ == Q of ncxmod_pfmod_t to add the requests
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    queue_chain_deps (tk_chain_t *tkc,
+                      dlq_hdr_t *pendingQ)
+{
+    tk_token_t     *tk;
+    const xmlChar  *modname, *revision;
+    const xmlChar **arg;
+    uint32          depth;
+    boolean         stmtstart;
+    status_t        res;
+
+    modname = NULL;
+    revision = NULL;
+    arg = NULL;
+    depth = 0;
+    stmtstart = TRUE;
+    res = NO_ERR;
+
+    for (tk = (tk_token_t *)dlq_firstEntry(&tkc->tkQ);
+         tk != NULL && res == NO_ERR;
+         tk = (tk_token_t *)dlq_nextEntry(tk)) {
+
+        switch (tk->typ) {
+        case TK_TT_LBRACE:
+            depth++;
+            stmtstart = TRUE;
+            arg = NULL;
+            continue;
+        case TK_TT_RBRACE:
+            if (depth) {
+                depth--;
+            }
+            /* fall through */
+        case TK_TT_SEMICOL:
+            if (depth == 1 && modname != NULL) {
+                if (valid_module_dep(modname, revision)) {
+                    res = queue_pfmod(modname, revision, pendingQ);
+                }
+                modname = NULL;
+                revision = NULL;
+            }
+            stmtstart = TRUE;
+            arg = NULL;
+            continue;
+        default:
+            ;
+        }
 
-    searchresult = ncxmod_new_search_result_ex(mod);
-    if (searchresult == NULL) {
-        return NULL;
+        if (stmtstart) {
+            /* keyword of a new statement */
+            stmtstart = FALSE;
+            arg = NULL;
+            if (tk->typ != TK_TT_TSTRING) {
+                continue;
+            }
+            if (depth == 1 &&
+                (!xml_strcmp(tk->val, YANG_K_IMPORT) ||
+                 !xml_strcmp(tk->val, YANG_K_INCLUDE))) {
+                modname = NULL;
+                revision = NULL;
+                arg = &modname;
+            } else if (depth == 2 && modname != NULL &&
+                       !xml_strcmp(tk->val, YANG_K_REVISION_DATE)) {
+                arg = &revision;
+            }
+        } else if (arg != NULL) {
+            if (TK_TYP_STR(tk->typ) && tk->mod == NULL) {
+                *arg = tk->val;
+            }
+            arg = NULL;
+        }
     }
-    searchresult->res = NO_ERR;
 
-    return searchresult;
+    return res;
 
-}  /* make_search_result */
+}  /* queue_chain_deps */
 
 
 /********************************************************************
-* FUNCTION search_subtree_callback
-* 
-* Handle the current filename in the subtree traversal
-* Quick parse and generate a search result for the module
+* FUNCTION run_prefetch_jobs
 *
-* INPUTS:
-*   fullspec == absolute or relative path spec, with filename and ext.
-*               this regular file exists, but has not been checked for
-*               read access of 
-*   cookie == resultQ to store malloced search result
+* Give the pending prefetch requests to the module prefetch
+* workers and wait until all of them are done.
+* Each import and include reported by a worker is
+* requested as well, unless it was requested before.
 *
-* RETURNS:
-*    status
+* INPUTS:
+*    pendingQ == Q of ncxmod_pfmod_t to prefetch
+*    topname == name of the module or set being loaded,
+*               for logging only
 *
-*    Return fatal error to stop the traversal or NO_ERR to
-*    keep the traversal going.  Do not return any warning or
-*    recoverable error, just log and move on
+* OUTPUTS:
+*    pendingQ is empty
 *********************************************************************/
-static status_t
-    search_subtree_callback (const char *fullspec,
-                             void *cookie)
+static void
+    run_prefetch_jobs (dlq_hdr_t *pendingQ,
+                       const xmlChar *topname)
 {
-    dlq_hdr_t               *resultQ;
-    ncx_module_t            *retmod;
-    yang_pcb_t              *pcb;
-    ncxmod_search_result_t  *searchresult;
-    status_t                 res;
+    ncxmod_pfworker_t  *workers, *worker;
+    ncxmod_pfmod_t     *pfmod;
+    struct pollfd      *pollfds;
+    uint32              workercnt, busycnt, pollcnt, jobcnt, i;
+    boolean             startok;
+
+    workers = m__getMem(ncxmod_load_jobs * sizeof(ncxmod_pfworker_t));
+    pollfds = m__getMem(ncxmod_load_jobs * sizeof(struct pollfd));
+    if (workers == NULL || pollfds == NULL) {
+        m__free(workers);
+        m__free(pollfds);
+        while (!dlq_empty(pendingQ)) {
+            (void)dlq_deque(pendingQ);
+        }
+        return;
+    }
 
-    resultQ = (dlq_hdr_t *)cookie;
+    workercnt = 0;
+    busycnt = 0;
+    jobcnt = 0;
+    startok = TRUE;
 
-    if (resultQ == NULL) {
-        return SET_ERROR(ERR_INTERNAL_VAL);
-    }
+    for (;;) {
+        /* give the pending requests to idle workers,
+         * starting a new worker if none is idle
+         */
+        while (!dlq_empty(pendingQ)) {
+            worker = NULL;
+            for (i = 0; i < workercnt && worker == NULL; i++) {
+                if (workers[i].fd >= 0 && !workers[i].busy) {
+                    worker = &workers[i];
+                }
+            }
+            if (worker == NULL && startok && workercnt < ncxmod_load_jobs) {
+                if (start_prefetch_worker(workers, workercnt) == NO_ERR) {
+                    worker = &workers[workercnt++];
+                } else {
+                    startok = FALSE;
+                }
+            }
+            if (worker == NULL) {
+                break;
+            }
 
-    pcb = yang_new_pcb();
-    if (pcb == NULL) {
-        return ERR_INTERNAL_MEM;
-    } 
-    pcb->searchmode = TRUE;
+            pfmod = (ncxmod_pfmod_t *)dlq_deque(pendingQ);
+            if (send_prefetch_request(worker, pfmod)) {
+                worker->busy = TRUE;
+                busycnt++;
+                jobcnt++;
+            } else {
+                stop_prefetch_worker(worker);
+            }
+        }
 
-    retmod = NULL;
-    searchresult = NULL;
+        if (busycnt == 0) {
+            break;
+        }
 
-    res = try_load_module(pcb, YANG_PT_TOP, (const xmlChar *)fullspec, 
-                          NULL, &retmod);
+        /* wait for a reply from any busy worker */
+        pollcnt = 0;
+        for (i = 0; i < workercnt; i++) {
+            if (workers[i].busy) {
+                pollfds[pollcnt].fd = workers[i].fd;
+                pollfds[pollcnt].events = POLLIN;
+                pollfds[pollcnt].revents = 0;
+                pollcnt++;
+            }
+        }
 
-    if (res != NO_ERR || retmod == NULL) {
-        if (LOGDEBUG2) {
-            log_debug2("\nFind module '%s' failed (%s)",
-                       fullspec,
-                       get_error_string(res));
+        if (poll(pollfds, pollcnt, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
         }
-    } else {
-        searchresult = make_search_result(retmod);
-        if (searchresult != NULL) {
-            /* hand off malloced memory here */
-            dlq_enque(searchresult, resultQ);
-        } else {
-            res = ERR_INTERNAL_MEM;
+
+        pollcnt = 0;
+        for (i = 0; i < workercnt; i++) {
+            if (!workers[i].busy) {
+                continue;
+            }
+            if (pollfds[pollcnt++].revents == 0) {
+                continue;
+            }
+            if (!read_prefetch_reply(&workers[i], pendingQ)) {
+                stop_prefetch_worker(&workers[i]);
+                busycnt--;
+            } else if (!workers[i].busy) {
+                busycnt--;
+            }
         }
     }
 
-    if (pcb) {
-        yang_free_pcb(pcb);
+    /* any modules left are tokenized by the loader */
+    while (!dlq_empty(pendingQ)) {
+        (void)dlq_deque(pendingQ);
     }
 
-    return res;
+    for (i = 0; i < workercnt; i++) {
+        stop_prefetch_worker(&workers[i]);
+    }
 
-}  /* search_subtree_callback */
+    if (LOGDEBUG2) {
+        log_debug2("\nncxmod: prefetched %u modules for '%s' "
+                   "with %u jobs", jobcnt, 
+                   (topname) ? topname : EMPTY_STRING, 
+                   workercnt);
+    }
+
+    m__free(pollfds);
+    m__free(workers);
+
+}  /* run_prefetch_jobs */
 
 
 /**************    E X T E R N A L   F U N C T I O N S **********/
@@ -2630,7 +4535,8 @@ static status_t
 status_t
     ncxmod_init (void)
 {
-    status_t   res = NO_ERR;
+    const char *jobs;
+    status_t    res = NO_ERR;
 
 #ifdef DEBUG
     if (ncxmod_init_done) {
@@ -2679,6 +4585,29 @@ status_t
 
     ncxmod_subdirs = TRUE;
 
+    dlq_createSQue(&ncxmod_indexQ);
+
+    /* try to get the module index cache file variable */
+    ncxmod_index_cache = NULL;
+    ncxmod_index_cache_loaded = FALSE;
+    if (res == NO_ERR) {
+        ncxmod_set_modcache((const xmlChar *)getenv(NCXMOD_MODCACHE));
+    }
+
+    /* try to get the YANG token cache directory variable */
+    ncxmod_tkcache = NULL;
+    if (res == NO_ERR) {
+        ncxmod_set_tkcache((const xmlChar *)getenv(NCXMOD_TKCACHE));
+    }
+
+    /* try to get the module prefetch jobs variable */
+    memset(ncxmod_pfhashtab, 0x0, sizeof(ncxmod_pfhashtab));
+    ncxmod_load_jobs = 0;
+    jobs = getenv(NCXMOD_LOAD_JOBS);
+    if (jobs != NULL) {
+        ncxmod_set_load_jobs((uint32)strtoul(jobs, NULL, 10));
+    }
+
     ncxmod_init_done = TRUE;
 
     return res;
@@ -2733,6 +4662,21 @@ void
         m__free(ncxmod_run_path_cli);
     }
 
+    ncxmod_clear_search_index();
+
+    if (ncxmod_index_cache) {
+        m__free(ncxmod_index_cache);
+        ncxmod_index_cache = NULL;
+    }
+
+    if (ncxmod_tkcache) {
+        m__free(ncxmod_tkcache);
+        ncxmod_tkcache = NULL;
+    }
+
+    free_pfmods();
+    ncxmod_load_jobs = 0;
+
     ncxmod_init_done = FALSE;
     
 }  /* ncxmod_cleanup */
@@ -4251,6 +6195,282 @@ void
 }  /* ncxmod_set_subdirs */
 
 
+/********************************************************************
+* FUNCTION ncxmod_set_modcache
+* 
+*   Set the module index cache file, overriding the
+*   YUMA_MODCACHE env var
+*
+* The module search indexes are saved in this file when
+* they are built, and read from it the first time a module
+* is searched.  The cached indexes are checked against the
+* directory mtimes before they are used.
+*
+* MALLOC FAILED IGNORED!!!
+*
+* INPUTS:
+*   modcache == new YUMA_MODCACHE value
+*            == NULL or empty string to disable
+*********************************************************************/
+void
+    ncxmod_set_modcache (const xmlChar *modcache)
+{
+    status_t  res;
+
+    if (ncxmod_index_cache) {
+        m__free(ncxmod_index_cache);
+        ncxmod_index_cache = NULL;
+    }
+
+    if (modcache && *modcache) {
+        /* ignoring possible malloc failed!! */
+        res = NO_ERR;
+        ncxmod_index_cache = ncx_get_source(modcache, &res);
+    }
+    ncxmod_index_cache_loaded = FALSE;
+
+}  /* ncxmod_set_modcache */
+
+
+/********************************************************************
+* FUNCTION ncxmod_set_tkcache
+* 
+*   Set the YANG token cache directory, overriding the
+*   YUMA_TKCACHE env var.  yangcli sets it to the tokens
+*   subdir of its --schema-cache directory
+*
+* The tokens of each YANG file are saved in a file in this
+* directory, keyed by the hash of the file contents, and are
+* loaded from it instead of tokenizing an unchanged file.
+* The directory must already exist.
+*
+* MALLOC FAILED IGNORED!!!
+*
+* INPUTS:
+*   tkcache == new YUMA_TKCACHE value
+*           == NULL or empty string to disable
+*********************************************************************/
+void
+    ncxmod_set_tkcache (const xmlChar *tkcache)
+{
+    status_t  res;
+
+    if (ncxmod_tkcache) {
+        m__free(ncxmod_tkcache);
+        ncxmod_tkcache = NULL;
+    }
+
+    if (tkcache && *tkcache) {
+        /* ignoring possible malloc failed!! */
+        res = NO_ERR;
+        ncxmod_tkcache = ncx_get_source(tkcache, &res);
+    }
+
+}  /* ncxmod_set_tkcache */
+
+
+/********************************************************************
+* FUNCTION ncxmod_get_tkcache
+* 
+*   Get the YANG token cache directory
+*
+* RETURNS:
+*   token cache directory or NULL if not used
+*********************************************************************/
+const xmlChar *
+    ncxmod_get_tkcache (void)
+{
+    return ncxmod_tkcache;
+
+}  /* ncxmod_get_tkcache */
+
+
+/********************************************************************
+* FUNCTION ncxmod_set_load_jobs
+* 
+*   Set the number of module prefetch jobs, overriding the
+*   YUMA_LOAD_JOBS env var
+*
+* If more than 1 job is set and the YANG token cache is used,
+* then the modules imported or included by a top module that
+* is not in the token cache are tokenized into the cache by
+* this many worker processes.  The modules are still parsed
+* and loaded one at a time by the calling process.
+*
+* INPUTS:
+*   jobs == new YUMA_LOAD_JOBS value
+*        == 0 or 1 to load the modules without prefetching them
+*********************************************************************/
+void
+    ncxmod_set_load_jobs (uint32 jobs)
+{
+    if (jobs > NCXMOD_MAX_LOAD_JOBS) {
+        jobs = NCXMOD_MAX_LOAD_JOBS;
+    }
+    ncxmod_load_jobs = jobs;
+
+}  /* ncxmod_set_load_jobs */
+
+
+/********************************************************************
+* FUNCTION ncxmod_get_load_jobs
+* 
+*   Get the number of module prefetch jobs
+*
+* RETURNS:
+*   number of module prefetch worker processes;
+*   0 or 1 if modules are not prefetched
+*********************************************************************/
+uint32
+    ncxmod_get_load_jobs (void)
+{
+    return ncxmod_load_jobs;
+
+}  /* ncxmod_get_load_jobs */
+
+
+/********************************************************************
+* FUNCTION ncxmod_prefetch_imports
+*
+* Tokenize the modules imported or included by a top module
+* into the token cache before the top module is parsed,
+* using the number of worker processes set with
+* ncxmod_set_load_jobs.
+*
+* The module parser uses global registries, so the modules
+* are still loaded one at a time by this process.  Only the
+* token chains are made in parallel by the workers; the
+* loader then reads them from the token cache.
+*
+* Nothing is done unless the tokens of the top module were
+* missing from the token cache.  If they were found, then
+* the modules it imports are expected to be cached too.
+* Each module is only requested once, so the workers are
+* only started for modules not loaded or prefetched before.
+*
+* INPUTS:
+*    tkc == token chain of the top module, just tokenized
+*********************************************************************/
+void
+    ncxmod_prefetch_imports (tk_chain_t *tkc)
+{
+    dlq_hdr_t           pendingQ;
+
+#ifdef DEBUG
+    if (!tkc) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
+
+    if (ncxmod_load_jobs < 2 || ncxmod_tkcache == NULL ||
+        !TK_CACHE_MISS(tkc)) {
+        return;
+    }
+
+    dlq_createSQue(&pendingQ);
+
+    /* the requests left in the Q if this fails
+     * are still in the hash table and freed later
+     */
+    (void)queue_chain_deps(tkc, &pendingQ);
+
+    if (!dlq_empty(&pendingQ)) {
+        run_prefetch_jobs(&pendingQ, tkc->filename);
+    }
+
+}  /* ncxmod_prefetch_imports */
+
+
+/********************************************************************
+* FUNCTION ncxmod_prefetch_modules
+*
+* Tokenize a set of modules and everything they import
+* or include into the token cache before they are parsed,
+* using the number of worker processes set with
+* ncxmod_set_load_jobs.
+*
+* This is used when a whole module set is about to be
+* loaded, such as the modules a manager just retrieved
+* from a server, so the workers are not limited to the
+* imports of one top module at a time.
+*
+* INPUTS:
+*    searchresultQ == Q of ncxmod_search_result_t;
+*                     each entry with a module name and
+*                     a source file is requested
+*********************************************************************/
+void
+    ncxmod_prefetch_modules (dlq_hdr_t *searchresultQ)
+{
+    ncxmod_search_result_t  *searchresult;
+    dlq_hdr_t                pendingQ;
+    const xmlChar           *revision;
+    status_t                 res;
+
+#ifdef DEBUG
+    if (!searchresultQ) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
+
+    if (ncxmod_load_jobs < 2 || ncxmod_tkcache == NULL) {
+        return;
+    }
+
+    dlq_createSQue(&pendingQ);
+    res = NO_ERR;
+
+    for (searchresult = (ncxmod_search_result_t *)
+             dlq_firstEntry(searchresultQ);
+         searchresult != NULL && res == NO_ERR;
+         searchresult = (ncxmod_search_result_t *)
+             dlq_nextEntry(searchresult)) {
+
+        if (searchresult->source == NULL) {
+            continue;
+        }
+
+        revision = searchresult->revision;
+        if (revision != NULL && *revision == 0) {
+            revision = NULL;
+        }
+        if (valid_module_dep(searchresult->module, revision)) {
+            res = queue_pfmod(searchresult->module, revision, &pendingQ);
+        }
+    }
+
+    if (!dlq_empty(&pendingQ)) {
+        run_prefetch_jobs(&pendingQ, NULL);
+    }
+
+}  /* ncxmod_prefetch_modules */
+
+
+/********************************************************************
+* FUNCTION ncxmod_clear_search_index
+* 
+*   Clear the module search indexes so the module search
+*   directories are read again the next time they are searched
+*
+* Each index is also checked against the directory mtimes
+* every few seconds, so this is only needed to pick up
+* changes to the module files right away
+*********************************************************************/
+void
+    ncxmod_clear_search_index (void)
+{
+    ncxmod_index_t *idx;
+
+    while (!dlq_empty(&ncxmod_indexQ)) {
+        idx = (ncxmod_index_t *)dlq_deque(&ncxmod_indexQ);
+        free_index(idx);
+    }
+
+}  /* ncxmod_clear_search_index */
+
+
 /********************************************************************
 * FUNCTION ncxmod_get_yumadir
 * 
@@ -4476,6 +6696,12 @@ void
 
     ncxmod_alt_path = altpath;
 
+    /* the modules in this path may have just been written */
+    (void)expire_indexes();
+
+    /* names prefetched before may be found in this path instead */
+    free_pfmods();
+
 }  /* ncxmod_set_altpath */
 
 
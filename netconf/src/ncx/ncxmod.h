@@ -173,6 +173,15 @@ extern "C" {
 /* NCX Environment Variable for SCRIPTS search path */
 #define NCXMOD_RUNPATH      "YUMA_RUNPATH"
 
+/* NCX Environment Variable for the module search index cache file */
+#define NCXMOD_MODCACHE      "YUMA_MODCACHE"
+
+/* NCX Environment Variable for the YANG token cache directory */
+#define NCXMOD_TKCACHE       "YUMA_TKCACHE"
+
+/* NCX Environment Variable for the number of module prefetch jobs */
+#define NCXMOD_LOAD_JOBS     "YUMA_LOAD_JOBS"
+
 /* per user yangcli internal data home when $HOME defined */
 #define NCXMOD_YUMA_DIR (const xmlChar *)"~/.yuma"
 
@@ -880,6 +889,148 @@ extern void
     ncxmod_set_subdirs (boolean usesubdirs);
 
 
+/********************************************************************
+* FUNCTION ncxmod_set_modcache
+* 
+*   Set the module index cache file, overriding the
+*   YUMA_MODCACHE env var
+*
+* The module search indexes are saved in this file when
+* they are built, and read from it the first time a module
+* is searched.  The cached indexes are checked against the
+* directory mtimes before they are used.
+*
+* MALLOC FAILED IGNORED!!!
+*
+* INPUTS:
+*   modcache == new YUMA_MODCACHE value
+*            == NULL or empty string to disable
+*********************************************************************/
+extern void
+    ncxmod_set_modcache (const xmlChar *modcache);
+
+
+/********************************************************************
+* FUNCTION ncxmod_set_tkcache
+* 
+*   Set the YANG token cache directory, overriding the
+*   YUMA_TKCACHE env var.  yangcli sets it to the tokens
+*   subdir of its --schema-cache directory
+*
+* The tokens of each YANG file are saved in a file in this
+* directory, keyed by the hash of the file contents, and are
+* loaded from it instead of tokenizing an unchanged file.
+* The directory must already exist.
+*
+* MALLOC FAILED IGNORED!!!
+*
+* INPUTS:
+*   tkcache == new YUMA_TKCACHE value
+*           == NULL or empty string to disable
+*********************************************************************/
+extern void
+    ncxmod_set_tkcache (const xmlChar *tkcache);
+
+
+/********************************************************************
+* FUNCTION ncxmod_get_tkcache
+* 
+*   Get the YANG token cache directory
+*
+* RETURNS:
+*   token cache directory or NULL if not used
+*********************************************************************/
+extern const xmlChar *
+    ncxmod_get_tkcache (void);
+
+
+/********************************************************************
+* FUNCTION ncxmod_set_load_jobs
+* 
+*   Set the number of module prefetch jobs, overriding the
+*   YUMA_LOAD_JOBS env var
+*
+* If more than 1 job is set and the YANG token cache is used,
+* then the modules imported or included by a top module that
+* is not in the token cache are tokenized into the cache by
+* this many worker processes.  The modules are still parsed
+* and loaded one at a time by the calling process.
+*
+* INPUTS:
+*   jobs == new YUMA_LOAD_JOBS value
+*        == 0 or 1 to load the modules without prefetching them
+*********************************************************************/
+extern void
+    ncxmod_set_load_jobs (uint32 jobs);
+
+
+/********************************************************************
+* FUNCTION ncxmod_get_load_jobs
+* 
+*   Get the number of module prefetch jobs
+*
+* RETURNS:
+*   number of module prefetch worker processes;
+*   0 or 1 if modules are not prefetched
+*********************************************************************/
+extern uint32
+    ncxmod_get_load_jobs (void);
+
+
+/********************************************************************
+* FUNCTION ncxmod_prefetch_imports
+*
+* Tokenize the modules imported or included by a top module
+* into the token cache before the top module is parsed,
+* using the number of worker processes set with
+* ncxmod_set_load_jobs.
+*
+* Nothing is done unless the tokens of the top module were
+* missing from the token cache.
+*
+* INPUTS:
+*    tkc == token chain of the top module, just tokenized
+*********************************************************************/
+extern void
+    ncxmod_prefetch_imports (tk_chain_t *tkc);
+
+
+/********************************************************************
+* FUNCTION ncxmod_prefetch_modules
+*
+* Tokenize a set of modules and everything they import
+* or include into the token cache before they are parsed,
+* using the number of worker processes set with
+* ncxmod_set_load_jobs.
+*
+* This is used when a whole module set is about to be
+* loaded, such as the modules a manager just retrieved
+* from a server, so the workers are not limited to the
+* imports of one top module at a time.
+*
+* INPUTS:
+*    searchresultQ == Q of ncxmod_search_result_t;
+*                     each entry with a module name and
+*                     a source file is requested
+*********************************************************************/
+extern void
+    ncxmod_prefetch_modules (dlq_hdr_t *searchresultQ);
+
+
+/********************************************************************
+* FUNCTION ncxmod_clear_search_index
+* 
+*   Clear the module search indexes so the module search
+*   directories are read again the next time they are searched
+*
+* Each index is also checked against the directory mtimes
+* every few seconds, so this is only needed to pick up
+* changes to the module files right away
+*********************************************************************/
+extern void
+    ncxmod_clear_search_index (void);
+
+
 /********************************************************************
 * FUNCTION ncxmod_get_yumadir
 * 
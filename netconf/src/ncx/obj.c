@@ -42,6 +42,7 @@ date         init     comment
 #include "ncx_appinfo.h"
 #include "ncx_feature.h"
 #include "ncx_list.h"
+#include "ncx_num.h"
 #include "obj.h"
 #include "tk.h"
 #include "typ.h"
@@ -3848,6 +3849,46 @@ static void clean_inherited_whenQ( dlq_hdr_t *ptrQ )
     }
 }
 
+
+
+/********************************************************************
+* FUNCTION get_appinfo_uint32
+*
+* Get the argument of an appinfo entry as a uint32 number
+*
+* INPUTS:
+*   appinfo == appinfo entry to check
+*   retval == address of return number
+*
+* OUTPUTS:
+*   *retval set if NO_ERR
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    get_appinfo_uint32 (const ncx_appinfo_t *appinfo,
+                        uint32 *retval)
+{
+    const xmlChar *str;
+    ncx_num_t      num;
+    status_t       res;
+
+    str = ncx_get_appinfo_value(appinfo);
+    if (str == NULL) {
+        return ERR_NCX_MISSING_PARM;
+    }
+
+    ncx_init_num(&num);
+    res = ncx_convert_num(str, NCX_NF_DEC, NCX_BT_UINT32, &num);
+    if (res == NO_ERR) {
+        *retval = num.u;
+    }
+    ncx_clean_num(NCX_BT_UINT32, &num);
+    return res;
+
+}  /* get_appinfo_uint32 */
+
     
 /**************** E X T E R N A L    F U N C T I O N S    **********/
 
@@ -6523,6 +6564,9 @@ obj_template_t *
         return NULL;
     }
 
+    newobj->cache_timeout = srcobj->cache_timeout;
+    newobj->cache_stale_timeout = srcobj->cache_stale_timeout;
+
     newobj->mod = mod;
     newobj->nsid = mod->nsid;
 
@@ -9725,6 +9769,74 @@ obj_template_t *
 }  /* obj_get_real_parent */
 
 
+/********************************************************************
+* FUNCTION obj_is_ancestor_or_self
+* 
+* Check if an object is the same as or an ancestor of
+* another object
+*
+* INPUTS:
+*    ancestor == object to check as the ancestor-or-self node
+*    obj  == object to check
+*
+* RETURNS:
+*    TRUE if ancestor is obj or one of its ancestors
+*    FALSE otherwise
+*********************************************************************/
+boolean
+    obj_is_ancestor_or_self (const obj_template_t *ancestor,
+                             const obj_template_t *obj)
+{
+    const obj_template_t *testobj;
+
+    for (testobj = obj; testobj != NULL; testobj = testobj->parent) {
+        if (testobj == ancestor) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+
+}  /* obj_is_ancestor_or_self */
+
+
+/********************************************************************
+* FUNCTION obj_get_common_ancestor
+* 
+* Get the lowest data node that is an ancestor-or-self
+* of both objects; skip OBJ_TYP_CHOICE and OBJ_TYP_CASE
+*
+* INPUTS:
+*    obj1  == first object to check
+*    obj2  == second object to check
+*
+* RETURNS:
+*    pointer to the common ancestor-or-self node
+*    NULL if the objects only have the root in common
+*********************************************************************/
+obj_template_t *
+    obj_get_common_ancestor (obj_template_t *obj1,
+                             obj_template_t *obj2)
+{
+    obj_template_t *testobj = obj1;
+
+    if (testobj != NULL && (testobj->objtype == OBJ_TYP_CHOICE ||
+                            testobj->objtype == OBJ_TYP_CASE)) {
+        testobj = obj_get_real_parent(testobj);
+    }
+
+    for (; testobj != NULL; testobj = obj_get_real_parent(testobj)) {
+        if (obj_is_root(testobj)) {
+            return NULL;
+        }
+        if (obj_is_ancestor_or_self(testobj, obj2)) {
+            return testobj;
+        }
+    }
+    return NULL;
+
+}  /* obj_get_common_ancestor */
+
+
 /********************************************************************
 * FUNCTION obj_get_presence_string
 *
@@ -11540,6 +11652,36 @@ void
         }
     }
 
+    if (!obj_is_config(obj)) {
+        /* ncx:cache-timeout and ncx:cache-stale-timeout extensions */
+        const ncx_appinfo_t *appinfo = 
+            ncx_find_const_appinfo(appinfoQ, NCX_PREFIX, 
+                                   NCX_EL_CACHE_TIMEOUT);
+        if (appinfo) {
+            const xmlChar *extname = NCX_EL_CACHE_TIMEOUT;
+            uint32 timeout = 0, stale_timeout = 0;
+            status_t res = get_appinfo_uint32(appinfo, &timeout);
+
+            if (res == NO_ERR) {
+                appinfo = ncx_find_const_appinfo(appinfoQ, NCX_PREFIX, 
+                                                 NCX_EL_CACHE_STALE_TIMEOUT);
+                if (appinfo) {
+                    extname = NCX_EL_CACHE_STALE_TIMEOUT;
+                    res = get_appinfo_uint32(appinfo, &stale_timeout);
+                }
+            }
+            if (res != NO_ERR) {
+                /* not setting any cache timers! */
+                log_error("\nError: invalid ncx:%s value for '%s' (%s)",
+                          extname,
+                          obj_get_name(obj),
+                          get_error_string(res));
+            } else {
+                obj_set_cache_timeout(obj, timeout, stale_timeout);
+            }
+        }
+    }
+
     if (obj_is_leafy(obj)) {
         const typ_def_t *typdef = obj_get_ctypdef(obj);
 
@@ -11910,6 +12052,73 @@ boolean
 }
 
 
+/********************************************************************
+* FUNCTION obj_set_cache_timeout
+*
+* Set the virtual value cache timers for an object
+* Overrides any ncx:cache-timeout and ncx:cache-stale-timeout
+* values and the session default for all virtual value nodes
+* for this object. A virtual value is shared by all sessions
+* until it is older than timeout seconds. After that, a stale
+* value is still returned for up to stale_timeout more seconds,
+* while it is refreshed out of band (see val_refresh_virtual_values)
+*
+* INPUTS:
+*   obj == obj_template to set
+*   timeout == cache timeout in seconds; 0 to disable the cache
+*   stale_timeout == stale-while-revalidate time in seconds;
+*                    0 to always refresh an expired value in-line
+*********************************************************************/
+void
+    obj_set_cache_timeout (obj_template_t *obj,
+                           uint32 timeout,
+                           uint32 stale_timeout)
+{
+    assert( obj && "obj is NULL!" );
+
+    obj->cache_timeout = timeout;
+    obj->cache_stale_timeout = stale_timeout;
+    obj->flags |= OBJ_FL_CACHE_TIMEOUT;
+
+}  /* obj_set_cache_timeout */
+
+
+/********************************************************************
+* FUNCTION obj_get_cache_timeout
+*
+* Get the virtual value cache timers for an object
+*
+* INPUTS:
+*   obj == obj_template to check
+*   timeout == address of return cache timeout
+*   stale_timeout == address of return stale-while-revalidate time
+*
+* OUTPUTS:
+*   *timeout and *stale_timeout set if TRUE returned
+*
+* RETURNS:
+*   TRUE if the object has its own cache timers
+*   FALSE if the session or global default should be used
+*********************************************************************/
+boolean
+    obj_get_cache_timeout (const obj_template_t *obj,
+                           uint32 *timeout,
+                           uint32 *stale_timeout)
+{
+    assert( obj && "obj is NULL!" );
+    assert( timeout && "timeout is NULL!" );
+    assert( stale_timeout && "stale_timeout is NULL!" );
+
+    if (!(obj->flags & OBJ_FL_CACHE_TIMEOUT)) {
+        return FALSE;
+    }
+    *timeout = obj->cache_timeout;
+    *stale_timeout = obj->cache_stale_timeout;
+    return TRUE;
+
+}  /* obj_get_cache_timeout */
+
+
 /********************************************************************
 * FUNCTION obj_new_iffeature_ptr
 *
@@ -165,6 +165,9 @@ extern "C" {
 /* object is tagged as ncx:user-write with no delete access */
 #define OBJ_FL_BLOCK_DELETE bit30
 
+/* object is tagged ncx:cache-timeout or obj_set_cache_timeout used */
+#define OBJ_FL_CACHE_TIMEOUT bit31
+
 
 /********************************************************************
 *								    *
@@ -467,6 +470,12 @@ typedef struct obj_template_t_ {
     /* ...or agt_cb_fnset_node_t queue for data OBJ */
     dlq_hdr_t                   cbsetQ;
 
+    /* virtual value cache timers in seconds for data OBJ;
+     * only used if OBJ_FL_CACHE_TIMEOUT is set
+     */
+    uint32                      cache_timeout;
+    uint32                      cache_stale_timeout;
+
     /* object module and namespace ID 
      * assigned at runtime
      * this can be changed over and over as a
@@ -2708,6 +2717,44 @@ extern obj_template_t *
     obj_get_real_parent (obj_template_t  *obj);
 
 
+/********************************************************************
+* FUNCTION obj_is_ancestor_or_self
+* 
+* Check if an object is the same as or an ancestor of
+* another object
+*
+* INPUTS:
+*    ancestor == object to check as the ancestor-or-self node
+*    obj  == object to check
+*
+* RETURNS:
+*    TRUE if ancestor is obj or one of its ancestors
+*    FALSE otherwise
+*********************************************************************/
+extern boolean
+    obj_is_ancestor_or_self (const obj_template_t *ancestor,
+                             const obj_template_t *obj);
+
+
+/********************************************************************
+* FUNCTION obj_get_common_ancestor
+* 
+* Get the lowest data node that is an ancestor-or-self
+* of both objects; skip OBJ_TYP_CHOICE and OBJ_TYP_CASE
+*
+* INPUTS:
+*    obj1  == first object to check
+*    obj2  == second object to check
+*
+* RETURNS:
+*    pointer to the common ancestor-or-self node
+*    NULL if the objects only have the root in common
+*********************************************************************/
+extern obj_template_t *
+    obj_get_common_ancestor (obj_template_t *obj1,
+                             obj_template_t *obj2);
+
+
 /********************************************************************
 * FUNCTION obj_get_presence_string
 *
@@ -3889,6 +3936,52 @@ extern boolean
     obj_is_block_user_delete (const obj_template_t *obj);
 
 
+/********************************************************************
+* FUNCTION obj_set_cache_timeout
+*
+* Set the virtual value cache timers for an object
+* Overrides any ncx:cache-timeout and ncx:cache-stale-timeout
+* values and the session default for all virtual value nodes
+* for this object. A virtual value is shared by all sessions
+* until it is older than timeout seconds. After that, a stale
+* value is still returned for up to stale_timeout more seconds,
+* while it is refreshed out of band (see val_refresh_virtual_values)
+*
+* INPUTS:
+*   obj == obj_template to set
+*   timeout == cache timeout in seconds; 0 to disable the cache
+*   stale_timeout == stale-while-revalidate time in seconds;
+*                    0 to always refresh an expired value in-line
+*********************************************************************/
+extern void
+    obj_set_cache_timeout (obj_template_t *obj,
+                           uint32 timeout,
+                           uint32 stale_timeout);
+
+
+/********************************************************************
+* FUNCTION obj_get_cache_timeout
+*
+* Get the virtual value cache timers for an object
+*
+* INPUTS:
+*   obj == obj_template to check
+*   timeout == address of return cache timeout
+*   stale_timeout == address of return stale-while-revalidate time
+*
+* OUTPUTS:
+*   *timeout and *stale_timeout set if TRUE returned
+*
+* RETURNS:
+*   TRUE if the object has its own cache timers
+*   FALSE if the session or global default should be used
+*********************************************************************/
+extern boolean
+    obj_get_cache_timeout (const obj_template_t *obj,
+                           uint32 *timeout,
+                           uint32 *stale_timeout);
+
+
 /********************************************************************
 * FUNCTION obj_new_iffeature_ptr
 *
@@ -69,6 +69,15 @@ date         init     comment
 /* used by yangcli to read in between stdin polling */
 #define MAX_READ_TRIES   500
 
+/* chars that need escaping in element content and HTML content;
+ * newline is included so the indent handling can see it
+ */
+#define CONTENT_SPECIAL_CHARS  "<>&\n"
+#define HTML_SPECIAL_CHARS     "<>&"
+
+/* size of the static blank run used by ses_indent */
+#define SES_INDENT_BLANKS   64
+
 
 /********************************************************************
 *                                                                   *
@@ -84,6 +93,10 @@ date         init     comment
 *********************************************************************/
 static ses_total_stats_t totals;
 
+/* run of spaces copied in blocks by ses_indent */
+static const xmlChar indent_blanks[SES_INDENT_BLANKS+1] =
+    "                                                                ";
+
 
 /********************************************************************
 * FUNCTION accept_buffer_ssh_v10
@@ -752,6 +765,83 @@ static status_t
 }  /* accept_buffer_ssh_v11 */
 
 
+/********************************************************************
+* FUNCTION put_block
+*
+* Write a block of chars to the session, without any translation
+*
+* Same as calling ses_putchar for each char in the block, except
+* the chars are copied into the output buffer with memcpy, one
+* copy per buffer boundary, and the session and total stats
+* are updated once for the whole block
+*
+* INPUTS:
+*   scb == session control block to write
+*   str == start of the block to write
+*   len == number of chars in the block to write
+*
+*********************************************************************/
+static void
+    put_block (ses_cb_t *scb,
+               const xmlChar *str,
+               uint32 len)
+{
+    ses_msg_buff_t *buff;
+    const xmlChar  *nl;
+    status_t        res;
+    size_t          limit, cnt, pad;
+    uint32          done;
+
+    if (len == 0) {
+        return;
+    }
+
+    if (scb->fd) {
+        /* Normal NETCONF session mode: */
+        pad = (scb->framing11) ? SES_ENDCHUNK_PAD : 0;
+        done = 0;
+        if (scb->outbuff == NULL) {
+            (void)ses_msg_new_buff(scb, TRUE, &scb->outbuff);
+        }
+        while (done < len && scb->outbuff != NULL) {
+            buff = scb->outbuff;
+            limit = buff->buffsize - pad;
+            if (buff->bufflen >= limit) {
+                res = ses_msg_new_output_buff(scb);
+                if (res != NO_ERR) {
+                    break;
+                }
+                continue;
+            }
+            cnt = min(limit - buff->bufflen, (size_t)(len - done));
+            memcpy(&buff->buff[buff->bufflen], &str[done], cnt);
+            buff->bufflen += cnt;
+            done += (uint32)cnt;
+        }
+        scb->stats.out_bytes += done;
+        totals.stats.out_bytes += done;
+    } else if (scb->fp) {
+        /* debug session, sending output to a file */
+        fwrite(str, 1, len, scb->fp);
+    } else {
+        /* debug session, sending output to the screen */
+        fwrite(str, 1, len, stdout);
+    }
+
+    /* only the chars after the last newline count for out_line */
+    nl = &str[len];
+    while (nl > str && nl[-1] != '\n') {
+        nl--;
+    }
+    if (nl > str) {
+        scb->stats.out_line = (uint32)(&str[len] - nl);
+    } else {
+        scb->stats.out_line += len;
+    }
+
+}  /* put_block */
+
+
 /********************************************************************
 * FUNCTION put_char_entity
 *
@@ -766,18 +856,43 @@ static void
     put_char_entity (ses_cb_t *scb,
                      xmlChar ch)
 {
-    xmlChar     numbuff[NCX_MAX_NUMLEN];
-
-    snprintf((char *)numbuff, NCX_MAX_NUMLEN, "%u", (uint32)ch);
+    xmlChar     numbuff[NCX_MAX_NUMLEN+4];
+    int         len;
 
-    ses_putchar(scb, '&');
-    ses_putchar(scb, '#');
-    ses_putstr(scb, numbuff);
-    ses_putchar(scb, ';');
+    len = snprintf((char *)numbuff, sizeof(numbuff), "&#%u;", (uint32)ch);
+    put_block(scb, numbuff, (uint32)len);
 
 }  /* put_char_entity */
 
 
+/********************************************************************
+* FUNCTION attr_special_char
+*
+* Check if a char needs to be escaped in attribute content
+*
+* INPUTS:
+*   ch == char to check
+*
+* RETURNS:
+*   TRUE if ch is the end of a plain run in ses_putastr
+*********************************************************************/
+static boolean
+    attr_special_char (xmlChar ch)
+{
+    switch (ch) {
+    case 0:
+    case '<':
+    case '>':
+    case '&':
+    case '"':
+        return TRUE;
+    default:
+        return (isspace(ch)) ? TRUE : FALSE;
+    }
+
+}  /* attr_special_char */
+
+
 /********************************************************************
 * FUNCTION handle_prolog_state
 *
@@ -1167,9 +1282,7 @@ void
     ses_putstr (ses_cb_t *scb,
                 const xmlChar *str)
 {
-    while (*str) {
-        ses_putchar(scb, *str++);
-    }
+    put_block(scb, str, xml_strlen(str));
 
 }  /* ses_putstr */
 
@@ -1194,18 +1307,22 @@ void
                        const xmlChar *str,
                        int32 indent)
 {
+    const xmlChar *nl;
+
     ses_indent(scb, indent);
     while (*str) {
-        if (*str == '\n') {
-            if (indent < 0) {
-                ses_putchar(scb, *str++);
-            } else {
-                ses_indent(scb, indent);
-                str++;
-            }
+        nl = (const xmlChar *)strchr((const char *)str, '\n');
+        if (nl == NULL) {
+            put_block(scb, str, xml_strlen(str));
+            return;
+        }
+        put_block(scb, str, (uint32)(nl - str));
+        if (indent < 0) {
+            ses_putchar(scb, '\n');
         } else {
-            ses_putchar(scb, *str++);
+            ses_indent(scb, indent);
         }
+        str = nl + 1;
     }
 }  /* ses_putstr_indent */
 
@@ -1230,27 +1347,31 @@ void
                  const xmlChar *str,
                  int32 indent)
 {
+    size_t  len;
+
     while (*str) {
+        /* copy the run of plain chars in one block */
+        len = strcspn((const char *)str, CONTENT_SPECIAL_CHARS);
+        if (len) {
+            put_block(scb, str, (uint32)len);
+            str += len;
+            continue;
+        }
+
         if (*str == '<') {
             ses_putstr(scb, LTSTR);
-            str++;
         } else if (*str == '>') {
             ses_putstr(scb, GTSTR);
-            str++;
         } else if (*str == '&') {
             ses_putstr(scb, AMPSTR);
-            str++;
         } else if ((scb->mode == SES_MODE_XMLDOC
-                    || scb->mode == SES_MODE_TEXT) && *str == '\n') {
-            if (indent < 0) {
-                ses_putchar(scb, *str++);
-            } else {
-                ses_indent(scb, indent);
-                str++;
-            }
+                    || scb->mode == SES_MODE_TEXT) && indent >= 0) {
+            /* newline */
+            ses_indent(scb, indent);
         } else {
-            ses_putchar(scb, *str++);
+            ses_putchar(scb, *str);
         }
+        str++;
     }
 }  /* ses_putcstr */
 
@@ -1273,19 +1394,25 @@ void
     ses_puthstr (ses_cb_t *scb,
                  const xmlChar *str)
 {
+    size_t  len;
+
     while (*str) {
+        /* copy the run of plain chars in one block */
+        len = strcspn((const char *)str, HTML_SPECIAL_CHARS);
+        if (len) {
+            put_block(scb, str, (uint32)len);
+            str += len;
+            continue;
+        }
+
         if (*str == '<') {
             ses_putstr(scb, LTSTR);
-            str++;
         } else if (*str == '>') {
             ses_putstr(scb, GTSTR);
-            str++;
-        } else if (*str == '&') {
-            ses_putstr(scb, AMPSTR);
-            str++;
         } else {
-            ses_putchar(scb, *str++);
+            ses_putstr(scb, AMPSTR);
         }
+        str++;
     }
 }  /* ses_puthstr */
 
@@ -1354,36 +1481,43 @@ void
                  const xmlChar *str,
                  int32 indent)
 {
+    const xmlChar *run;
+
     while (*str) {
+        /* copy the run of plain chars in one block */
+        run = str;
+        while (!attr_special_char(*str)) {
+            str++;
+        }
+        if (str != run) {
+            put_block(scb, run, (uint32)(str - run));
+            continue;
+        }
+
         if (*str == '<') {
             ses_putstr(scb, LTSTR);
-            str++;
         } else if (*str == '>') {
             ses_putstr(scb, GTSTR);
-            str++;
         } else if (*str == '&') {
             ses_putstr(scb, AMPSTR);
-            str++;
         } else if (*str == '"') {
             ses_putstr(scb, QSTR);
-            str++;
         } else if (*str == '\n') {
             if (scb->mode == SES_MODE_XMLDOC || 
                 scb->mode == SES_MODE_TEXT) {
                 if (indent < 0) {
-                    ses_putchar(scb, *str++);
+                    ses_putchar(scb, *str);
                 } else {
                     ses_indent(scb, indent);
-                    str++;
                 }
             } else {
-                put_char_entity(scb, *str++);
+                put_char_entity(scb, *str);
             }
-        } else if (isspace(*str)) {
-            put_char_entity(scb, *str++);
         } else {
-            ses_putchar(scb, *str++);
+            /* other whitespace */
+            put_char_entity(scb, *str);
         }
+        str++;
     }
 }  /* ses_putastr */
 
@@ -1471,7 +1605,7 @@ void
     ses_indent (ses_cb_t *scb,
                 int32 indent)
 {
-    int32 i;
+    int32 cnt;
 
     if (indent < 0) {
         return;
@@ -1480,8 +1614,10 @@ void
     /* set limit on indentation in case of bug */
     indent = min(indent, 255);
     ses_putchar(scb, '\n');
-    for (i=0; i<indent; i++) {
-        ses_putchar(scb, ' ');
+    while (indent > 0) {
+        cnt = min(indent, SES_INDENT_BLANKS);
+        put_block(scb, indent_blanks, (uint32)cnt);
+        indent -= cnt;
     }
 
 }  /* ses_indent */
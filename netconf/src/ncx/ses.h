@@ -84,17 +84,29 @@ extern "C" {
 /* controls the size of each buffer chuck */
 #define SES_MSG_BUFFSIZE  2000   // 1024
 
+/* output buffers start at SES_MSG_BUFFSIZE and double in size
+ * while a message is being generated, up to this default limit
+ */
+#define SES_MSG_MAX_BUFFSIZE  65536
+
+/* hard limit for the max output buffer size; the base:1.1 chunk
+ * size must fit in the SES_STARTCHUNK_PAD area (7 digits)
+ */
+#define SES_MSG_MAX_BUFFSIZE_LIMIT  1048576
+
 /* max number of buffer chunks a session can have allocated at once  */
 #define SES_MAX_BUFFERS  4096
 
 /* max number of buffers a session is allowed to cache in its freeQ */
 #define SES_MAX_FREE_BUFFERS  32
 
-/* max number of buffers to try to send in one call to the write fn */
-#define SES_MAX_BUFFSEND   32
+/* max number of buffers to try to send in one call to the write fn
+ * (will be limited to IOV_MAX if that is smaller)
+ */
+#define SES_MAX_BUFFSEND   1024
 
 /* max number of bytes to try to send in one call to the write_fn */
-#define SES_MAX_BYTESEND   0xffff
+#define SES_MAX_BYTESEND   0x3ffff
 
 /* max desired lines size; not a hard limit */
 #define SES_DEF_LINESIZE   72
@@ -245,7 +257,9 @@ typedef struct ses_msg_buff_t_ {
     size_t           bufflen;        /* buff actual size */
     size_t           buffpos;       /* buff cur position */
     boolean          islast;      /* T: last buff in msg */
-    xmlChar          buff[SES_MSG_BUFFSIZE];   
+    boolean          framed;  /* T: base:1.1 chunk tags added */
+    size_t           buffsize;   /* size of the buff memory */
+    xmlChar         *buff;   /* malloced after the header */
 } ses_msg_buff_t;
 
 
@@ -313,6 +327,7 @@ typedef struct ses_cb_t_ {
     dlq_hdr_t        freeQ;              /* Q of ses_msg_buff_t */
     dlq_hdr_t        outQ;               /* Q of ses_msg_buff_t */
     ses_msg_buff_t  *outbuff;          /* current output buffer */
+    uint32           outbuffsize;  /* size of next output buffer */
     ses_ready_t      inready;            /* header for inreadyQ */
     ses_ready_t      outready;          /* header for outreadyQ */
     ses_stats_t      stats;           /* per-session statistics */
@@ -36,6 +36,7 @@ date         init     comment
 #include  <unistd.h>
 #include  <errno.h>
 #include  <assert.h>
+#include  <limits.h>
 #include  <sys/uio.h>
 
 #include  "procdefs.h"
@@ -60,6 +61,13 @@ date         init     comment
 /* max number of buffers a session is allowed to cache in its freeQ */
 #define MAX_FREE_MSGS  32
 
+/* max number of iovecs to use in one writev call */
+#if defined(IOV_MAX) && (IOV_MAX < SES_MAX_BUFFSEND)
+#define SES_MSG_MAX_IOV  IOV_MAX
+#else
+#define SES_MSG_MAX_IOV  SES_MAX_BUFFSEND
+#endif
+
 
 /********************************************************************
 *                                                                   *
@@ -78,6 +86,7 @@ static uint32    freecnt;
 static dlq_hdr_t freeQ;
 static dlq_hdr_t inreadyQ;
 static dlq_hdr_t outreadyQ;
+static uint32    max_outbuffsize = SES_MSG_MAX_BUFFSIZE;
 
 
 /********************************************************************
@@ -168,6 +177,39 @@ static status_t
 }  /* do_send_buff */
 
 
+/********************************************************************
+* FUNCTION alloc_buff
+*
+* Malloc a session buffer chunk header and its buffer memory
+* in one block
+*
+* INPUTS:
+*   buffsize == number of bytes of buffer memory needed
+*
+* RETURNS:
+*   malloced buffer chunk or NULL if malloc error
+*********************************************************************/
+static ses_msg_buff_t *
+    alloc_buff (size_t buffsize)
+{
+    ses_msg_buff_t *newbuff;
+
+    /* add 1 pad byte because the input code uses xml_strncpy,
+     * which writes a zero byte past the end of a full buffer
+     */
+    newbuff = (ses_msg_buff_t *)
+        m__getMem(sizeof(ses_msg_buff_t) + buffsize + 1);
+    if (newbuff == NULL) {
+        return NULL;
+    }
+    memset(newbuff, 0x0, sizeof(ses_msg_buff_t));
+    newbuff->buffsize = buffsize;
+    newbuff->buff = (xmlChar *)&newbuff[1];
+    return newbuff;
+
+}  /* alloc_buff */
+
+
 /********************************************************************
 * FUNCTION ses_msg_init
 *
@@ -228,6 +270,31 @@ void
 }  /* ses_msg_cleanup */
 
 
+/********************************************************************
+* FUNCTION ses_msg_set_max_outbuff_size
+*
+* Set the max size an output buffer is allowed to grow to
+* Output buffers start at SES_MSG_BUFFSIZE for each message
+* and double in size each time one is filled
+*
+* INPUTS:
+*   maxsize == max output buffer size in bytes;
+*              will be adjusted to the range
+*              SES_MSG_BUFFSIZE .. SES_MSG_MAX_BUFFSIZE_LIMIT
+*********************************************************************/
+void
+    ses_msg_set_max_outbuff_size (uint32 maxsize)
+{
+    if (maxsize < SES_MSG_BUFFSIZE) {
+        maxsize = SES_MSG_BUFFSIZE;
+    } else if (maxsize > SES_MSG_MAX_BUFFSIZE_LIMIT) {
+        maxsize = SES_MSG_MAX_BUFFSIZE_LIMIT;
+    }
+    max_outbuffsize = maxsize;
+
+}  /* ses_msg_set_max_outbuff_size */
+
+
 /********************************************************************
 * FUNCTION ses_msg_new_msg
 *
@@ -326,19 +393,30 @@ status_t ses_msg_new_buff( ses_cb_t *scb,
                            ses_msg_buff_t **buff)
 {
     ses_msg_buff_t *newbuff;
+    size_t          buffsize;
 
     assert( scb && "scb == NULL" );
     assert( buff && "buff == NULL" );
 
-    /* handle the session freeQ separately */
-    if (scb->freecnt) {
+    /* input buffers are always SES_MSG_BUFFSIZE;
+     * output buffers grow while a big message is generated
+     */
+    buffsize = SES_MSG_BUFFSIZE;
+    if (outbuff && scb->outbuffsize > SES_MSG_BUFFSIZE) {
+        buffsize = min(scb->outbuffsize, max_outbuffsize);
+    }
+
+    /* handle the session freeQ separately;
+     * it only holds SES_MSG_BUFFSIZE buffers
+     */
+    if (scb->freecnt && buffsize == SES_MSG_BUFFSIZE) {
         newbuff = (ses_msg_buff_t *)dlq_deque(&scb->freeQ);
         if (newbuff) {
             /* use buffer from freeQ */
             ses_msg_init_buff(scb, outbuff, newbuff);
 
 #ifdef SES_MSG_CLEAR_INIT_BUFFERS
-            memset(newbuff->buff, 0x0, SES_MSG_BUFFSIZE);
+            memset(newbuff->buff, 0x0, newbuff->buffsize);
 #endif
 
             *buff = newbuff;
@@ -364,7 +442,7 @@ status_t ses_msg_new_buff( ses_cb_t *scb,
     }
 
     /* malloc the buffer */
-    newbuff = m__getObj(ses_msg_buff_t);
+    newbuff = alloc_buff(buffsize);
     if (newbuff == NULL) {
         return ERR_INTERNAL_MEM;
     }
@@ -373,7 +451,7 @@ status_t ses_msg_new_buff( ses_cb_t *scb,
     ses_msg_init_buff(scb, outbuff, newbuff);
 
 #ifdef DEBUG
-    memset(newbuff->buff, 0x0, SES_MSG_BUFFSIZE);
+    memset(newbuff->buff, 0x0, newbuff->buffsize);
 #endif
 
     *buff = newbuff;
@@ -410,6 +488,7 @@ void
     assert( scb && "scb == NULL" );
 
     if (scb->state < SES_ST_SHUTDOWN_REQ &&
+        buff->buffsize == SES_MSG_BUFFSIZE &&
         scb->freecnt < SES_MAX_FREE_BUFFERS) {
         dlq_enque(buff, &scb->freeQ);
         scb->freecnt++;
@@ -466,13 +545,13 @@ status_t
 
     res = NO_ERR;
     if (scb->framing11) {
-        if (buff->bufflen < (SES_MSG_BUFFSIZE - SES_ENDCHUNK_PAD)) {
+        if (buff->bufflen < (buff->buffsize - SES_ENDCHUNK_PAD)) {
             buff->buff[buff->bufflen++] = (xmlChar)ch;
         } else {
             res = ERR_BUFF_OVFL;
         }
     } else {
-        if (buff->bufflen < SES_MSG_BUFFSIZE) {
+        if (buff->bufflen < buff->buffsize) {
             buff->buff[buff->bufflen++] = (xmlChar)ch;
         } else {
             res = ERR_BUFF_OVFL;
@@ -499,12 +578,10 @@ status_t
     ses_msg_send_buffs (ses_cb_t *scb)
 {
     ses_msg_buff_t  *buff;
-    uint32           buffleft, total;
+    size_t           buffleft, total;
     ssize_t          retcnt;
     int              i, cnt;
-    boolean          done;
-    status_t         res;
-    struct iovec     iovs[SES_MAX_BUFFSEND];
+    struct iovec     iovs[SES_MSG_MAX_IOV];
 
     assert( scb && "scb == NULL" );
 
@@ -537,97 +614,86 @@ status_t
         return (*scb->wrfn)(scb);
     }
 
-    memset(iovs, 0x0, sizeof(iovs));
+    /* setup the writev call for as many buffers as allowed;
+     * base:1.1 chunk framing is added in the start pad and
+     * end pad of each buffer the first time it is sent,
+     * so the buffer contents are never copied
+     */
     total = 0;
     cnt = 0;
-    done = FALSE;
-    buff = (ses_msg_buff_t *)dlq_firstEntry(&scb->outQ);
+    for (buff = (ses_msg_buff_t *)dlq_firstEntry(&scb->outQ);
+         buff != NULL && cnt < SES_MSG_MAX_IOV;
+         buff = (ses_msg_buff_t *)dlq_nextEntry(buff)) {
 
-    /* setup the writev call */
-    for (i=0; i<SES_MAX_BUFFSEND && !done && buff; i++) {
-        buffleft = buff->bufflen - buff->buffpos;
-        if ((total+buffleft) > SES_MAX_BYTESEND) {
-            done = TRUE;
-        } else {
-            total += buffleft;
-            iovs[i].iov_base = &buff->buff[buff->buffpos];
-            iovs[i].iov_len = buffleft;
-            buff = (ses_msg_buff_t *)dlq_nextEntry(buff);
+        if (scb->framing11 && !buff->framed) {
+            ses_msg_add_framing(scb, buff);
+
+            /* switch to absolute positions like base:1.0 buffers */
+            buff->buffpos = buff->buffstart;
+            buff->bufflen += buff->buffstart;
 
-#ifdef SES_MSG_FULL_TRACE
             if (LOGDEBUG3) {
-                log_debug3("\nses_msg: setup send buff %d\n%s\n", 
-                           i,
-                           iovs[i].iov_base);
+                log_debug3("\nses_msg send 1.1 buff:%u\n",
+                           buff->bufflen - buff->buffpos);
+                trace_buff(buff);
             }
-#endif
-            cnt++;
         }
-    }
 
-    /* make sure there is at least one buffer set */
-    if (iovs[0].iov_base == NULL) {
-        return SET_ERROR(ERR_NCX_OPERATION_FAILED);
-    }
+        buffleft = buff->bufflen - buff->buffpos;
 
-    if (scb->framing11) {
-        /* send the 'cnt' number of buffs identified above
-         * do not use the iovs array because this function
-         * may not write the entire amount requested
-         * and that would not match the huge chunksize;
-         * so just send each buffer as a chunk
+        /* always send at least the first buffer,
+         * even if it is bigger than SES_MAX_BYTESEND
          */
-        for (i=0; i < cnt; i++) {
-            buff = (ses_msg_buff_t *)dlq_deque(&scb->outQ);
-            if (buff == NULL) {
-                return SET_ERROR(ERR_INTERNAL_VAL);
-            }
-            res = do_send_buff(scb, buff);
-            ses_msg_free_buff(scb, buff);            
-            if (res != NO_ERR) {
-                return res;
-            }
+        if (cnt > 0 && (total+buffleft) > SES_MAX_BYTESEND) {
+            break;
         }
-        return NO_ERR;
+
+        total += buffleft;
+        iovs[cnt].iov_base = &buff->buff[buff->buffpos];
+        iovs[cnt].iov_len = buffleft;
+        cnt++;
     }
 
-    /* else base:1.0 framing
-     * write a packet to the session socket 
-     */
+    /* make sure there is at least one buffer set */
+    if (cnt == 0) {
+        return SET_ERROR(ERR_NCX_OPERATION_FAILED);
+    }
+
+    /* write a packet to the session socket */
     retcnt = writev(scb->fd, iovs, cnt);
     if (retcnt < 0) {
-        /* should not need retries because the select loop
-         * indicated this session was ready for output
-         */
-        log_info("\nses msg write failed for session %d", scb->sid);
-        return errno_to_status();
+        if (errno == EINTR || errno == EAGAIN) {
+            /* nothing written; try again next loop */
+            retcnt = 0;
+        } else {
+            log_info("\nses msg write failed for session %d", scb->sid);
+            return errno_to_status();
+        }
     } else {
         if (LOGDEBUG2) {
-            log_debug2("\nses wrote %d of %d bytes on session %d\n", 
+            log_debug2("\nses wrote %d of %u bytes in %d buffers "
+                       "on session %d\n", 
                        retcnt, 
                        total, 
+                       cnt,
                        scb->sid);
         }
     }
 
-    /* clean up the buffers that were written */
-    buff = (ses_msg_buff_t *)dlq_firstEntry(&scb->outQ);
-
-    while (retcnt && buff) {
-        /* get the number of bytes written from this buffer */
+    /* clean up the buffers that were written; resume a
+     * partially written buffer from buffpos next time
+     */
+    for (i = 0; i < cnt; i++) {
+        buff = (ses_msg_buff_t *)dlq_firstEntry(&scb->outQ);
         buffleft = buff->bufflen - buff->buffpos;
 
-        /* free the buffer if all of it was written or just
-         * bump the buffer pointer if not
-         */
-        if ((uint32)retcnt >= buffleft) {
+        if ((size_t)retcnt >= buffleft) {
             dlq_remove(buff);
             ses_msg_free_buff(scb, buff);
             retcnt -= (ssize_t)buffleft;
-            buff = (ses_msg_buff_t *)dlq_firstEntry(&scb->outQ);            
         } else {
-            buff->buffpos += (uint32)retcnt;
-            retcnt = 0;
+            buff->buffpos += (size_t)retcnt;
+            break;
         }
     }
 
@@ -686,6 +752,14 @@ status_t ses_msg_new_output_buff (ses_cb_t *scb)
         dlq_enque(scb->outbuff, &scb->outQ);
         ses_msg_make_outready(scb);
         scb->outbuff = NULL;
+
+        /* the message does not fit in the buffers used so far,
+         * so use a bigger buffer for the rest of it
+         */
+        if (scb->outbuffsize < max_outbuffsize) {
+            scb->outbuffsize = max(scb->outbuffsize, SES_MSG_BUFFSIZE) * 2;
+            scb->outbuffsize = min(scb->outbuffsize, max_outbuffsize);
+        }
         res = ses_msg_new_buff(scb, TRUE, &scb->outbuff);
     }
     return res;
@@ -790,6 +864,9 @@ void ses_msg_finish_outmsg (ses_cb_t *scb)
         scb->outbuff->buffpos = scb->outbuff->buffstart;
         dlq_enque(scb->outbuff, &scb->outQ);
         scb->outbuff = NULL;
+
+        /* start the next message with a small buffer again */
+        scb->outbuffsize = SES_MSG_BUFFSIZE;
         (void)ses_msg_new_buff(scb, TRUE, &scb->outbuff);
 
         ses_msg_make_outready(scb);
@@ -902,9 +979,10 @@ void ses_msg_add_framing( ses_cb_t *scb, ses_msg_buff_t *buff )
     assert( scb && "scb == NULL" );
     assert( buff && "buff == NULL" );
 
-    if (!scb->framing11) {
+    if (!scb->framing11 || buff->framed) {
         return;
     }
+    buff->framed = TRUE;
 
     /* get the chunk size */
     char numbuff[SES_MAX_CHUNKNUM_SIZE];
@@ -955,6 +1033,7 @@ void
 
     buff->buffpos = 0;
     buff->islast = FALSE;
+    buff->framed = FALSE;
     if (outbuff && scb->framing11) {
         buff->buffstart = SES_STARTCHUNK_PAD;
     } else {
@@ -96,6 +96,22 @@ extern void
     ses_msg_cleanup (void);
 
 
+/********************************************************************
+* FUNCTION ses_msg_set_max_outbuff_size
+*
+* Set the max size an output buffer is allowed to grow to
+* Output buffers start at SES_MSG_BUFFSIZE for each message
+* and double in size each time one is filled
+*
+* INPUTS:
+*   maxsize == max output buffer size in bytes;
+*              will be adjusted to the range
+*              SES_MSG_BUFFSIZE .. SES_MSG_MAX_BUFFSIZE_LIMIT
+*********************************************************************/
+extern void
+    ses_msg_set_max_outbuff_size (uint32 maxsize);
+
+
 /********************************************************************
 * FUNCTION ses_msg_new_msg
 *
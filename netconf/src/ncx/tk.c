@@ -37,10 +37,16 @@ date         init     comment
 #include <memory.h>
 #include <ctype.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <xmlstring.h>
 
 #include  "procdefs.h"
+#include "bobhash.h"
 #include "dlq.h"
 #include "log.h"
 #include "ncx.h"
@@ -68,12 +74,60 @@ date         init     comment
 
 #define FL_ALL    (FL_YANG|FL_CONF|FL_XPATH|FL_REDO)
 
+/* token cache file header magic string (8 bytes) */
+#define TK_CACHE_MAGIC     "yumatkc"
+
+/* string offset used for a NULL mod or val field */
+#define TK_CACHE_NOSTR     0xffffffff
+
+/* size of the checked line map for N lines */
+#define TK_CACHE_LINEMAP_SIZE(N)  (((N) + 7) >> 3)
+
+/* init values for the 2 hashes of the source file contents */
+#define TK_CACHE_INIT1     0x5bd1e995
+#define TK_CACHE_INIT2     0x7feb352d
+
+/* init value for the hash of the cache file after the header */
+#define TK_CACHE_INIT3     0x68e31da4
+
 /********************************************************************
 *                                                                   *
 *                            T Y P E S                              *
 *                                                                   *
 *********************************************************************/
 
+/* token cache file header; all fields in host byte order
+ * followed by tkcount tk_cache_rec_t records, the string
+ * table of strsize bytes, and the map of the lines checked
+ * by ncx_check_warn_linelen: 1 bit per line, linecnt bits
+ */
+typedef struct tk_cache_hdr_t_ {
+    char            magic[8];
+    uint32          version;
+    uint32          recsize;
+    uint32          srclen;
+    uint32          srchash1;
+    uint32          srchash2;
+    uint32          maxlinelen;
+    uint32          linecnt;
+    uint32          tkcount;
+    uint32          strsize;
+    uint32          bodyhash;
+} tk_cache_hdr_t;
+
+/* token cache file record for 1 token;
+ * val is an offset into the string table; if modlen is
+ * non-zero the mod string is stored right before val
+ */
+typedef struct tk_cache_rec_t_ {
+    uint32          val;
+    uint32          len;
+    uint32          linenum;
+    uint16          linepos;
+    uint8           typ;
+    uint8           modlen;
+} tk_cache_rec_t;
+
 /* One quick entry token lookup */
 typedef struct tk_ent_t_ {
     tk_type_t       ttyp;
@@ -214,6 +268,290 @@ static tk_btyp_t blist [] = {
 
 
 
+/********************************************************************
+* FUNCTION arena_alloc
+* 
+* Allocate memory from the token chain arena
+* The memory is only freed by tk_free_chain
+*
+* INPUTS:
+*  tkc == token chain
+*  size == number of bytes needed
+*
+* RETURNS:
+*   pointer to the memory or NULL if malloc failed
+*********************************************************************/
+static void *
+    arena_alloc (tk_chain_t *tkc,
+                 size_t size)
+{
+    tk_arena_t  *arena;
+    void        *ret;
+    size_t       blocksize;
+
+    /* keep the memory aligned for tk_token_t structs */
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    arena = tkc->arena;
+    if (arena == NULL || arena->size - arena->used < size) {
+        blocksize = (size > TK_ARENA_BLOCK_SIZE / 4) 
+            ? size : TK_ARENA_BLOCK_SIZE;
+        arena = m__getMem(sizeof(tk_arena_t) + blocksize);
+        if (arena == NULL) {
+            return NULL;
+        }
+        arena->size = blocksize;
+        arena->used = 0;
+        if (tkc->arena != NULL && blocksize != TK_ARENA_BLOCK_SIZE) {
+            /* keep filling the current block after a big request */
+            arena->next = tkc->arena->next;
+            tkc->arena->next = arena;
+        } else {
+            arena->next = tkc->arena;
+            tkc->arena = arena;
+        }
+    }
+
+    ret = (xmlChar *)&arena[1] + arena->used;
+    arena->used += size;
+    return ret;
+
+}  /* arena_alloc */
+
+
+/********************************************************************
+* FUNCTION free_arena
+* 
+* Free all the token chain arena blocks
+*
+* INPUTS:
+*  tkc == token chain
+*********************************************************************/
+static void
+    free_arena (tk_chain_t *tkc)
+{
+    tk_arena_t  *arena;
+
+    while (tkc->arena) {
+        arena = tkc->arena;
+        tkc->arena = arena->next;
+        m__free(arena);
+    }
+
+}  /* free_arena */
+
+
+/********************************************************************
+* FUNCTION get_strbuff
+* 
+* Get a buffer for a token string
+* The arena is used if the chain is in arena mode
+*
+* INPUTS:
+*  tkc == token chain the token is for
+*  size == number of bytes needed
+*
+* RETURNS:
+*   pointer to the buffer or NULL if malloc failed
+*********************************************************************/
+static xmlChar *
+    get_strbuff (tk_chain_t *tkc,
+                 uint32 size)
+{
+    xmlChar  *buff;
+
+    if (TK_ARENA(tkc)) {
+        return (xmlChar *)arena_alloc(tkc, size);
+    }
+    buff = (xmlChar *)m__getMem(size);
+    return buff;
+
+}  /* get_strbuff */
+
+
+/********************************************************************
+* FUNCTION free_strbuff
+* 
+* Free a buffer from get_strbuff
+*
+* INPUTS:
+*  tkc == token chain the buffer was allocated for
+*  buff == buffer to free
+*********************************************************************/
+static void
+    free_strbuff (tk_chain_t *tkc,
+                  xmlChar *buff)
+{
+    if (!TK_ARENA(tkc)) {
+        m__free(buff);
+    }
+
+}  /* free_strbuff */
+
+
+/********************************************************************
+* FUNCTION dup_str
+* 
+* Copy a token string like xml_strndup
+* The arena is used if the chain is in arena mode
+*
+* INPUTS:
+*  tkc == token chain the token is for
+*  str == string to copy
+*  len == max number of chars to copy
+*
+* RETURNS:
+*   zero-terminated copy of the string or NULL if malloc failed
+*********************************************************************/
+static xmlChar *
+    dup_str (tk_chain_t *tkc,
+             const xmlChar *str,
+             uint32 len)
+{
+    xmlChar  *ret;
+    uint32    i;
+
+    if (!TK_ARENA(tkc)) {
+        return xml_strndup(str, len);
+    }
+
+    ret = (xmlChar *)arena_alloc(tkc, len + 1);
+    if (ret == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < len && str[i]; i++) {
+        ret[i] = str[i];
+    }
+    ret[i] = 0;
+    return ret;
+
+}  /* dup_str */
+
+
+/********************************************************************
+* FUNCTION read_input
+* 
+* Read the entire input file into the chain input buffer
+* The lines are handed to the tokenizer by read_line
+* without copying them
+*
+* INPUTS:
+*   tkc == token chain with the open input file
+*
+* RETURNS:
+*   TRUE if the file was read into tkc->inbuff
+*   FALSE if not; the file can still be read with fgets
+*********************************************************************/
+static boolean
+    read_input (tk_chain_t *tkc)
+{
+    struct stat  statbuf;
+    size_t       len;
+
+    if (fstat(fileno(tkc->fp), &statbuf) != 0 ||
+        !S_ISREG(statbuf.st_mode) ||
+        statbuf.st_size >= (off_t)NCX_MAX_STRLEN) {
+        return FALSE;
+    }
+
+    len = (size_t)statbuf.st_size;
+    tkc->inbuff = m__getMem(len + 1);
+    if (tkc->inbuff == NULL) {
+        return FALSE;
+    }
+
+    if (len && fread(tkc->inbuff, 1, len, tkc->fp) != len) {
+        m__free(tkc->inbuff);
+        tkc->inbuff = NULL;
+        rewind(tkc->fp);
+        return FALSE;
+    }
+
+    tkc->inend = tkc->inbuff + len;
+    *tkc->inend = 0;
+    tkc->innext = tkc->inbuff;
+    tkc->insave = *tkc->innext;
+    return TRUE;
+
+}  /* read_input */
+
+
+/********************************************************************
+* FUNCTION free_input
+* 
+* Free the chain input buffer, if any
+*
+* INPUTS:
+*   tkc == token chain
+*********************************************************************/
+static void
+    free_input (tk_chain_t *tkc)
+{
+    if (tkc->inbuff) {
+        m__free(tkc->inbuff);
+        tkc->inbuff = NULL;
+        tkc->inend = NULL;
+        tkc->innext = NULL;
+        tkc->insave = 0;
+
+        /* the line buffer was pointing into inbuff */
+        tkc->buff = NULL;
+        tkc->bptr = NULL;
+    }
+
+}  /* free_input */
+
+
+/********************************************************************
+* FUNCTION read_line
+* 
+* Get the next input line in tkc->buff, the same way as
+* fgets(tkc->buff, TK_BUFF_SIZE, tkc->fp)
+*
+* If the file is in the input buffer, tkc->buff is set to the
+* line in the buffer, and the char after the line is replaced
+* by a zero until the next line is read
+*
+* INPUTS:
+*   tkc == token chain 
+*
+* RETURNS:
+*   TRUE if a line was read; FALSE if EOF
+*********************************************************************/
+static boolean
+    read_line (tk_chain_t *tkc)
+{
+    xmlChar  *str, *end;
+    size_t    len;
+
+    if (tkc->inbuff == NULL) {
+        return (fgets((char *)tkc->buff, TK_BUFF_SIZE, tkc->fp)) 
+            ? TRUE : FALSE;
+    }
+
+    /* put back the char replaced at the end of the last line */
+    str = tkc->innext;
+    *str = tkc->insave;
+    if (str == tkc->inend) {
+        return FALSE;
+    }
+
+    len = (size_t)(tkc->inend - str);
+    if (len > TK_BUFF_SIZE - 1) {
+        len = TK_BUFF_SIZE - 1;
+    }
+    end = (xmlChar *)memchr(str, '\n', len);
+    end = (end) ? end + 1 : str + len;
+
+    tkc->buff = str;
+    tkc->innext = end;
+    tkc->insave = *end;
+    *end = 0;
+    return TRUE;
+
+}  /* read_line */
+
+
 /********************************************************************
 * FUNCTION new_origstr
 * 
@@ -326,6 +664,7 @@ static void
 * Allocatate a new token with a value string that will be copied
 *
 * INPUTS:
+*  tkc == token chain the token is for
 *  ttyp == token type
 *  tval == token value or NULL if not used
 *  tlen == token value length if used; Ignored if tval == NULL
@@ -334,23 +673,31 @@ static void
 *   new token or NULL if some error
 *********************************************************************/
 static tk_token_t *
-    new_token (tk_type_t ttyp, 
+    new_token (tk_chain_t *tkc,
+               tk_type_t ttyp, 
                const xmlChar *tval,
                uint32  tlen)
 {
     tk_token_t  *tk;
 
-    tk = m__getObj(tk_token_t);
+    if (TK_ARENA(tkc)) {
+        tk = (tk_token_t *)arena_alloc(tkc, sizeof(tk_token_t));
+    } else {
+        tk = m__getObj(tk_token_t);
+    }
     if (!tk) {
         return NULL;
     }
     memset(tk, 0x0, sizeof(tk_token_t));
     tk->typ = ttyp;
+    tk->chainmem = TK_ARENA(tkc) ? TRUE : FALSE;
     if (tval) {
         tk->len = tlen;
-        tk->val = xml_strndup(tval, tlen);
+        tk->val = dup_str(tkc, tval, tlen);
         if (!tk->val) {
-            m__free(tk);
+            if (!tk->chainmem) {
+                m__free(tk);
+            }
             return NULL;
         }
     }
@@ -381,24 +728,31 @@ static tk_token_t *
 * consumed and freed later, and not copied 
 *
 * INPUTS:
+*  tkc == token chain the token is for
 *  ttyp == token type
-*  tval == token value or NULL if not used
+*  tval == token value from get_strbuff or NULL if not used
 *
 * RETURNS:
 *   new token or NULL if some error
 *********************************************************************/
 static tk_token_t *
-    new_mtoken (tk_type_t ttyp, 
-               xmlChar *tval)
+    new_mtoken (tk_chain_t *tkc,
+                tk_type_t ttyp, 
+                xmlChar *tval)
 {
     tk_token_t  *tk;
 
-    tk = m__getObj(tk_token_t);
+    if (TK_ARENA(tkc)) {
+        tk = (tk_token_t *)arena_alloc(tkc, sizeof(tk_token_t));
+    } else {
+        tk = m__getObj(tk_token_t);
+    }
     if (!tk) {
         return NULL;
     }
     memset(tk, 0x0, sizeof(tk_token_t));
     tk->typ = ttyp;
+    tk->chainmem = TK_ARENA(tkc) ? TRUE : FALSE;
     if (tval) {
         tk->len = xml_strlen(tval);
         tk->val = tval;
@@ -445,6 +799,11 @@ static void
     }
 #endif
 
+    if (tk->chainmem) {
+        /* token and strings are freed with the chain memory */
+        return;
+    }
+
     if (tk->mod) {
         m__free(tk->mod);
     }
@@ -473,6 +832,7 @@ static void
 *         is a prefix name in YANG
 *
 * INPUTS:
+*  tkc == token chain the token is for
 *  ttyp == token type
 *  mod == module name string, not z-terminated
 *  modlen == 'mod' string length
@@ -483,18 +843,19 @@ static void
 *   new token or NULL if some error
 *********************************************************************/
 static tk_token_t *
-    new_token_wmod (tk_type_t ttyp, 
-                       const xmlChar *mod,
-                       uint32 modlen,
-                       const xmlChar *tval, 
-                       uint32 tlen)
+    new_token_wmod (tk_chain_t *tkc,
+                    tk_type_t ttyp, 
+                    const xmlChar *mod,
+                    uint32 modlen,
+                    const xmlChar *tval, 
+                    uint32 tlen)
 {
     tk_token_t  *ret;
 
-    ret = new_token(ttyp, tval, tlen);
+    ret = new_token(tkc, ttyp, tval, tlen);
     if (ret) {
         ret->modlen = modlen;
-        ret->mod = xml_strndup(mod, modlen);
+        ret->mod = dup_str(tkc, mod, modlen);
         if (!ret->mod) {
             free_token(ret);
             return NULL;
@@ -552,10 +913,10 @@ static status_t
         return ERR_NCX_LEN_EXCEEDED;
     } else if (total == 0) {
         /* zero length value strings are allowed */
-        tk = new_token(ttyp, NULL, 0);
+        tk = new_token(tkc, ttyp, NULL, 0);
     } else {
         /* normal case string -- non-zero length */
-        tk = new_token(ttyp, tkc->bptr, total);
+        tk = new_token(tkc, ttyp, tkc->bptr, total);
     }
     if (!tk) {
         return ERR_INTERNAL_MEM;
@@ -906,15 +1267,15 @@ static status_t
 
     if (total == 0) {
         /* zero length value strings are allowed */
-        tk = (isdouble) ? new_token( TK_TT_QSTRING,  NULL, 0) 
-                        : new_token( TK_TT_SQSTRING, NULL, 0);
+        tk = (isdouble) ? new_token(tkc, TK_TT_QSTRING,  NULL, 0) 
+                        : new_token(tkc, TK_TT_SQSTRING, NULL, 0);
     } else if (!isdouble) {
         /* single quote string */
-        tk = new_token( TK_TT_SQSTRING, tkbuff, total );
+        tk = new_token(tkc, TK_TT_SQSTRING, tkbuff, total );
     } else {
         /* double quote normal case -- non-zero length QSTRING fill the buffer, 
          * while converting escaped chars */
-        xmlChar *buff = (xmlChar *)m__getMem(total+1);
+        xmlChar *buff = get_strbuff(tkc, total+1);
         if (!buff) {
             return ERR_INTERNAL_MEM;
         }
@@ -932,9 +1293,9 @@ static status_t
             }
         }
 
-        tk = new_mtoken(TK_TT_QSTRING, buff);
+        tk = new_mtoken(tkc, TK_TT_QSTRING, buff);
         if ( !tk ) {
-            m__free(buff);
+            free_strbuff(tkc, buff);
             m__free(origbuff);
         }
     }
@@ -1143,7 +1504,7 @@ static status_t
     /* keep saving lines in tempbuff until the QSTRING_CH is found */
     done = FALSE;
     while (!done) {
-        if (!fgets((char *)tkc->buff, TK_BUFF_SIZE, tkc->fp)) {
+        if (!read_line(tkc)) {
             /* read line failed -- assume EOF */
             m__free(tempbuff);
             return ERR_NCX_UNENDED_QSTRING;
@@ -1279,7 +1640,7 @@ static status_t
     /* keep saving lines in tempbuff until the QSTRING_CH is found */
     done = FALSE;
     while (!done) {
-        if (!fgets((char *)tkc->buff, TK_BUFF_SIZE, tkc->fp)) {
+        if (!read_line(tkc)) {
             /* read line failed -- assume EOF */
             m__free(tempbuff);
             return ERR_NCX_UNENDED_QSTRING;
@@ -1386,7 +1747,7 @@ static status_t
      */
     done = FALSE;
     while (!done) {
-        if (!fgets((char *)tkc->buff, TK_BUFF_SIZE, tkc->fp)) {
+        if (!read_line(tkc)) {
             /* read line failed -- assume EOF */
             return ERR_NCX_UNENDED_COMMENT;
         } else {
@@ -1696,14 +2057,15 @@ static status_t
 
     if (prefix) {
         /* XPath $prefix:identifier */
-        tk = new_token_wmod(TK_TT_QVARBIND,
+        tk = new_token_wmod(tkc,
+                            TK_TT_QVARBIND,
                             prefix, 
                             prelen, 
                             item, 
                             (uint32)(str - item));
     } else {
         /* XPath $identifier */
-        tk = new_token(TK_TT_VARBIND,  tkc->bptr+1, len);
+        tk = new_token(tkc, TK_TT_VARBIND,  tkc->bptr+1, len);
     }
 
     if (!tk) {
@@ -1846,7 +2208,8 @@ static status_t
             if ((str - item) > NCX_MAX_Q_STRLEN) {
                 return ERR_NCX_LEN_EXCEEDED;
             }
-            tk = new_token_wmod(scoped ? TK_TT_MSSTRING : TK_TT_MSTRING,
+            tk = new_token_wmod(tkc,
+                                scoped ? TK_TT_MSSTRING : TK_TT_MSTRING,
                                 prefix, 
                                 prelen, 
                                 item, 
@@ -1855,17 +2218,19 @@ static status_t
             if ((str - tkc->bptr) > NCX_MAX_Q_STRLEN) {
                 return ERR_NCX_LEN_EXCEEDED;
             }
-            tk = new_token(scoped ? TK_TT_SSTRING : TK_TT_TSTRING,
+            tk = new_token(tkc,
+                           scoped ? TK_TT_SSTRING : TK_TT_TSTRING,
                            tkc->bptr, 
                            (uint32)(str - tkc->bptr));
         }
     } else if (prefix) {
         if (namestar) {
             /* XPath 'prefix:*'  */
-            tk = new_token(TK_TT_NCNAME_STAR,  prefix, prelen);
+            tk = new_token(tkc, TK_TT_NCNAME_STAR,  prefix, prelen);
         } else {
             /* XPath prefix:identifier */
-            tk = new_token_wmod(TK_TT_MSTRING,
+            tk = new_token_wmod(tkc,
+                                TK_TT_MSTRING,
                                 prefix, 
                                 prelen, 
                                 item, 
@@ -1873,7 +2238,8 @@ static status_t
         }
     } else {
         /* XPath identifier */
-        tk = new_token(TK_TT_TSTRING,  
+        tk = new_token(tkc,
+                       TK_TT_TSTRING,
                        tkc->bptr, 
                        (uint32)(str - tkc->bptr));
     }
@@ -2012,7 +2378,7 @@ static status_t
             /* else fixup the consecutive strings
              * get a buffer to store the result
              */
-            buff = (xmlChar *)m__getMem(bufflen+1);
+            buff = get_strbuff(tkc, bufflen+1);
             if (!buff) {
                 tkc->cur = first;
                 return ERR_INTERNAL_MEM;
@@ -2058,7 +2424,7 @@ static status_t
                                               usestr);
                         if (origstr == NULL) {
                             tkc->cur = first;
-                            m__free(buff);
+                            free_strbuff(tkc, buff);
                             return ERR_INTERNAL_MEM;
                         }
 
@@ -2094,7 +2460,9 @@ static status_t
                  * like an SQSTRING; just toss it as origval copy is
                  * already set before the conversion was done
                  */
-                m__free(first->val);
+                if (!first->chainmem) {
+                    m__free(first->val);
+                }
             }
             first->val = buff;
         
@@ -2122,6 +2490,446 @@ static status_t
 }  /* concat_qstrings */
 
 
+/********************************************************************
+* FUNCTION scan_source
+* 
+* Get the cache key and line info for the source file contents
+* The lines are measured the same way as ncx_check_warn_linelen
+*
+* INPUTS:
+*   buff == zero-terminated source file contents
+*   hdr == cache header with the srclen field set
+*
+* OUTPUTS:
+*   hdr->srchash1, srchash2, maxlinelen and linecnt are set
+*
+* RETURNS:
+*   TRUE if the source can be cached
+*   FALSE if it has a zero byte or a line that does not fit
+*   in the tokenizer line buffer
+*********************************************************************/
+static boolean
+    scan_source (const xmlChar *buff,
+                 tk_cache_hdr_t *hdr)
+{
+    const xmlChar  *str, *linestart;
+    uint32          len;
+
+    hdr->maxlinelen = 0;
+    hdr->linecnt = 0;
+
+    str = buff;
+    while (*str) {
+        linestart = str;
+        len = 0;
+        while (*str && *str != '\n') {
+            len += (*str == '\t') ? 8 : 1;
+            str++;
+        }
+        if (*str) {
+            str++;
+        }
+        if ((uint32)(str - linestart) >= TK_BUFF_SIZE - 1) {
+            return FALSE;
+        }
+        if (len > hdr->maxlinelen) {
+            hdr->maxlinelen = len;
+        }
+        hdr->linecnt++;
+    }
+
+    if ((uint32)(str - buff) != hdr->srclen) {
+        return FALSE;
+    }
+
+    hdr->srchash1 = (uint32)bobhash(buff, hdr->srclen, TK_CACHE_INIT1);
+    hdr->srchash2 = (uint32)bobhash(buff, hdr->srclen, TK_CACHE_INIT2);
+    return TRUE;
+
+}  /* scan_source */
+
+
+/********************************************************************
+* FUNCTION make_cache_filespec
+* 
+* Get the token cache file name for a source file
+*
+* INPUTS:
+*   cachedir == token cache directory
+*   hdr == cache header with the source fields set
+*
+* RETURNS:
+*   malloced filespec or NULL if malloc failed
+*********************************************************************/
+static xmlChar *
+    make_cache_filespec (const xmlChar *cachedir,
+                         const tk_cache_hdr_t *hdr)
+{
+    xmlChar  *filespec;
+    uint32    len;
+
+    len = xml_strlen(cachedir);
+    filespec = m__getMem(len + 40);
+    if (filespec == NULL) {
+        return NULL;
+    }
+    sprintf((char *)filespec, "%s%s%08x%08x-%u.tkc",
+            (const char *)cachedir,
+            (len && cachedir[len-1] == '/') ? "" : "/",
+            hdr->srchash1,
+            hdr->srchash2,
+            hdr->srclen);
+    return filespec;
+
+}  /* make_cache_filespec */
+
+
+/********************************************************************
+* FUNCTION check_cache_str
+* 
+* Check a string table offset in a token cache record
+*
+* INPUTS:
+*   strtab == cache string table
+*   strsize == size of the string table
+*   offset == string offset to check
+*   len == string length
+*
+* RETURNS:
+*   TRUE if the string is a valid zero-terminated string
+*********************************************************************/
+static boolean
+    check_cache_str (const xmlChar *strtab,
+                     uint32 strsize,
+                     uint32 offset,
+                     uint32 len)
+{
+    if (offset == TK_CACHE_NOSTR) {
+        return TRUE;
+    }
+    if (offset >= strsize || len >= strsize - offset) {
+        return FALSE;
+    }
+    if (strtab[offset + len] != 0 ||
+        xml_strlen(&strtab[offset]) != len) {
+        return FALSE;
+    }
+    return TRUE;
+
+}  /* check_cache_str */
+
+
+/********************************************************************
+* FUNCTION load_cache
+* 
+* Load the token chain from a token cache file
+* The file is mapped and the token strings point into the
+* mapped file; all tokens are allocated in 1 arena block
+*
+* INPUTS:
+*   tkc == token chain to fill in
+*   filespec == token cache file to load
+*   srchdr == cache header with the source fields set
+*
+* RETURNS:
+*   NO_ERR if the tokens were loaded
+*   ERR_NCX_SKIPPED if the cache file is missing or not valid
+*   ERR_INTERNAL_MEM if malloc failed
+*********************************************************************/
+static status_t
+    load_cache (tk_chain_t *tkc,
+                const xmlChar *filespec,
+                const tk_cache_hdr_t *srchdr)
+{
+    struct stat           statbuf;
+    const tk_cache_hdr_t *hdr;
+    const tk_cache_rec_t *rec;
+    xmlChar              *strtab;
+    tk_token_t           *tkblock, *tk;
+    void                 *map;
+    size_t                maplen;
+    uint32                i;
+    int                   fd;
+
+    fd = open((const char *)filespec, O_RDONLY);
+    if (fd < 0) {
+        return ERR_NCX_SKIPPED;
+    }
+    if (fstat(fd, &statbuf) != 0 ||
+        statbuf.st_size < (off_t)sizeof(tk_cache_hdr_t)) {
+        close(fd);
+        return ERR_NCX_SKIPPED;
+    }
+
+    /* the mapping is private so the token strings can be
+     * changed by the parser without touching the file
+     */
+    maplen = (size_t)statbuf.st_size;
+    map = mmap(NULL, maplen, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return ERR_NCX_SKIPPED;
+    }
+
+    hdr = (const tk_cache_hdr_t *)map;
+    if (memcmp(hdr->magic, TK_CACHE_MAGIC, sizeof(hdr->magic)) ||
+        hdr->version != TK_CACHE_VERSION ||
+        hdr->recsize != sizeof(tk_cache_rec_t) ||
+        hdr->srclen != srchdr->srclen ||
+        hdr->srchash1 != srchdr->srchash1 ||
+        hdr->srchash2 != srchdr->srchash2 ||
+        hdr->maxlinelen != srchdr->maxlinelen ||
+        hdr->linecnt != srchdr->linecnt ||
+        hdr->tkcount == 0 ||
+        hdr->tkcount > (maplen - sizeof(tk_cache_hdr_t)) / 
+        sizeof(tk_cache_rec_t) ||
+        maplen != sizeof(tk_cache_hdr_t) + 
+        (size_t)hdr->tkcount * sizeof(tk_cache_rec_t) + hdr->strsize +
+        TK_CACHE_LINEMAP_SIZE(hdr->linecnt) ||
+        hdr->bodyhash != (uint32)bobhash((const ub1 *)&hdr[1], 
+                                         (ub4)(maplen - sizeof(*hdr)),
+                                         TK_CACHE_INIT3)) {
+        log_debug("\ntk: ignoring invalid token cache file '%s'", 
+                  filespec);
+        (void)munmap(map, maplen);
+        return ERR_NCX_SKIPPED;
+    }
+
+    rec = (const tk_cache_rec_t *)&hdr[1];
+    strtab = (xmlChar *)&rec[hdr->tkcount];
+
+    /* check all the records before any token is queued */
+    for (i = 0; i < hdr->tkcount; i++) {
+        if (rec[i].typ == TK_TT_NONE || rec[i].typ >= TK_TT_NEWLINE ||
+            (rec[i].modlen && 
+             (rec[i].val == TK_CACHE_NOSTR ||
+              rec[i].val < (uint32)rec[i].modlen + 1 ||
+              !check_cache_str(strtab, hdr->strsize, 
+                               rec[i].val - rec[i].modlen - 1, 
+                               rec[i].modlen))) ||
+            !check_cache_str(strtab, hdr->strsize, 
+                             rec[i].val, rec[i].len)) {
+            log_debug("\ntk: ignoring invalid token cache file '%s'", 
+                      filespec);
+            (void)munmap(map, maplen);
+            return ERR_NCX_SKIPPED;
+        }
+    }
+
+    tkblock = (tk_token_t *)
+        arena_alloc(tkc, hdr->tkcount * sizeof(tk_token_t));
+    if (tkblock == NULL) {
+        (void)munmap(map, maplen);
+        return ERR_INTERNAL_MEM;
+    }
+    memset(tkblock, 0x0, hdr->tkcount * sizeof(tk_token_t));
+
+    for (i = 0; i < hdr->tkcount; i++) {
+        tk = &tkblock[i];
+        tk->typ = (tk_type_t)rec[i].typ;
+        if (rec[i].modlen) {
+            tk->mod = &strtab[rec[i].val - rec[i].modlen - 1];
+            tk->modlen = rec[i].modlen;
+        }
+        if (rec[i].val != TK_CACHE_NOSTR) {
+            tk->val = &strtab[rec[i].val];
+            tk->len = rec[i].len;
+        }
+        tk->linenum = rec[i].linenum;
+        tk->linepos = rec[i].linepos;
+        tk->chainmem = TRUE;
+        dlq_createSQue(&tk->origstrQ);
+        dlq_enque(tk, &tkc->tkQ);
+    }
+
+    tkc->tkmap = map;
+    tkc->tkmaplen = maplen;
+    tkc->linenum = hdr->linecnt;
+    tkc->linepos = 1;
+    tkc->cur = (tk_token_t *)&tkc->tkQ;
+    return NO_ERR;
+
+}  /* load_cache */
+
+
+/********************************************************************
+* FUNCTION save_cache
+* 
+* Save the tokenized chain in a token cache file
+* The file is written to a temp file and then renamed
+* Errors are ignored; the cache entry is just not saved
+*
+* INPUTS:
+*   tkc == token chain after tk_tokenize_input
+*   filespec == token cache file to write
+*   srchdr == cache header with the source fields set
+*********************************************************************/
+static void
+    save_cache (const tk_chain_t *tkc,
+                const xmlChar *filespec,
+                const tk_cache_hdr_t *srchdr)
+{
+    tk_cache_hdr_t     hdr;
+    tk_cache_rec_t    *rec;
+    const tk_token_t  *tk;
+    xmlChar           *body, *strtab, *tempfile;
+    FILE              *fp;
+    size_t             bodylen;
+    uint32             offset;
+    boolean            ok;
+
+    /* size the string table; skip chains that cannot be
+     * restored exactly from the saved fields; origval is
+     * only used in DOCMODE so the copy left by concat_qstrings
+     * is not saved
+     */
+    hdr = *srchdr;
+    hdr.tkcount = 0;
+    hdr.strsize = 0;
+    for (tk = (const tk_token_t *)dlq_firstEntry(&tkc->tkQ);
+         tk != NULL;
+         tk = (const tk_token_t *)dlq_nextEntry(tk)) {
+        if (!dlq_empty(&tk->origstrQ) ||
+            tk->linepos > 0xffff || (uint32)tk->typ > 0xff ||
+            (tk->mod && (tk->val == NULL || tk->modlen == 0 ||
+                         tk->modlen > 0xff ||
+                         xml_strlen(tk->mod) != tk->modlen)) ||
+            (tk->val && xml_strlen(tk->val) != tk->len)) {
+            return;
+        }
+        if (tk->mod) {
+            hdr.strsize += tk->modlen + 1;
+        }
+        if (tk->val) {
+            hdr.strsize += tk->len + 1;
+        }
+        hdr.tkcount++;
+    }
+    if (hdr.tkcount == 0 || tkc->linemap == NULL || 
+        tkc->linemapcnt != hdr.linecnt || tkc->linenum != hdr.linecnt) {
+        return;
+    }
+
+    memcpy(hdr.magic, TK_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TK_CACHE_VERSION;
+    hdr.recsize = sizeof(tk_cache_rec_t);
+
+    /* build the records, string table and line map in 1 buffer */
+    bodylen = hdr.tkcount * sizeof(tk_cache_rec_t) + hdr.strsize +
+        TK_CACHE_LINEMAP_SIZE(hdr.linecnt);
+    body = m__getMem(bodylen);
+    if (body == NULL) {
+        return;
+    }
+    rec = (tk_cache_rec_t *)body;
+    strtab = (xmlChar *)&rec[hdr.tkcount];
+
+    offset = 0;
+    for (tk = (const tk_token_t *)dlq_firstEntry(&tkc->tkQ);
+         tk != NULL;
+         tk = (const tk_token_t *)dlq_nextEntry(tk), rec++) {
+        rec->typ = (uint8)tk->typ;
+        rec->linenum = tk->linenum;
+        rec->linepos = (uint16)tk->linepos;
+        rec->modlen = 0;
+        rec->val = TK_CACHE_NOSTR;
+        rec->len = 0;
+        if (tk->mod) {
+            rec->modlen = (uint8)tk->modlen;
+            memcpy(&strtab[offset], tk->mod, tk->modlen + 1);
+            offset += tk->modlen + 1;
+        }
+        if (tk->val) {
+            rec->val = offset;
+            rec->len = tk->len;
+            memcpy(&strtab[offset], tk->val, tk->len + 1);
+            offset += tk->len + 1;
+        }
+    }
+    memcpy(&strtab[offset], tkc->linemap, 
+           TK_CACHE_LINEMAP_SIZE(hdr.linecnt));
+    hdr.bodyhash = (uint32)bobhash(body, (uint32)bodylen, TK_CACHE_INIT3);
+
+    tempfile = m__getMem(xml_strlen(filespec) + 16);
+    if (tempfile == NULL) {
+        m__free(body);
+        return;
+    }
+    sprintf((char *)tempfile, "%s.%u", 
+            (const char *)filespec, 
+            (uint32)getpid());
+
+    fp = fopen((const char *)tempfile, "w");
+    if (fp == NULL) {
+        log_debug("\ntk: cannot write token cache file '%s'", tempfile);
+        m__free(tempfile);
+        m__free(body);
+        return;
+    }
+
+    ok = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+          fwrite(body, bodylen, 1, fp) == 1) ? TRUE : FALSE;
+
+    if (fclose(fp) != 0 || !ok ||
+        rename((const char *)tempfile, (const char *)filespec) != 0) {
+        log_debug("\ntk: cannot write token cache file '%s'", filespec);
+        (void)unlink((const char *)tempfile);
+    }
+    m__free(tempfile);
+    m__free(body);
+
+}  /* save_cache */
+
+
+/********************************************************************
+* FUNCTION replay_linelen_warnings
+* 
+* Print the line length warnings that tk_tokenize_input
+* would print for the source file contents
+* Only the lines read outside of multi-line strings and
+* comments were checked; these are saved in the line map
+*
+* INPUTS:
+*   tkc == token chain loaded from the cache
+*   mod == module in progress (NULL if not used)
+*   buff == zero-terminated source file contents
+*********************************************************************/
+static void
+    replay_linelen_warnings (tk_chain_t *tkc,
+                             ncx_module_t *mod,
+                             const xmlChar *buff)
+{
+    const tk_cache_hdr_t *hdr;
+    const uint8          *linemap;
+    const xmlChar        *str;
+    uint32                linenum, i;
+
+    hdr = (const tk_cache_hdr_t *)tkc->tkmap;
+    linemap = (const uint8 *)tkc->tkmap + tkc->tkmaplen - 
+        TK_CACHE_LINEMAP_SIZE(hdr->linecnt);
+
+    linenum = tkc->linenum;
+    str = buff;
+    for (i = 0; *str && i < hdr->linecnt; i++) {
+        /* an empty line is never too long */
+        if ((linemap[i >> 3] & (1 << (i & 7))) && *str != '\n') {
+            tkc->linenum = i + 1;
+            tkc->linepos = 1;
+            ncx_check_warn_linelen(tkc, mod, str);
+        }
+        while (*str && *str != '\n') {
+            str++;
+        }
+        if (*str) {
+            str++;
+        }
+    }
+    tkc->linenum = linenum;
+    tkc->linepos = 1;
+
+}  /* replay_linelen_warnings */
+
+
 /**************    E X T E R N A L   F U N C T I O N S **********/
 
 
@@ -2295,9 +3103,15 @@ void
         tkptr = (tk_token_ptr_t *)dlq_deque(&tkc->tkptrQ);
         free_token_ptr(tkptr);
     }
-    if ((tkc->flags & TK_FL_MALLOC) && tkc->buff) {
+    if (tkc->inbuff) {
+        free_input(tkc);
+    } else if ((tkc->flags & TK_FL_MALLOC) && tkc->buff) {
         m__free(tkc->buff);
     }
+    free_arena(tkc);
+    if (tkc->tkmap) {
+        (void)munmap(tkc->tkmap, tkc->tkmaplen);
+    }
     m__free(tkc);
     
 } /* tk_free_chain */
@@ -2695,13 +3509,28 @@ status_t
 
     /* check if a temp buffer is needed */
     if (tkc->flags & TK_FL_MALLOC) {
-        tkc->buff = m__getMem(TK_BUFF_SIZE);
-        if (!tkc->buff) {
-            res = ERR_INTERNAL_MEM;
-            ncx_print_errormsg(tkc, mod, res);
-            return res;
-        } else {
-            memset(tkc->buff, 0x0, TK_BUFF_SIZE);
+        /* try to read the whole file so the lines
+         * do not have to be copied into the temp buffer
+         */
+        if (tkc->inbuff == NULL && tkc->fp != NULL) {
+            (void)read_input(tkc);
+        }
+        if (tkc->inbuff == NULL) {
+            tkc->buff = m__getMem(TK_BUFF_SIZE);
+            if (!tkc->buff) {
+                res = ERR_INTERNAL_MEM;
+                ncx_print_errormsg(tkc, mod, res);
+                return res;
+            } else {
+                memset(tkc->buff, 0x0, TK_BUFF_SIZE);
+            }
+        }
+
+        /* the YANG file tokens are freed all at once with
+         * the chain so they are allocated from the arena
+         */
+        if (tkc->source == TK_SOURCE_YANG && !TK_DOCMODE(tkc)) {
+            tkc->flags |= TK_FL_ARENA;
         }
     } else if (tkc->buff == NULL) {
         /* tkc->buff expected to be setup already */
@@ -2721,7 +3550,7 @@ status_t
          * or already have the buffer if parsing from memory
          */
         if (tkc->filename) {
-            if (!fgets((char *)tkc->buff, TK_BUFF_SIZE, tkc->fp)) {
+            if (!read_line(tkc)) {
                 /* read line failed, treating as not an error */
                 res = NO_ERR;
                 done = TRUE;
@@ -2729,7 +3558,7 @@ status_t
             } else {
                 /* save newline token for conf file only */
                 if (tkc->source == TK_SOURCE_CONF) {
-                    tk = new_token(TK_TT_NEWLINE, NULL, 0);
+                    tk = new_token(tkc, TK_TT_NEWLINE, NULL, 0);
                     if (!tk) {
                         res = ERR_INTERNAL_MEM;
                         done = TRUE;
@@ -2757,6 +3586,10 @@ status_t
             }
 #endif
             ncx_check_warn_linelen(tkc, mod, tkc->buff);
+            if (tkc->linemap && tkc->linenum <= tkc->linemapcnt) {
+                tkc->linemap[(tkc->linenum - 1) >> 3] |= 
+                    (uint8)(1 << ((tkc->linenum - 1) & 7));
+            }
         }
 
         /* Have some sort of input in the buffer (tkc->buff) */
@@ -2779,7 +3612,7 @@ status_t
             } else if (*tkc->bptr == '\n') {
                 /* save newline token for conf file only */
                 if (tkc->source == TK_SOURCE_CONF) {
-                    tk = new_token(TK_TT_NEWLINE, NULL, 0);
+                    tk = new_token(tkc, TK_TT_NEWLINE, NULL, 0);
                     if (!tk) {
                         res = ERR_INTERNAL_MEM;
                         done = TRUE;
@@ -2883,11 +3716,116 @@ status_t
         ncx_print_errormsg(tkc, mod, res);
     }
 
+    /* the token strings are copies, the input is not needed */
+    free_input(tkc);
+
     return res;
 
 }  /* tk_tokenize_input */
 
 
+/********************************************************************
+* FUNCTION tk_tokenize_cached_input
+* 
+* Parse the YANG input FILE into tk_token_t structs, using the
+* token cache in the specified directory
+*
+* The cache entry for a source file is keyed by the hash and
+* length of the file contents.  If it is found and valid, the
+* tokens are taken from the mapped cache file instead of
+* tokenizing the source.  Otherwise tk_tokenize_input is called
+* and the result is saved in the cache directory.
+*
+* The cache is not used for DOCMODE chains, since the original
+* strings are not saved in the cache file.
+*
+* Error messages are printed by this function!!
+* Do not duplicate error messages upon error return
+*
+* INPUTS:
+*   tkc == token chain setup with tk_setup_chain_yang
+*   mod == module in progress (NULL if not used)
+*          !!! Just used for error messages !!!
+*   cachedir == token cache directory
+*            == NULL to just call tk_tokenize_input
+*
+* RETURNS:
+*   status of the operation
+*********************************************************************/
+status_t 
+    tk_tokenize_cached_input (tk_chain_t *tkc,
+                              ncx_module_t *mod,
+                              const xmlChar *cachedir)
+{
+    tk_cache_hdr_t  hdr;
+    xmlChar        *filespec;
+    status_t        res;
+    uint32          warnlen;
+
+#ifdef DEBUG
+    if (!tkc) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    }
+#endif
+
+    if (cachedir == NULL || tkc->fp == NULL || 
+        tkc->source != TK_SOURCE_YANG || TK_DOCMODE(tkc)) {
+        return tk_tokenize_input(tkc, mod);
+    }
+
+    /* the input buffer is used by tk_tokenize_input if
+     * the tokens are not found in the cache
+     */
+    memset(&hdr, 0x0, sizeof(tk_cache_hdr_t));
+    if (tkc->inbuff == NULL && !read_input(tkc)) {
+        return tk_tokenize_input(tkc, mod);
+    }
+    hdr.srclen = (uint32)(tkc->inend - tkc->inbuff);
+    if (!scan_source(tkc->inbuff, &hdr)) {
+        return tk_tokenize_input(tkc, mod);
+    }
+
+    filespec = make_cache_filespec(cachedir, &hdr);
+    if (filespec == NULL) {
+        return tk_tokenize_input(tkc, mod);
+    }
+
+    res = load_cache(tkc, filespec, &hdr);
+    if (res == NO_ERR) {
+        log_debug3("\ntk: using token cache file '%s'", filespec);
+        warnlen = ncx_get_warn_linelen();
+        if (warnlen && hdr.maxlinelen > warnlen) {
+            replay_linelen_warnings(tkc, mod, tkc->inbuff);
+        }
+        free_input(tkc);
+    } else {
+        tkc->flags |= TK_FL_CACHEMISS;
+
+        /* record the lines checked for the line length warning */
+        tkc->linemapcnt = hdr.linecnt;
+        tkc->linemap = m__getMem(TK_CACHE_LINEMAP_SIZE(hdr.linecnt));
+        if (tkc->linemap) {
+            memset(tkc->linemap, 0x0, TK_CACHE_LINEMAP_SIZE(hdr.linecnt));
+        }
+
+        res = tk_tokenize_input(tkc, mod);
+        if (res == NO_ERR) {
+            save_cache(tkc, filespec, &hdr);
+        }
+
+        if (tkc->linemap) {
+            m__free(tkc->linemap);
+            tkc->linemap = NULL;
+        }
+        tkc->linemapcnt = 0;
+    }
+
+    m__free(filespec);
+    return res;
+
+}  /* tk_tokenize_cached_input */
+
+
 /********************************************************************
 * FUNCTION tk_retokenize_cur_string
 * 
@@ -3149,7 +4087,8 @@ tk_chain_t *
          oldtoken != NULL && res == NO_ERR;
          oldtoken = (tk_token_t *)dlq_nextEntry(oldtoken)) {
 
-        token = new_token(oldtoken->typ,
+        token = new_token(tkc,
+                          oldtoken->typ,
                           oldtoken->val,
                           oldtoken->len);
         if (!token) {
@@ -3158,8 +4097,9 @@ tk_chain_t *
         }
 
         if (oldtoken->mod) {
-            token->mod = xml_strndup(oldtoken->mod,
-                                     oldtoken->modlen);
+            token->mod = dup_str(tkc,
+                                 oldtoken->mod,
+                                 oldtoken->modlen);
             if (!token->mod) {
                 free_token(token);
                 tk_free_chain(tkc);
@@ -3205,10 +4145,11 @@ status_t
     tkc->linenum++;
 
     if ( !valstr ) {
-        tk = new_token(TK_TT_TSTRING, NULL, 0);
+        tk = new_token(tkc, TK_TT_TSTRING, NULL, 0);
     } else {
         /* normal case string -- non-zero length */
-        tk = new_token(TK_TT_TSTRING,
+        tk = new_token(tkc,
+                       TK_TT_TSTRING,
                        valstr, 
                        xml_strlen(valstr));
     }
@@ -3256,7 +4197,8 @@ status_t
     /* hack for YIN input, no XML line numbers */
     tkc->linenum++;
 
-    tk = new_token_wmod(TK_TT_MSTRING,
+    tk = new_token_wmod(tkc,
+                        TK_TT_MSTRING,
                         prefix, 
                         prefixlen, 
                         valstr,
@@ -3302,7 +4244,7 @@ status_t
     tkc->linenum++;
 
     if ( !valstr ) {
-        tk = new_token(TK_TT_QSTRING, NULL, 0);
+        tk = new_token(tkc, TK_TT_QSTRING, NULL, 0);
     } else {
         uint32 tklen = xml_strlen(valstr);
 
@@ -3315,7 +4257,7 @@ status_t
         }
 
         /* normal case string -- non-zero length */
-        tk = new_token(tktyp, valstr, tklen);
+        tk = new_token(tkc, tktyp, valstr, tklen);
     }
     if (!tk) {
         return ERR_INTERNAL_MEM;
@@ -3355,7 +4297,8 @@ status_t
     /* hack for YIN input, no XML line numbers */
     tkc->linenum++;
 
-    tk = new_token(TK_TT_LBRACE,
+    tk = new_token(tkc,
+                   TK_TT_LBRACE,
                    (const xmlChar *)"{",
                    1);
     if (!tk) {
@@ -3396,7 +4339,8 @@ status_t
     /* hack for YIN input, no XML line numbers */
     tkc->linenum++;
 
-    tk = new_token(TK_TT_RBRACE,
+    tk = new_token(tkc,
+                   TK_TT_RBRACE,
                    (const xmlChar *)"}",
                    1);
     if (!tk) {
@@ -3437,7 +4381,8 @@ status_t
     /* hack for YIN input, no XML line numbers */
     tkc->linenum++;
 
-    tk = new_token(TK_TT_SEMICOL,
+    tk = new_token(tkc,
+                   TK_TT_SEMICOL,
                    (const xmlChar *)";",
                    1);
     if (!tk) {
@@ -59,6 +59,12 @@ extern "C" {
 /* maximum line size allowed in an YANG module */
 #define TK_BUFF_SIZE                0xffff
 
+/* token cache file format version; change if tk_type_t changes */
+#define TK_CACHE_VERSION            1
+
+/* size of each block in the token chain arena */
+#define TK_ARENA_BLOCK_SIZE         0x10000
+
 
 /* macros for quick processing of token chains
  * All these macros take 1 parameter 
@@ -154,6 +160,12 @@ extern "C" {
 /* return non-zero if token preservation docmode */
 #define TK_DOCMODE(TKC)  ((TKC)->flags & TK_FL_DOCMODE)
 
+/* return non-zero if new tokens are allocated in the chain arena */
+#define TK_ARENA(TKC)  ((TKC)->flags & TK_FL_ARENA)
+
+/* return non-zero if the token cache was checked and missed */
+#define TK_CACHE_MISS(TKC)  ((TKC)->flags & TK_FL_CACHEMISS)
+
 #define TK_HAS_ORIGTK(TK) (((TK)->typ == TK_TT_QSTRING ||   \
                             (TK)->typ == TK_TT_SQSTRING) && \
                            (TK)->origval != NULL)
@@ -180,6 +192,18 @@ extern "C" {
  */
 #define TK_FL_DOCMODE     bit2
 
+/* == 1: new tokens and their strings are allocated from the
+ *       chain arena and are all freed in tk_free_chain
+ * == 0: each token and string is malloced separately
+ */
+#define TK_FL_ARENA       bit3
+
+/* == 1: the token cache was checked for this file but did
+ *       not have its tokens, so the file was tokenized
+ * == 0: the tokens came from the cache or it was not used
+ */
+#define TK_FL_CACHEMISS   bit4
+
 
 
 
@@ -287,6 +311,7 @@ typedef struct tk_token_t_ {
     uint32      linenum;
     uint32      linepos;
     xmlns_id_t  nsid;        /* only used for TK_TT_MSTRING tokens */
+    boolean     chainmem;    /* token is in the chain arena, not malloced */
     dlq_hdr_t   origstrQ;  /* Q of tk_origstr_t only used in DOCMODE */
 } tk_token_t;
 
@@ -301,6 +326,16 @@ typedef struct tk_token_ptr_t_ {
 } tk_token_ptr_t;
 
 
+/* one block of token chain arena memory;
+ * the memory for the block starts right after this header
+ */
+typedef struct tk_arena_t_ {
+    struct tk_arena_t_ *next;
+    size_t              size;
+    size_t              used;
+} tk_arena_t;
+
+
 /* token parsing chain */
 typedef struct tk_chain_t_ {
     dlq_hdr_t      qhdr;
@@ -316,6 +351,15 @@ typedef struct tk_chain_t_ {
     uint32         linepos;
     uint32         flags;
     tk_source_t    source;
+    tk_arena_t    *arena;           /* blocks for TK_FL_ARENA tokens */
+    xmlChar       *inbuff;       /* entire input file, if buffered */
+    xmlChar       *inend;                 /* end of inbuff contents */
+    xmlChar       *innext;                /* start of the next line */
+    xmlChar        insave;   /* char replaced by the end-of-line 0 */
+    void          *tkmap;     /* mapped cache file used by tokens */
+    size_t         tkmaplen;
+    uint8         *linemap;    /* bit set for each line checked with */
+    uint32         linemapcnt;  /* ncx_check_warn_linelen, if used */
 } tk_chain_t;
 
 
@@ -593,6 +637,40 @@ extern status_t
 		       ncx_module_t *mod);
 
 
+/********************************************************************
+* FUNCTION tk_tokenize_cached_input
+* 
+* Parse the YANG input FILE into tk_token_t structs, using the
+* token cache in the specified directory
+*
+* The cache entry for a source file is keyed by the hash and
+* length of the file contents.  If it is found and valid, the
+* tokens are taken from the mapped cache file instead of
+* tokenizing the source.  Otherwise tk_tokenize_input is called
+* and the result is saved in the cache directory.
+*
+* The cache is not used for DOCMODE chains, since the original
+* strings are not saved in the cache file.
+*
+* Error messages are printed by this function!!
+* Do not duplicate error messages upon error return
+*
+* INPUTS:
+*   tkc == token chain setup with tk_setup_chain_yang
+*   mod == module in progress (NULL if not used)
+*          !!! Just used for error messages !!!
+*   cachedir == token cache directory
+*            == NULL to just call tk_tokenize_input
+*
+* RETURNS:
+*   status of the operation
+*********************************************************************/
+extern status_t 
+    tk_tokenize_cached_input (tk_chain_t *tkc,
+                              ncx_module_t *mod,
+                              const xmlChar *cachedir);
+
+
 /********************************************************************
 * FUNCTION tk_retokenize_cur_string
 * 
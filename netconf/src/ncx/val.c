@@ -46,6 +46,7 @@ date         init     comment
 
 #include "procdefs.h"
 #include "b64.h"
+#include "bobhash.h"
 #include "cfg.h"
 #include "dlq.h"
 #include "getcb.h"
@@ -82,6 +83,19 @@ date         init     comment
 /* #define VAL_EDITVARS_DEBUG */
 /* #define VAL_FREE_DEBUG 1 */
 
+/* initial hash table sizes for the child node index;
+ * must be a power of 2
+ */
+#define VAL_CHILDIDX_NAME_SIZE   16
+#define VAL_CHILDIDX_KEY_SIZE    64
+
+/* a parent node gets a child node index after a linear search
+ * of its childQ has to step over this many sibling nodes
+ */
+#define VAL_CHILDIDX_THRESHOLD   32
+
+#define VAL_CHILDIDX_HASH_INIT   0x5d2c7e1b
+
 /********************************************************************
 *                                                                   *
 *                          T Y P E S                                *
@@ -95,17 +109,66 @@ typedef struct finderparms_t_ {
     int64         foundpos;
 } finderparms_t;
 
+/* one list entry in a val_keyidx_t hash chain */
+typedef struct val_keyent_t_ {
+    struct val_keyent_t_ *next;
+    val_value_t          *val;
+    uint32                hash;
+} val_keyent_t;
+
+/* the list entries in one val_childgrp_t, hashed by key tuple;
+ * entries without a complete set of typed key leafs are kept
+ * in the unkeyed chain and compared one at a time
+ */
+typedef struct val_keyidx_t_ {
+    uint32         size;
+    uint32         count;
+    val_keyent_t **buckets;
+    val_keyent_t  *unkeyed;
+} val_keyidx_t;
+
+/* all the child nodes of one parent with the same QName;
+ * first and last are the outermost instances in childQ order
+ */
+typedef struct val_childgrp_t_ {
+    struct val_childgrp_t_ *next;
+    uint32         hash;              /* hash of the local-name */
+    uint32         count;
+    val_value_t   *first;
+    val_value_t   *last;
+    val_keyidx_t  *keyidx;           /* NCX_BT_LIST groups only */
+    boolean        nokeys;       /* keyidx cannot be used */
+} val_childgrp_t;
+
+/* val_value_t childidx: the groups are hashed by local-name only
+ * so a search by module name or in any namespace can use it too
+ */
+typedef struct val_childidx_t_ {
+    uint32           size;
+    uint32           count;
+    val_childgrp_t **buckets;
+} val_childidx_t;
+
 /* pick a log output function for dump_value */
 typedef void (*dumpfn_t) (const char *fstr, ...);
 
 /* pick a log indent function for dump_value */
 typedef void (*indentfn_t) (int32 indentcnt);
 
+/* one virtual value with a stale cached value to refresh */
+typedef struct val_vrefresh_t_ {
+    struct val_vrefresh_t_ *next;
+    val_value_t            *val;
+} val_vrefresh_t;
+
 #ifdef VAL_EDITVARS_DEBUG
 static uint32 editvars_malloc = 0;
 static uint32 editvars_free = 0;
 #endif
 
+/* virtual values waiting for val_refresh_virtual_values */
+static val_vrefresh_t *vrefresh_list = NULL;
+
 
 /********************************************************************
 * FUNCTION stdout_num
@@ -456,6 +519,69 @@ static void
 }  /* free_editvars */
 
 
+/********************************************************************
+* FUNCTION queue_vrefresh
+* 
+* Save a virtual value with a stale cached value so it
+* will be refreshed by val_refresh_virtual_values
+* 
+* INPUTS:
+*   val == virtual value to refresh
+*
+* OUTPUTS:
+*    VAL_FL_VREFRESH set in val->flags if queued
+*********************************************************************/
+static void
+    queue_vrefresh (val_value_t *val)
+{
+    val_vrefresh_t *vrefresh;
+
+    if (val->flags & VAL_FL_VREFRESH) {
+        return;
+    }
+
+    vrefresh = m__getObj(val_vrefresh_t);
+    if (vrefresh == NULL) {
+        /* the value will be refreshed in-line when it expires */
+        return;
+    }
+    vrefresh->val = val;
+    vrefresh->next = vrefresh_list;
+    vrefresh_list = vrefresh;
+    val->flags |= VAL_FL_VREFRESH;
+
+}  /* queue_vrefresh */
+
+
+/********************************************************************
+* FUNCTION remove_vrefresh
+* 
+* Remove a virtual value from the refresh list
+* 
+* INPUTS:
+*   val == virtual value to remove
+*
+* OUTPUTS:
+*    VAL_FL_VREFRESH cleared in val->flags
+*********************************************************************/
+static void
+    remove_vrefresh (val_value_t *val)
+{
+    val_vrefresh_t **link, *vrefresh;
+
+    for (link = &vrefresh_list; *link != NULL; link = &(*link)->next) {
+        vrefresh = *link;
+        if (vrefresh->val == val) {
+            *link = vrefresh->next;
+            m__free(vrefresh);
+            break;
+        }
+    }
+    val->flags &= ~VAL_FL_VREFRESH;
+
+}  /* remove_vrefresh */
+
+
 /********************************************************************
 * FUNCTION clean_value
 * 
@@ -477,6 +603,10 @@ static void
     val_index_t   *in;
     ncx_btype_t    btyp;
 
+    if (full && (val->flags & VAL_FL_VREFRESH)) {
+        remove_vrefresh(val);
+    }
+
     if (full && val->virtualval) {
         /* check if any cached entry of self needs to be cleared */
         val_free_value(val->virtualval);
@@ -530,6 +660,7 @@ static void
     case NCX_BT_CONTAINER:
     case NCX_BT_CHOICE:
     case NCX_BT_CASE:
+        val_clear_child_index(val);
         while (!dlq_empty(&val->v.childQ)) {
             cur = (val_value_t *)dlq_deque(&val->v.childQ);
             val_free_value(cur);
@@ -1071,7 +1202,7 @@ static void
     realval->nsid = virval->nsid;
     realval->obj = virval->obj;
     realval->typdef = virval->typdef;
-    realval->flags = virval->flags;
+    realval->flags = virval->flags & ~(VAL_FL_STREAMCB | VAL_FL_VREFRESH);
     realval->btyp = virval->btyp;
     realval->dataclass = virval->dataclass;
     realval->parent = virval->parent;
@@ -1155,6 +1286,135 @@ static status_t
 }  /* copy_editvars */
 
 
+/********************************************************************
+* FUNCTION fill_virtual_entries
+* 
+* Build the complete value of a streaming virtual node
+* by adding all the entries returned by the callback
+* 
+* INPUTS:
+*   scb == session control block getting the virtual value
+*   val == streaming virtual value to get value for
+*   retval == initialized value to fill in
+*
+* OUTPUTS:
+*    all the entries are added to retval
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    fill_virtual_entries (ses_cb_t *scb,
+                          val_value_t *val,
+                          val_value_t *retval)
+{
+    val_value_t *entry;
+    void        *cursor;
+    status_t     res;
+
+    cursor = NULL;
+    res = NO_ERR;
+    while ((entry = val_get_next_virtual_entry(scb, val, 
+                                               &cursor, &res)) != NULL) {
+        val_add_child(entry, retval);
+    }
+    val_finish_virtual_entries(scb, val, &cursor);
+    return res;
+
+}  /* fill_virtual_entries */
+
+
+/********************************************************************
+* FUNCTION get_cache_timers
+* 
+* Get the virtual value cache timers to use for a value node
+* The object settings are used if present, else the session
+* cache timeout or the global default if no session
+* 
+* INPUTS:
+*   scb == session control block getting the virtual value
+*          (may be NULL)
+*   val == virtual value to check
+*   timeout == address of return cache timeout (0 == no cache)
+*   stale_timeout == address of return stale-while-revalidate time
+*
+* OUTPUTS:
+*    *timeout and *stale_timeout set
+*********************************************************************/
+static void
+    get_cache_timers (const ses_cb_t *scb,
+                      const val_value_t *val,
+                      uint32 *timeout,
+                      uint32 *stale_timeout)
+{
+    if (val->obj != NULL &&
+        obj_get_cache_timeout(val->obj, timeout, stale_timeout)) {
+        return;
+    }
+
+    *stale_timeout = 0;
+    if (scb != NULL) {
+        *timeout = scb->cache_timeout;
+    } else {
+        *timeout = ncx_get_vtimeout_value();
+    }
+
+}  /* get_cache_timers */
+
+
+
+/********************************************************************
+* FUNCTION new_virtual_value
+* 
+* Call the get callback for a virtual value node
+*
+* The callback is called without a session because the
+* value is cached in the shared data tree for all sessions
+* 
+* INPUTS:
+*   val == virtual value to get value for
+*   res == pointer to output function return status value
+*
+* OUTPUTS:
+*    *res == the function return status
+*
+* RETURNS:
+*   the malloced value, or NULL if some error
+*********************************************************************/
+static val_value_t *
+    new_virtual_value (val_value_t *val,
+                       status_t *res)
+{
+    val_value_t *retval;
+    getcb_fn_t   getcb;
+
+    retval = val_new_value();
+    if (!retval) {
+        *res = ERR_INTERNAL_MEM;
+        return NULL;
+    }
+    setup_virtual_retval(val, retval);
+
+    if (val->flags & VAL_FL_STREAMCB) {
+        /* a consumer that needs the whole subtree, such as
+         * an XPath or subtree filter, gets all the entries
+         */
+        *res = fill_virtual_entries(NULL, val, retval);
+    } else {
+        getcb = (getcb_fn_t)val->getcb;
+        *res = (*getcb)(NULL, GETCB_GET_VALUE, val, retval);
+    }
+    if (*res != NO_ERR) {
+        val_free_value(retval);
+        retval = NULL;
+    } else {
+        retval->parent = val->parent;
+    }
+    return retval;
+
+}  /* new_virtual_value */
+
+
 /********************************************************************
 * FUNCTION cache_virtual_value
 * 
@@ -1168,10 +1428,15 @@ static status_t
 * This will be returned if virtual value has no
 * instance at this time.
 *
+* The cached value is shared by all sessions until the cache
+* timeout expires. Within the stale timeout after that, the
+* stale value is returned and the node is queued for
+* val_refresh_virtual_values (stale-while-revalidate)
+*
 * INPUTS:
 *   scb == session control block getting the virtual value
 *          the scb->cache_timeout value will be used
-*          id scb is not NULL
+*          if scb is not NULL and the object has no cache timers
 *   val == virtual value to get value for
 *   res == pointer to output function return status value
 *
@@ -1192,11 +1457,9 @@ static val_value_t *
                          status_t *res)
 {
     val_value_t *retval;
-    getcb_fn_t   getcb;
     time_t       timenow;
-    double       timediff, timerval;
-    uint32       deftimeout;
-    boolean      disable_cache;
+    double       timediff;
+    uint32       timeout, stale_timeout;
 
     *res = NO_ERR;
 
@@ -1205,56 +1468,50 @@ static val_value_t *
         return NULL;
     }
 
-    getcb = (getcb_fn_t)val->getcb;
-
     if (val->virtualval != NULL) {
         /* already have a value; check if it is fresh enough */
         (void)uptime(&timenow);
         timediff = difftime(timenow, val->cachetime);
-
-        disable_cache = FALSE;
-        if (scb != NULL) {
-            timerval = (double)scb->cache_timeout;
-            if (scb->cache_timeout == 0) {
-                disable_cache = TRUE;
-            }
-        } else {
-            deftimeout = ncx_get_vtimeout_value();
-            timerval = (double)deftimeout;
-        }
+        get_cache_timers(scb, val, &timeout, &stale_timeout);
 
         if (LOGDEBUG4) {
             log_debug4("\nval: virtual val timer %e", timediff);
         }
 
-        if (disable_cache || timediff > timerval) {
-            if (LOGDEBUG4) {
-                log_debug4("\nval: refresh virtual val %s",
-                           val->name);
+        if (timeout != 0) {
+            if (timediff <= (double)timeout) {
+                return val->virtualval;
             }
-            val_free_value(val->virtualval);
-            val->virtualval = NULL;
-        } else {
-            return val->virtualval;
+            if (timediff <= (double)timeout + (double)stale_timeout) {
+                /* return the stale value now and get a new
+                 * value after this request is done
+                 */
+                if (LOGDEBUG4) {
+                    log_debug4("\nval: stale virtual val %s",
+                               val->name);
+                }
+                queue_vrefresh(val);
+                return val->virtualval;
+            }
+        }
+
+        if (LOGDEBUG4) {
+            log_debug4("\nval: refresh virtual val %s",
+                       val->name);
         }
+        val_free_value(val->virtualval);
+        val->virtualval = NULL;
     }
 
     /* first get or stale and need a refresh */
-    retval = val_new_value();
-    if (!retval) {
-        *res = ERR_INTERNAL_MEM;
-        return NULL;
+    if (val->flags & VAL_FL_VREFRESH) {
+        remove_vrefresh(val);
     }
-    setup_virtual_retval(val, retval);
     (void)uptime(&val->cachetime);
 
-    *res = (*getcb)(NULL, GETCB_GET_VALUE, val, retval);
-    if (*res != NO_ERR) {
-        val_free_value(retval);
-        retval = NULL;
-    } else {
+    retval = new_virtual_value(val, res);
+    if (retval) {
         val->virtualval = retval;
-        val->virtualval->parent = val->parent;
     }
     return retval;
 
@@ -1338,7 +1595,7 @@ static val_value_t *
     copy->parent = val->parent;
     copy->nsid = val->nsid;
     copy->btyp = val->btyp;
-    copy->flags = val->flags;
+    copy->flags = val->flags & ~VAL_FL_VREFRESH;
     copy->dataclass = val->dataclass;
 
     /* copy any active partial locks;
@@ -1497,33 +1754,1160 @@ static val_value_t *
             if (!copy->v.fname) {
                 *res = ERR_INTERNAL_MEM;
             }
-        }
-        break;
-    case NCX_BT_INTERN:
-        if (val->v.intbuff) {
-            copy->v.intbuff = xml_strdup(val->v.intbuff);
-            if (!copy->v.intbuff) {
-                *res = ERR_INTERNAL_MEM;
+        }
+        break;
+    case NCX_BT_INTERN:
+        if (val->v.intbuff) {
+            copy->v.intbuff = xml_strdup(val->v.intbuff);
+            if (!copy->v.intbuff) {
+                *res = ERR_INTERNAL_MEM;
+            }
+        }
+        break;
+    default:
+        *res = SET_ERROR(ERR_INTERNAL_VAL);
+    }
+
+    /* reconstruct index records if needed */
+    if (*res==NO_ERR && !dlq_empty(&val->indexQ)) {
+        *res = val_gen_index_chain(val->obj, copy);
+    }
+
+    if (*res != NO_ERR) {
+        val_free_value(copy);
+        copy = NULL;
+    }
+
+    return copy;
+
+}  /* clone_test */
+
+
+/********************************************************************
+* FUNCTION childidx_name_hash
+* 
+* Get the child node index hash value for a local-name
+*
+* INPUTS:
+*   name == local-name to hash
+*
+* RETURNS:
+*   hash value
+*********************************************************************/
+static uint32
+    childidx_name_hash (const xmlChar *name)
+{
+    return (uint32)bobhash(name, xml_strlen(name), VAL_CHILDIDX_HASH_INIT);
+
+}  /* childidx_name_hash */
+
+
+/********************************************************************
+* FUNCTION childidx_same_qname
+* 
+* Check if a child node belongs in the specified group
+*
+* INPUTS:
+*   val == child node to check
+*   grp == child node group to check
+*
+* RETURNS:
+*   TRUE if val has the same QName as the group nodes
+*********************************************************************/
+static boolean
+    childidx_same_qname (const val_value_t *val,
+                         const val_childgrp_t *grp)
+{
+    if (val->name == NULL || val->nsid != grp->first->nsid) {
+        return FALSE;
+    }
+    return (xml_strcmp(val->name, grp->first->name)) ? FALSE : TRUE;
+
+}  /* childidx_same_qname */
+
+
+/********************************************************************
+* FUNCTION keyidx_hash
+* 
+* Get the key tuple hash value for a list entry
+* Only key leafs with the base type of their object are hashed
+* because index_match compares other key values as strings
+*
+* INPUTS:
+*   listval == list entry to hash
+* OUTPUTS:
+*   *hash == hash value if TRUE is returned
+*
+* RETURNS:
+*   TRUE if listval has a complete set of typed key leafs
+*   FALSE if not
+*********************************************************************/
+static boolean
+    keyidx_hash (const val_value_t *listval,
+                 uint32 *hash)
+{
+    const val_index_t *valin;
+    const val_value_t *keyval;
+    uint32             keycnt = 0;
+    ub4                h = VAL_CHILDIDX_HASH_INIT;
+
+    if (listval->obj == NULL || listval->obj->objtype != OBJ_TYP_LIST) {
+        return FALSE;
+    }
+
+    for (valin = (const val_index_t *)dlq_firstEntry(&listval->indexQ);
+         valin != NULL;
+         valin = (const val_index_t *)dlq_nextEntry(valin)) {
+
+        keyval = valin->val;
+        if (keyval->obj == NULL ||
+            keyval->btyp != obj_get_basetype(keyval->obj)) {
+            return FALSE;
+        }
+        keycnt++;
+
+        switch (keyval->btyp) {
+        case NCX_BT_EMPTY:
+        case NCX_BT_BOOLEAN:
+            h = bobhash((const ub1 *)&keyval->v.boo, 
+                        sizeof(keyval->v.boo), h);
+            break;
+        case NCX_BT_ENUM:
+            h = bobhash((const ub1 *)&keyval->v.enu.val, 
+                        sizeof(keyval->v.enu.val), h);
+            break;
+        case NCX_BT_INT8:
+        case NCX_BT_INT16:
+        case NCX_BT_INT32:
+            h = bobhash((const ub1 *)&keyval->v.num.i,
+                        sizeof(keyval->v.num.i), h);
+            break;
+        case NCX_BT_INT64:
+            h = bobhash((const ub1 *)&keyval->v.num.l,
+                        sizeof(keyval->v.num.l), h);
+            break;
+        case NCX_BT_UINT8:
+        case NCX_BT_UINT16:
+        case NCX_BT_UINT32:
+            h = bobhash((const ub1 *)&keyval->v.num.u,
+                        sizeof(keyval->v.num.u), h);
+            break;
+        case NCX_BT_UINT64:
+            h = bobhash((const ub1 *)&keyval->v.num.ul,
+                        sizeof(keyval->v.num.ul), h);
+            break;
+        case NCX_BT_STRING:
+        case NCX_BT_INSTANCE_ID:
+        case NCX_BT_LEAFREF:
+            if (keyval->v.str) {
+                h = bobhash(keyval->v.str, xml_strlen(keyval->v.str), h);
+            }
+            break;
+        case NCX_BT_IDREF:
+            h = bobhash((const ub1 *)&keyval->v.idref.nsid,
+                        sizeof(keyval->v.idref.nsid), h);
+            if (keyval->v.idref.name) {
+                h = bobhash(keyval->v.idref.name,
+                            xml_strlen(keyval->v.idref.name), h);
+            }
+            break;
+        default:
+            /* other key types are only compared by val_compare */
+            ;
+        }
+    }
+
+    if (keycnt != obj_key_count(listval->obj)) {
+        return FALSE;
+    }
+
+    *hash = (uint32)h;
+    return TRUE;
+
+}  /* keyidx_hash */
+
+
+/********************************************************************
+* FUNCTION keyidx_free_chain
+* 
+* Free a chain of key index entries
+*
+* INPUTS:
+*   ent == first entry in the chain to free
+*********************************************************************/
+static void
+    keyidx_free_chain (val_keyent_t *ent)
+{
+    val_keyent_t *nextent;
+
+    for (; ent != NULL; ent = nextent) {
+        nextent = ent->next;
+        m__free(ent);
+    }
+
+}  /* keyidx_free_chain */
+
+
+/********************************************************************
+* FUNCTION keyidx_free
+* 
+* Free a list key index
+*
+* INPUTS:
+*   keyidx == key index to free
+*********************************************************************/
+static void
+    keyidx_free (val_keyidx_t *keyidx)
+{
+    uint32 i;
+
+    for (i = 0; i < keyidx->size; i++) {
+        keyidx_free_chain(keyidx->buckets[i]);
+    }
+    keyidx_free_chain(keyidx->unkeyed);
+    m__free(keyidx->buckets);
+    m__free(keyidx);
+
+}  /* keyidx_free */
+
+
+/********************************************************************
+* FUNCTION keyidx_insert
+* 
+* Insert a hashed entry in a list key index
+* Grow the hash table first if it is getting full
+*
+* INPUTS:
+*   keyidx == key index to use
+*   ent == entry to insert; ent->hash is set
+*********************************************************************/
+static void
+    keyidx_insert (val_keyidx_t *keyidx,
+                   val_keyent_t *ent)
+{
+    val_keyent_t **buckets, *cur, *nextent;
+    uint32         size, i;
+
+    if (keyidx->count >= keyidx->size * 2) {
+        size = keyidx->size * 2;
+        buckets = (val_keyent_t **)m__getMem(size * sizeof(val_keyent_t *));
+        if (buckets != NULL) {
+            memset(buckets, 0x0, size * sizeof(val_keyent_t *));
+            for (i = 0; i < keyidx->size; i++) {
+                for (cur = keyidx->buckets[i]; cur != NULL; cur = nextent) {
+                    nextent = cur->next;
+                    cur->next = buckets[cur->hash & (size - 1)];
+                    buckets[cur->hash & (size - 1)] = cur;
+                }
+            }
+            m__free(keyidx->buckets);
+            keyidx->buckets = buckets;
+            keyidx->size = size;
+        } /* else keep using the smaller table */
+    }
+
+    i = ent->hash & (keyidx->size - 1);
+    ent->next = keyidx->buckets[i];
+    keyidx->buckets[i] = ent;
+    keyidx->count++;
+
+}  /* keyidx_insert */
+
+
+/********************************************************************
+* FUNCTION keyidx_add
+* 
+* Add a list entry to a list key index
+*
+* INPUTS:
+*   keyidx == key index to use
+*   listval == list entry to add
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    keyidx_add (val_keyidx_t *keyidx,
+                val_value_t *listval)
+{
+    val_keyent_t *ent = m__getObj(val_keyent_t);
+    if (ent == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    ent->val = listval;
+
+    if (keyidx_hash(listval, &ent->hash)) {
+        keyidx_insert(keyidx, ent);
+    } else {
+        ent->hash = 0;
+        ent->next = keyidx->unkeyed;
+        keyidx->unkeyed = ent;
+    }
+    return NO_ERR;
+
+}  /* keyidx_add */
+
+
+/********************************************************************
+* FUNCTION keyidx_remove
+* 
+* Remove a list entry from a list key index
+*
+* INPUTS:
+*   keyidx == key index to use
+*   listval == list entry to remove
+*
+* RETURNS:
+*   TRUE if the entry was found and removed
+*   FALSE if the entry was not found (key values changed)
+*********************************************************************/
+static boolean
+    keyidx_remove (val_keyidx_t *keyidx,
+                   const val_value_t *listval)
+{
+    val_keyent_t **pp, *ent;
+    uint32         hash;
+
+    for (pp = &keyidx->unkeyed; *pp != NULL; pp = &(*pp)->next) {
+        ent = *pp;
+        if (ent->val == listval) {
+            *pp = ent->next;
+            m__free(ent);
+            return TRUE;
+        }
+    }
+
+    if (!keyidx_hash(listval, &hash)) {
+        return FALSE;
+    }
+
+    for (pp = &keyidx->buckets[hash & (keyidx->size - 1)];
+         *pp != NULL;
+         pp = &(*pp)->next) {
+        ent = *pp;
+        if (ent->val == listval) {
+            *pp = ent->next;
+            m__free(ent);
+            keyidx->count--;
+            return TRUE;
+        }
+    }
+    return FALSE;
+
+}  /* keyidx_remove */
+
+
+/********************************************************************
+* FUNCTION keyidx_build
+* 
+* Build the list key index for a group of list entries
+*
+* INPUTS:
+*   grp == child node group to index
+*
+* RETURNS:
+*   malloced key index or NULL if it cannot be used
+*   for this group
+*********************************************************************/
+static val_keyidx_t *
+    keyidx_build (val_childgrp_t *grp)
+{
+    val_keyidx_t *keyidx;
+    val_value_t  *val;
+    uint32        size = VAL_CHILDIDX_KEY_SIZE;
+
+    keyidx = m__getObj(val_keyidx_t);
+    if (keyidx == NULL) {
+        return NULL;
+    }
+    memset(keyidx, 0x0, sizeof(val_keyidx_t));
+
+    while (size < grp->count) {
+        size *= 2;
+    }
+    keyidx->buckets = (val_keyent_t **)m__getMem(size * sizeof(val_keyent_t *));
+    if (keyidx->buckets == NULL) {
+        m__free(keyidx);
+        return NULL;
+    }
+    memset(keyidx->buckets, 0x0, size * sizeof(val_keyent_t *));
+    keyidx->size = size;
+
+    for (val = grp->first; val != NULL; 
+         val = (val_value_t *)dlq_nextEntry(val)) {
+        if (childidx_same_qname(val, grp)) {
+            if (val->btyp != NCX_BT_LIST ||
+                keyidx_add(keyidx, val) != NO_ERR) {
+                keyidx_free(keyidx);
+                return NULL;
+            }
+        }
+        if (val == grp->last) {
+            break;
+        }
+    }
+    return keyidx;
+
+}  /* keyidx_build */
+
+
+/********************************************************************
+* FUNCTION keyidx_list_match
+* 
+* Check if a list entry is a match for val_first_child_match
+*
+* INPUTS:
+*   val == list entry in the index
+*   child == list entry to find
+*
+* RETURNS:
+*   TRUE if val is a match
+*********************************************************************/
+static boolean
+    keyidx_list_match (val_value_t *val,
+                       const val_value_t *child)
+{
+    if (VAL_IS_DELETED(val) || val->obj != child->obj) {
+        return FALSE;
+    }
+    return val_index_match(child, val);
+
+}  /* keyidx_list_match */
+
+
+/********************************************************************
+* FUNCTION childidx_match_list
+* 
+* Use the list key index to find the list entry with the same
+* key tuple as the child node
+*
+* INPUTS:
+*   grp == child node group for the list
+*   child == list entry to find (e.g., from a NETCONF PDU)
+* OUTPUTS:
+*   *retval == the matching list entry or NULL if none
+*              if TRUE is returned
+*
+* RETURNS:
+*   TRUE if *retval is the answer
+*   FALSE if the childQ needs to be searched instead
+*********************************************************************/
+static boolean
+    childidx_match_list (val_childgrp_t *grp,
+                         const val_value_t *child,
+                         val_value_t **retval)
+{
+    val_keyidx_t  *keyidx;
+    val_keyent_t **pp, *ent;
+    val_value_t   *match = NULL;
+    uint32         hash = 0, cnt = 0;
+    boolean        usehash;
+
+    if (grp->nokeys || child->obj == NULL ||
+        child->obj->objtype != OBJ_TYP_LIST) {
+        return FALSE;
+    }
+
+    if (grp->keyidx == NULL) {
+        grp->keyidx = keyidx_build(grp);
+        if (grp->keyidx == NULL) {
+            grp->nokeys = TRUE;
+            return FALSE;
+        }
+    }
+    keyidx = grp->keyidx;
+
+    usehash = keyidx_hash(child, &hash);
+    if (!usehash && 
+        dlq_count(&child->indexQ) == obj_key_count(child->obj)) {
+        /* complete key set, but compared as strings */
+        return FALSE;
+    }
+
+    /* move entries that got all their keys since they were added */
+    pp = &keyidx->unkeyed;
+    while (*pp != NULL) {
+        ent = *pp;
+        if (keyidx_hash(ent->val, &ent->hash)) {
+            *pp = ent->next;
+            keyidx_insert(keyidx, ent);
+        } else {
+            pp = &ent->next;
+        }
+    }
+
+    if (usehash) {
+        for (ent = keyidx->buckets[hash & (keyidx->size - 1)];
+             ent != NULL;
+             ent = ent->next) {
+            if (ent->hash == hash && keyidx_list_match(ent->val, child)) {
+                match = ent->val;
+                cnt++;
+            }
+        }
+    }
+    for (ent = keyidx->unkeyed; ent != NULL; ent = ent->next) {
+        if (keyidx_list_match(ent->val, child)) {
+            match = ent->val;
+            cnt++;
+        }
+    }
+
+    if (cnt > 1) {
+        /* duplicate entries; let the search find the first one */
+        return FALSE;
+    }
+    *retval = match;
+    return TRUE;
+
+}  /* childidx_match_list */
+
+
+/********************************************************************
+* FUNCTION childidx_free
+* 
+* Free a child node index
+*
+* INPUTS:
+*   childidx == child node index to free
+*********************************************************************/
+static void
+    childidx_free (val_childidx_t *childidx)
+{
+    val_childgrp_t *grp, *nextgrp;
+    uint32          i;
+
+    for (i = 0; i < childidx->size; i++) {
+        for (grp = childidx->buckets[i]; grp != NULL; grp = nextgrp) {
+            nextgrp = grp->next;
+            if (grp->keyidx) {
+                keyidx_free(grp->keyidx);
+            }
+            m__free(grp);
+        }
+    }
+    m__free(childidx->buckets);
+    m__free(childidx);
+
+}  /* childidx_free */
+
+
+/********************************************************************
+* FUNCTION childidx_find_group
+* 
+* Find the child node group for a QName
+*
+* INPUTS:
+*   childidx == child node index to search
+*   nsid == namespace ID of the child node
+*   name == local-name of the child node
+*
+* RETURNS:
+*   pointer to the group or NULL if not found
+*********************************************************************/
+static val_childgrp_t *
+    childidx_find_group (const val_childidx_t *childidx,
+                         xmlns_id_t nsid,
+                         const xmlChar *name)
+{
+    val_childgrp_t *grp;
+    uint32          hash = childidx_name_hash(name);
+
+    for (grp = childidx->buckets[hash & (childidx->size - 1)];
+         grp != NULL;
+         grp = grp->next) {
+        if (grp->hash == hash && grp->first->nsid == nsid &&
+            !xml_strcmp(grp->first->name, name)) {
+            return grp;
+        }
+    }
+    return NULL;
+
+}  /* childidx_find_group */
+
+
+/********************************************************************
+* FUNCTION childidx_find_name
+* 
+* Find the child node group for a val_find_child search
+*
+* INPUTS:
+*   childidx == child node index to search
+*   modname == module name; NULL for any namespace
+*   name == local-name of the child node
+* OUTPUTS:
+*   *multiple == TRUE if more than one group matched
+*                and NULL is returned
+*
+* RETURNS:
+*   pointer to the only group that matches or NULL if none
+*********************************************************************/
+static val_childgrp_t *
+    childidx_find_name (const val_childidx_t *childidx,
+                        const xmlChar *modname,
+                        const xmlChar *name,
+                        boolean *multiple)
+{
+    val_childgrp_t *grp, *found = NULL;
+    uint32          hash = childidx_name_hash(name);
+
+    *multiple = FALSE;
+    for (grp = childidx->buckets[hash & (childidx->size - 1)];
+         grp != NULL;
+         grp = grp->next) {
+        if (grp->hash != hash || xml_strcmp(grp->first->name, name)) {
+            continue;
+        }
+        if (modname && xml_strcmp(modname, val_get_mod_name(grp->first))) {
+            continue;
+        }
+        if (found) {
+            *multiple = TRUE;
+            return NULL;
+        }
+        found = grp;
+    }
+    return found;
+
+}  /* childidx_find_name */
+
+
+/********************************************************************
+* FUNCTION childidx_new_group
+* 
+* Add a new child node group with one child node
+*
+* INPUTS:
+*   childidx == child node index to use
+*   child == first child node in the group
+*
+* RETURNS:
+*   status
+*********************************************************************/
+static status_t
+    childidx_new_group (val_childidx_t *childidx,
+                        val_value_t *child)
+{
+    val_childgrp_t **buckets, *grp, *cur, *nextgrp;
+    uint32           size, i;
+
+    grp = m__getObj(val_childgrp_t);
+    if (grp == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(grp, 0x0, sizeof(val_childgrp_t));
+    grp->hash = childidx_name_hash(child->name);
+    grp->count = 1;
+    grp->first = child;
+    grp->last = child;
+
+    if (childidx->count >= childidx->size * 2) {
+        size = childidx->size * 2;
+        buckets = (val_childgrp_t **)
+            m__getMem(size * sizeof(val_childgrp_t *));
+        if (buckets != NULL) {
+            memset(buckets, 0x0, size * sizeof(val_childgrp_t *));
+            for (i = 0; i < childidx->size; i++) {
+                for (cur = childidx->buckets[i]; cur != NULL; cur = nextgrp) {
+                    nextgrp = cur->next;
+                    cur->next = buckets[cur->hash & (size - 1)];
+                    buckets[cur->hash & (size - 1)] = cur;
+                }
+            }
+            m__free(childidx->buckets);
+            childidx->buckets = buckets;
+            childidx->size = size;
+        } /* else keep using the smaller table */
+    }
+
+    i = grp->hash & (childidx->size - 1);
+    grp->next = childidx->buckets[i];
+    childidx->buckets[i] = grp;
+    childidx->count++;
+    return NO_ERR;
+
+}  /* childidx_new_group */
+
+
+/********************************************************************
+* FUNCTION childidx_build
+* 
+* Build the child node index for a complex value node
+* Nothing is done if there is not enough memory;
+* the childQ will be searched instead
+*
+* INPUTS:
+*   parent == complex value node to index
+*********************************************************************/
+static void
+    childidx_build (val_value_t *parent)
+{
+    val_childidx_t *childidx;
+    val_childgrp_t *grp;
+    val_value_t    *val;
+
+    childidx = m__getObj(val_childidx_t);
+    if (childidx == NULL) {
+        return;
+    }
+    childidx->size = VAL_CHILDIDX_NAME_SIZE;
+    childidx->count = 0;
+    childidx->buckets = (val_childgrp_t **)
+        m__getMem(childidx->size * sizeof(val_childgrp_t *));
+    if (childidx->buckets == NULL) {
+        m__free(childidx);
+        return;
+    }
+    memset(childidx->buckets, 0x0, 
+           childidx->size * sizeof(val_childgrp_t *));
+
+    for (val = (val_value_t *)dlq_firstEntry(&parent->v.childQ);
+         val != NULL;
+         val = (val_value_t *)dlq_nextEntry(val)) {
+        if (val->name == NULL) {
+            /* deleted node marker */
+            continue;
+        }
+        grp = childidx_find_group(childidx, val->nsid, val->name);
+        if (grp) {
+            grp->last = val;
+            grp->count++;
+        } else if (childidx_new_group(childidx, val) != NO_ERR) {
+            childidx_free(childidx);
+            return;
+        }
+    }
+    parent->childidx = childidx;
+
+}  /* childidx_build */
+
+
+/********************************************************************
+* FUNCTION childidx_check_build
+* 
+* Build the child node index after a linear search of the
+* childQ if the search was long enough to be worth it
+* The index is a lookup cache, so it may be added to a
+* parent node that is otherwise read-only
+*
+* INPUTS:
+*   parent == complex value node that was searched
+*   steps == number of child nodes visited by the search
+*********************************************************************/
+static void
+    childidx_check_build (const val_value_t *parent,
+                          uint32 steps)
+{
+    if (parent->childidx == NULL && steps >= VAL_CHILDIDX_THRESHOLD) {
+        childidx_build((val_value_t *)parent);
+    }
+
+}  /* childidx_check_build */
+
+
+/********************************************************************
+* FUNCTION childidx_add
+* 
+* Update the child node index after a child node
+* was inserted in the parent childQ
+* The index is discarded if the new position of the
+* child node in its group cannot be determined
+*
+* INPUTS:
+*   parent == parent node of child
+*   child == child node that was inserted
+*********************************************************************/
+static void
+    childidx_add (val_value_t *parent,
+                  val_value_t *child)
+{
+    val_childidx_t *childidx = parent->childidx;
+    val_childgrp_t *grp;
+    val_value_t    *prev, *next;
+
+    if (childidx == NULL || child->name == NULL) {
+        return;
+    }
+
+    grp = childidx_find_group(childidx, child->nsid, child->name);
+    if (grp == NULL) {
+        if (childidx_new_group(childidx, child) != NO_ERR) {
+            val_clear_child_index(parent);
+        }
+        return;
+    }
+
+    prev = (val_value_t *)dlq_prevEntry(child);
+    next = (val_value_t *)dlq_nextEntry(child);
+    if (next == grp->first) {
+        grp->first = child;
+    } else if (prev == grp->last) {
+        grp->last = child;
+    } else if (!((prev && childidx_same_qname(prev, grp)) ||
+                 (next && childidx_same_qname(next, grp)))) {
+        /* not next to another instance; no way to tell
+         * if the child is now the first or last instance
+         */
+        val_clear_child_index(parent);
+        return;
+    }
+    grp->count++;
+
+    if (grp->keyidx) {
+        if (child->btyp != NCX_BT_LIST ||
+            keyidx_add(grp->keyidx, child) != NO_ERR) {
+            keyidx_free(grp->keyidx);
+            grp->keyidx = NULL;
+            grp->nokeys = (child->btyp != NCX_BT_LIST);
+        }
+    }
+
+}  /* childidx_add */
+
+
+/********************************************************************
+* FUNCTION childidx_remove
+* 
+* Update the child node index before a child node
+* is removed from the parent childQ
+*
+* INPUTS:
+*   parent == parent node of child
+*   child == child node that will be removed
+*********************************************************************/
+static void
+    childidx_remove (val_value_t *parent,
+                     val_value_t *child)
+{
+    val_childidx_t  *childidx = parent->childidx;
+    val_childgrp_t **pp, *grp;
+    val_value_t     *val;
+
+    if (childidx == NULL || child->name == NULL) {
+        return;
+    }
+
+    grp = childidx_find_group(childidx, child->nsid, child->name);
+    if (grp == NULL) {
+        val_clear_child_index(parent);
+        return;
+    }
+
+    if (grp->count == 1) {
+        if (grp->first != child) {
+            val_clear_child_index(parent);
+            return;
+        }
+        for (pp = &childidx->buckets[grp->hash & (childidx->size - 1)];
+             *pp != grp;
+             pp = &(*pp)->next) {
+            ;
+        }
+        *pp = grp->next;
+        if (grp->keyidx) {
+            keyidx_free(grp->keyidx);
+        }
+        m__free(grp);
+        childidx->count--;
+        return;
+    }
+
+    if (child == grp->first) {
+        val = (val_value_t *)dlq_nextEntry(child);
+        if (val == NULL || !childidx_same_qname(val, grp)) {
+            val_clear_child_index(parent);
+            return;
+        }
+        grp->first = val;
+    } else if (child == grp->last) {
+        val = (val_value_t *)dlq_prevEntry(child);
+        if (val == NULL || !childidx_same_qname(val, grp)) {
+            val_clear_child_index(parent);
+            return;
+        }
+        grp->last = val;
+    }
+    grp->count--;
+
+    if (grp->keyidx && !keyidx_remove(grp->keyidx, child)) {
+        /* key leafs were changed after the entry was indexed */
+        keyidx_free(grp->keyidx);
+        grp->keyidx = NULL;
+    }
+
+}  /* childidx_remove */
+
+
+/********************************************************************
+* FUNCTION child_match
+* 
+* Check if a child node matches for val_first_child_match
+*
+* INPUTS:
+*   val == child node in the parent to check
+*   child == child value to find (e.g., from a NETCONF PDU) 
+*
+* RETURNS:
+*   TRUE if val is a match
+*********************************************************************/
+static boolean
+    child_match (val_value_t *val,
+                 val_value_t *child)
+{
+    if (VAL_IS_DELETED(val)) {
+        return FALSE;
+    }
+
+    /* check the node if the QName matches */
+    if (val->nsid == child->nsid &&
+        !xml_strcmp(val->name, child->name)) {
+
+        if (val->btyp == NCX_BT_LIST) {
+            /* match the instance identifiers, if any */
+            return val_index_match(child, val);
+        } else if (val->obj->objtype == OBJ_TYP_LEAF_LIST) {
+            if (val->btyp == child->btyp) {
+                /* find the leaf-list with the same value */
+                return (val_compare(val, child)) ? FALSE : TRUE;
+            } else {
+                /* match any value; if this is a subtree
+                 * filter test, it is not for a content match
+                 * node
+                 */
+                return TRUE;
+            }
+        } else {
+            /* can only be this one instance */
+            return TRUE;
+        }
+    }
+    return FALSE;
+
+}  /* child_match */
+
+
+/********************************************************************
+* FUNCTION insert_child_sorted
+* 
+*   Insert a child value node in the childQ of a parent
+*   value node in the proper place
+*   Does not update the parent childidx
+*
+* INPUTS:
+*    child == node to store in the parent
+*    parent == complex value node with a childQ
+*
+* RETURNS:
+*    number of sibling nodes visited to find the place
+*********************************************************************/
+static uint32
+    insert_child_sorted (val_value_t *child,
+                         val_value_t *parent)
+{
+    dlq_hdr_t *childQ = &parent->v.childQ;
+    uint32 steps = 0;
+
+    /* check new first entry */
+    if (dlq_empty(childQ)) {
+        dlq_enque(child, childQ);
+        return steps;
+    }
+
+    val_value_t *curval = NULL;
+    obj_template_t *newobj = child->obj;
+    xmlns_id_t parentid = val_get_nsid(parent);
+    xmlns_id_t childid = val_get_nsid(child);
+    boolean sysorder = obj_is_system_ordered(newobj);
+    int ret = 0;
+
+    /* with a child index the place after the last instance
+     * of the same object can be found right away; a sorted
+     * instance can only go there if it is not less than the last one
+     */
+    if (parent->childidx != NULL &&
+        parent->obj->objtype != OBJ_TYP_ANYXML) {
+        val_childgrp_t *grp = 
+            childidx_find_group(parent->childidx, child->nsid, child->name);
+        if (grp != NULL && grp->last->obj == newobj &&
+            !VAL_IS_DELETED(grp->last)) {
+            if (sysorder && ncx_get_system_sorted()) {
+                if (newobj->objtype == OBJ_TYP_LIST) {
+                    ret = val_index_compare(child, grp->last);
+                } else {
+                    ret = val_compare(child, grp->last);
+                }
+            }
+            if (ret >= 0) {
+                dlq_insertAfter(child, grp->last);
+                return steps;
+            }
+            ret = 0;
+        }
+    }
+
+    /* The current set of sibling nodes needs to
+     * be searched to determine where to insert this child
+     */
+    if (obj_is_root(parent->obj)) {
+        /* adding objects to the root is different; need
+         * to use alphabetical order, not schema order
+         * since submodules blur the top-level object
+         * order within a module namespace
+         */
+        for (curval = val_get_first_child(parent);
+             curval != NULL;
+             curval = val_get_next_child(curval)) {
+
+            steps++;
+
+            /* check same type of sibling cornercase
+             * should only happen if the child is
+             * type list or leaf-list
+             */
+            if (newobj == curval->obj) {
+                /* make a new sorted or last one of these entries */
+                boolean syssorted = ncx_get_system_sorted();
+                boolean done = FALSE;
+
+                while (!done) {
+                    steps++;
+                    if (sysorder && syssorted) {
+                        if (newobj->objtype == OBJ_TYP_LIST) {
+                            ret = val_index_compare(child, curval);
+                        } else {
+                            ret = val_compare(child, curval);
+                        }
+                        if (ret < 0) {
+                            dlq_insertAhead(child, curval);
+                            return steps;
+                        }
+                    }
+                    val_value_t *nextchild = val_get_next_child(curval);
+                    if (nextchild == NULL || nextchild->obj != child->obj) {
+                        done = TRUE;
+                    } else {
+                        curval = nextchild;
+                    }
+                }
+                dlq_insertAfter(child, curval);
+                return steps;
+            }
+
+            ret = xml_strcmp(child->name, curval->name);
+            if (ret < 0) {
+                dlq_insertAhead(child, curval);
+                return steps;
+            } else if (ret == 0) {
+                ret = xml_strcmp(val_get_mod_name(child),
+                                 val_get_mod_name(curval));
+                if (ret < 0) {
+                    dlq_insertAhead(child, curval);
+                    return steps;
+                    /* same name, insert in module alphabetical order */
+                }
+            }
+        }
+
+        /* make new last entry */
+        dlq_enque(child, childQ);
+    } else if (parent->obj->objtype == OBJ_TYP_ANYXML) {
+        /* there is no schema order to check, so see if this
+         * child already exists
+         */
+        curval = val_find_child(parent, val_get_mod_name(child), child->name);
+        if (curval != NULL) {
+            /* make new last instance of this child node */
+            val_value_t *saveval = NULL;
+            while (curval != NULL) {
+                saveval = curval;
+                curval = val_find_next_child(parent, val_get_mod_name(child),
+                                             child->name, curval);
+            }
+            dlq_insertAfter(child, saveval);
+        } else {
+            /* make new last child; first one of these */
+            dlq_enque(child, childQ);
+        }
+    } else {
+        /* normal container or list */
+        for (curval = val_get_first_child(parent);
+             curval != NULL;
+             curval = val_get_next_child(curval)) {
+
+            steps++;
+
+            /* check same type of sibling cornercase
+             * should only happen if the child is
+             * type list or leaf-list
+             */
+            if (newobj == curval->obj) {
+                /* make a new last one of these entries */
+                boolean syssorted = ncx_get_system_sorted();
+                boolean done = FALSE;
+
+                while (!done) {
+                    steps++;
+                    if (sysorder && syssorted) {
+                        if (newobj->objtype == OBJ_TYP_LIST) {
+                            ret = val_index_compare(child, curval);
+                        } else {
+                            ret = val_compare(child, curval);
+                        }
+                        if (ret < 0) {
+                            dlq_insertAhead(child, curval);
+                            return steps;
+                        }
+                    }
+
+                    val_value_t *nextchild = val_get_next_child(curval);
+                    if (nextchild == NULL || nextchild->obj != child->obj) {
+                        done = TRUE;
+                    } else {
+                        curval = nextchild;
+                    }              
+                }
+
+                /* make a new last instance of this node type */
+                dlq_insertAfter(child, curval);
+                return steps;
+            }
+
+            /* simple test; since native children
+             * will be before external augmented children;
+             * any native node will insert ahead of such 
+             * an augment node
+             */
+            if (val_get_nsid(curval) != parentid && childid == parentid) {
+                dlq_insertAhead(child, curval);
+                return steps;
             }
-        }
-        break;
-    default:
-        *res = SET_ERROR(ERR_INTERNAL_VAL);
-    }
 
-    /* reconstruct index records if needed */
-    if (*res==NO_ERR && !dlq_empty(&val->indexQ)) {
-        *res = val_gen_index_chain(val->obj, copy);
-    }
+            /* new node and current node are different so
+             * check if the current object is after the
+             * new object in the schema order.  If so,
+             * then insert ahead of this node
+             *
+             * the object siblings are not numbered, so
+             * a linear search is used here
+             */
+            obj_template_t *testobj = obj_next_child_deep(child->obj);
+            for (; testobj != NULL; testobj = obj_next_child_deep(testobj)) {
+                if (testobj == curval->obj) {
+                    /* insert child ahead of this node
+                     * which occurs after it in schema order
+                     */
+                    dlq_insertAhead(child, curval);
+                    return steps;
+                }
+            }
+        }
 
-    if (*res != NO_ERR) {
-        val_free_value(copy);
-        copy = NULL;
+        /* make a new last entry */
+        dlq_enque(child, childQ);
     }
+    return steps;
 
-    return copy;
-
-}  /* clone_test */
+}   /* insert_child_sorted */
 
 
 /*************** E X T E R N A L    F U N C T I O N S  *************/
@@ -1613,6 +2997,43 @@ void
 }  /* val_init_virtual */
 
 
+/********************************************************************
+* FUNCTION val_init_virtual_stream
+* 
+* Special function to initialize a virtual complex value node
+* which returns its child entries one at a time
+*
+* MUST CALL val_new_value FIRST
+*
+* INPUTS:
+*   val == pointer to the malloced struct to initialize
+*   cbfn == streaming get callback function to use
+*           (really getcb_stream_fn_t)
+*   obj == object template to use; must have child nodes
+*********************************************************************/
+void
+    val_init_virtual_stream (val_value_t *val,
+                             void  *cbfn,
+                             obj_template_t *obj)
+{
+#ifdef DEBUG
+    if (!val || !cbfn || !obj) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
+
+    val_init_from_template(val, obj);
+    if (!typ_has_children(val->btyp)) {
+        SET_ERROR(ERR_INTERNAL_VAL);
+        return;
+    }
+    val->getcb = cbfn;
+    val->flags |= VAL_FL_STREAMCB;
+
+}  /* val_init_virtual_stream */
+
+
 /********************************************************************
 * FUNCTION val_init_from_template
 * 
@@ -1697,6 +3118,10 @@ void
         return;
     }
 
+    if (val->parent) {
+        val_clear_child_index(val->parent);
+    }
+
     /* replace the name field */
     if (val->dname) {
         m__free(val->dname);
@@ -1782,6 +3207,9 @@ void
     }
 #endif
 
+    if (val->parent && val->nsid != nsid) {
+        val_clear_child_index(val->parent);
+    }
     val->nsid = nsid;
 
     /* check no change to name */
@@ -1790,6 +3218,10 @@ void
         return;
     }
 
+    if (val->parent) {
+        val_clear_child_index(val->parent);
+    }
+
     /* replace the name field */
     if (val->dname) {
         m__free(val->dname);
@@ -3787,31 +5219,12 @@ status_t
             log_error("\nError: dump value '%s' to JSON file failed (%s)",
                       val->name, get_error_string(res));
         }
+    } else {
+        res = ERR_NCX_OPERATION_NOT_SUPPORTED;
     }
     return res;
 }   /* val_dump_value_max_w_file */
 
-/* val_make_serialized_string helper functions and definitions */
-typedef struct serializer_node_t_ {
-    char* buf;
-    char* cur;
-    size_t buf_len;
-} serializer_node_t;
-
-static ssize_t writer_fn(void *cookie, const void *buffer, size_t size)
-{
-    serializer_node_t* ser = (serializer_node_t *)cookie;
-
-    if(ser->buf==NULL) {
-        ser->buf_len+=size;
-    } else {
-        assert((ser->cur+size) <= (ser->buf+ser->buf_len));
-        memcpy(ser->cur,buffer,size);
-        ser->cur+=size;
-    }
-    return size;
-}
-
 /********************************************************************
 * FUNCTION val_make_serialized_string
 *
@@ -3827,23 +5240,23 @@ static ssize_t writer_fn(void *cookie, const void *buffer, size_t size)
 status_t
     val_make_serialized_string (val_value_t *val, ncx_display_mode_t mode, xmlChar** str)
 {
-    serializer_node_t ser;
-    status_t res;
-    FILE* fp;
-    cookie_io_functions_t io_functions;
-    io_functions.read=NULL;
-    io_functions.write=(cookie_write_function_t *)writer_fn;
-    io_functions.seek=NULL;
-    io_functions.close=NULL;
+    FILE      *fp;
+    char      *buff;
+    size_t     bufflen;
+    status_t   res;
 
-    fp=fopencookie (&ser, "w", io_functions);
-    assert(fp != NULL);
+    *str = NULL;
 
-    ser.buf=NULL;
-    ser.cur=NULL;
-    ser.buf_len=0;
+    /* the memory stream grows the buffer as the value is
+     * written, so the value is only serialized once
+     */
+    buff = NULL;
+    bufflen = 0;
+    fp = open_memstream(&buff, &bufflen);
+    if (fp == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
 
-    /* dry-run figure the required buffer length */
     res = val_dump_value_max_w_file(val,
                         0/*startident*/,
                         NCX_DEF_INDENT/*indent_amount*/,
@@ -3851,27 +5264,16 @@ status_t
                         TRUE/*with_meta*/,
                         FALSE/*configonly*/,
                         fp);
-    if(res!=NO_ERR) {
+    if (fclose(fp) != 0 && res == NO_ERR) {
+        res = ERR_INTERNAL_MEM;
+    }
+    if (res != NO_ERR) {
+        free(buff);
         return res;
     }
-    fclose(fp);
-
-    fp=fopencookie (&ser, "w", io_functions);
-    assert(fp != NULL);
-
-    ser.buf=(char*)malloc(ser.buf_len+1);
-    ser.cur=ser.buf;
-    ser.buf[ser.buf_len]=0;
-    res = val_dump_value_max_w_file(val,
-                        0/*startident*/,
-                        NCX_DEF_INDENT/*indent_amount*/,
-                        mode,
-                        TRUE/*with_meta*/,
-                        FALSE/*configonly*/,
-                        fp);
-    fclose(fp);
 
-    *str = ser.buf;
+    /* the buffer is malloced and zero-terminated */
+    *str = (xmlChar *)buff;
     return NO_ERR;
 
 }
@@ -5402,206 +6804,45 @@ void
     val_add_child (val_value_t *child,
                    val_value_t *parent)
 {
-#ifdef DEBUG
-    if (child == NULL || parent == NULL) {
-        SET_ERROR(ERR_INTERNAL_PTR);
-        return;
-    }
-#endif
-
-    child->parent = parent;
-    dlq_enque(child, &parent->v.childQ);
-
-}   /* val_add_child */
-
-
-/********************************************************************
-* FUNCTION val_add_child_sorted
-* 
-*   Add a child value node to a parent value node
-*   in the proper place
-*
-* INPUTS:
-*    child == node to store in the parent
-*    parent == complex value node with a childQ
-*
-*********************************************************************/
-void
-    val_add_child_sorted (val_value_t *child,
-                          val_value_t *parent)
-{
-    assert( child && "child is NULL!" );
-    assert( parent && "parent is NULL!" );
-
-    child->parent = parent;
-    dlq_hdr_t *childQ = &parent->v.childQ;
-
-    /* check new first entry */
-    if (dlq_empty(childQ)) {
-        dlq_enque(child, childQ);
-        return;
-    }
-
-    val_value_t *curval = NULL;
-    obj_template_t *newobj = child->obj;
-    xmlns_id_t parentid = val_get_nsid(parent);
-    xmlns_id_t childid = val_get_nsid(child);
-    boolean sysorder = obj_is_system_ordered(newobj);
-    int ret = 0;
-
-    /* The current set of sibling nodes needs to
-     * be searched to determine where to insert this child
-     */
-    if (obj_is_root(parent->obj)) {
-        /* adding objects to the root is different; need
-         * to use alphabetical order, not schema order
-         * since submodules blur the top-level object
-         * order within a module namespace
-         */
-        for (curval = val_get_first_child(parent);
-             curval != NULL;
-             curval = val_get_next_child(curval)) {
-
-            /* check same type of sibling cornercase
-             * should only happen if the child is
-             * type list or leaf-list
-             */
-            if (newobj == curval->obj) {
-                /* make a new sorted or last one of these entries */
-                boolean syssorted = ncx_get_system_sorted();
-                boolean done = FALSE;
-
-                while (!done) {
-                    if (sysorder && syssorted) {
-                        if (newobj->objtype == OBJ_TYP_LIST) {
-                            ret = val_index_compare(child, curval);
-                        } else {
-                            ret = val_compare(child, curval);
-                        }
-                        if (ret < 0) {
-                            dlq_insertAhead(child, curval);
-                            return;
-                        }
-                    }
-                    val_value_t *nextchild = val_get_next_child(curval);
-                    if (nextchild == NULL || nextchild->obj != child->obj) {
-                        done = TRUE;
-                    } else {
-                        curval = nextchild;
-                    }
-                }
-                dlq_insertAfter(child, curval);
-                return;
-            }
-
-            ret = xml_strcmp(child->name, curval->name);
-            if (ret < 0) {
-                dlq_insertAhead(child, curval);
-                return;
-            } else if (ret == 0) {
-                ret = xml_strcmp(val_get_mod_name(child),
-                                 val_get_mod_name(curval));
-                if (ret < 0) {
-                    dlq_insertAhead(child, curval);
-                    return;
-                    /* same name, insert in module alphabetical order */
-                }
-            }
-        }
-
-        /* make new last entry */
-        dlq_enque(child, childQ);
-    } else if (parent->obj->objtype == OBJ_TYP_ANYXML) {
-        /* there is no schema order to check, so see if this
-         * child already exists
-         */
-        curval = val_find_child(parent, val_get_mod_name(child), child->name);
-        if (curval != NULL) {
-            /* make new last instance of this child node */
-            val_value_t *saveval = NULL;
-            while (curval != NULL) {
-                saveval = curval;
-                curval = val_find_next_child(parent, val_get_mod_name(child),
-                                             child->name, curval);
-            }
-            dlq_insertAfter(child, saveval);
-        } else {
-            /* make new last child; first one of these */
-            dlq_enque(child, childQ);
-        }
-    } else {
-        /* normal container or list */
-        for (curval = val_get_first_child(parent);
-             curval != NULL;
-             curval = val_get_next_child(curval)) {
-
-            /* check same type of sibling cornercase
-             * should only happen if the child is
-             * type list or leaf-list
-             */
-            if (newobj == curval->obj) {
-                /* make a new last one of these entries */
-                boolean syssorted = ncx_get_system_sorted();
-                boolean done = FALSE;
-
-                while (!done) {
-                    if (sysorder && syssorted) {
-                        if (newobj->objtype == OBJ_TYP_LIST) {
-                            ret = val_index_compare(child, curval);
-                        } else {
-                            ret = val_compare(child, curval);
-                        }
-                        if (ret < 0) {
-                            dlq_insertAhead(child, curval);
-                            return;
-                        }
-                    }
+#ifdef DEBUG
+    if (child == NULL || parent == NULL) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
 
-                    val_value_t *nextchild = val_get_next_child(curval);
-                    if (nextchild == NULL || nextchild->obj != child->obj) {
-                        done = TRUE;
-                    } else {
-                        curval = nextchild;
-                    }              
-                }
+    child->parent = parent;
+    dlq_enque(child, &parent->v.childQ);
+    childidx_add(parent, child);
 
-                /* make a new last instance of this node type */
-                dlq_insertAfter(child, curval);
-                return;
-            }
+}   /* val_add_child */
 
-            /* simple test; since native children
-             * will be before external augmented children;
-             * any native node will insert ahead of such 
-             * an augment node
-             */
-            if (val_get_nsid(curval) != parentid && childid == parentid) {
-                dlq_insertAhead(child, curval);
-                return;
-            }
 
-            /* new node and current node are different so
-             * check if the current object is after the
-             * new object in the schema order.  If so,
-             * then insert ahead of this node
-             *
-             * the object siblings are not numbered, so
-             * a linear search is used here
-             */
-            obj_template_t *testobj = obj_next_child_deep(child->obj);
-            for (; testobj != NULL; testobj = obj_next_child_deep(testobj)) {
-                if (testobj == curval->obj) {
-                    /* insert child ahead of this node
-                     * which occurs after it in schema order
-                     */
-                    dlq_insertAhead(child, curval);
-                    return;
-                }
-            }
-        }
+/********************************************************************
+* FUNCTION val_add_child_sorted
+* 
+*   Add a child value node to a parent value node
+*   in the proper place
+*
+* INPUTS:
+*    child == node to store in the parent
+*    parent == complex value node with a childQ
+*
+*********************************************************************/
+void
+    val_add_child_sorted (val_value_t *child,
+                          val_value_t *parent)
+{
+    assert( child && "child is NULL!" );
+    assert( parent && "parent is NULL!" );
 
-        /* make a new last entry */
-        dlq_enque(child, childQ);
+    child->parent = parent;
+
+    uint32 steps = insert_child_sorted(child, parent);
+    if (parent->childidx) {
+        childidx_add(parent, child);
+    } else {
+        childidx_check_build(parent, steps);
     }
 
 }   /* val_add_child_sorted */
@@ -5634,6 +6875,7 @@ void
     child->parent = parent;
     if (current) {
         dlq_insertAfter(child, current);
+        childidx_add(parent, child);
     } else {
         val_add_child_sorted(child, parent);
     }
@@ -5660,6 +6902,9 @@ void
     }
 #endif
 
+    if (child->parent) {
+        childidx_remove(child->parent, child);
+    }
     dlq_remove(child);
     child->parent = NULL;
 
@@ -5687,16 +6932,51 @@ void
     }
 #endif
 
-    newchild->parent = curchild->parent;
+    val_value_t *parent = curchild->parent;
+    if (parent) {
+        childidx_remove(parent, curchild);
+    }
+
+    newchild->parent = parent;
     newchild->getcb = curchild->getcb;
+    newchild->flags |= (curchild->flags & VAL_FL_STREAMCB);
 
     dlq_swap(newchild, curchild);
 
     curchild->parent = NULL;
 
+    if (parent) {
+        childidx_add(parent, newchild);
+    }
+
 }   /* val_swap_child */
 
 
+/********************************************************************
+* FUNCTION val_clear_child_index
+* 
+*   Discard the child lookup index of a complex value node
+*   Must be called after the childQ is changed without
+*   using the val_add_child or val_remove_child functions
+*   The index will be rebuilt later if needed
+*
+* INPUTS:
+*    val == complex value node to clear
+*
+*********************************************************************/
+void
+    val_clear_child_index (val_value_t *val)
+{
+    assert( val && "val is NULL!" );
+
+    if (val->childidx) {
+        childidx_free(val->childidx);
+        val->childidx = NULL;
+    }
+
+}   /* val_clear_child_index */
+
+
 /********************************************************************
 * FUNCTION val_first_child_match
 * 
@@ -5714,6 +6994,7 @@ val_value_t *
                            val_value_t *child)
 {
     val_value_t *val;
+    uint32       steps = 0;
 
 #ifdef DEBUG
     if (!parent || !child) {
@@ -5726,44 +7007,30 @@ val_value_t *
         return NULL;
     }
 
-    for (val = (val_value_t *)dlq_firstEntry(&parent->v.childQ);
-         val != NULL;
-         val = (val_value_t *)dlq_nextEntry(val)) {
-
-        if (VAL_IS_DELETED(val)) {
-            continue;
+    if (parent->childidx && child->name) {
+        val_childgrp_t *grp = 
+            childidx_find_group(parent->childidx, child->nsid, child->name);
+        if (grp == NULL) {
+            return NULL;
         }
+        if (grp->first->btyp == NCX_BT_LIST &&
+            childidx_match_list(grp, child, &val)) {
+            return val;
+        }
+        val = grp->first;
+    } else {
+        val = (val_value_t *)dlq_firstEntry(&parent->v.childQ);
+    }
 
-        /* check the node if the QName matches */
-        if (val->nsid == child->nsid &&
-            !xml_strcmp(val->name, child->name)) {
-
-            if (val->btyp == NCX_BT_LIST) {
-                /* match the instance identifiers, if any */
-                if (val_index_match(child, val)) {
-                    return val;
-                }
-            } else if (val->obj->objtype == OBJ_TYP_LEAF_LIST) {
-                if (val->btyp == child->btyp) {
-                    /* find the leaf-list with the same value */
-                    if (!val_compare(val, child)) {
-                        return val;
-                    }
-                } else {
-                    /* match any value; if this is a subtree
-                     * filter test, it is not for a content match
-                     * node
-                     */
-                    return val;
-                }
-            } else {
-                /* can only be this one instance */
-                return val;
-            }
+    for (; val != NULL; val = (val_value_t *)dlq_nextEntry(val)) {
+        steps++;
+        if (child_match(val, child)) {
+            break;
         }
     }
 
-    return NULL;
+    childidx_check_build(parent, steps);
+    return val;
 
 }  /* val_first_child_match */
 
@@ -5799,40 +7066,25 @@ val_value_t *
         return NULL;
     }
 
+    if (parent->childidx && child->name) {
+        val_childgrp_t *grp = 
+            childidx_find_group(parent->childidx, child->nsid, child->name);
+        if (grp == NULL || curmatch == grp->last) {
+            return NULL;
+        }
+        if (grp->first->btyp == NCX_BT_LIST &&
+            childidx_match_list(grp, child, &val) &&
+            (val == NULL || val == curmatch)) {
+            /* no other instance has the same keys */
+            return NULL;
+        }
+    }
+
     for (val = (val_value_t *)dlq_nextEntry(curmatch);
          val != NULL;
          val = (val_value_t *)dlq_nextEntry(val)) {
-
-        if (VAL_IS_DELETED(val)) {
-            continue;
-        }
-
-        /* check the node if the QName matches */
-        if (val->nsid == child->nsid &&
-            !xml_strcmp(val->name, child->name)) {
-
-            if (val->btyp == NCX_BT_LIST) {
-                /* match the instance identifiers, if any */
-                if (val_index_match(child, val)) {
-                    return val;
-                }
-            } else if (val->obj->objtype == OBJ_TYP_LEAF_LIST) {
-                if (val->btyp == child->btyp) {
-                    /* find the leaf-list with the same value */
-                    if (!val_compare(val, child)) {
-                        return val;
-                    }
-                } else {
-                    /* match any value; if this is a subtree
-                     * filter test, it is not for a content match
-                     * node
-                     */
-                    return val;
-                }
-            } else {
-                /* can only be this one instance */
-                return val;
-            }
+        if (child_match(val, child)) {
+            return val;
         }
     }
 
@@ -5936,7 +7188,8 @@ val_value_t *
                     const xmlChar *modname,
                     const xmlChar *childname)
 {
-    val_value_t *val;
+    val_value_t *val = NULL;
+    uint32       steps = 0;
 
 #ifdef DEBUG
     if (!parent || !childname) {
@@ -5949,9 +7202,23 @@ val_value_t *
         return NULL;
     }
 
-    for (val = (val_value_t *)dlq_firstEntry(&parent->v.childQ);
-         val != NULL;
-         val = (val_value_t *)dlq_nextEntry(val)) {
+    if (parent->childidx) {
+        boolean multiple = FALSE;
+        val_childgrp_t *grp = childidx_find_name(parent->childidx, modname,
+                                                 childname, &multiple);
+        if (grp) {
+            /* no match before the first instance in the group */
+            val = grp->first;
+        } else if (!multiple) {
+            return NULL;
+        }
+    }
+    if (val == NULL) {
+        val = (val_value_t *)dlq_firstEntry(&parent->v.childQ);
+    }
+
+    for (; val != NULL; val = (val_value_t *)dlq_nextEntry(val)) {
+        steps++;
         if (VAL_IS_DELETED(val)) {
             continue;
         }
@@ -5961,10 +7228,12 @@ val_value_t *
             continue;
         }
         if (!xml_strcmp(val->name, childname)) {
-            return val;
+            break;
         }
     }
-    return NULL;
+
+    childidx_check_build(parent, steps);
+    return val;
 
 }  /* val_find_child */
 
@@ -6116,6 +7385,17 @@ val_value_t *
         return NULL;
     }
 
+    if (parent->childidx && curchild->name &&
+        !xml_strcmp(curchild->name, childname)) {
+        boolean multiple = FALSE;
+        val_childgrp_t *grp = childidx_find_name(parent->childidx, modname,
+                                                 childname, &multiple);
+        if (grp && curchild == grp->last) {
+            /* no match after the last instance in the group */
+            return NULL;
+        }
+    }
+
     for (val = (val_value_t *)dlq_nextEntry(curchild);
          val != NULL;
          val = (val_value_t *)dlq_nextEntry(val)) {
@@ -8843,7 +10123,8 @@ boolean
     case NCX_BT_LIST:
     case NCX_BT_CHOICE:
     case NCX_BT_CASE:
-        return dlq_empty(&val->v.childQ);
+        /* streaming virtual entries are not in the childQ */
+        return dlq_empty(&val->v.childQ) && !val_is_virtual_stream(val);
     case NCX_BT_EXTERN:
     case NCX_BT_INTERN:
         /* just put these on a new line; rare usage at this time */
@@ -9056,6 +10337,191 @@ val_value_t *
 }  /* val_get_virtual_value */
 
 
+/********************************************************************
+* FUNCTION val_is_virtual_stream
+* 
+* Check if the specified value is a virtual value
+* that returns its child entries one at a time
+* 
+* INPUTS:
+*   val == value to check
+*   
+* RETURNS:
+*   TRUE if the val is a streaming virtual value
+*   FALSE otherwise
+*********************************************************************/
+boolean
+    val_is_virtual_stream (const val_value_t *val)
+{
+#ifdef DEBUG
+    if (!val) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return FALSE;
+    }
+#endif
+
+    return (val->getcb && (val->flags & VAL_FL_STREAMCB)) ? TRUE : FALSE;
+
+}  /* val_is_virtual_stream */
+
+
+/********************************************************************
+* FUNCTION val_get_next_virtual_entry
+* 
+* Get the next child entry of a streaming virtual value
+* The entry is not added to the val->v.childQ and
+* not cached; only its parent pointer is set to val
+*
+* Call val_finish_virtual_entries when done, even if
+* the iteration is stopped early
+*
+* INPUTS:
+*   session == session CB ptr cast as void *
+*              that is getting the virtual value
+*   val == streaming virtual value to get the entry for
+*   cursor == address of iteration state; set *cursor to NULL
+*             before the first call
+*   res == pointer to output function return status value
+*
+* OUTPUTS:
+*    *cursor updated by the callback
+*    *res == the function return status
+*
+* RETURNS:
+*   malloced child entry; must be freed by the caller
+*   NULL if no more entries or some error
+*********************************************************************/
+val_value_t *
+    val_get_next_virtual_entry (void *session,
+                                val_value_t *val,
+                                void **cursor,
+                                status_t *res)
+{
+    getcb_stream_fn_t  getcb;
+    val_value_t       *entry;
+
+#ifdef DEBUG
+    if (!val || !cursor || !res) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return NULL;
+    }
+#endif
+
+    if (!val_is_virtual_stream(val)) {
+        *res = SET_ERROR(ERR_INTERNAL_VAL);
+        return NULL;
+    }
+
+    getcb = (getcb_stream_fn_t)val->getcb;
+    entry = NULL;
+    *res = (*getcb)((ses_cb_t *)session, GETCB_GET_NEXT, val, 
+                    cursor, &entry);
+    if (*res != NO_ERR) {
+        if (entry) {
+            val_free_value(entry);
+        }
+        if (*res == ERR_NCX_SKIPPED) {
+            *res = NO_ERR;
+        }
+        return NULL;
+    }
+
+    if (entry) {
+        entry->parent = val;
+    }
+    return entry;
+
+}  /* val_get_next_virtual_entry */
+
+
+/********************************************************************
+* FUNCTION val_finish_virtual_entries
+* 
+* End an iteration started with val_get_next_virtual_entry
+* 
+* INPUTS:
+*   session == session CB ptr cast as void *
+*              that is getting the virtual value
+*   val == streaming virtual value being iterated
+*   cursor == address of iteration state
+*
+* OUTPUTS:
+*    *cursor set to NULL
+*********************************************************************/
+void
+    val_finish_virtual_entries (void *session,
+                                val_value_t *val,
+                                void **cursor)
+{
+    getcb_stream_fn_t  getcb;
+    val_value_t       *entry;
+
+#ifdef DEBUG
+    if (!val || !cursor) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
+
+    if (val_is_virtual_stream(val)) {
+        getcb = (getcb_stream_fn_t)val->getcb;
+        entry = NULL;
+        (void)(*getcb)((ses_cb_t *)session, GETCB_GET_DONE, val,
+                       cursor, &entry);
+        if (entry) {
+            val_free_value(entry);
+        }
+    }
+    *cursor = NULL;
+
+}  /* val_finish_virtual_entries */
+
+
+/********************************************************************
+* FUNCTION val_refresh_virtual_values
+* 
+* Refresh all the cached virtual values that were returned
+* stale to a session during their stale timeout
+* (see ncx:cache-stale-timeout and obj_set_cache_timeout)
+*
+* Called by the server outside of any request processing
+*********************************************************************/
+void
+    val_refresh_virtual_values (void)
+{
+    val_vrefresh_t *vrefresh;
+    val_value_t    *val, *newval;
+    status_t        res;
+
+    while (vrefresh_list != NULL) {
+        vrefresh = vrefresh_list;
+        vrefresh_list = vrefresh->next;
+        val = vrefresh->val;
+        m__free(vrefresh);
+        val->flags &= ~VAL_FL_VREFRESH;
+
+        res = NO_ERR;
+        newval = new_virtual_value(val, &res);
+        if (newval == NULL) {
+            /* keep the stale value until it expires */
+            if (LOGDEBUG2) {
+                log_debug2("\nval: refresh virtual val %s failed (%s)",
+                           val->name,
+                           get_error_string(res));
+            }
+            continue;
+        }
+
+        if (val->virtualval) {
+            val_free_value(val->virtualval);
+        }
+        val->virtualval = newval;
+        (void)uptime(&val->cachetime);
+    }
+
+}  /* val_refresh_virtual_values */
+
+
 /********************************************************************
 * FUNCTION val_is_default
 * 
@@ -9912,6 +11378,9 @@ void
     }
 #endif
 
+    if (val->parent && val->nsid != nsid) {
+        val_clear_child_index(val->parent);
+    }
     val->nsid = nsid;
 
     for (child = val_get_first_child(val);
@@ -10280,6 +11749,8 @@ void
 
     /* move all the entries at once */
     dlq_block_enque(&srcval->v.childQ, &destval->v.childQ);
+    val_clear_child_index(srcval);
+    val_clear_child_index(destval);
 
 }  /* val_move_children */
 
@@ -10706,6 +12177,10 @@ void
         if (valin->val == keyval) {
             dlq_remove(valin);
             m__free(valin);
+            if (parent->parent) {
+                /* the list entry key tuple is changed */
+                val_clear_child_index(parent->parent);
+            }
             return;
         }
     }
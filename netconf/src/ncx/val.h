@@ -179,6 +179,16 @@ extern "C" {
  */
 #define VAL_FL_SUBTREE_DIRTY bit10
 
+/* if set, the getcb is really a getcb_stream_fn_t that returns
+ * the child entries of this virtual node one at a time
+ */
+#define VAL_FL_STREAMCB  bit11
+
+/* if set, a stale virtualval was returned and this node is
+ * waiting for val_refresh_virtual_values
+ */
+#define VAL_FL_VREFRESH  bit12
+
 /* set the virtualval lifetime to 3 seconds */
 #define VAL_VIRTUAL_CACHE_TIME   3
 
@@ -340,6 +350,14 @@ typedef struct val_value_t_ {
     struct val_index_t_ *index;   /* back-ptr/flag in use as index */
     dlq_hdr_t       indexQ;    /* Q of val_index_t or ncx_filptr_t */
 
+    /* optional lookup index for the childQ of a complex node;
+     * built on demand by the val_find_child family of functions
+     * once a parent has many child nodes, and maintained by the
+     * val_add_child family of functions.  Any code that edits
+     * the childQ directly must call val_clear_child_index
+     */
+    struct val_childidx_t_ *childidx;
+
     /* this field is used for NCX_BT_CHOICE 
      * If set, the object path for this node is really:
      *    $this --> casobj --> casobj.parent --> $this.parent
@@ -517,6 +535,26 @@ extern void
 		      struct obj_template_t_ *obj);
 
 
+/********************************************************************
+* FUNCTION val_init_virtual_stream
+* 
+* Special function to initialize a virtual complex value node
+* which returns its child entries one at a time
+*
+* MUST CALL val_new_value FIRST
+*
+* INPUTS:
+*   val == pointer to the malloced struct to initialize
+*   cbfn == streaming get callback function to use
+*           (really getcb_stream_fn_t)
+*   obj == object template to use; must have child nodes
+*********************************************************************/
+extern void
+    val_init_virtual_stream (val_value_t *val,
+			     void *cbfn,
+			     struct obj_template_t_ *obj);
+
+
 /********************************************************************
 * FUNCTION val_init_from_template
 * 
@@ -1793,6 +1831,22 @@ extern void
 		    val_value_t *curchild);
 
 
+/********************************************************************
+* FUNCTION val_clear_child_index
+* 
+*   Discard the child lookup index of a complex value node
+*   Must be called after the childQ is changed without
+*   using the val_add_child or val_remove_child functions
+*   The index will be rebuilt later if needed
+*
+* INPUTS:
+*    val == complex value node to clear
+*
+*********************************************************************/
+extern void
+    val_clear_child_index (val_value_t *val);
+
+
 /********************************************************************
 * FUNCTION val_first_child_match
 * 
@@ -2979,6 +3033,89 @@ extern val_value_t *
 			   status_t *res);
 
 
+/********************************************************************
+* FUNCTION val_is_virtual_stream
+* 
+* Check if the specified value is a virtual value
+* that returns its child entries one at a time
+* 
+* INPUTS:
+*   val == value to check
+*   
+* RETURNS:
+*   TRUE if the val is a streaming virtual value
+*   FALSE otherwise
+*********************************************************************/
+extern boolean
+    val_is_virtual_stream (const val_value_t *val);
+
+
+/********************************************************************
+* FUNCTION val_get_next_virtual_entry
+* 
+* Get the next child entry of a streaming virtual value
+* The entry is not added to the val->v.childQ and
+* not cached; only its parent pointer is set to val
+*
+* Call val_finish_virtual_entries when done, even if
+* the iteration is stopped early
+*
+* INPUTS:
+*   session == session CB ptr cast as void *
+*              that is getting the virtual value
+*   val == streaming virtual value to get the entry for
+*   cursor == address of iteration state; set *cursor to NULL
+*             before the first call
+*   res == pointer to output function return status value
+*
+* OUTPUTS:
+*    *cursor updated by the callback
+*    *res == the function return status
+*
+* RETURNS:
+*   malloced child entry; must be freed by the caller
+*   NULL if no more entries or some error
+*********************************************************************/
+extern val_value_t *
+    val_get_next_virtual_entry (void *session,  /* really ses_cb_t * */
+				val_value_t *val,
+				void **cursor,
+				status_t *res);
+
+
+/********************************************************************
+* FUNCTION val_finish_virtual_entries
+* 
+* End an iteration started with val_get_next_virtual_entry
+* 
+* INPUTS:
+*   session == session CB ptr cast as void *
+*              that is getting the virtual value
+*   val == streaming virtual value being iterated
+*   cursor == address of iteration state
+*
+* OUTPUTS:
+*    *cursor set to NULL
+*********************************************************************/
+extern void
+    val_finish_virtual_entries (void *session,  /* really ses_cb_t * */
+				val_value_t *val,
+				void **cursor);
+
+
+/********************************************************************
+* FUNCTION val_refresh_virtual_values
+* 
+* Refresh all the cached virtual values that were returned
+* stale to a session during their stale timeout
+* (see ncx:cache-stale-timeout and obj_set_cache_timeout)
+*
+* Called by the server outside of any request processing
+*********************************************************************/
+extern void
+    val_refresh_virtual_values (void);
+
+
 /********************************************************************
 * FUNCTION val_is_default
 * 
@@ -64,6 +64,18 @@ date         init     comment
 *********************************************************************/
 /* #define VAL_UTIL_DEBUG_CANONICAL 1 */
 
+/********************************************************************
+*                                                                   *
+*                          T Y P E S                                *
+*                                                                   *
+*********************************************************************/
+
+/* one instance to sort in add_sorted_instances */
+typedef struct sortrec_t_ {
+    val_value_t  *val;
+    uint32        pos;
+} sortrec_t;
+
 /********************************************************************
 * FUNCTION new_index
 * 
@@ -854,6 +866,150 @@ static status_t
 } /* check_when_stmt */
 
 
+/********************************************************************
+* FUNCTION is_instance
+* 
+* Check if a node in the tempQ is an instance of the
+* specified object, the same way val_find_child_que does
+*
+* INPUTS:
+*   chval == child node to check
+*   modname == module name of the object
+*   name == name of the object
+*
+* RETURNS:
+*   TRUE if chval is an instance
+*********************************************************************/
+static boolean
+    is_instance (const val_value_t *chval,
+                 const xmlChar *modname,
+                 const xmlChar *name)
+{
+    if (VAL_IS_DELETED(chval)) {
+        return FALSE;
+    }
+    if (xml_strcmp(modname, val_get_mod_name(chval))) {
+        return FALSE;
+    }
+    return (xml_strcmp(name, chval->name)) ? FALSE : TRUE;
+
+}  /* is_instance */
+
+
+/********************************************************************
+* FUNCTION compare_sortrecs
+* 
+* qsort compare function for add_sorted_instances
+* Instances that compare equal keep their original order
+*
+* INPUTS:
+*   p1 == pointer to first sortrec_t
+*   p2 == pointer to second sortrec_t
+*
+* RETURNS:
+*   compare result
+*********************************************************************/
+static int
+    compare_sortrecs (const void *p1,
+                      const void *p2)
+{
+    const sortrec_t *rec1 = (const sortrec_t *)p1;
+    const sortrec_t *rec2 = (const sortrec_t *)p2;
+    int ret;
+
+    if (rec1->val->obj->objtype == OBJ_TYP_LIST) {
+        ret = val_index_compare(rec1->val, rec2->val);
+    } else {
+        ret = val_compare(rec1->val, rec2->val);
+    }
+    if (ret < 0) {
+        return -1;
+    } else if (ret > 0) {
+        return 1;
+    }
+    return (rec1->pos < rec2->pos) ? -1 : 1;
+
+}  /* compare_sortrecs */
+
+
+/********************************************************************
+* FUNCTION add_sorted_instances
+* 
+* Move all the instances of a system-ordered list or leaf-list
+* from the tempQ to the parent node, in sorted order
+* Sorting them all at once avoids one val_add_child_sorted
+* search of the siblings for each instance
+*
+* INPUTS:
+*   val == parent value node to add the instances to
+*   tempQ == Q of child nodes taken from val
+*   chobj == list or leaf-list object to move
+*
+* RETURNS:
+*   TRUE if the instances were moved
+*   FALSE if not enough memory; nothing done
+*********************************************************************/
+static boolean
+    add_sorted_instances (val_value_t *val,
+                          dlq_hdr_t *tempQ,
+                          obj_template_t *chobj)
+{
+    const xmlChar *modname = obj_get_mod_name(chobj);
+    const xmlChar *name = obj_get_name(chobj);
+    val_value_t   *chval, *prevval;
+    sortrec_t     *recs;
+    uint32         cnt = 0, i;
+
+    for (chval = (val_value_t *)dlq_firstEntry(tempQ);
+         chval != NULL;
+         chval = (val_value_t *)dlq_nextEntry(chval)) {
+        if (is_instance(chval, modname, name)) {
+            cnt++;
+        }
+    }
+    if (cnt == 0) {
+        return TRUE;
+    }
+
+    recs = (sortrec_t *)m__getMem(cnt * sizeof(sortrec_t));
+    if (recs == NULL) {
+        return FALSE;
+    }
+
+    i = 0;
+    for (chval = (val_value_t *)dlq_firstEntry(tempQ);
+         chval != NULL;
+         chval = (val_value_t *)dlq_nextEntry(chval)) {
+        if (is_instance(chval, modname, name)) {
+            recs[i].val = chval;
+            recs[i].pos = i;
+            i++;
+        }
+    }
+
+    qsort(recs, cnt, sizeof(sortrec_t), compare_sortrecs);
+
+    prevval = NULL;
+    for (i = 0; i < cnt; i++) {
+        chval = recs[i].val;
+        dlq_remove(chval);
+        if (prevval) {
+            val_insert_child(chval, prevval, val);
+        } else {
+            val_add_child_sorted(chval, val);
+        }
+        if (chobj->objtype == OBJ_TYP_LIST) {
+            val_set_canonical_order(chval);
+        }
+        prevval = chval;
+    }
+
+    m__free(recs);
+    return TRUE;
+
+}  /* add_sorted_instances */
+
+
 /*************** E X T E R N A L    F U N C T I O N S  *************/
 
 
@@ -956,6 +1112,7 @@ void
     /* transfer all the val->childQ nodes to the tempQ */
     dlq_createSQue(&tempQ);
     dlq_block_enque(&val->v.childQ, &tempQ);
+    val_clear_child_index(val);
 
     switch (val->obj->objtype) {
     case OBJ_TYP_LEAF:
@@ -1004,6 +1161,13 @@ void
                 continue;
             }
 
+            if ((chobj->objtype == OBJ_TYP_LIST ||
+                 chobj->objtype == OBJ_TYP_LEAF_LIST) &&
+                obj_is_system_ordered(chobj) && ncx_get_system_sorted() &&
+                add_sorted_instances(val, &tempQ, chobj)) {
+                continue;
+            }
+
             chval = val_find_child_que(&tempQ, obj_get_mod_name(chobj),
                                        obj_get_name(chobj));
             while (chval) {
@@ -1038,6 +1202,7 @@ void
                       " to end of childQ for val %s",
                       dlq_count(&tempQ), val->name);
             dlq_block_enque(&tempQ, &val->v.childQ);
+            val_clear_child_index(val);
         }
 
         break;
@@ -3331,6 +3496,8 @@ void
 * Get the value node for output to a session
 * Checks access control if enabled
 * Checks filtering via testfn if non-NULL
+* A streaming virtual value is returned as-is; the caller
+* must use val_get_next_virtual_entry to get its child entries
 *
 * INPUTS:
 *   scb == session control block
@@ -3389,7 +3556,10 @@ val_value_t *
         }
     }
                                    
-    if (val_is_virtual(val)) {
+    /* a streaming virtual value is returned as-is; the writer
+     * gets its child entries one at a time
+     */
+    if (val_is_virtual(val) && !val_is_virtual_stream(val)) {
         v_val = val_get_virtual_value(scb, val, res);
         if (!v_val) {
             return NULL;
@@ -934,6 +934,8 @@ extern void
 * Get the value node for output to a session
 * Checks access control if enabled
 * Checks filtering via testfn if non-NULL
+* A streaming virtual value is returned as-is; the caller
+* must use val_get_next_virtual_entry to get its child entries
 *
 * INPUTS:
 *   scb == session control block
@@ -373,6 +373,43 @@ status_t
 } /* xml_get_reader_from_filespec */
 
 
+/********************************************************************
+* FUNCTION xml_get_reader_from_buffer
+* 
+* Get a new xmlTextReader for parsing an XML document
+* that is already in memory
+*
+* INPUTS:
+*   buff == buffer holding the XML instance document to parse;
+*           must stay valid until the reader is freed
+*   bufflen == number of bytes in buff
+* OUTPUTS:
+*   *reader == pointer to new reader or NULL if some error
+*
+* RETURNS:
+*   status of the operation
+*********************************************************************/
+status_t
+    xml_get_reader_from_buffer (const char *buff,
+                                int bufflen,
+                                xmlTextReaderPtr  *reader)
+{
+#ifdef DEBUG
+    if (!buff || !reader) {
+        return SET_ERROR(ERR_INTERNAL_PTR);
+    } 
+#endif
+
+    *reader = xmlReaderForMemory(buff, bufflen, NULL, NULL,
+                                 XML_READER_OPTIONS);
+    if (*reader==NULL) {
+        return ERR_XML_READER_START_FAILED;
+    }
+    return NO_ERR;
+
+} /* xml_get_reader_from_buffer */
+
+
 /********************************************************************
 * FUNCTION xml_get_reader_for_session
 * 
@@ -821,6 +821,41 @@ static void write_child_values( ses_cb_t *scb,
     } 
 }
 
+/******************************************************************************/
+/**
+ * Write out the child entries of a streaming virtual value.
+ * Each entry is written and freed before the next one is requested,
+ * so the virtual subtree is never held in memory as a whole.
+ * 
+ * \param scb the session control block.
+ * \param msg the message (xml_msg_hdr_t) being processed.
+ * \param out the streaming virtual value to write.
+ * \param indent the start indent amount if indent is enabled.
+*  \param testfn callback function to use, NULL if not used
+ */
+static void write_stream_child_values( ses_cb_t *scb,
+                                       xml_msg_hdr_t *msg,
+                                       val_value_t *out,
+                                       int32 indent,
+                                       val_nodetest_fn_t testfn )
+{
+    val_value_t  *chval;
+    void         *cursor = NULL;
+    status_t      res = NO_ERR;
+
+    while ((chval = val_get_next_virtual_entry(scb, out, 
+                                               &cursor, &res)) != NULL) {
+        xml_wr_full_check_val( scb, msg, chval, indent, testfn );
+        val_free_value(chval);
+    }
+    val_finish_virtual_entries(scb, out, &cursor);
+
+    if (res != NO_ERR) {
+        log_error("\nError: get entries for virtual node '%s' failed (%s)",
+                  out->name, get_error_string(res));
+    }
+}
+
 /********************************************************************
 * FUNCTION write_check_val
 * 
@@ -936,7 +971,11 @@ static void write_check_val ( ses_cb_t *scb,
     case NCX_BT_LIST:
     case NCX_BT_CHOICE:
     case NCX_BT_CASE:
-        write_child_values( scb, msg, out, indent, testfn );
+        if (val_is_virtual_stream(out)) {
+            write_stream_child_values( scb, msg, out, indent, testfn );
+        } else {
+            write_child_values( scb, msg, out, indent, testfn );
+        }
         break;
     default:
         SET_ERROR(ERR_INTERNAL_VAL);
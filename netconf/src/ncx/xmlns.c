@@ -37,6 +37,10 @@ date         init     comment
 #include  "procdefs.h"
 #endif
 
+#ifndef _H_bobhash
+#include  "bobhash.h"
+#endif
+
 #ifndef _H_def_reg
 #include  "def_reg.h"
 #endif
@@ -78,11 +82,19 @@ date         init     comment
 *                       C O N S T A N T S                           *
 *                                                                   *
 *********************************************************************/
-/* max registered namespaces/modules in the database
- * increase to allow more modules loaded at once
- * (this is an arbitrary limit)
+/* initial size of the namespace table; it is doubled
+ * each time it is full, so there is no fixed limit on
+ * the number of registered namespaces/modules
  */
-#define XMLNS_MAX_NS   4096
+#define XMLNS_INIT_NS   256
+
+/* number of buckets in each namespace lookup hash table */
+#define XMLNS_HASH_BITS  10
+#define XMLNS_HASH_SIZE  (hashsize(XMLNS_HASH_BITS))
+#define XMLNS_HASH_MASK  (hashmask(XMLNS_HASH_BITS))
+
+/* random number to seed the hash function */
+#define XMLNS_HASH_INIT  0x3c6ef372
 
 #ifdef DEBUG
 #define XMLNS_DEBUG 1
@@ -94,6 +106,25 @@ date         init     comment
 *                                                                   *
 *********************************************************************/
 
+/* keys used to look up a namespace entry */
+typedef enum xmlns_key_t_ {
+    XMLNS_KEY_NAME,            /* namespace URI */
+    XMLNS_KEY_PFIX,            /* namespace prefix */
+    XMLNS_KEY_MOD,             /* module name */
+    XMLNS_NUM_KEYS
+} xmlns_key_t;
+
+
+/* one entry in the namespace table, indexed by NS ID - 1
+ * Each entry is in 1 hash chain for each key.  The chains
+ * are kept in NS ID order, so the first entry registered
+ * with a prefix or module name is found first.
+ */
+typedef struct xmlns_entry_t_ {
+    xmlns_t     *rec;
+    xmlns_id_t   next[XMLNS_NUM_KEYS];   /* next NS ID in chain */
+} xmlns_entry_t;
+
 
 /********************************************************************
 *                                                                   *
@@ -141,8 +172,14 @@ static xmlns_id_t xmlns_wdaid;
 /* next ID to allocate */
 static xmlns_id_t xmlns_next_id;
 
-/* array of xmlns_t pointers */
-static xmlns_t   *xmlns[XMLNS_MAX_NS];
+/* malloced array of xmlns_tabsize namespace entries */
+static xmlns_entry_t *xmlns;
+
+/* number of entries allocated in the xmlns array */
+static uint32 xmlns_tabsize;
+
+/* first NS ID in each hash chain for each key */
+static xmlns_id_t xmlns_hashtab[XMLNS_NUM_KEYS][XMLNS_HASH_SIZE];
 
 /* module init done flag */
 static boolean xmlns_init_done = FALSE;
@@ -162,8 +199,14 @@ static boolean xmlns_init_done = FALSE;
  * RETURN
  *   zero if not valid, non-zero if valid
  */
-#define valid_id(I) ((I)&&((I)<=XMLNS_MAX_NS)&&(xmlns[(I)-1]) && \
-                     (xmlns[(I)-1]->ns_id==(I)))
+#define valid_id(I) ((I)&&((I)<xmlns_next_id)&&(xmlns[(I)-1].rec) && \
+                     (xmlns[(I)-1].rec->ns_id==(I)))
+
+/* MACRO get_rec
+ *
+ * get the xmlns_t for a valid ns_id (I)
+ */
+#define get_rec(I) (xmlns[(I)-1].rec)
 
 
 
@@ -216,6 +259,117 @@ static void
 }  /* free_xmlns */
 
 
+/********************************************************************
+* FUNCTION hash_str
+* 
+* Get the hash bucket for a counted string
+*
+* INPUTS:
+*    str == string to hash
+*    len == length of str
+*
+* RETURNS:
+*    hash table index
+*********************************************************************/
+static uint32
+    hash_str (const xmlChar *str,
+              uint32 len)
+{
+    return (uint32)bobhash((const ub1 *)str, len, XMLNS_HASH_INIT) &
+        XMLNS_HASH_MASK;
+
+}  /* hash_str */
+
+
+/********************************************************************
+* FUNCTION first_in_chain
+* 
+* Get the first NS ID in the hash chain for a key string
+*
+* INPUTS:
+*    key == lookup key of the hash chain
+*    str == key string to find
+*    len == length of str
+*
+* RETURNS:
+*    first NS ID in the chain or XMLNS_NULL_NS_ID if empty
+*********************************************************************/
+static xmlns_id_t
+    first_in_chain (xmlns_key_t key,
+                    const xmlChar *str,
+                    uint32 len)
+{
+    return xmlns_hashtab[key][hash_str(str, len)];
+
+}  /* first_in_chain */
+
+
+/********************************************************************
+* FUNCTION add_hash_chain
+* 
+* Add a new NS ID to the end of a hash chain
+*
+* INPUTS:
+*    key == lookup key of the hash chain
+*    str == key string of the new entry
+*    ns_id == new NS ID, higher than any ID in the chain
+*********************************************************************/
+static void
+    add_hash_chain (xmlns_key_t key,
+                    const xmlChar *str,
+                    xmlns_id_t ns_id)
+{
+    xmlns_id_t  *link;
+
+    link = &xmlns_hashtab[key][hash_str(str, xml_strlen(str))];
+    while (*link) {
+        link = &xmlns[*link-1].next[key];
+    }
+    *link = ns_id;
+
+}  /* add_hash_chain */
+
+
+/********************************************************************
+* FUNCTION grow_xmlns
+* 
+* Make room in the namespace table for the next NS ID
+*
+* RETURNS:
+*    status
+*********************************************************************/
+static status_t
+    grow_xmlns (void)
+{
+    xmlns_entry_t  *newtab;
+    uint32          newsize;
+
+    if (xmlns_next_id <= xmlns_tabsize) {
+        return NO_ERR;
+    }
+
+    newsize = (xmlns_tabsize) ? xmlns_tabsize * 2 : XMLNS_INIT_NS;
+    if (newsize <= xmlns_tabsize) {
+        return ERR_TOO_MANY_ENTRIES;
+    }
+
+    newtab = m__getMem(newsize * sizeof(xmlns_entry_t));
+    if (newtab == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(newtab, 0x0, newsize * sizeof(xmlns_entry_t));
+
+    if (xmlns) {
+        memcpy(newtab, xmlns, xmlns_tabsize * sizeof(xmlns_entry_t));
+        m__free(xmlns);
+    }
+    xmlns = newtab;
+    xmlns_tabsize = newsize;
+    return NO_ERR;
+
+}  /* grow_xmlns */
+
+
 
 /********************************************************************
 * FUNCTION init_xmlns_static_vars
@@ -230,11 +384,9 @@ static void
 static void 
     init_xmlns_static_vars (void)
 {
-    uint32 i;
-
-    for (i=0; i < XMLNS_MAX_NS; i++) {
-        xmlns[i] = NULL;
-    }
+    xmlns = NULL;
+    xmlns_tabsize = 0;
+    memset(xmlns_hashtab, 0x0, sizeof(xmlns_hashtab));
 
     xmlns_invid = 0;
     xmlns_ncid = 0;
@@ -299,8 +451,10 @@ void
 
     if (xmlns_init_done) {
         for (i=0; i<xmlns_next_id-1; i++) {
-            free_xmlns(xmlns[i]);
-            xmlns[i] = NULL;
+            free_xmlns(xmlns[i].rec);
+        }
+        if (xmlns) {
+            m__free(xmlns);
         }
         init_xmlns_static_vars();
         xmlns_init_done = FALSE;
@@ -363,7 +517,7 @@ status_t
         return ERR_NCX_WRONG_LEN;
     }
 
-    if (!xmlns_next_id || xmlns_next_id > XMLNS_MAX_NS) {
+    if (!xmlns_next_id) {
         return ERR_TOO_MANY_ENTRIES;
     }
 
@@ -372,6 +526,11 @@ status_t
         return ERR_DUP_NS;
     }
 
+    res = grow_xmlns();
+    if (res != NO_ERR) {
+        return res;
+    }
+
     /* all ok - try to malloc the new entry at the end of the list */
     rec = new_xmlns();
     if (!rec) {
@@ -414,7 +573,10 @@ status_t
         return res;
     }
 
-    xmlns[xmlns_next_id-1] = rec;
+    xmlns[xmlns_next_id-1].rec = rec;
+    add_hash_chain(XMLNS_KEY_NAME, rec->ns_name, rec->ns_id);
+    add_hash_chain(XMLNS_KEY_PFIX, rec->ns_pfix, rec->ns_id);
+    add_hash_chain(XMLNS_KEY_MOD, rec->ns_module, rec->ns_id);
 
     /* hack: check if this is one of the cached NS IDs */
     if (!xml_strcmp(ns, NC_URN)) {
@@ -473,7 +635,7 @@ const xmlChar *
     if (!valid_id(ns_id)) {
         return (const xmlChar *)"--";
     } else {
-        return (const xmlChar *)xmlns[ns_id-1]->ns_pfix;
+        return (const xmlChar *)get_rec(ns_id)->ns_pfix;
     }
 } /* xmlns_get_ns_prefix */
 
@@ -494,7 +656,7 @@ const xmlChar *
     if (!valid_id(ns_id)) {
         return NULL;
     } else {
-        return (const xmlChar *)xmlns[ns_id-1]->ns_name;
+        return (const xmlChar *)get_rec(ns_id)->ns_name;
     }
 } /* xmlns_get_ns_name */
 
@@ -513,8 +675,8 @@ const xmlChar *
 xmlns_id_t 
     xmlns_find_ns_by_module (const xmlChar *modname)
 {
-    uint32    i;
-    xmlns_t  *rec;
+    xmlns_id_t  id;
+    xmlns_t    *rec;
 
 #ifdef DEBUG
     if (!modname) {
@@ -523,12 +685,12 @@ xmlns_id_t
     } 
 #endif
 
-    for (i=0; i<xmlns_next_id-1; i++) {
-        rec = xmlns[i];
-        if (rec->ns_module) {
-            if (!xml_strcmp(rec->ns_module, modname)) {
-                return rec->ns_id;
-            }
+    for (id = first_in_chain(XMLNS_KEY_MOD, modname, xml_strlen(modname));
+         id != XMLNS_NULL_NS_ID;
+         id = xmlns[id-1].next[XMLNS_KEY_MOD]) {
+        rec = get_rec(id);
+        if (!xml_strcmp(rec->ns_module, modname)) {
+            return id;
         }
     }
     return XMLNS_NULL_NS_ID;
@@ -549,8 +711,8 @@ xmlns_id_t
 xmlns_id_t 
     xmlns_find_ns_by_prefix (const xmlChar *pfix)
 {
-    uint32    i;
-    xmlns_t  *rec;
+    xmlns_id_t  id;
+    xmlns_t    *rec;
 
 #ifdef DEBUG
     if (!pfix) {
@@ -558,12 +720,12 @@ xmlns_id_t
     } 
 #endif
 
-    for (i=0; i<xmlns_next_id-1; i++) {
-        rec = xmlns[i];
-        if (rec->ns_pfix[0]) {
-            if (!xml_strcmp(rec->ns_pfix, pfix)) {
-                return rec->ns_id;
-            }
+    for (id = first_in_chain(XMLNS_KEY_PFIX, pfix, xml_strlen(pfix));
+         id != XMLNS_NULL_NS_ID;
+         id = xmlns[id-1].next[XMLNS_KEY_PFIX]) {
+        rec = get_rec(id);
+        if (!xml_strcmp(rec->ns_pfix, pfix)) {
+            return id;
         }
     }
     return XMLNS_NULL_NS_ID;
@@ -619,8 +781,8 @@ xmlns_id_t
     xmlns_find_ns_by_name_str (const xmlChar *name,
                                uint32 namelen)
 {
-    xmlns_t  *ns;
-    uint32    i;
+    xmlns_t     *ns;
+    xmlns_id_t   id;
 
 #ifdef DEBUG
     if (!name) {
@@ -633,12 +795,13 @@ xmlns_id_t
     } 
 #endif
 
-    for (i=0; i<xmlns_next_id-1; i++) {
-        ns = xmlns[i];
-        if (ns->ns_name) {
-            if (!xml_strncmp(ns->ns_name, name, namelen)) {
-                return ns->ns_id;
-            }
+    for (id = first_in_chain(XMLNS_KEY_NAME, name, namelen);
+         id != XMLNS_NULL_NS_ID;
+         id = xmlns[id-1].next[XMLNS_KEY_NAME]) {
+        ns = get_rec(id);
+        if (!xml_strncmp(ns->ns_name, name, namelen) &&
+            ns->ns_name[namelen] == 0) {
+            return id;
         }
     }
 
@@ -876,7 +1039,7 @@ const xmlChar *
     if (!valid_id(nsid)) {
         return NULL;
     }
-    return xmlns[nsid-1]->ns_module;
+    return get_rec(nsid)->ns_module;
 
 }  /* xmlns_get_module */
 
@@ -901,7 +1064,7 @@ void *
     if (!valid_id(nsid)) {
         return NULL;
     }
-    return xmlns[nsid-1]->ns_mod;
+    return get_rec(nsid)->ns_mod;
 
 }  /* xmlns_get_modptr */
 
@@ -920,8 +1083,8 @@ void
     xmlns_set_modptrs (const xmlChar *modname,
                        void *modptr)
 {
-    uint32    i;
-    xmlns_t  *rec;
+    xmlns_id_t  id;
+    xmlns_t    *rec;
 
 #ifdef DEBUG
     if (!modname) {
@@ -935,12 +1098,12 @@ void
         return;
     }
 
-    for (i=0; i<xmlns_next_id-1; i++) {
-        rec = xmlns[i];
-        if (rec->ns_module) {
-            if (!xml_strcmp(rec->ns_module, modname)) {
-                rec->ns_mod = modptr;
-            }
+    for (id = first_in_chain(XMLNS_KEY_MOD, modname, xml_strlen(modname));
+         id != XMLNS_NULL_NS_ID;
+         id = xmlns[id-1].next[XMLNS_KEY_MOD]) {
+        rec = get_rec(id);
+        if (!xml_strcmp(rec->ns_module, modname)) {
+            rec->ns_mod = modptr;
         }
     }
 
@@ -2369,6 +2369,7 @@ xpath_pcb_t *
     dlq_createSQue(&pcb->result_cacheQ);
     dlq_createSQue(&pcb->resnode_cacheQ);
     dlq_createSQue(&pcb->varbindQ);
+    dlq_createSQue(&pcb->depQ);
 
     return pcb;
 
@@ -2438,7 +2439,8 @@ xpath_pcb_t *
     newpcb->doctype = srcpcb->doctype;
     newpcb->val = srcpcb->val;
     newpcb->val_docroot = srcpcb->val_docroot;
-    newpcb->flags = srcpcb->flags;
+    /* the depQ is only valid for the object used in validation */
+    newpcb->flags = srcpcb->flags & ~(XP_FL_OBJDEPS | XP_FL_OBJDEPS_ANY);
     /*** skip copying the scratch result ***/
     /*** ??? context ??? ***/
     newpcb->functions = srcpcb->functions;
@@ -2538,6 +2540,11 @@ void xpath_free_pcb (xpath_pcb_t *pcb)
         xpath_free_resnode(resnode);
     }
 
+    while (!dlq_empty(&pcb->depQ)) {
+        resnode = (xpath_resnode_t *)dlq_deque(&pcb->depQ);
+        xpath_free_resnode(resnode);
+    }
+
     var_clean_varQ(&pcb->varbindQ);
 
     m__free(pcb);
@@ -2656,6 +2663,8 @@ void
     }
 #endif
 
+    xpath_free_nodeindex(result);
+
     switch (result->restype) {
     case XP_RT_NODESET:
         while (!dlq_empty(&result->r.nodeQ)) {
@@ -2687,6 +2696,45 @@ void
 }  /* xpath_clean_result */
 
 
+/********************************************************************
+* FUNCTION xpath_free_nodeindex
+* 
+* Free the node-set index attached to an XPath result, if any
+* Must be called if the result nodeQ is changed after the
+* index has been built
+*
+* INPUTS:
+*   result == pointer to result struct to use
+*********************************************************************/
+void
+    xpath_free_nodeindex (xpath_result_t *result)
+{
+    xpath_nodeindex_t *nodeindex;
+
+#ifdef DEBUG
+    if (!result) {
+        SET_ERROR(ERR_INTERNAL_PTR);
+        return;
+    }
+#endif
+
+    nodeindex = result->nodeindex;
+    if (nodeindex == NULL) {
+        return;
+    }
+
+    if (nodeindex->selfkeys) {
+        m__free(nodeindex->selfkeys);
+    }
+    if (nodeindex->treekeys) {
+        m__free(nodeindex->treekeys);
+    }
+    m__free(nodeindex);
+    result->nodeindex = NULL;
+
+}  /* xpath_free_nodeindex */
+
+
 /********************************************************************
 * FUNCTION xpath_new_resnode
 * 
@@ -211,6 +211,19 @@ extern "C" {
 #define XP_FL_SCHEMA_INSTANCEID          bit7
 
 
+/* set by xpath1_validate_expr when the depQ and depanchor
+ * fields describe the data nodes read by the expression
+ */
+#define XP_FL_OBJDEPS             bit8
+
+
+/* set by xpath1_validate_expr when the data nodes read by
+ * the expression cannot be found from the object tree
+ * (e.g., variables, deref(), sibling axes, missing nodes)
+ */
+#define XP_FL_OBJDEPS_ANY         bit9
+
+
 /********************************************************************
 *								    *
 *			     T Y P E S				    *
@@ -324,6 +337,27 @@ typedef struct xpath_resnode_t_ {
 } xpath_resnode_t;
 
 
+/* 1 node name key in a node-set index */
+typedef struct xpath_nodekey_t_ {
+    const xmlChar        *name;   /* bptr to node name */
+    xmlns_id_t            nsid;
+} xpath_nodekey_t;
+
+
+/* optional node-set index for name-based membership tests
+ * selfkeys holds 1 key for each result node
+ * treekeys holds 1 key for each result node and each of its
+ * ancestors, up to but not including the root node
+ * both arrays are sorted by name, then nsid, without duplicates
+ */
+typedef struct xpath_nodeindex_t_ {
+    uint32                selfcnt;
+    uint32                treecnt;
+    xpath_nodekey_t      *selfkeys;    /* malloced array */
+    xpath_nodekey_t      *treekeys;    /* malloced array */
+} xpath_nodeindex_t;
+
+
 /* XPath expression result */
 typedef struct xpath_result_t_ {
     dlq_hdr_t            qhdr;        /* in case saved in a Q */
@@ -338,6 +372,7 @@ typedef struct xpath_result_t_ {
     } r;
 
     status_t             res;
+    xpath_nodeindex_t   *nodeindex;   /* optional nodeQ index */
 } xpath_result_t;
 
 
@@ -438,6 +473,16 @@ typedef struct xpath_pcb_t_ {
     /* saved error info for the agent to process */
     ncx_error_t          tkerr;
     boolean              seen;      /* yangdiff support */
+
+    /* schema nodes read by the expression, found by
+     * xpath1_validate_expr; only valid if XP_FL_OBJDEPS is set
+     * The depanchor is the lowest data node ancestor-or-self
+     * of the context node that contains every node visited
+     * by the expression; NULL if the expression can visit
+     * nodes in other instances of every ancestor
+     */
+    dlq_hdr_t            depQ;       /* Q of xpath_resnode_t */
+    obj_template_t      *depanchor;
 } xpath_pcb_t;
 
 
@@ -837,6 +882,20 @@ extern void
     xpath_clean_result (xpath_result_t *result);
 
 
+/********************************************************************
+* FUNCTION xpath_free_nodeindex
+* 
+* Free the node-set index attached to an XPath result, if any
+* Must be called if the result nodeQ is changed after the
+* index has been built
+*
+* INPUTS:
+*   result == pointer to result struct to use
+*********************************************************************/
+extern void
+    xpath_free_nodeindex (xpath_result_t *result);
+
+
 /********************************************************************
 * FUNCTION xpath_new_resnode
 * 
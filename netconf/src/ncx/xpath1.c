@@ -5308,6 +5308,123 @@ static xpath_resnode_t *
 }  /* find_resnode */
 
 
+/********************************************************************
+* FUNCTION compare_nodekeys
+* 
+* qsort compare function for xpath_nodekey_t entries
+* Sort by name, then by namespace ID
+*
+* INPUTS:
+*    key1, key2 == pointers to the 2 keys to compare
+*
+* RETURNS:
+*    -1, 0, or 1 for less, equal, or greater
+*********************************************************************/
+static int
+    compare_nodekeys (const void *key1,
+                      const void *key2)
+{
+    const xpath_nodekey_t *k1 = (const xpath_nodekey_t *)key1;
+    const xpath_nodekey_t *k2 = (const xpath_nodekey_t *)key2;
+    int ret;
+
+    ret = xml_strcmp(k1->name, k2->name);
+    if (ret) {
+        return ret;
+    }
+    if (k1->nsid < k2->nsid) {
+        return -1;
+    }
+    return (k1->nsid > k2->nsid) ? 1 : 0;
+
+}  /* compare_nodekeys */
+
+
+/********************************************************************
+* FUNCTION sort_nodekeys
+* 
+* Sort a node key array and remove duplicate entries
+*
+* INPUTS:
+*    keys == array of keys to sort
+*    count == number of entries in keys
+*
+* RETURNS:
+*    number of entries left in keys
+*********************************************************************/
+static uint32
+    sort_nodekeys (xpath_nodekey_t *keys,
+                   uint32 count)
+{
+    uint32 i, last;
+
+    if (count < 2) {
+        return count;
+    }
+
+    qsort(keys, count, sizeof(xpath_nodekey_t), compare_nodekeys);
+
+    last = 0;
+    for (i = 1; i < count; i++) {
+        if (compare_nodekeys(&keys[last], &keys[i])) {
+            keys[++last] = keys[i];
+        }
+    }
+    return last + 1;
+
+}  /* sort_nodekeys */
+
+
+/********************************************************************
+* FUNCTION find_nodekey
+* 
+* Binary search a sorted node key array
+* Follows the same matching rules as find_resnode_slow:
+* a zero nsid matches a node with any namespace
+*
+* INPUTS:
+*    keys == sorted array of keys to check
+*    count == number of entries in keys
+*    nsid == namespace ID of name to find; 0 to match any
+*    name == name to find
+*
+* RETURNS:
+*    TRUE if found, FALSE otherwise
+*********************************************************************/
+static boolean
+    find_nodekey (const xpath_nodekey_t *keys,
+                  uint32 count,
+                  xmlns_id_t nsid,
+                  const xmlChar *name)
+{
+    uint32 lo, hi, mid;
+    int    ret;
+
+    lo = 0;
+    hi = count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        ret = xml_strcmp(name, keys[mid].name);
+        if (ret == 0 && nsid) {
+            if (nsid < keys[mid].nsid) {
+                ret = -1;
+            } else if (nsid > keys[mid].nsid) {
+                ret = 1;
+            }
+        }
+        if (ret == 0) {
+            return TRUE;
+        } else if (ret < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return FALSE;
+
+}  /* find_nodekey */
+
+
 /********************************************************************
 * FUNCTION find_resnode_slow
 * 
@@ -7321,6 +7438,99 @@ static status_t
 } /* parse_predicate */
 
 
+/********************************************************************
+* FUNCTION record_objdeps
+* 
+* Record the schema nodes in a nodeset found while validating
+* an expression against the object tree
+*
+* Every node visited moves the pcb->depanchor up to a common
+* ancestor, so the expression cannot leave the subtree of
+* the anchor instance that contains the context node.
+* The nodes in a final path result are also added to the
+* pcb->depQ, since these are the nodes that are actually read
+*
+* INPUTS:
+*    pcb == parser control block in progress
+*    result == nodeset result to check
+*    isdep == TRUE if this is a final path result
+*             FALSE if this is an intermediate step result
+*
+* OUTPUTS:
+*   pcb->depanchor and pcb->depQ may be updated
+*   XP_FL_OBJDEPS_ANY is set if the nodes read cannot
+*   be found from the nodeset
+*********************************************************************/
+static void
+    record_objdeps (xpath_pcb_t *pcb,
+                    xpath_result_t *result,
+                    boolean isdep)
+{
+    xpath_resnode_t  *resnode, *depnode;
+    obj_template_t   *obj;
+
+    if (pcb->val || !pcb->obj || !(pcb->flags & XP_FL_OBJDEPS) ||
+        !result || result->restype != XP_RT_NODESET) {
+        return;
+    }
+
+    if (dlq_empty(&result->r.nodeQ)) {
+        /* the object tree did not have the node;
+         * it could be added later by an augment  */
+        pcb->flags |= XP_FL_OBJDEPS_ANY;
+        return;
+    }
+
+    for (resnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+         resnode != NULL;
+         resnode = (xpath_resnode_t *)dlq_nextEntry(resnode)) {
+
+        obj = resnode->node.objptr;
+        if (obj == NULL) {
+            continue;
+        }
+
+        if (obj == pcb->docroot || obj_is_root(obj)) {
+            /* the whole document is visited */
+            pcb->depanchor = NULL;
+            if (isdep) {
+                pcb->flags |= XP_FL_OBJDEPS_ANY;
+            }
+            continue;
+        }
+
+        if (pcb->depanchor) {
+            pcb->depanchor = obj_get_common_ancestor(pcb->depanchor, obj);
+        }
+
+        if (!isdep) {
+            continue;
+        }
+
+        for (depnode = (xpath_resnode_t *)dlq_firstEntry(&pcb->depQ);
+             depnode != NULL;
+             depnode = (xpath_resnode_t *)dlq_nextEntry(depnode)) {
+            if (depnode->node.objptr == obj) {
+                break;
+            }
+        }
+        if (depnode == NULL) {
+            depnode = xpath_new_resnode();
+            if (depnode == NULL) {
+                pcb->flags |= XP_FL_OBJDEPS_ANY;
+                return;
+            }
+            depnode->node.objptr = obj;
+            dlq_enque(depnode, &pcb->depQ);
+        }
+        if (resnode->dblslash) {
+            depnode->dblslash = TRUE;
+        }
+    }
+
+}  /* record_objdeps */
+
+
 /********************************************************************
 * FUNCTION parse_step
 * 
@@ -7546,6 +7756,29 @@ static status_t
         return res;
     }
 
+    switch (axis) {
+    case XP_AX_FOLLOWING:
+    case XP_AX_FOLLOWING_SIBLING:
+    case XP_AX_PRECEDING:
+    case XP_AX_PRECEDING_SIBLING:
+        /* these axes can select other instances of the
+         * same object, so the object tree cannot show
+         * which instances are read    */
+        pcb->flags |= XP_FL_OBJDEPS_ANY;
+        break;
+    default:
+        ;
+    }
+
+    /* a wildcard or node() test also matches nodes that
+     * a module loaded later can add with an augment   */
+    nexttyp = tk_next_typ(pcb->tkc);
+    if (nexttyp == TK_TT_STAR || nexttyp == TK_TT_NCNAME_STAR ||
+        (nexttyp == TK_TT_TSTRING &&
+         tk_next_typ2(pcb->tkc) == TK_TT_LPAREN)) {
+        pcb->flags |= XP_FL_OBJDEPS_ANY;
+    }
+
     /* axis or default child parsed OK, get node test */
     res = parse_node_test(pcb, axis, result);
     if (res == NO_ERR) {
@@ -7608,10 +7841,21 @@ static xpath_result_t *
 
     val1 = result;
 
+    if (!result) {
+        /* an absolute path starts at the docroot */
+        nexttyp = tk_next_typ(pcb->tkc);
+        if (nexttyp == TK_TT_FSLASH || nexttyp == TK_TT_DBLFSLASH) {
+            if (!pcb->val && pcb->obj) {
+                pcb->depanchor = NULL;
+            }
+        }
+    }
+
     done = FALSE;
     while (!done && *res == NO_ERR) {
         *res = parse_step(pcb, &val1);
         if (*res == NO_ERR) {
+            record_objdeps(pcb, val1, FALSE);
             nexttyp = tk_next_typ(pcb->tkc);
             if (!(nexttyp == TK_TT_FSLASH ||
                   nexttyp == TK_TT_DBLFSLASH)) {
@@ -7731,6 +7975,25 @@ static xpath_result_t *
                 /*** log agent error ***/
             }
         } else {
+            if (!pcb->val && pcb->obj) {
+                if (fncb->fn == deref_fn || fncb->fn == id_fn) {
+                    /* the instance read depends on the data */
+                    pcb->flags |= XP_FL_OBJDEPS_ANY;
+                } else if (parmcnt == 0 &&
+                           pcb->context.node.objptr != NULL) {
+                    /* a function with no parameters may
+                     * use the context node instead   */
+                    val2 = new_nodeset(pcb, pcb->context.node.objptr,
+                                       NULL, 1, FALSE);
+                    if (val2) {
+                        record_objdeps(pcb, val2, TRUE);
+                        free_result(pcb, val2);
+                    } else {
+                        pcb->flags |= XP_FL_OBJDEPS_ANY;
+                    }
+                }
+            }
+
             /* make the function call */
             val1 = (*fncb->fn)(pcb, &parmQ, res);
 
@@ -7820,6 +8083,12 @@ static xpath_result_t *
             return NULL;
         }
 
+        /* the value of a variable is not known until
+         * the expression is evaluated   */
+        if (!pcb->val && pcb->obj) {
+            pcb->flags |= XP_FL_OBJDEPS_ANY;
+        }
+
         /* get QName or NCName variable reference
          * but only if this get is a real one
          */
@@ -8064,9 +8333,11 @@ static xpath_result_t *
     const xmlChar   *nextval;
     tk_type_t        nexttyp, nexttyp2;
     xpath_exop_t     curop;
+    boolean          locpath;
 
     val1 = NULL;
     val2 = NULL;
+    locpath = FALSE;
 
     /* peek ahead to check the possible next sequence */
     nexttyp = tk_next_typ(pcb->tkc);
@@ -8079,7 +8350,8 @@ static xpath_result_t *
     case TK_TT_STAR:              /* rel, step, node, name */
     case TK_TT_NCNAME_STAR:       /* rel, step, node, name */
     case TK_TT_MSTRING:          /* rel, step, node, QName */
-        return parse_location_path(pcb, NULL, res);
+        locpath = TRUE;
+        break;
     case TK_TT_TSTRING:
         /* some sort of identifier string to check
          * get the value of the string and the following token type
@@ -8090,25 +8362,27 @@ static xpath_result_t *
         /* check 'axis-name ::' sequence */
         if (nexttyp2==TK_TT_DBLCOLON && get_axis_id(nextval)) {
             /* this is an axis name */
-            return parse_location_path(pcb, NULL, res);
-        }               
-
-        /* check 'NodeType (' sequence */
-        if (nexttyp2==TK_TT_LPAREN && get_nodetype_id(nextval)) {
+            locpath = TRUE;
+        } else if (nexttyp2==TK_TT_LPAREN && get_nodetype_id(nextval)) {
             /* this is an nodetype name */
-            return parse_location_path(pcb, NULL, res);
-        }
-
-        /* check not a function call, so must be a QName */
-        if (nexttyp2 != TK_TT_LPAREN) {
+            locpath = TRUE;
+        } else if (nexttyp2 != TK_TT_LPAREN) {
             /* this is an NameTest QName w/o a prefix */
-            return parse_location_path(pcb, NULL, res);
+            locpath = TRUE;
         }
         break;
     default:
         ;
     }
 
+    if (locpath) {
+        val2 = parse_location_path(pcb, NULL, res);
+        if (*res == NO_ERR) {
+            record_objdeps(pcb, val2, TRUE);
+        }
+        return val2;
+    }
+
     /* if we get here, then a filter expression is expected */
     val1 = parse_filter_expr(pcb, res);
 
@@ -8137,6 +8411,10 @@ static xpath_result_t *
         free_result(pcb, val1);
     }
 
+    if (*res == NO_ERR) {
+        record_objdeps(pcb, val2, TRUE);
+    }
+
     return val2;
 
 } /* parse_path_expr */
@@ -9333,6 +9611,7 @@ status_t
                              boolean missing_is_error)
 {
     xpath_result_t       *result;
+    xpath_resnode_t      *resnode;
     obj_template_t       *rootobj;
     boolean               rootdone;
  
@@ -9360,6 +9639,14 @@ status_t
         pcb->flags |= XP_FL_CONFIGONLY;
     }
 
+    /* start a new list of the nodes read by the expression */
+    pcb->flags &= ~(XP_FL_OBJDEPS | XP_FL_OBJDEPS_ANY);
+    while (!dlq_empty(&pcb->depQ)) {
+        resnode = (xpath_resnode_t *)dlq_deque(&pcb->depQ);
+        xpath_free_resnode(resnode);
+    }
+    pcb->depanchor = NULL;
+
     if (pcb->parseres != NO_ERR) {
         /* errors already reported, skip this one */
         return NO_ERR;
@@ -9371,10 +9658,11 @@ status_t
         return SET_ERROR(ERR_INTERNAL_VAL);
     }
 
-    pcb->context.node.objptr = get_context_objnode(obj);
-    pcb->orig_context.node.objptr = pcb->context.node.objptr;
+    /* node is a union; clear valptr before setting objptr */
     pcb->context.node.valptr = NULL;
     pcb->orig_context.node.valptr = NULL;
+    pcb->context.node.objptr = get_context_objnode(obj);
+    pcb->orig_context.node.objptr = pcb->context.node.objptr;
 
     rootdone = FALSE;
     if (obj_is_root(obj) || 
@@ -9406,6 +9694,13 @@ status_t
         pcb->docroot = rootobj;
     }
 
+    pcb->flags |= XP_FL_OBJDEPS;
+    pcb->depanchor = pcb->context.node.objptr;
+    if (pcb->depanchor && 
+        (pcb->depanchor == pcb->docroot || obj_is_root(pcb->depanchor))) {
+        pcb->depanchor = NULL;
+    }
+
     /* validate the XPath expression against the 
      * full cooked object tree
      */
@@ -9415,6 +9710,10 @@ status_t
         result = parse_expr(pcb, &pcb->validateres);
     }
 
+    if (pcb->validateres != NO_ERR) {
+        pcb->flags &= ~XP_FL_OBJDEPS;
+    }
+
     if (result) {
         if (LOGDEBUG3) {
             dump_result(pcb, result, "validate_expr");
@@ -9896,6 +10195,8 @@ boolean
                                    dlq_hdr_t *resultQ,
                                    const val_value_t *val)
 {
+    const xmlChar *docname;
+
 #ifdef DEBUG
     if (!pcb || !resultQ || !val) {
         SET_ERROR(ERR_INTERNAL_PTR);
@@ -9906,10 +10207,14 @@ boolean
     /* quick test -- see if docroot is already in the Q
      * which means nothing else is needed
      */
-    if (find_resnode_slow(pcb, 
-                          resultQ,
-                          0,
-                          pcb->val_docroot->name)) {
+    if (pcb->val_docroot) {
+        docname = pcb->val_docroot->name;
+    } else if (pcb->docroot) {
+        docname = obj_get_name(pcb->docroot);
+    } else {
+        docname = NULL;
+    }
+    if (docname && find_resnode_slow(pcb, resultQ, 0, docname)) {
         return TRUE;
     }
 
@@ -10012,6 +10317,314 @@ boolean
 }  /* xpath1_check_node_child_exists_slow */
 
 
+/********************************************************************
+* FUNCTION xpath1_index_nodeset
+* 
+* Build a name index for a node-set result, so the
+* xpath1_check_result_node_exists and
+* xpath1_check_result_node_child_exists functions
+* can use a binary search instead of scanning the nodeQ
+*
+* The index uses back-pointers to the node names, so it
+* is only valid as long as the result nodeQ is valid.
+* Any existing index is replaced.
+*
+* INPUTS:
+*    pcb == parser control block used to evaluate the result
+*    result == node-set result struct to index
+*
+* OUTPUTS:
+*    result->nodeindex is set
+*
+* RETURNS:
+*    status
+*********************************************************************/
+status_t
+    xpath1_index_nodeset (xpath_pcb_t *pcb,
+                          xpath_result_t *result)
+{
+    xpath_nodeindex_t *nodeindex;
+    xpath_resnode_t   *resnode;
+    val_value_t       *testval;
+    obj_template_t    *testobj;
+    uint32             nodecnt, treecnt;
+
+    assert( pcb && "pcb is NULL" );
+    assert( result && "result is NULL" );
+
+    if (result->restype != XP_RT_NODESET) {
+        return ERR_NCX_WRONG_TYPE;
+    }
+
+    xpath_free_nodeindex(result);
+
+    /* count the entries needed for each key array */
+    nodecnt = 0;
+    treecnt = 0;
+    for (resnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+         resnode != NULL;
+         resnode = (xpath_resnode_t *)dlq_nextEntry(resnode)) {
+        nodecnt++;
+        if (pcb->val) {
+            for (testval = resnode->node.valptr;
+                 testval && !obj_is_root(testval->obj);
+                 testval = testval->parent) {
+                treecnt++;
+            }
+        } else {
+            for (testobj = resnode->node.objptr;
+                 testobj && !obj_is_root(testobj);
+                 testobj = testobj->parent) {
+                treecnt++;
+            }
+        }
+    }
+
+    nodeindex = m__getObj(xpath_nodeindex_t);
+    if (nodeindex == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(nodeindex, 0x0, sizeof(xpath_nodeindex_t));
+
+    if (nodecnt) {
+        nodeindex->selfkeys = (xpath_nodekey_t *)
+            m__getMem(nodecnt * sizeof(xpath_nodekey_t));
+        if (nodeindex->selfkeys == NULL) {
+            m__free(nodeindex);
+            return ERR_INTERNAL_MEM;
+        }
+    }
+    if (treecnt) {
+        nodeindex->treekeys = (xpath_nodekey_t *)
+            m__getMem(treecnt * sizeof(xpath_nodekey_t));
+        if (nodeindex->treekeys == NULL) {
+            if (nodeindex->selfkeys) {
+                m__free(nodeindex->selfkeys);
+            }
+            m__free(nodeindex);
+            return ERR_INTERNAL_MEM;
+        }
+    }
+
+    /* fill in the keys the same way the _slow functions compare */
+    for (resnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+         resnode != NULL;
+         resnode = (xpath_resnode_t *)dlq_nextEntry(resnode)) {
+        xpath_nodekey_t *key = &nodeindex->selfkeys[nodeindex->selfcnt++];
+
+        if (pcb->val) {
+            key->name = resnode->node.valptr->name;
+            key->nsid = val_get_nsid(resnode->node.valptr);
+            for (testval = resnode->node.valptr;
+                 testval && !obj_is_root(testval->obj);
+                 testval = testval->parent) {
+                key = &nodeindex->treekeys[nodeindex->treecnt++];
+                key->name = testval->name;
+                key->nsid = val_get_nsid(testval);
+            }
+        } else {
+            key->name = obj_get_name(resnode->node.objptr);
+            key->nsid = obj_get_nsid(resnode->node.objptr);
+            for (testobj = resnode->node.objptr;
+                 testobj && !obj_is_root(testobj);
+                 testobj = testobj->parent) {
+                key = &nodeindex->treekeys[nodeindex->treecnt++];
+                key->name = obj_get_name(testobj);
+                key->nsid = obj_get_nsid(testobj);
+            }
+        }
+    }
+
+    nodeindex->selfcnt = sort_nodekeys(nodeindex->selfkeys,
+                                       nodeindex->selfcnt);
+    nodeindex->treecnt = sort_nodekeys(nodeindex->treekeys,
+                                       nodeindex->treecnt);
+    result->nodeindex = nodeindex;
+    return NO_ERR;
+
+}  /* xpath1_index_nodeset */
+
+
+/********************************************************************
+* FUNCTION xpath1_check_result_node_exists
+* 
+* Check if any ancestor-or-self node of val is in the
+* specified node-set result, comparing node names.
+* Same answer as xpath1_check_node_exists_slow, but the
+* result->nodeindex is used if it has been built
+*
+* INPUTS:
+*    pcb == parser control block to use
+*    result == node-set result to check
+*    val   == value node to find
+*
+* RETURNS:
+*    TRUE if found, FALSE otherwise
+*********************************************************************/
+boolean
+    xpath1_check_result_node_exists (xpath_pcb_t *pcb,
+                                     xpath_result_t *result,
+                                     const val_value_t *val)
+{
+    const xpath_nodeindex_t *nodeindex;
+    const xmlChar           *docname;
+
+    assert( pcb && "pcb is NULL" );
+    assert( result && "result is NULL" );
+    assert( val && "val is NULL" );
+
+    nodeindex = result->nodeindex;
+    if (nodeindex == NULL) {
+        return xpath1_check_node_exists_slow(pcb, &result->r.nodeQ, val);
+    }
+
+    /* quick test -- see if docroot is already in the index */
+    if (pcb->val_docroot) {
+        docname = pcb->val_docroot->name;
+    } else if (pcb->docroot) {
+        docname = obj_get_name(pcb->docroot);
+    } else {
+        docname = NULL;
+    }
+    if (docname && find_nodekey(nodeindex->selfkeys, nodeindex->selfcnt,
+                                0, docname)) {
+        return TRUE;
+    }
+
+    if (val == pcb->val_docroot) {
+        return FALSE;
+    }
+
+    while (val) {
+        if (find_nodekey(nodeindex->selfkeys, nodeindex->selfcnt,
+                         val_get_nsid(val), val->name)) {
+            return TRUE;
+        }
+
+        if (val->parent && !obj_is_root(val->parent->obj)) {
+            val = val->parent;
+        } else {
+            return FALSE;
+        }
+    }
+    return FALSE;
+
+}  /* xpath1_check_result_node_exists */
+
+
+/********************************************************************
+* FUNCTION xpath1_check_result_node_child_exists
+* 
+* Check if val names any ancestor-or-self node of a node in
+* the specified node-set result, comparing node names.
+* Same answer as xpath1_check_node_child_exists_slow, but the
+* result->nodeindex is used if it has been built
+*
+* INPUTS:
+*    pcb == parser control block to use
+*    result == node-set result to check
+*    val   == value node to find
+*
+* RETURNS:
+*    TRUE if found, FALSE otherwise
+*********************************************************************/
+boolean
+    xpath1_check_result_node_child_exists (xpath_pcb_t *pcb,
+                                           xpath_result_t *result,
+                                           const val_value_t *val)
+{
+    const xpath_nodeindex_t *nodeindex;
+
+    assert( pcb && "pcb is NULL" );
+    assert( result && "result is NULL" );
+    assert( val && "val is NULL" );
+
+    nodeindex = result->nodeindex;
+    if (nodeindex == NULL) {
+        return xpath1_check_node_child_exists_slow(pcb, &result->r.nodeQ,
+                                                   val);
+    }
+
+    return find_nodekey(nodeindex->treekeys, nodeindex->treecnt,
+                        val_get_nsid(val), val->name);
+
+}  /* xpath1_check_result_node_child_exists */
+
+
+/********************************************************************
+* FUNCTION xpath1_convert_nodeset_to_objects
+* 
+* Convert a value node-set result into the equivalent
+* object node-set.  Each value node is replaced by its
+* object template and duplicate objects are removed.
+*
+* The converted result no longer holds any back-pointers
+* into the data tree, so it can be saved across edits
+* to the datastore it was evaluated against.
+* Only the _slow node check functions give the same
+* answer for the converted result, since they compare
+* node names instead of node pointers.
+*
+* INPUTS:
+*    pcb == parser control block used to evaluate the result
+*    result == result struct to convert
+*
+* OUTPUTS:
+*    result->r.nodeQ contents converted to object pointers
+*    result->isval set to FALSE
+*    pcb->val and pcb->val_docroot set to NULL
+*********************************************************************/
+void
+    xpath1_convert_nodeset_to_objects (xpath_pcb_t *pcb,
+                                       xpath_result_t *result)
+{
+    xpath_resnode_t  *resnode, *testnode, *nextnode;
+    obj_template_t   *obj;
+
+    assert( pcb && "pcb is NULL" );
+    assert( result && "result is NULL" );
+
+    if (result->restype != XP_RT_NODESET || !result->isval) {
+        return;
+    }
+
+    xpath_free_nodeindex(result);
+
+    if (pcb->val_docroot) {
+        pcb->docroot = pcb->val_docroot->obj;
+    }
+
+    for (resnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+         resnode != NULL;
+         resnode = nextnode) {
+
+        nextnode = (xpath_resnode_t *)dlq_nextEntry(resnode);
+        obj = resnode->node.valptr->obj;
+
+        for (testnode = (xpath_resnode_t *)dlq_firstEntry(&result->r.nodeQ);
+             testnode != resnode;
+             testnode = (xpath_resnode_t *)dlq_nextEntry(testnode)) {
+            if (testnode->node.objptr == obj) {
+                break;
+            }
+        }
+
+        if (testnode != resnode) {
+            dlq_remove(resnode);
+            free_resnode(pcb, resnode);
+        } else {
+            resnode->node.objptr = obj;
+        }
+    }
+
+    result->isval = FALSE;
+    result->last = (int64)dlq_count(&result->r.nodeQ);
+    pcb->val = NULL;
+    pcb->val_docroot = NULL;
+
+}  /* xpath1_convert_nodeset_to_objects */
+
+
 /********************************************************************
 * FUNCTION xpath1_stringify_nodeset
 * 
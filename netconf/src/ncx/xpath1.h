@@ -410,6 +410,105 @@ extern boolean
                                    const val_value_t *val);
 
 
+/********************************************************************
+* FUNCTION xpath1_index_nodeset
+* 
+* Build a name index for a node-set result, so the
+* xpath1_check_result_node_exists and
+* xpath1_check_result_node_child_exists functions
+* can use a binary search instead of scanning the nodeQ
+*
+* The index uses back-pointers to the node names, so it
+* is only valid as long as the result nodeQ is valid.
+* Any existing index is replaced.
+*
+* INPUTS:
+*    pcb == parser control block used to evaluate the result
+*    result == node-set result struct to index
+*
+* OUTPUTS:
+*    result->nodeindex is set
+*
+* RETURNS:
+*    status
+*********************************************************************/
+extern status_t
+    xpath1_index_nodeset (xpath_pcb_t *pcb,
+                          xpath_result_t *result);
+
+
+/********************************************************************
+* FUNCTION xpath1_check_result_node_exists
+* 
+* Check if any ancestor-or-self node of val is in the
+* specified node-set result, comparing node names.
+* Same answer as xpath1_check_node_exists_slow, but the
+* result->nodeindex is used if it has been built
+*
+* INPUTS:
+*    pcb == parser control block to use
+*    result == node-set result to check
+*    val   == value node to find
+*
+* RETURNS:
+*    TRUE if found, FALSE otherwise
+*********************************************************************/
+extern boolean
+    xpath1_check_result_node_exists (xpath_pcb_t *pcb,
+                                     xpath_result_t *result,
+                                     const val_value_t *val);
+
+
+/********************************************************************
+* FUNCTION xpath1_check_result_node_child_exists
+* 
+* Check if val names any ancestor-or-self node of a node in
+* the specified node-set result, comparing node names.
+* Same answer as xpath1_check_node_child_exists_slow, but the
+* result->nodeindex is used if it has been built
+*
+* INPUTS:
+*    pcb == parser control block to use
+*    result == node-set result to check
+*    val   == value node to find
+*
+* RETURNS:
+*    TRUE if found, FALSE otherwise
+*********************************************************************/
+extern boolean
+    xpath1_check_result_node_child_exists (xpath_pcb_t *pcb,
+                                           xpath_result_t *result,
+                                           const val_value_t *val);
+
+
+/********************************************************************
+* FUNCTION xpath1_convert_nodeset_to_objects
+* 
+* Convert a value node-set result into the equivalent
+* object node-set.  Each value node is replaced by its
+* object template and duplicate objects are removed.
+*
+* The converted result no longer holds any back-pointers
+* into the data tree, so it can be saved across edits
+* to the datastore it was evaluated against.
+* Only the _slow node check functions give the same
+* answer for the converted result, since they compare
+* node names instead of node pointers.
+*
+* INPUTS:
+*    pcb == parser control block used to evaluate the result
+*    result == result struct to convert
+*
+* OUTPUTS:
+*    result->r.nodeQ contents converted to object pointers
+*    result->isval set to FALSE
+*    pcb->val and pcb->val_docroot set to NULL
+*********************************************************************/
+extern void
+    xpath1_convert_nodeset_to_objects (xpath_pcb_t *pcb,
+                                       xpath_result_t *result);
+
+
 /********************************************************************
 * FUNCTION xpath1_stringify_nodeset
 * 
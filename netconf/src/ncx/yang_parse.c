@@ -3905,7 +3905,7 @@ status_t
         /* serialize the file into language tokens
          * !!! need to change this later because it may use too
          * !!! much memory in embedded parsers */
-        res = tk_tokenize_input(tkc, mod);
+        res = tk_tokenize_cached_input(tkc, mod, ncxmod_get_tkcache());
         if ( NO_ERR != res ) {
             ncx_free_module(mod);
 
@@ -3915,6 +3915,10 @@ status_t
             tk_free_chain(tkc);
             return res;
         }
+
+        if (ptyp == YANG_PT_TOP && !pcb->searchmode) {
+            ncxmod_prefetch_imports(tkc);
+        }
     }
 
 #ifdef YANG_PARSE_TK_DEBUG
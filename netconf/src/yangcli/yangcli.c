@@ -236,6 +236,9 @@ static uint32          default_timeout;
  */
 static boolean         keep_session_model_copies_after_compilation;
 
+/* max number of <get-schema> requests outstanding during autoload */
+static uint32          autoload_window;
+
 /* default value for val_dump_value display mode */
 static ncx_display_mode_t   display_mode;
 
@@ -656,6 +659,7 @@ server_cb_t *
     server_cb->log_level = log_get_debug_level();
     server_cb->autoload = autoload;
     server_cb->keep_session_model_copies_after_compilation = keep_session_model_copies_after_compilation;
+    server_cb->autoload_window = autoload_window;
     server_cb->fixorder = fixorder;
     server_cb->get_optional = optional;
     server_cb->testoption = testoption;
@@ -701,6 +705,7 @@ void
     server_cb->log_level = log_get_debug_level();
     server_cb->autoload = autoload;
     server_cb->keep_session_model_copies_after_compilation = keep_session_model_copies_after_compilation;
+    server_cb->autoload_window = autoload_window;
     server_cb->fixorder = fixorder;
     server_cb->get_optional = optional;
     server_cb->testoption = testoption;
@@ -2202,6 +2207,23 @@ status_t
         keep_session_model_copies_after_compilation = FALSE;
     }
 
+    /* get the autoload-window parameter */
+    parm = val_find_child(mgr_cli_valset, YANGCLI_EX_MOD, YANGCLI_AUTOLOAD_WINDOW);
+    if (parm && parm->res == NO_ERR) {
+        autoload_window = VAL_UINT(parm);
+    } else {
+        autoload_window = YANGCLI_DEF_AUTOLOAD_WINDOW;
+    }
+
+    /* get the schema-cache parameter */
+    parm = val_find_child(mgr_cli_valset, YANGCLI_EX_MOD, YANGCLI_SCHEMA_CACHE);
+    if (parm && parm->res == NO_ERR) {
+        res = autoload_set_schema_cache(VAL_STR(parm));
+        if (res != NO_ERR) {
+            return res;
+        }
+    }
+
     /* get the autouservars parameter */
     parm = val_find_child(mgr_cli_valset, YANGCLI_MOD, YANGCLI_AUTOUSERVARS);
     if (parm && parm->res == NO_ERR) {
@@ -3720,6 +3742,7 @@ void yangcli_init_module_static_vars()
     confname = NULL;
     default_module = NULL;
     default_timeout = 30;
+    autoload_window = YANGCLI_DEF_AUTOLOAD_WINDOW;
     display_mode = NCX_DISPLAY_MODE_PLAIN;
     fixorder = TRUE;
     optional = FALSE;
@@ -4112,6 +4135,9 @@ static void
         runcommand = NULL;
     }
 
+    /* release the schema cache directory */
+    (void)autoload_set_schema_cache(NULL);
+
     /* Cleanup the Netconf Server Library */
     mgr_cleanup();
 
@@ -87,6 +87,8 @@ extern "C" {
 
 #define YANGCLI_DEF_TIMEOUT   30
 
+#define YANGCLI_DEF_AUTOLOAD_WINDOW  8
+
 #define YANGCLI_DEF_SERVER (const xmlChar *)"default"
 
 #define YANGCLI_DEF_DISPLAY_MODE   NCX_DISPLAY_MODE_PLAIN
@@ -229,6 +231,8 @@ extern "C" {
 
 #define YANGCLI_KEEP_SESSION_MODEL_COPIES_AFTER_COMPILATION    (const xmlChar *)"keep-session-model-copies-after-compilation"
 #define YANGCLI_DUMP_SESSION  (const xmlChar *)"dump-session"
+#define YANGCLI_SCHEMA_CACHE  (const xmlChar *)"schema-cache"
+#define YANGCLI_AUTOLOAD_WINDOW  (const xmlChar *)"autoload-window"
 
 /* YANGCLI local RPC commands */
 #define YANGCLI_ALIAS   (const xmlChar *)"alias"
@@ -439,6 +443,7 @@ typedef struct server_cb_t_ {
     log_debug_t          log_level;
     boolean              autoload;
     boolean              keep_session_model_copies_after_compilation;
+    uint32               autoload_window;
     boolean              fixorder;
     op_testop_t          testoption;
     op_errop_t           erroption;
@@ -482,6 +487,14 @@ typedef struct server_cb_t_ {
     dlq_hdr_t            searchresultQ; /* Q of ncxmod_search_result_t */
     ncxmod_search_result_t  *cursearchresult;
 
+    /* autoload keeps up to autoload_window <get-schema> requests
+     * outstanding; the replies arrive in request order, so
+     * cursearchresult is the oldest request and
+     * autoload_lastsent is the newest one
+     */
+    ncxmod_search_result_t  *autoload_lastsent;
+    uint32               autoload_pending;
+
     /* contains only the modules that the server is using
      * plus the 'netconf.yang' module
      */
@@ -42,6 +42,7 @@ date         init     comment
 #include <stdio.h>
 #include <ctype.h>
 #include <assert.h>
+#include <sys/stat.h>
 #include "libtecla.h"
 
 #include "procdefs.h"
@@ -74,6 +75,15 @@ date         init     comment
 #define YANGCLI_AUTOLOAD_DEBUG 1
 #endif
 
+/* longest server string used in a schema cache file name */
+#define SCHEMA_CACHE_MAX_KEYLEN  128
+
+/* expanded --schema-cache directory, NULL if not used */
+static xmlChar *schema_cache;
+
+/* TRUE if the YANG token cache is the tokens subdir of schema_cache */
+static boolean schema_cache_tokens;
+
 /********************************************************************
 * FUNCTION make_get_schema_reqdata
 * 
@@ -206,7 +216,7 @@ static status_t
 
     res = make_get_schema_reqdata(server_cb, scb, module, revision, &rpc, &reqdata);
     if(res!=NO_ERR) {
-        return NO_ERR;
+        return res;
     }
 
     /* allocate an RPC request and send it */
@@ -367,6 +377,292 @@ static boolean
 
 }  /* reset_feature */
 
+/********************************************************************
+ * FUNCTION copy_schema_file
+ * 
+ * Copy a YANG or YIN source file line by line
+ *
+ * INPUTS:
+ *   source == complete pathspec of source file
+ *   dest == complete pathspec of destination file
+ *
+ * RETURNS:
+ *   status
+ *********************************************************************/
+static status_t
+    copy_schema_file (const xmlChar *source,
+                      const xmlChar *dest)
+{
+    xmlChar             *linebuffer;
+    FILE                *srcfile, *destfile;
+    boolean              done;
+    status_t             res;
+
+    res = NO_ERR;
+
+    /* get a buffer for transferring lines */
+    linebuffer = m__getMem(NCX_MAX_LINELEN+1);
+    if (linebuffer == NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+
+#ifdef YANGCLI_AUTOLOAD_DEBUG
+    if (LOGDEBUG2) {
+        log_debug2("\nyangcli_autoload: Copying '%s' to '%s'",
+                   source,
+                   dest);
+    }
+#endif
+
+    /* open the destination file for writing */
+    destfile = fopen((const char *)dest, "w+");
+    if (destfile == NULL) {
+        res = errno_to_status();
+        m__free(linebuffer);
+        return res;
+    }
+
+    /* open the YANG or YIN source file for reading */
+    srcfile = fopen((const char *)source, "r");
+    if (srcfile == NULL) {
+        res = errno_to_status();
+        fclose(destfile);
+        m__free(linebuffer);
+        return res;
+    }
+
+    done = FALSE;
+    while (!done) {
+        if (!fgets((char *)linebuffer, NCX_MAX_LINELEN, srcfile)) {
+            /* read line failed, not an error */
+            done = TRUE;
+            continue;
+        }
+
+        if (fputs((const char *)linebuffer, destfile) == EOF) {
+            log_error("\nError: copy to file '%s' failed", dest);
+            done = TRUE;
+            res = ERR_FIL_WRITE;
+        }
+    }
+
+    fclose(srcfile);
+    if (fclose(destfile) != 0 && res == NO_ERR) {
+        res = ERR_FIL_WRITE;
+    }
+    m__free(linebuffer);
+
+    return res;
+
+}   /* copy_schema_file */
+
+
+/********************************************************************
+* FUNCTION valid_cache_key
+* 
+* Check if a string from the server can be used as part
+* of a schema cache file name
+*
+* INPUTS:
+*    str == module name, revision date or module-set-id to check
+*
+* RETURNS:
+*    TRUE if the string is safe to use in a file name
+*********************************************************************/
+static boolean
+    valid_cache_key (const xmlChar *str)
+{
+    const xmlChar *p;
+
+    if (str == NULL || *str == 0 || *str == '.' ||
+        xml_strlen(str) > SCHEMA_CACHE_MAX_KEYLEN) {
+        return FALSE;
+    }
+
+    for (p = str; *p; p++) {
+        if (!(isalnum((int)*p) || *p == '-' || *p == '_' || *p == '.')) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+
+}  /* valid_cache_key */
+
+
+/********************************************************************
+* FUNCTION make_schema_cache_filespec
+* 
+* Get the schema cache file name for a module
+*
+* A module with a revision date is stored as <module>@<revision>.yang
+* A module without a revision date can only be identified by
+* the yang-library module-set-id of the server, and is stored
+* as <module>@set-<module-set-id>.yang
+*
+* INPUTS:
+*    mscb == manager session control block to use
+*    module == module name
+*    revision == revision date (may be NULL)
+*
+* RETURNS:
+*    malloced filespec or NULL if the module cannot be cached
+*********************************************************************/
+static xmlChar *
+    make_schema_cache_filespec (mgr_scb_t *mscb,
+                                const xmlChar *module,
+                                const xmlChar *revision)
+{
+    val_value_t   *msidval;
+    const xmlChar *msid;
+    xmlChar       *filespec, *p;
+    uint32         len;
+
+    if (schema_cache == NULL || !valid_cache_key(module)) {
+        return NULL;
+    }
+
+    msid = NULL;
+    if (revision != NULL && *revision) {
+        if (!valid_cache_key(revision)) {
+            return NULL;
+        }
+    } else {
+        revision = NULL;
+        if (mscb->modules_state_val == NULL) {
+            return NULL;
+        }
+        msidval = val_find_child(mscb->modules_state_val,
+                                 (const xmlChar *)"ietf-yang-library",
+                                 (const xmlChar *)"module-set-id");
+        if (msidval == NULL || !valid_cache_key(VAL_STRING(msidval))) {
+            return NULL;
+        }
+        msid = VAL_STRING(msidval);
+    }
+
+    len = xml_strlen(schema_cache) + xml_strlen(module) + 16 +
+        xml_strlen((revision) ? revision : msid);
+    filespec = m__getMem(len);
+    if (filespec == NULL) {
+        return NULL;
+    }
+
+    p = filespec;
+    p += xml_strcpy(p, schema_cache);
+    if (p == filespec || p[-1] != '/') {
+        *p++ = '/';
+    }
+    p += xml_strcpy(p, module);
+    *p++ = '@';
+    if (revision) {
+        p += xml_strcpy(p, revision);
+    } else {
+        p += xml_strcpy(p, (const xmlChar *)"set-");
+        p += xml_strcpy(p, msid);
+    }
+    p += xml_strcpy(p, (const xmlChar *)".yang");
+
+    return filespec;
+
+}  /* make_schema_cache_filespec */
+
+
+/********************************************************************
+* FUNCTION find_schema_cache_file
+* 
+* Check if a module is stored in the schema cache
+*
+* INPUTS:
+*    mscb == manager session control block to use
+*    module == module name
+*    revision == revision date (may be NULL)
+*
+* RETURNS:
+*    malloced filespec of the cached file or NULL if not found
+*********************************************************************/
+static xmlChar *
+    find_schema_cache_file (mgr_scb_t *mscb,
+                            const xmlChar *module,
+                            const xmlChar *revision)
+{
+    xmlChar      *filespec;
+    struct stat   statbuf;
+
+    filespec = make_schema_cache_filespec(mscb, module, revision);
+    if (filespec == NULL) {
+        return NULL;
+    }
+
+    if (stat((const char *)filespec, &statbuf) != 0 ||
+        !S_ISREG(statbuf.st_mode)) {
+        m__free(filespec);
+        return NULL;
+    }
+    return filespec;
+
+}  /* find_schema_cache_file */
+
+
+/********************************************************************
+* FUNCTION save_schema_cache_file
+* 
+* Store a module retrieved with <get-schema> in the schema cache
+* The file is written under a temporary name and renamed,
+* so other yangcli instances never see a partial file
+* Errors are not fatal; the module is just not cached
+*
+* INPUTS:
+*    mscb == manager session control block to use
+*    module == module name
+*    revision == revision date (may be NULL)
+*    source == complete pathspec of the retrieved YANG file
+*********************************************************************/
+static void
+    save_schema_cache_file (mgr_scb_t *mscb,
+                            const xmlChar *module,
+                            const xmlChar *revision,
+                            const xmlChar *source)
+{
+    xmlChar   *filespec, *tempfile;
+    status_t   res;
+
+    filespec = make_schema_cache_filespec(mscb, module, revision);
+    if (filespec == NULL) {
+        return;
+    }
+
+    tempfile = m__getMem(xml_strlen(filespec) + 16);
+    if (tempfile == NULL) {
+        m__free(filespec);
+        return;
+    }
+    sprintf((char *)tempfile, "%s.%u",
+            (const char *)filespec,
+            (uint32)getpid());
+
+    res = copy_schema_file(source, tempfile);
+    if (res == NO_ERR &&
+        rename((const char *)tempfile, (const char *)filespec) != 0) {
+        res = errno_to_status();
+    }
+
+    if (res != NO_ERR) {
+        log_debug("\nautoload: cannot write schema cache file '%s' (%s)",
+                  filespec,
+                  get_error_string(res));
+        (void)unlink((const char *)tempfile);
+    } else if (LOGDEBUG2) {
+        log_debug2("\nautoload: saved module '%s' in schema cache '%s'",
+                   module,
+                   filespec);
+    }
+
+    m__free(tempfile);
+    m__free(filespec);
+
+}  /* save_schema_cache_file */
+
+
 static ncxmod_temp_filcb_t *
     get_new_temp_filcb (mgr_scb_t *mscb,
                         const xmlChar *module,
@@ -454,6 +750,12 @@ status_t get_schema_reply_to_temp_filcb(server_cb_t * server_cb, mgr_scb_t *mscb
                                    revision,
                                    temp_filcb->source,
                                    dataval);
+            if (res == NO_ERR) {
+                save_schema_cache_file(mscb,
+                                       module,
+                                       revision,
+                                       temp_filcb->source);
+            }
         }
     }
 
@@ -480,16 +782,11 @@ static status_t
                             const xmlChar *revision,
                             const xmlChar *source)
 {
-    xmlChar             *linebuffer;
-    FILE                *srcfile, *destfile;
     ncxmod_temp_filcb_t *temp_filcb;
-    boolean              done, isyang;
+    boolean              isyang;
     status_t             res;
 
     res = NO_ERR;
-    linebuffer = NULL;
-    srcfile = NULL;
-    destfile = NULL;
 
     if (yang_fileext_is_yang(source)) {
         isyang = TRUE;
@@ -504,60 +801,12 @@ static status_t
         return res;
     }
 
-    /* get a buffer for transferring lines */
-    linebuffer = m__getMem(NCX_MAX_LINELEN+1);;
-    if (linebuffer == NULL) {
-        ncxmod_free_session_tempfile(temp_filcb);
-        return ERR_INTERNAL_MEM;
-    }
-
-#ifdef YANGCLI_AUTOLOAD_DEBUG
-    if (LOGDEBUG2) {
-        log_debug2("\nyangcli_autoload: Copying '%s' to '%s'",
-                   source,
-                   temp_filcb->source);
-    }
-#endif
-
-    /* open the destination file for writing */
-    destfile = fopen((const char *)temp_filcb->source, "w+");
-    if (destfile == NULL) {
-        res = errno_to_status();
-        ncxmod_free_session_tempfile(temp_filcb);
-        m__free(linebuffer);
-        return res;
-    }
-
-    /* open the YANG or YIN source file for reading */
-    srcfile = fopen((const char *)source, "r");
-    if (srcfile == NULL) {
-        res = errno_to_status();
-        fclose(destfile);
+    res = copy_schema_file(source, temp_filcb->source);
+    if (res != NO_ERR && res != ERR_FIL_WRITE) {
+        /*** keeping partial file around on write errors!!! ***/
         ncxmod_free_session_tempfile(temp_filcb);
-        m__free(linebuffer);
-        return res;
     }
 
-    done = FALSE;
-    while (!done) {
-        if (!fgets((char *)linebuffer, NCX_MAX_LINELEN, srcfile)) {
-            /* read line failed, not an error */
-            done = TRUE;
-            continue;
-        }
-
-        if (fputs((const char *)linebuffer, destfile) == EOF) {
-            log_error("\nError: copy to temp file failed");
-            /*** keeping partial file around!!! ***/
-            done = TRUE;
-            res = ERR_FIL_WRITE;
-        }
-    }
-
-    fclose(srcfile);
-    fclose(destfile);
-    m__free(linebuffer);
-
     return res;
 
 }   /* copy_module_to_tempdir */
@@ -740,6 +989,126 @@ static status_t
 }  /* autoload_module */
 
 
+/********************************************************************
+* FUNCTION next_get_schema_result
+* 
+* Find the next search result that needs to be
+* retrieved with <get-schema>
+*
+* INPUTS:
+*   server_cb == server control block to use
+*   searchresult == search result to start after
+*                == NULL to start with the first entry
+*
+* RETURNS:
+*    search result for the next module to retrieve
+*    NULL if none left
+*********************************************************************/
+static ncxmod_search_result_t *
+    next_get_schema_result (server_cb_t *server_cb,
+                            ncxmod_search_result_t *searchresult)
+{
+    if (searchresult == NULL) {
+        searchresult = (ncxmod_search_result_t *)
+            dlq_firstEntry(&server_cb->searchresultQ);
+    } else {
+        searchresult = (ncxmod_search_result_t *)
+            dlq_nextEntry(searchresult);
+    }
+
+    for (; searchresult != NULL;
+         searchresult = (ncxmod_search_result_t *)
+             dlq_nextEntry(searchresult)) {
+
+        /* skip found entries */
+        if (searchresult->source != NULL) {
+            continue;
+        }
+
+        /* skip found modules with errors */          
+        if (!(searchresult->res == ERR_NCX_WRONG_VERSION ||
+              searchresult->res == ERR_NCX_MOD_NOT_FOUND)) {
+            continue;
+        }
+
+        /* module not found or wrong version found */
+        return searchresult;
+    }
+    return NULL;
+
+}  /* next_get_schema_result */
+
+
+/********************************************************************
+* FUNCTION send_get_schema_window
+* 
+* Send <get-schema> requests for the modules after the
+* last one requested, until server_cb->autoload_window
+* requests are outstanding or no modules are left
+*
+* NETCONF servers reply to the requests in the order
+* they were received, so the search result of the oldest
+* outstanding request is kept in server_cb->cursearchresult
+*
+* INPUTS:
+*   server_cb == server control block to use
+*   scb == session control block to use
+*
+* OUTPUTS:
+*   server_cb->autoload_pending and autoload_lastsent updated
+*   server_cb->cursearchresult set if it was NULL and
+*   a request was sent
+*
+* RETURNS:
+*    status of the last request that could not be sent
+*********************************************************************/
+static status_t
+    send_get_schema_window (server_cb_t *server_cb,
+                            ses_cb_t *scb)
+{
+    ncxmod_search_result_t  *searchresult;
+    status_t                 res, retres;
+    uint32                   window;
+
+    retres = NO_ERR;
+    window = (server_cb->autoload_window) ? server_cb->autoload_window : 1;
+
+    while (server_cb->autoload_pending < window) {
+        searchresult = next_get_schema_result(server_cb,
+                                              server_cb->autoload_lastsent);
+        if (searchresult == NULL) {
+            break;
+        }
+
+        res = send_get_schema_to_server(server_cb,
+                                        scb,
+                                        searchresult->module,
+                                        searchresult->revision);
+        if (res != NO_ERR) {
+            /* skip this module and try to compile without it */
+            log_error("\nError: <get-schema> for module '%s', "
+                      "revision '%s' not sent (%s)",
+                      searchresult->module,
+                      (searchresult->revision) ? 
+                      searchresult->revision : EMPTY_STRING,
+                      get_error_string(res));
+            searchresult->res = res;
+            retres = res;
+            continue;
+        }
+
+        if (server_cb->cursearchresult == NULL) {
+            server_cb->cursearchresult = searchresult;
+        }
+        server_cb->autoload_lastsent = searchresult;
+        server_cb->autoload_pending++;
+    }
+
+    return retres;
+
+}  /* send_get_schema_window */
+
+
 /**************    E X T E R N A L   F U N C T I O N S **********/
 
 
@@ -775,6 +1144,7 @@ status_t
     mgr_scb_t               *mscb;
     ncxmod_search_result_t  *searchresult;
     ncx_module_t            *testmod;
+    xmlChar                 *cachefile;
     status_t                 res, retres;
     boolean                  need_yt, need_ncx, need_nacm, need_ync;
 
@@ -894,6 +1264,52 @@ status_t
             }
         }
     }
+
+    /* use the schema cache for the modules that would
+     * otherwise be retrieved with <get-schema>
+     */
+    for (searchresult = (ncxmod_search_result_t *)
+             dlq_firstEntry(&server_cb->searchresultQ);
+         searchresult != NULL && schema_cache != NULL;
+         searchresult = (ncxmod_search_result_t *)
+             dlq_nextEntry(searchresult)) {
+
+        if (searchresult->source != NULL ||
+            !(searchresult->res == ERR_NCX_WRONG_VERSION ||
+              searchresult->res == ERR_NCX_MOD_NOT_FOUND)) {
+            continue;
+        }
+
+        cachefile = find_schema_cache_file(mscb,
+                                           searchresult->module,
+                                           searchresult->revision);
+        if (cachefile == NULL) {
+            continue;
+        }
+
+        res = copy_module_to_tempdir(mscb,
+                                     searchresult->module,
+                                     searchresult->revision,
+                                     cachefile);
+        if (res == NO_ERR) {
+            if (LOGDEBUG) {
+                log_debug("\nautoload: Using cached module '%s' "
+                          "revision '%s'",
+                          searchresult->module,
+                          (searchresult->revision) ? 
+                          searchresult->revision : EMPTY_STRING);
+            }
+            searchresult->source = cachefile;
+        } else {
+            /* not fatal; try <get-schema> instead */
+            log_debug("\nautoload: cannot use schema cache file "
+                      "'%s' (%s)",
+                      cachefile,
+                      get_error_string(res));
+            m__free(cachefile);
+        }
+    }
+
     return retres;
 
 }  /* autoload_setup_tempdir */
@@ -908,6 +1324,9 @@ status_t
 * make sure all files are present.  Try to use the
 * <get-schema> operation to fill in any missing modules
 *
+* Up to server_cb->autoload_window requests are sent
+* without waiting for the replies
+*
 * INPUTS:
 *   server_cb == server session control block to use
 *   scb == session control block to use
@@ -924,9 +1343,7 @@ status_t
     autoload_start_get_modules (server_cb_t *server_cb,
                                 ses_cb_t *scb)
 {
-    ncxmod_search_result_t  *searchresult;
     status_t                 res;
-    boolean                  done;
 
 #ifdef DEBUG
     if (!server_cb || !scb) {
@@ -934,41 +1351,15 @@ status_t
     }
 #endif
 
-    done = FALSE;
-    res = NO_ERR;
-
-    /* find first file that needs to be retrieved with get-schema */
-    for (searchresult = (ncxmod_search_result_t *)
-             dlq_firstEntry(&server_cb->searchresultQ);
-         searchresult != NULL && !done;
-         searchresult = (ncxmod_search_result_t *)
-             dlq_nextEntry(searchresult)) {
-
-        /* skip found entries */
-        if (searchresult->source != NULL) {
-            continue;
-        }
-
-        /* skip found modules with errors */          
-        if (!(searchresult->res == ERR_NCX_WRONG_VERSION ||
-              searchresult->res == ERR_NCX_MOD_NOT_FOUND)) {
-            continue;
-        }
-
-        /* found an entry that needs to be retrieved
-         * either module not found or wrong version found
-         */
-        done = TRUE;
+    server_cb->cursearchresult = NULL;
+    server_cb->autoload_lastsent = NULL;
+    server_cb->autoload_pending = 0;
 
-        res = send_get_schema_to_server(server_cb,
-                                       scb,
-                                       searchresult->module,
-                                       searchresult->revision);
-        if (res == NO_ERR) {
-            server_cb->command_mode = CMD_MODE_AUTOLOAD;
-            server_cb->cursearchresult = searchresult;
-        }
-        /* exit loop if we get here */
+    /* send the first window of <get-schema> requests */
+    res = send_get_schema_window(server_cb, scb);
+    if (server_cb->autoload_pending) {
+        server_cb->command_mode = CMD_MODE_AUTOLOAD;
+        return NO_ERR;
     }
 
     return res;
@@ -994,7 +1385,8 @@ status_t
 *   the the specified YANG files that was retrieved from
 *   the device with <get-schema>
 *
-*   Next request is started, or autoload process is completed
+*   More requests are sent to keep server_cb->autoload_window
+*   requests outstanding, or the autoload process is completed
 *   and the command_mode is changed back to CMD_MODE_NORMAL
 *
 * RETURNS:
@@ -1010,7 +1402,6 @@ status_t
     ncxmod_search_result_t  *searchresult;
     const xmlChar           *module, *revision;
     status_t                 res;
-    boolean                  done;
 
 #ifdef DEBUG
     if (!server_cb || !scb || !reply) {
@@ -1018,7 +1409,6 @@ status_t
     }
 #endif
 
-    done = FALSE;
     res = NO_ERR;
     mscb = (mgr_scb_t *)scb->mgrcb;
     searchresult = server_cb->cursearchresult;
@@ -1073,40 +1463,24 @@ status_t
 
     }
 
-    /* find next file that needs to be retrieved with get-schema */
-    for (searchresult = (ncxmod_search_result_t *)
-             dlq_nextEntry(server_cb->cursearchresult);
-         searchresult != NULL && !done;
-         searchresult = (ncxmod_search_result_t *)
-             dlq_nextEntry(searchresult)) {
-
-        /* skip found entries */
-        if (searchresult->source != NULL) {
-            continue;
-        }
-
-        /* skip found modules with errors */          
-        if (!(searchresult->res == ERR_NCX_WRONG_VERSION ||
-              searchresult->res == ERR_NCX_MOD_NOT_FOUND)) {
-            continue;
-        }
-
-        /* found an entry that needs to be retrieved */
-        server_cb->command_mode = CMD_MODE_AUTOLOAD;
-        server_cb->cursearchresult = searchresult;
-        done = TRUE;
-
-        res = send_get_schema_to_server(server_cb,
-                                       scb,
-                                       searchresult->module,
-                                       searchresult->revision);
+    /* the reply to the next oldest request is expected next */
+    if (server_cb->autoload_pending) {
+        server_cb->autoload_pending--;
     }
+    server_cb->cursearchresult = (server_cb->autoload_pending) ?
+        next_get_schema_result(server_cb, searchresult) : NULL;
+
+    /* keep the window of outstanding requests full */
+    res = send_get_schema_window(server_cb, scb);
 
-    if (!done) {
+    if (server_cb->autoload_pending == 0) {
         /* no search results left to get */
         return autoload_compile_modules(server_cb, scb);
     }
 
+    server_cb->command_mode = CMD_MODE_AUTOLOAD;
+    server_cb->state = MGR_IO_ST_CONN_RPYWAIT;
+
     return res;
 
 }  /* autoload_handle_rpc_reply */
@@ -1180,6 +1554,11 @@ status_t
      */
     ncx_set_cur_modQ(&mscb->temp_modQ);
 
+    /* tokenize all the server modules into the token cache
+     * in parallel, if prefetch jobs are enabled
+     */
+    ncxmod_prefetch_modules(&server_cb->searchresultQ);
+
     /* !!! temp until the ietf-netconf.yang module
      * is fully supported.  The yuma-netconf.yang
      * module is pre-loaded as the first module
@@ -1314,10 +1693,86 @@ status_t
 
     server_cb->command_mode = CMD_MODE_NORMAL;
     server_cb->cursearchresult = NULL;
+    server_cb->autoload_lastsent = NULL;
+    server_cb->autoload_pending = 0;
 
     return res;
 
 }  /* autoload_compile_modules */
 
 
+/********************************************************************
+* FUNCTION autoload_set_schema_cache
+* 
+* Set the directory of the persistent schema cache
+*
+* Modules retrieved with <get-schema> are stored in this
+* directory and used instead of <get-schema> by later sessions
+* The directory is created if it does not exist.
+* If no YANG token cache is set, a 'tokens' subdirectory
+* is used as the token cache, so the cached modules are
+* also not tokenized again.  That token cache is cleared
+* again when the schema cache is disabled or changed
+*
+* INPUTS:
+*   cachedir == schema cache directory, NULL to disable the cache
+*
+* RETURNS:
+*    status
+*********************************************************************/
+status_t
+    autoload_set_schema_cache (const xmlChar *cachedir)
+{
+    xmlChar     *tokendir;
+    status_t     res;
+
+    if (schema_cache != NULL) {
+        m__free(schema_cache);
+        schema_cache = NULL;
+    }
+    if (schema_cache_tokens) {
+        ncxmod_set_tkcache(NULL);
+        schema_cache_tokens = FALSE;
+    }
+
+    if (cachedir == NULL || *cachedir == 0) {
+        return NO_ERR;
+    }
+
+    res = NO_ERR;
+    schema_cache = ncx_get_source(cachedir, &res);
+    if (schema_cache == NULL) {
+        return res;
+    }
+
+    if (mkdir((const char *)schema_cache, S_IRWXU) != 0 &&
+        errno != EEXIST) {
+        res = errno_to_status();
+        log_error("\nError: Could not setup schema cache '%s' (%s)",
+                  schema_cache,
+                  get_error_string(res));
+        m__free(schema_cache);
+        schema_cache = NULL;
+        return res;
+    }
+
+    if (ncxmod_get_tkcache() == NULL) {
+        tokendir = m__getMem(xml_strlen(schema_cache) + 8);
+        if (tokendir == NULL) {
+            return ERR_INTERNAL_MEM;
+        }
+        sprintf((char *)tokendir, "%s/tokens", (const char *)schema_cache);
+        if (mkdir((const char *)tokendir, S_IRWXU) == 0 ||
+            errno == EEXIST) {
+            ncxmod_set_tkcache(tokendir);
+            schema_cache_tokens = TRUE;
+        }
+        m__free(tokendir);
+    }
+
+    return NO_ERR;
+
+}  /* autoload_set_schema_cache */
+
+
 /* END yangcli_autoload.c */
@@ -205,6 +205,29 @@ status_t make_get_schema_reqdata(server_cb_t *server_cb,
 
 status_t get_schema_reply_to_temp_filcb(server_cb_t * server_cb, mgr_scb_t *mscb, const xmlChar* module, const xmlChar* revision, val_value_t* reply);
 
+
+/********************************************************************
+* FUNCTION autoload_set_schema_cache
+* 
+* Set the directory of the persistent schema cache
+*
+* Modules retrieved with <get-schema> are stored in this
+* directory and used instead of <get-schema> by later sessions
+* The directory is created if it does not exist.
+* If no YANG token cache is set, a 'tokens' subdirectory
+* is used as the token cache, so the cached modules are
+* also not tokenized again.  That token cache is cleared
+* again when the schema cache is disabled or changed
+*
+* INPUTS:
+*   cachedir == schema cache directory, NULL to disable the cache
+*
+* RETURNS:
+*    status
+*********************************************************************/
+extern status_t
+    autoload_set_schema_cache (const xmlChar *cachedir);
+
 #ifdef __cplusplus
 }  /* end extern 'C' */
 #endif
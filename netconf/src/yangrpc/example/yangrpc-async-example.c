@@ -0,0 +1,97 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "ncx.h"
+#include "ncxmod.h"
+#include "val.h"
+#include "yangrpc.h"
+
+#define SESSIONS 4
+#define REQUESTS 100
+
+static unsigned int replies;
+
+static void reply_cb(yangrpc_cb_ptr_t yangrpc_cb_ptr, void* cookie, status_t res, val_value_t* reply_val)
+{
+    unsigned int* session_replies = (unsigned int*)cookie;
+
+    assert(res==NO_ERR);
+    assert(reply_val!=NULL);
+    (*session_replies)++;
+    replies++;
+    val_free_value(reply_val);
+}
+
+int main(int argc, char* argv[])
+{
+    status_t res;
+    yangrpc_cb_ptr_t yangrpc_cb_ptrs[SESSIONS];
+    unsigned int session_replies[SESSIONS];
+    unsigned int completed;
+    unsigned int i, j;
+    ncx_module_t * ietf_netconf_mod;
+    obj_template_t* rpc_obj;
+    obj_template_t* input_obj;
+    obj_template_t* filter_obj;
+
+    val_value_t* request_val;
+    val_value_t* filter_val;
+    val_value_t* type_meta_val;
+    val_value_t* select_meta_val;
+
+    res = yangrpc_init(NULL);
+    assert(res==NO_ERR);
+    for(i=0;i<SESSIONS;i++) {
+        res = yangrpc_connect("127.0.0.1"/*server*/, 830/*port*/, "vladimir"/*user*/,""/*password*/,"/home/vladimir/.ssh/id_rsa.pub"/*public_key*/, "/home/vladimir/.ssh/id_rsa"/*private_key*/, NULL, &yangrpc_cb_ptrs[i]);
+        assert(res==NO_ERR);
+        session_replies[i]=0;
+    }
+
+    res = ncxmod_load_module ((const xmlChar *)"ietf-netconf", NULL, NULL, &ietf_netconf_mod);
+    assert(res==NO_ERR);
+
+    rpc_obj = ncx_find_object(ietf_netconf_mod, (const xmlChar *)"get");
+    assert(obj_is_rpc(rpc_obj));
+    input_obj = obj_find_child(rpc_obj, NULL, (const xmlChar *)"input");
+    assert(input_obj!=NULL);
+    filter_obj = obj_find_child(input_obj, NULL, (const xmlChar *)"filter");
+    assert(filter_obj!=NULL);
+
+    request_val = val_new_value();
+    val_init_from_template(request_val, rpc_obj);
+    filter_val = val_new_value();
+    val_init_from_template(filter_val, filter_obj);
+
+    type_meta_val = val_make_string(0, (const xmlChar *)"type", (const xmlChar *)"xpath");
+    select_meta_val = val_make_string(0, (const xmlChar *)"select", (const xmlChar *)"/interfaces-state");
+
+    val_add_meta(select_meta_val, filter_val);
+    val_add_meta(type_meta_val, filter_val);
+    val_add_child(filter_val, request_val);
+
+    /* queue all requests without waiting for the replies */
+    for(i=0;i<SESSIONS;i++) {
+        for(j=0;j<REQUESTS;j++) {
+            res = yangrpc_async_exec(yangrpc_cb_ptrs[i], request_val, reply_cb, &session_replies[i]);
+            assert(res==NO_ERR);
+        }
+    }
+
+    /* send them and collect the replies from all sessions */
+    while(replies<SESSIONS*REQUESTS) {
+        res = yangrpc_async_poll(yangrpc_cb_ptrs, SESSIONS, -1, &completed);
+        assert(res==NO_ERR);
+    }
+
+    for(i=0;i<SESSIONS;i++) {
+        printf("session %u: %u replies\n", i, session_replies[i]);
+        assert(yangrpc_async_pending(yangrpc_cb_ptrs[i])==0);
+    }
+
+    val_free_value(request_val);
+
+    for(i=0;i<SESSIONS;i++) {
+        yangrpc_close(yangrpc_cb_ptrs[i]);
+    }
+    return 0;
+}
@@ -23,6 +23,7 @@
 #include <ctype.h>
 #include <time.h>
 #include <sys/time.h>
+#include <poll.h>
 #include <assert.h>
 
 #include "mgr.h"
@@ -52,6 +53,7 @@
 #include "runstack.h"
 #include "ses_msg.h"
 #include "status.h"
+#include "uptime.h"
 #include "val.h"
 #include "val_util.h"
 #include "var.h"
@@ -74,6 +76,21 @@
 
 #include "yangrpc.h"
 
+/* yangrpc_async_exec request context, req->replydata */
+typedef struct yangrpc_async_req_t_ {
+    dlq_hdr_t             qhdr;
+    yangrpc_cb_ptr_t      yangrpc_cb_ptr;
+    yangrpc_async_cbfn_t  cbfn;
+    void                 *cookie;
+    status_t              res;
+    val_value_t          *reply_val;
+} yangrpc_async_req_t;
+
+/* Q of yangrpc_async_req_t completed and waiting for the
+ * callback to be called by yangrpc_async_poll
+ */
+static dlq_hdr_t async_doneQ;
+
 extern void
     create_session (server_cb_t *server_cb);
 
@@ -314,6 +331,8 @@ status_t yangrpc_init(char* args)
     /* set the default debug output level */
     log_level = LOG_DEBUG_INFO;
 
+    dlq_createSQue(&async_doneQ);
+
     yangcli_init_module_static_vars();
 
     /* initialize the NCX Library first to allow NCX modules
@@ -1129,6 +1148,298 @@ status_t yangrpc_exec(yangrpc_cb_ptr_t yangrpc_cb_ptr, val_value_t* request_val,
     return NO_ERR;
 }
 
+/********************************************************************
+ * FUNCTION yangrpc_async_reply_handler
+ * 
+ *  handle incoming <rpc-reply> messages for yangrpc_async_exec
+ *  requests; the callback is called later by yangrpc_async_poll
+ * 
+ * INPUTS:
+ *   scb == session receiving RPC reply
+ *   req == original request returned for freeing or reusing
+ *   rpy == reply received from the server (for checking then freeing)
+ *
+ * RETURNS:
+ *   none
+ *********************************************************************/
+static void
+    yangrpc_async_reply_handler (ses_cb_t *scb,
+                                 mgr_rpc_req_t *req,
+                                 mgr_rpc_rpy_t *rpy)
+{
+    yangrpc_async_req_t  *asyncreq;
+
+    asyncreq = (yangrpc_async_req_t *)req->replydata;
+    asyncreq->res = rpy->res;
+    asyncreq->reply_val = rpy->reply;
+    rpy->reply = NULL;
+    dlq_enque(asyncreq, &async_doneQ);
+
+    mgr_rpc_free_request(req);
+    mgr_rpc_free_reply(rpy);
+
+}  /* yangrpc_async_reply_handler */
+
+/********************************************************************
+ * FUNCTION fail_async_requests
+ * 
+ *  Complete the outstanding yangrpc_async_exec requests
+ *  of a session without a reply
+ * 
+ * INPUTS:
+ *   scb == session control block
+ *   res == status to pass to the callbacks
+ *   timedout_only == TRUE to complete only the requests
+ *                    whose timeout has expired
+ *
+ *********************************************************************/
+static void
+    fail_async_requests (ses_cb_t *scb,
+                         status_t res,
+                         boolean timedout_only)
+{
+    mgr_scb_t            *mscb;
+    mgr_rpc_req_t        *req, *nextreq;
+    yangrpc_async_req_t  *asyncreq;
+    time_t                timenow;
+
+    mscb = mgr_ses_get_mscb(scb);
+    (void)uptime(&timenow);
+
+    for (req = (mgr_rpc_req_t *)dlq_firstEntry(&mscb->reqQ);
+         req != NULL;
+         req = nextreq) {
+
+        nextreq = (mgr_rpc_req_t *)dlq_nextEntry(req);
+
+        if (req->replycb != (void *)yangrpc_async_reply_handler) {
+            continue;
+        }
+        if (timedout_only &&
+            (!req->timeout ||
+             difftime(timenow, req->starttime) < (double)req->timeout)) {
+            continue;
+        }
+
+        log_info("\nyangrpc: request '%s' on session %u failed (%s)",
+                 req->msg_id,
+                 scb->sid,
+                 get_error_string(res));
+        asyncreq = (yangrpc_async_req_t *)req->replydata;
+        asyncreq->res = res;
+        dlq_remove(req);
+        dlq_enque(asyncreq, &async_doneQ);
+        mgr_rpc_free_request(req);
+    }
+
+}  /* fail_async_requests */
+
+/********************************************************************
+ * FUNCTION close_async_session
+ * 
+ *  Complete the outstanding yangrpc_async_exec requests
+ *  of a dropped session and free the session
+ * 
+ * INPUTS:
+ *   scb == session control block
+ *
+ *********************************************************************/
+static void
+    close_async_session (ses_cb_t *scb)
+{
+    fail_async_requests(scb, ERR_NCX_SESSION_CLOSED, FALSE);
+    mgr_ses_free_session(scb->sid);
+
+}  /* close_async_session */
+
+status_t yangrpc_async_exec(yangrpc_cb_ptr_t yangrpc_cb_ptr, val_value_t* request_val, yangrpc_async_cbfn_t cbfn, void* cookie)
+{
+    status_t res;
+    ses_cb_t* scb;
+    mgr_scb_t* mscb;
+    mgr_rpc_req_t *req;
+    yangrpc_async_req_t *asyncreq;
+    server_cb_t* server_cb;
+    server_cb = (server_cb_t*)yangrpc_cb_ptr;
+
+    scb = mgr_ses_get_scb(server_cb->mysid);
+    if (!scb) {
+        return ERR_NCX_SESSION_CLOSED;
+    }
+    mscb = (mgr_scb_t *)scb->mgrcb;
+    ncx_set_temp_modQ(&mscb->temp_modQ);
+    ncx_set_session_modQ(&mscb->temp_modQ);
+
+    asyncreq = m__getObj(yangrpc_async_req_t);
+    if (!asyncreq) {
+        return ERR_INTERNAL_MEM;
+    }
+    memset(asyncreq, 0x0, sizeof(yangrpc_async_req_t));
+    asyncreq->yangrpc_cb_ptr = yangrpc_cb_ptr;
+    asyncreq->cbfn = cbfn;
+    asyncreq->cookie = cookie;
+
+    req = mgr_rpc_new_request(scb);
+    if (!req) {
+        m__free(asyncreq);
+        log_error("\nError allocating a new RPC request");
+        return ERR_INTERNAL_MEM;
+    }
+    req->data = val_clone(request_val);
+    if (!req->data) {
+        mgr_rpc_free_request(req);
+        m__free(asyncreq);
+        return ERR_INTERNAL_MEM;
+    }
+    req->rpc = request_val->obj;
+    req->timeout = server_cb->timeout;
+    req->replydata = asyncreq;
+
+    /* the request will be stored if this returns NO_ERR,
+     * the buffers are sent by yangrpc_async_poll
+     */
+    res = mgr_rpc_send_request(scb, req, yangrpc_async_reply_handler);
+    if (res != NO_ERR) {
+        log_error("\nError: send <%s> message failed (%s)",
+                  obj_get_name(req->rpc),
+                  get_error_string(res));
+        mgr_rpc_free_request(req);
+        m__free(asyncreq);
+    }
+    return res;
+}
+
+unsigned int yangrpc_async_pending(yangrpc_cb_ptr_t yangrpc_cb_ptr)
+{
+    ses_cb_t* scb;
+    mgr_scb_t* mscb;
+    server_cb_t* server_cb;
+    server_cb = (server_cb_t*)yangrpc_cb_ptr;
+
+    scb = mgr_ses_get_scb(server_cb->mysid);
+    if (!scb) {
+        return 0;
+    }
+    mscb = (mgr_scb_t *)scb->mgrcb;
+    return dlq_count(&mscb->reqQ);
+}
+
+status_t yangrpc_async_poll(yangrpc_cb_ptr_t* yangrpc_cb_ptrs, unsigned int count, int timeout_msec, unsigned int* completed)
+{
+    status_t res;
+    ses_cb_t* scb;
+    mgr_scb_t* mscb;
+    server_cb_t* server_cb;
+    struct pollfd* fds;
+    yangrpc_async_req_t* asyncreq;
+    unsigned int i;
+    unsigned int waiting;
+    int ret;
+
+    *completed = 0;
+    waiting = 0;
+
+    fds = malloc(count*sizeof(struct pollfd));
+    if (count && fds==NULL) {
+        return ERR_INTERNAL_MEM;
+    }
+
+    /* send the queued requests */
+    for (i=0; i<count; i++) {
+        server_cb = (server_cb_t*)yangrpc_cb_ptrs[i];
+        fds[i].fd = -1;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+        scb = mgr_ses_get_scb(server_cb->mysid);
+        if (!scb) {
+            continue;
+        }
+        if (!dlq_empty(&scb->outQ)) {
+            res = ses_msg_send_buffs(scb);
+            if (res != NO_ERR) {
+                log_error("\nError: yangrpc send failed on session %u (%s)",
+                          scb->sid,
+                          get_error_string(res));
+                close_async_session(scb);
+                continue;
+            }
+        }
+        mscb = (mgr_scb_t *)scb->mgrcb;
+        if (!dlq_empty(&mscb->reqQ)) {
+            fds[i].fd = scb->fd;
+            waiting++;
+            /* time_t resolution is enough for the request timeouts */
+            if (server_cb->timeout &&
+                (timeout_msec < 0 || timeout_msec > 1000)) {
+                timeout_msec = 1000;
+            }
+        }
+    }
+
+    if (!dlq_empty(&async_doneQ)) {
+        timeout_msec = 0;
+    } else if (waiting == 0) {
+        /* no replies to wait for, do not block */
+        free(fds);
+        return NO_ERR;
+    }
+
+    ret = poll(fds, count, timeout_msec);
+    if (ret < 0 && errno != EINTR) {
+        log_error("\nError: yangrpc poll failed (%s)", strerror(errno));
+        free(fds);
+        return ERR_NCX_OPERATION_FAILED;
+    }
+
+    /* read the replies one session at a time so each is
+     * parsed with the modules of its own session
+     */
+    for (i=0; i<count && ret > 0; i++) {
+        if (fds[i].fd == -1 || fds[i].revents == 0) {
+            continue;
+        }
+        server_cb = (server_cb_t*)yangrpc_cb_ptrs[i];
+        scb = mgr_ses_get_scb(server_cb->mysid);
+        if (!scb) {
+            continue;
+        }
+        mscb = (mgr_scb_t *)scb->mgrcb;
+        ncx_set_temp_modQ(&mscb->temp_modQ);
+        ncx_set_session_modQ(&mscb->temp_modQ);
+
+        res = ses_accept_input(scb);
+        if (res != NO_ERR) {
+            close_async_session(scb);
+            continue;
+        }
+        while (mgr_ses_process_first_ready()) {
+            ;
+        }
+    }
+    free(fds);
+
+    for (i=0; i<count; i++) {
+        server_cb = (server_cb_t*)yangrpc_cb_ptrs[i];
+        scb = mgr_ses_get_scb(server_cb->mysid);
+        if (scb) {
+            fail_async_requests(scb, ERR_NCX_TIMEOUT, TRUE);
+        }
+    }
+
+    /* call the callbacks last, they may queue new requests */
+    while (!dlq_empty(&async_doneQ)) {
+        asyncreq = (yangrpc_async_req_t *)dlq_deque(&async_doneQ);
+        (*asyncreq->cbfn)(asyncreq->yangrpc_cb_ptr,
+                          asyncreq->cookie,
+                          asyncreq->res,
+                          asyncreq->reply_val);
+        m__free(asyncreq);
+        (*completed)++;
+    }
+
+    return NO_ERR;
+}
+
 void yangrpc_close(yangrpc_cb_ptr_t yangrpc_cb_ptr)
 {
     log_info("Closing session\n");
@@ -12,6 +12,22 @@
 
 typedef void* yangrpc_cb_ptr_t;
 
+/* callback invoked by yangrpc_async_poll for each completed
+ * yangrpc_async_exec request
+ *   yangrpc_cb_ptr == session the request was sent on
+ *   cookie == cookie passed to yangrpc_async_exec
+ *   res == NO_ERR if a reply was received
+ *          ERR_NCX_TIMEOUT if no reply came within --timeout
+ *          ERR_NCX_SESSION_CLOSED if the session was dropped
+ *          other error if the reply could not be parsed
+ *   reply_val == RPC reply value or NULL if none;
+ *          owned by the callback, free with val_free_value
+ */
+typedef void (*yangrpc_async_cbfn_t) (yangrpc_cb_ptr_t yangrpc_cb_ptr,
+                                      void* cookie,
+                                      status_t res,
+                                      val_value_t* reply_val);
+
 /********************************************************************
 *								    *
 *			F U N C T I O N S			    *
@@ -97,6 +113,62 @@ status_t yangrpc_parse_cli(yangrpc_cb_ptr_t yangrpc_cb_ptr, char* cli_cmd_str, v
 *********************************************************************/
 status_t yangrpc_exec(yangrpc_cb_ptr_t yangrpc_cb_ptr, val_value_t* request_val, val_value_t** reply_val);
 
+/********************************************************************
+* FUNCTION yangrpc_async_exec
+*
+* Function queueing the RPC request specified in request_val
+* without waiting for the reply. Any number of requests can be
+* outstanding on a session. The request is sent and the reply
+* is received by yangrpc_async_poll which then calls cbfn.
+*
+* INPUTS:
+*   yangrpc_cb_ptr == control block pointer
+*   request_val == RPC request value pointer, copied
+*   cbfn == callback to call with the reply
+*   cookie == user pointer passed to cbfn
+*
+* RETURNS:
+*   status, cbfn is only called if NO_ERR
+*********************************************************************/
+status_t yangrpc_async_exec(yangrpc_cb_ptr_t yangrpc_cb_ptr, val_value_t* request_val, yangrpc_async_cbfn_t cbfn, void* cookie);
+
+/********************************************************************
+* FUNCTION yangrpc_async_pending
+*
+* Function returning the number of requests sent on the session
+* that are still waiting for a reply
+*
+* INPUTS:
+*   yangrpc_cb_ptr == control block pointer
+*
+* RETURNS:
+*   number of outstanding requests
+*********************************************************************/
+unsigned int yangrpc_async_pending(yangrpc_cb_ptr_t yangrpc_cb_ptr);
+
+/********************************************************************
+* FUNCTION yangrpc_async_poll
+*
+* Function sending the queued requests of a set of sessions,
+* waiting up to timeout_msec for replies on any of them and
+* calling the callbacks of the completed requests. A callback
+* may queue new requests with yangrpc_async_exec.
+*
+* INPUTS:
+*   yangrpc_cb_ptrs == array of control block pointers
+*   count == number of entries in yangrpc_cb_ptrs
+*   timeout_msec == poll timeout, -1 to wait for input;
+*      returns after at most 1 second while requests with
+*      a timeout are outstanding and at once if there are
+*      no outstanding requests
+* OUTPUTS:
+*   completed == number of callbacks called
+*
+* RETURNS:
+*   status
+*********************************************************************/
+status_t yangrpc_async_poll(yangrpc_cb_ptr_t* yangrpc_cb_ptrs, unsigned int count, int timeout_msec, unsigned int* completed);
+
 /********************************************************************
 * FUNCTION yangrpc_close
 *
@@ -0,0 +1,190 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def get_config(conn, source):
+	get_config_rpc = """
+<get-config>
+  <source>
+    <%(source)s/>
+  </source>
+  <filter type="subtree">
+    <top xmlns="http://yuma123.org/ns/test-candidate-refill"/>
+  </filter>
+</get-config>
+""" % {'source':source}
+	result = conn.rpc(get_config_rpc)
+	data = result.xpath('./data')
+	assert(len(data)==1)
+	return data[0]
+
+def check_refilled(conn):
+	running = lxml.etree.tostring(get_config(conn, "running"))
+	candidate = lxml.etree.tostring(get_config(conn, "candidate"))
+	print running
+	print candidate
+	assert(running==candidate)
+	return get_config(conn, "running")
+
+def edit(conn, config):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <candidate/>
+  </target>
+  <default-operation>merge</default-operation>
+  <config>
+    <top xmlns="http://yuma123.org/ns/test-candidate-refill" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0">
+%(config)s
+    </top>
+  </config>
+</edit-config>
+""" % {'config':config}
+	result = conn.rpc(edit_config_rpc)
+	print lxml.etree.tostring(result)
+	ok = result.xpath('./ok')
+	assert(len(ok)==1)
+
+def rpc_ok(conn, rpc):
+	result = conn.rpc(rpc)
+	print lxml.etree.tostring(result)
+	ok = result.xpath('./ok')
+	assert(len(ok)==1)
+
+def leaf(data, path):
+	return [node.text for node in data.xpath(path)]
+
+def main():
+	print("""
+#Description: Verify the candidate is the same as running after each refill
+#Procedure:
+#1 - Create entries x, y and z and leaf c. Commit. Verify candidate == running.
+#2 - Delete x/b and change y/a in the same edit. Commit. Verify candidate == running.
+#3 - Change only z/a. Commit. Verify candidate == running (partial refill).
+#4 - Change only y/b. Commit. Verify candidate == running and z/a is kept.
+#5 - Change x/a, delete y, create w and change c. <discard-changes>. Verify candidate == running.
+#6 - Change x/a. Commit. Verify candidate == running.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	commit_rpc = "<commit/>"
+	discard_changes_rpc = "<discard-changes/>"
+
+	print("#1")
+	edit(conn, """
+<entry><name>x</name><a>1</a><b>1</b></entry>
+<entry><name>y</name><a>1</a><b>1</b></entry>
+<entry><name>z</name><a>1</a></entry>
+<c>1</c>
+""")
+	rpc_ok(conn, commit_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, './top/entry/name')==['x', 'y', 'z'])
+
+	print("#2")
+	edit(conn, """
+<entry><name>x</name><b nc:operation="delete"/></entry>
+<entry><name>y</name><a>2</a></entry>
+""")
+	rpc_ok(conn, commit_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, "./top/entry[name='x']/b")==[])
+	assert(leaf(data, "./top/entry[name='y']/a")==['2'])
+
+	print("#3")
+	edit(conn, """
+<entry><name>z</name><a>3</a></entry>
+""")
+	rpc_ok(conn, commit_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, "./top/entry[name='z']/a")==['3'])
+
+	print("#4")
+	edit(conn, """
+<entry><name>y</name><b>4</b></entry>
+""")
+	rpc_ok(conn, commit_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, "./top/entry[name='y']/b")==['4'])
+	assert(leaf(data, "./top/entry[name='z']/a")==['3'])
+
+	print("#5")
+	edit(conn, """
+<entry><name>x</name><a>5</a></entry>
+<entry nc:operation="delete"><name>y</name></entry>
+<entry><name>w</name><a>5</a></entry>
+<c>5</c>
+""")
+	rpc_ok(conn, discard_changes_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, './top/entry/name')==['x', 'y', 'z'])
+	assert(leaf(data, "./top/entry[name='x']/a")==['1'])
+	assert(leaf(data, './top/c')==['1'])
+
+	print("#6")
+	edit(conn, """
+<entry><name>x</name><a>6</a></entry>
+""")
+	rpc_ok(conn, commit_rpc)
+	data = check_refilled(conn)
+	assert(leaf(data, "./top/entry[name='x']/a")==['6'])
+	assert(leaf(data, "./top/entry[name='y']/a")==['2'])
+
+	return 0
+
+sys.exit(main())
@@ -0,0 +1,306 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def get_config(conn):
+	get_config_rpc = """
+<get-config>
+  <source>
+    <running/>
+  </source>
+  <filter type="subtree">
+    <top xmlns="http://yuma123.org/ns/test-child-index"/>
+  </filter>
+</get-config>
+"""
+	result = conn.rpc(get_config_rpc)
+	data = result.xpath('./data')
+	assert(len(data)==1)
+	return data[0]
+
+def edit_rpc(conn, config, operation):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <running/>
+  </target>
+  <default-operation>merge</default-operation>
+  <config>
+    <top xmlns="http://yuma123.org/ns/test-child-index" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" xmlns:yang="urn:ietf:params:xml:ns:yang:1" %(operation)s>
+%(config)s
+    </top>
+  </config>
+</edit-config>
+""" % {'config':config, 'operation':operation}
+	result = conn.rpc(edit_config_rpc)
+	print lxml.etree.tostring(result)
+	return result
+
+def edit(conn, config, operation=""):
+	result = edit_rpc(conn, config, operation)
+	ok = result.xpath('./ok')
+	assert(len(ok)==1)
+
+def edit_error(conn, config):
+	result = edit_rpc(conn, config, "")
+	ok = result.xpath('./ok')
+	assert(len(ok)==0)
+	assert(len(result.xpath('./rpc-error'))==1)
+
+def sys_entry(id, value=None, attrs=""):
+	if value == None:
+		return "<sys %s><id>%u</id></sys>" % (attrs, id)
+	return "<sys %s><id>%u</id><value>%s</value></sys>" % (attrs, id, value)
+
+def user_entry(name, value=None, attrs=""):
+	if value == None:
+		return "<user %s><name>%s</name></user>" % (attrs, name)
+	return "<user %s><name>%s</name><value>%s</value></user>" % (attrs, name, value)
+
+def entries(data, name, key):
+	result = []
+	for node in data.xpath('./top/%s' % name):
+		values = node.xpath('./value')
+		if len(values)==0:
+			value = None
+		else:
+			value = values[0].text
+		result.append((node.xpath('./%s' % key)[0].text, value))
+	return result
+
+def check(conn, sys_model, user_model, ll_model):
+	data = get_config(conn)
+	sys_list = entries(data, "sys", "id")
+	user_list = entries(data, "user", "name")
+	ll_list = [node.text for node in data.xpath('./top/ll')]
+	expected_sys = [("%u" % id, sys_model[id]) for id in sorted(sys_model.keys())]
+	if sys_list != expected_sys:
+		print "sys: %s\nexpected: %s" % (sys_list, expected_sys)
+	assert(sys_list == expected_sys)
+	if user_list != user_model:
+		print "user: %s\nexpected: %s" % (user_list, user_model)
+	assert(user_list == user_model)
+	if ll_list != ll_model:
+		print "ll: %s\nexpected: %s" % (ll_list, ll_model)
+	assert(ll_list == ll_model)
+
+def user_index(user_model, name):
+	return [entry[0] for entry in user_model].index(name)
+
+def user_insert(user_model, name, value, position):
+	# insert the new entry (name, value) "first" or "last"
+	if position == "first":
+		user_model.insert(0, (name, value))
+	else:
+		user_model.append((name, value))
+
+def user_attrs(position):
+	return 'yang:insert="%s"' % position
+
+def ll_move(ll_model, value, position):
+	if value in ll_model:
+		ll_model.remove(value)
+	if position == "first":
+		ll_model.insert(0, value)
+	elif position == "last":
+		ll_model.append(value)
+	else:
+		(where, key) = position.split(" ")
+		i = ll_model.index(key)
+		if where == "after":
+			i = i + 1
+		ll_model.insert(i, value)
+
+def ll_attrs(position):
+	if position in ("first", "last"):
+		return 'yang:insert="%s"' % position
+	(where, key) = position.split(" ")
+	return 'yang:insert="%s" yang:value="%s"' % (where, key)
+
+def main():
+	print("""
+#Description: Verify edits of lists with many entries find the right siblings
+#Procedure:
+#1 - Create 300 system ordered entries in scrambled order.
+#2 - Merge new values into every 6th entry and create 50 entries in between.
+#3 - Delete every 10th entry. Verify deleting one of them again fails.
+#4 - Replace entries and merge into the replaced entries.
+#5 - Create 100 user ordered entries. Insert new entries first and last.
+#6 - Merge values into existing and inserted entries, delete an entry and
+#    append another one. Verify no entry is duplicated.
+#7 - Create 50 user ordered leaf-list entries. Insert new entries and
+#    move existing ones first, before and after others.
+#8 - Replace the whole container, then merge 40 entries into it.
+#Each step checks the exact entries and their order with <get-config>.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	sys_model = {}
+	user_model = []
+	ll_model = []
+
+	print("#1")
+	config = ""
+	for i in range(300):
+		id = ((i * 37) % 300) * 2
+		sys_model[id] = "v%u" % id
+		config += sys_entry(id, sys_model[id])
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#2")
+	config = ""
+	for id in range(0, 600, 6):
+		sys_model[id] = "m%u" % id
+		config += sys_entry(id, sys_model[id])
+	for id in range(1, 100, 2):
+		sys_model[id] = "n%u" % id
+		config += sys_entry(id, sys_model[id])
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#3")
+	config = ""
+	for id in range(0, 600, 10):
+		del sys_model[id]
+		config += sys_entry(id, attrs='nc:operation="delete"')
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+	edit_error(conn, sys_entry(10, attrs='nc:operation="delete"'))
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#4")
+	sys_model[2] = "r2"
+	sys_model[3] = None
+	edit(conn, sys_entry(2, "r2", 'nc:operation="replace"') + sys_entry(3, None, 'nc:operation="replace"'))
+	check(conn, sys_model, user_model, ll_model)
+	sys_model[3] = "m3"
+	sys_model[4] = "m4"
+	edit(conn, sys_entry(3, "m3") + sys_entry(4, "m4"))
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#5")
+	config = ""
+	for i in range(100):
+		name = "u%u" % i
+		user_model.append((name, "v%u" % i))
+		config += user_entry(name, "v%u" % i)
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+	for (name, position) in [("first", "first"),
+				 ("last", "last"),
+				 ("first-2", "first"),
+				 ("last-2", "last")]:
+		value = "i-%s" % name
+		user_insert(user_model, name, value, position)
+		edit(conn, user_entry(name, value, user_attrs(position)))
+		check(conn, sys_model, user_model, ll_model)
+
+	print("#6")
+	config = ""
+	for name in ["u99", "u0", "u30", "first", "last-2"]:
+		i = user_index(user_model, name)
+		user_model[i] = (name, "moved-%s" % name)
+		config += user_entry(name, "moved-%s" % name)
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+	del user_model[user_index(user_model, "u50")]
+	edit(conn, user_entry("u50", attrs='nc:operation="delete"'))
+	user_insert(user_model, "x", "x", "last")
+	edit(conn, user_entry("x", "x"))
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#7")
+	config = ""
+	for i in range(50):
+		ll_model.append("l%u" % i)
+		config += "<ll>l%u</ll>" % i
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+	for (value, position) in [("lfirst", "first"),
+				  ("l49", "before l10"),
+				  ("lx", "after l25"),
+				  ("l0", "after l48"),
+				  ("l20", "after l0"),
+				  ("l1", "before lfirst"),
+				  ("l48", "before l5")]:
+		ll_move(ll_model, value, position)
+		edit(conn, "<ll %s>%s</ll>" % (ll_attrs(position), value))
+		check(conn, sys_model, user_model, ll_model)
+	ll_model.remove("l30")
+	edit(conn, '<ll nc:operation="delete">l30</ll>')
+	check(conn, sys_model, user_model, ll_model)
+
+	print("#8")
+	sys_model = {5:"a", 3:"b", 1:"c"}
+	user_model = [("b", "b"), ("a", "a")]
+	ll_model = ["y", "x"]
+	edit(conn, sys_entry(5, "a") + sys_entry(3, "b") + sys_entry(1, "c") +
+	     user_entry("b", "b") + user_entry("a", "a") +
+	     "<ll>y</ll><ll>x</ll>", 'nc:operation="replace"')
+	check(conn, sys_model, user_model, ll_model)
+	config = ""
+	for id in range(80, 0, -2):
+		sys_model[id] = "p%u" % id
+		config += sys_entry(id, sys_model[id])
+	edit(conn, config)
+	check(conn, sys_model, user_model, ll_model)
+
+	return 0
+
+sys.exit(main())
@@ -0,0 +1,220 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def get_config(conn):
+	get_config_rpc = """
+<get-config>
+  <source>
+    <running/>
+  </source>
+  <filter type="subtree">
+    <top xmlns="http://yuma123.org/ns/test-commit-validation"/>
+  </filter>
+</get-config>
+"""
+	result = conn.rpc(get_config_rpc)
+	data = result.xpath('./data')
+	assert(len(data)==1)
+	return data[0]
+
+def edit(conn, config, test_option="test-then-set"):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <candidate/>
+  </target>
+  <default-operation>merge</default-operation>
+  <test-option>%(test_option)s</test-option>
+  <config>
+    <top xmlns="http://yuma123.org/ns/test-commit-validation" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0">
+%(config)s
+    </top>
+  </config>
+</edit-config>
+""" % {'config':config, 'test_option':test_option}
+	result = conn.rpc(edit_config_rpc)
+	ok = result.xpath('./ok')
+	if len(ok)!=1:
+		print lxml.etree.tostring(result)
+	return len(ok)==1
+
+def commit(conn):
+	result = conn.rpc("<commit/>")
+	ok = result.xpath('./ok')
+	if len(ok)!=1:
+		print lxml.etree.tostring(result)
+	return len(ok)==1
+
+def discard_changes(conn):
+	result = conn.rpc("<discard-changes/>")
+	ok = result.xpath('./ok')
+	assert(len(ok)==1)
+
+def rejected(conn, config):
+	# checked by <edit-config> to the candidate
+	ok = edit(conn, config)
+	discard_changes(conn)
+	if ok:
+		return False
+	# not checked by <edit-config>, so checked by <commit>
+	assert(edit(conn, config, test_option="set"))
+	ok = commit(conn)
+	discard_changes(conn)
+	return not ok
+
+def entries(first, last, fmt):
+	config = ""
+	for i in range(first, last):
+		config = config + fmt % {'name':"n%d" % i, 'i':i}
+	return config
+
+def main():
+	print("""
+#Description: Verify the commit tests still detect each violation when
+#             the edit is far from the node with the constraint
+#Procedure:
+#1 - Create a valid config with 3 list entries. Verify commit succeeds.
+#2 - Lower /top/settings/limit below an entry value. Verify commit fails (must).
+#3 - Delete a target used by an entry ref. Verify commit fails (leafref).
+#4 - Set a and b of one entry to the values of another entry. Verify commit fails (unique).
+#5 - Set a of one entry above its b. Verify commit fails (must on a sibling).
+#6 - Change /top/settings/mode. Verify the extra leafs are removed (when).
+#7 - Delete /top/settings/required only. Verify commit fails (delete-only).
+#8 - Delete an unused target only. Verify commit succeeds (delete-only).
+#9 - Create 1100 entries and lower the limit. Verify commit fails (too many edits).
+#10 - Create 1100 entries. Verify commit succeeds.
+#11 - Change a in 300 entries, one above its b. Verify commit fails (too many anchors).
+#12 - Change a in 300 entries. Verify commit succeeds.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	print("#1")
+	assert(edit(conn, """
+<settings><limit>10</limit><mode>on</mode><required/></settings>
+<target><name>t1</name></target>
+<target><name>t2</name></target>
+<target><name>t3</name></target>
+<entry><name>e1</name><a>1</a><b>1</b><value>5</value><extra>1</extra><ref>t1</ref><need>1</need></entry>
+<entry><name>e2</name><a>2</a><b>2</b><value>5</value><extra>2</extra><ref>t2</ref><need>2</need></entry>
+<entry><name>e3</name><a>3</a><b>3</b><value>5</value><extra>3</extra><ref>t2</ref><need>3</need></entry>
+"""))
+	assert(commit(conn))
+
+	print("#2")
+	assert(rejected(conn, """
+<settings><limit>3</limit></settings>
+"""))
+
+	print("#3")
+	assert(rejected(conn, """
+<target nc:operation="delete"><name>t1</name></target>
+"""))
+
+	print("#4")
+	assert(rejected(conn, """
+<entry><name>e3</name><a>1</a><b>1</b></entry>
+"""))
+
+	print("#5")
+	assert(rejected(conn, """
+<entry><name>e3</name><a>4</a></entry>
+"""))
+
+	print("#6")
+	assert(edit(conn, """
+<settings><mode>off</mode></settings>
+"""))
+	assert(commit(conn))
+	data = get_config(conn)
+	assert(len(data.xpath('./top/entry/extra'))==0)
+
+	print("#7")
+	assert(rejected(conn, """
+<settings><required nc:operation="delete"/></settings>
+"""))
+
+	print("#8")
+	assert(edit(conn, """
+<target nc:operation="delete"><name>t3</name></target>
+"""))
+	assert(commit(conn))
+
+	print("#9")
+	assert(rejected(conn, entries(0, 1100, "<entry><name>%(name)s</name></entry>") + """
+<settings><limit>3</limit></settings>
+"""))
+
+	print("#10")
+	assert(edit(conn, entries(0, 1100, "<entry><name>%(name)s</name><b>1000</b></entry>")))
+	assert(commit(conn))
+	data = get_config(conn)
+	assert(len(data.xpath('./top/entry'))==1103)
+
+	print("#11")
+	assert(rejected(conn, entries(0, 299, "<entry><name>%(name)s</name><a>%(i)d</a></entry>") + """
+<entry><name>n299</name><a>2000</a></entry>
+"""))
+
+	print("#12")
+	assert(edit(conn, entries(0, 300, "<entry><name>%(name)s</name><a>%(i)d</a></entry>")))
+	assert(commit(conn))
+
+	return 0
+
+sys.exit(main())
@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def edit(conn, config):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <running/>
+  </target>
+  <default-operation>merge</default-operation>
+  <config>
+    <top xmlns="http://yuma123.org/ns/test-leafref-running" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0">
+%(config)s
+    </top>
+  </config>
+</edit-config>
+""" % {'config':config}
+	result = conn.rpc(edit_config_rpc)
+	print lxml.etree.tostring(result)
+	ok = result.xpath('./ok')
+	return len(ok)==1
+
+def main():
+	print("""
+#Description: Verify edit-config on running checks the leafrefs to an edited target
+#Procedure:
+#1 - Create items a and b and set ref to a. Verify edit-config succeeds.
+#2 - Delete item a. Verify edit-config fails.
+#3 - Rename item a to c in one edit. Verify edit-config fails.
+#4 - Delete item b. Verify edit-config succeeds.
+#5 - Set ref to c and create item c in one edit. Verify edit-config succeeds.
+#6 - Delete item a. Verify edit-config succeeds.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	print("#1")
+	assert(edit(conn, """
+<item><name>a</name></item>
+<item><name>b</name></item>
+<ref>a</ref>
+"""))
+
+	print("#2")
+	assert(not edit(conn, """
+<item nc:operation="delete"><name>a</name></item>
+"""))
+
+	print("#3")
+	assert(not edit(conn, """
+<item nc:operation="delete"><name>a</name></item>
+<item nc:operation="create"><name>c</name></item>
+"""))
+
+	print("#4")
+	assert(edit(conn, """
+<item nc:operation="delete"><name>b</name></item>
+"""))
+
+	print("#5")
+	assert(edit(conn, """
+<item nc:operation="create"><name>c</name></item>
+<ref>c</ref>
+"""))
+
+	print("#6")
+	assert(edit(conn, """
+<item nc:operation="delete"><name>a</name></item>
+"""))
+
+	return 0
+
+sys.exit(main())
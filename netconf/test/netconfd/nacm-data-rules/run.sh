@@ -0,0 +1,18 @@
+#!/bin/bash -e
+rm -rf tmp || true
+mkdir tmp
+if [ "$RUN_WITH_CONFD" != "" ] ; then
+  #not implemented for confd - SKIP
+  exit 77
+else
+  killall -KILL netconfd || true
+  rm /tmp/ncxserver.sock || true
+  sed -e "s/@USER@/$USER/" startup-cfg.xml > tmp/startup-cfg.xml
+  /usr/sbin/netconfd --module=iana-if-type --module=ietf-interfaces --target=running --startup=tmp/startup-cfg.xml --superuser=nobody-$USER 2>&1 1>tmp/server.log &
+  SERVER_PID=$!
+fi
+
+sleep 4
+python session.litenc.py --server=$NCSERVER --port=$NCPORT --user=$NCUSER --password=$NCPASSWORD
+kill -KILL $SERVER_PID
+sleep 1
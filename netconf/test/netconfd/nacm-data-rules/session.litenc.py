@@ -0,0 +1,157 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def get_interfaces(conn):
+	get_rpc = """
+<get>
+  <filter type="subtree">
+    <interfaces xmlns="urn:ietf:params:xml:ns:yang:ietf-interfaces"/>
+  </filter>
+</get>
+"""
+	result = conn.rpc(get_rpc)
+	print lxml.etree.tostring(result)
+	names = result.xpath('./data/interfaces/interface/name')
+	descriptions = result.xpath('./data/interfaces/interface/description')
+	return (len(names), len(descriptions))
+
+def edit(conn, config):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <running/>
+  </target>
+  <default-operation>merge</default-operation>
+  <config>
+%(config)s
+  </config>
+</edit-config>
+""" % {'config':config}
+	result = conn.rpc(edit_config_rpc)
+	print lxml.etree.tostring(result)
+	ok = result.xpath('./ok')
+	assert(len(ok)==1)
+
+def main():
+	print("""
+#Description: Verify the cached NACM data rules follow /nacm and datastore edits
+#Procedure:
+#1 - <get> /interfaces. Verify only the names are readable.
+#2 - Add a rule permitting read of /interfaces/interface/description.
+#3 - <get> /interfaces in the same session. Verify the descriptions are readable.
+#4 - Create a new interface with a description.
+#5 - <get> /interfaces. Verify the new interface is readable.
+#6 - Delete the description read rule.
+#7 - <get> /interfaces. Verify only the names are readable.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	print("#1")
+	assert(get_interfaces(conn)==(2,0))
+
+	print("#2")
+	edit(conn, """
+<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+  <rule-list>
+    <name>test-rules</name>
+    <rule>
+      <name>read-description</name>
+      <path xmlns:if="urn:ietf:params:xml:ns:yang:ietf-interfaces">/if:interfaces/if:interface/if:description</path>
+      <access-operations>read</access-operations>
+      <action>permit</action>
+    </rule>
+  </rule-list>
+</nacm>
+""")
+
+	print("#3")
+	assert(get_interfaces(conn)==(2,2))
+
+	print("#4")
+	edit(conn, """
+<interfaces xmlns="urn:ietf:params:xml:ns:yang:ietf-interfaces">
+  <interface>
+    <name>eth2</name>
+    <type xmlns:ianaift="urn:ietf:params:xml:ns:yang:iana-if-type">ianaift:ethernetCsmacd</type>
+    <description>third</description>
+  </interface>
+</interfaces>
+""")
+
+	print("#5")
+	assert(get_interfaces(conn)==(3,3))
+
+	print("#6")
+	edit(conn, """
+<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+  <rule-list>
+    <name>test-rules</name>
+    <rule xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" nc:operation="delete">
+      <name>read-description</name>
+    </rule>
+  </rule-list>
+</nacm>
+""")
+
+	print("#7")
+	assert(get_interfaces(conn)==(3,0))
+
+	return 0
+
+sys.exit(main())
@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+
+def connect(server, port, user):
+	conn = litenc.litenc()
+	ret = conn.connect(server=server, port=port, user=user)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return None
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	ret = conn.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return None
+	conn_lxml=litenc_lxml.litenc_lxml(conn)
+	hello = conn_lxml.receive()
+	if hello == None:
+		print("[FAILED] Receiving <hello>")
+		return None
+	session_id = hello.xpath('./session-id')[0].text
+	print "[OK] Receiving <hello> session-id=%(session_id)s" % {'session_id':session_id}
+	return (conn, conn_lxml, session_id)
+
+def create_subscription(conn_lxml, filter):
+	result = conn_lxml.rpc("""
+<create-subscription xmlns="urn:ietf:params:xml:ns:netconf:notification:1.0">
+ <filter type="subtree">
+%(filter)s
+ </filter>
+</create-subscription>
+""" % {'filter':filter})
+	print lxml.etree.tostring(result)
+	assert(len(result.xpath('./ok'))==1)
+
+def receive_notification(conn_lxml, name):
+	notification = conn_lxml.receive()
+	assert(notification != None)
+	print lxml.etree.tostring(notification)
+	event = notification.xpath('./*[local-name()!="eventTime"]')
+	assert(len(event)==1)
+	assert(event[0].tag==name)
+	return notification
+
+def main():
+	print("""
+#Description: Verify subscriptions with the same subtree filter share the
+#             filter result and a different filter gets its own
+#Procedure:
+#1 - Open sessions #1, #2 and #3. Subscribe #1 and #2 with the same filter
+#    for the <termination-reason> event leaf and #3 with a filter for the
+#    <session-id> event leaf.
+#2 - Open and close session #4, then open and close session #5.
+#3 - Verify #1 and #2 both receive the same <netconf-session-end> for #4 and
+#    then for #5 and nothing else.
+#4 - Verify #3 receives <netconf-session-start> and <netconf-session-end>
+#    for #4 and then for #5 and nothing else.
+""")
+
+	user=os.getenv('USER')
+	port=830
+	server="127.0.0.1"
+
+	termination_reason_filter = """
+  <termination-reason xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-notifications"/>
+"""
+	session_id_filter = """
+  <session-id xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-notifications"/>
+"""
+
+	print("#1")
+	subscribers = []
+	for i in range(3):
+		s = connect(server, port, user)
+		assert(s != None)
+		subscribers.append(s)
+	create_subscription(subscribers[0][1], termination_reason_filter)
+	create_subscription(subscribers[1][1], termination_reason_filter)
+	create_subscription(subscribers[2][1], session_id_filter)
+
+	print("#2")
+	session_ids = []
+	for i in range(2):
+		(conn, conn_lxml, session_id) = connect(server, port, user)
+		session_ids.append(session_id)
+		result = conn_lxml.rpc("<close-session/>")
+		assert(len(result.xpath('./ok'))==1)
+		conn.terminate()
+
+	print("#3")
+	for session_id in session_ids:
+		first = receive_notification(subscribers[0][1], "netconf-session-end")
+		assert(first.xpath('./netconf-session-end/session-id')[0].text==session_id)
+		second = receive_notification(subscribers[1][1], "netconf-session-end")
+		assert(lxml.etree.tostring(first)==lxml.etree.tostring(second))
+
+	print("#4")
+	for session_id in session_ids:
+		for name in ["netconf-session-start", "netconf-session-end"]:
+			notification = receive_notification(subscribers[2][1], name)
+			assert(notification.xpath('./'+name+'/session-id')[0].text==session_id)
+
+	return(0)
+
+sys.exit(main())
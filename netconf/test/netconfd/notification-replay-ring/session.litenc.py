@@ -0,0 +1,132 @@
+#!/usr/bin/env python
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+
+def connect(server, port, user):
+	conn = litenc.litenc()
+	ret = conn.connect(server=server, port=port, user=user)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return None
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	ret = conn.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return None
+	conn_lxml=litenc_lxml.litenc_lxml(conn)
+	hello = conn_lxml.receive()
+	if hello == None:
+		print("[FAILED] Receiving <hello>")
+		return None
+	session_id = hello.xpath('./session-id')[0].text
+	print "[OK] Receiving <hello> session-id=%(session_id)s" % {'session_id':session_id}
+	return (conn, conn_lxml, session_id)
+
+def create_edit(conn_lxml, name):
+	result = conn_lxml.rpc("""
+<edit-config>
+ <target>
+  <running/>
+ </target>
+ <config>
+  <top xmlns="http://yuma123.org/ns/test-notification-replay-ring">
+   <entry>
+    <name>%(name)s</name>
+   </entry>
+  </top>
+ </config>
+</edit-config>
+""" % {'name':name})
+	assert(len(result.xpath('./ok'))==1)
+
+def replay(conn_lxml, start_time, stop_time=None):
+	if stop_time == None:
+		stop = ""
+	else:
+		stop = "<stopTime>%(stop_time)s</stopTime>" % {'stop_time':stop_time}
+	result = conn_lxml.rpc("""
+<create-subscription xmlns="urn:ietf:params:xml:ns:netconf:notification:1.0">
+ <startTime>%(start_time)s</startTime>
+ %(stop)s
+</create-subscription>
+""" % {'start_time':start_time, 'stop':stop})
+	print lxml.etree.tostring(result)
+	assert(len(result.xpath('./ok'))==1)
+
+	events = []
+	while True:
+		notification = conn_lxml.receive()
+		assert(notification != None)
+		print lxml.etree.tostring(notification)
+		if len(notification.xpath('./replayComplete'))==1:
+			break
+		target = notification.xpath('./netconf-config-change/edit/target')
+		assert(len(target)==1)
+		events.append((notification.xpath('./eventTime')[0].text, target[0].text))
+
+	if stop_time != None:
+		notification = conn_lxml.receive()
+		assert(notification != None)
+		print lxml.etree.tostring(notification)
+		assert(len(notification.xpath('./notificationComplete'))==1)
+	return events
+
+def main():
+	print("""
+#Description: Verify <create-subscription> replay with startTime and stopTime
+#             after the replay buffer has wrapped past --eventlog-size=5
+#Procedure:
+#1 - Open sessions #1 to #4.
+#2 - Create 8 list entries with 8 <edit-config> on #1, 1 second apart.
+#3 - Replay from 1970 on #2. Verify only the last 5 <netconf-config-change>
+#    are replayed in order.
+#4 - Replay on #3 with startTime equal to the 3rd replayed eventTime.
+#    Verify the 3rd to 5th are replayed.
+#5 - Replay on #4 with startTime equal to the 2nd and stopTime equal to
+#    the 4th replayed eventTime. Verify the 2nd to 4th are replayed.
+""")
+
+	user=os.getenv('USER')
+	port=830
+	server="127.0.0.1"
+
+	print("#1")
+	sessions = []
+	for i in range(4):
+		s = connect(server, port, user)
+		assert(s != None)
+		sessions.append(s)
+
+	print("#2")
+	for i in range(8):
+		create_edit(sessions[0][1], "e%d" % i)
+		time.sleep(1.1)
+
+	print("#3")
+	events = replay(sessions[1][1], "1970-01-01T00:00:00Z")
+	print events
+	assert(len(events)==5)
+	for i in range(5):
+		assert(events[i][1].endswith("[tnrr:name='e%d']" % (i+3)))
+		if i > 0:
+			assert(events[i-1][0] < events[i][0])
+
+	print("#4")
+	assert(replay(sessions[2][1], events[2][0])==events[2:])
+
+	print("#5")
+	assert(replay(sessions[3][1], events[1][0], events[3][0])==events[1:4])
+
+	return(0)
+
+sys.exit(main())
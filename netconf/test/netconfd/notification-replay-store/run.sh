@@ -0,0 +1,33 @@
+#!/bin/bash -e
+rm -rf tmp || true
+mkdir tmp
+if [ "$RUN_WITH_CONFD" != "" ] ; then
+  #not implemented for confd - SKIP
+  exit 77
+fi
+
+NETCONFD_ARGS="--module=./test-notification-replay-store.yang --eventlog-size=5 --eventlog-dir=tmp/eventlog --eventlog-segment-size=65536 --eventlog-segment-count=3 --target=running --no-startup --superuser=$USER"
+
+killall -KILL netconfd || true
+rm /tmp/ncxserver.sock || true
+/usr/sbin/netconfd $NETCONFD_ARGS 2>&1 1>tmp/server1.log &
+SERVER_PID=$!
+sleep 3
+python session.store.litenc.py
+kill -KILL $SERVER_PID
+sleep 1
+
+# cut the last stored record short
+LAST_SEGMENT=`ls tmp/eventlog/notif-*.seg | sort -t- -k2 -n | tail -n 1`
+truncate -s -16 $LAST_SEGMENT
+
+# the next event starts a new segment because of its age
+sleep 3
+rm /tmp/ncxserver.sock || true
+/usr/sbin/netconfd $NETCONFD_ARGS --eventlog-segment-age=2 2>&1 1>tmp/server2.log &
+SERVER_PID=$!
+sleep 3
+python session.replay.litenc.py
+kill -KILL $SERVER_PID
+cat tmp/server1.log tmp/server2.log
+sleep 1
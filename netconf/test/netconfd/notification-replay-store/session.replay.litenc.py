@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+import time
+import re
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+
+def connect(server, port, user):
+	conn = litenc.litenc()
+	ret = conn.connect(server=server, port=port, user=user)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return None
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	ret = conn.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return None
+	conn_lxml=litenc_lxml.litenc_lxml(conn)
+	hello = conn_lxml.receive()
+	if hello == None:
+		print("[FAILED] Receiving <hello>")
+		return None
+	session_id = hello.xpath('./session-id')[0].text
+	print "[OK] Receiving <hello> session-id=%(session_id)s" % {'session_id':session_id}
+	return (conn, conn_lxml, session_id)
+
+def segments():
+	files = [f for f in os.listdir("tmp/eventlog") if f.startswith("notif-") and f.endswith(".seg")]
+	return sorted([int(f[len("notif-"):-len(".seg")]) for f in files])
+
+def replay(conn_lxml, start_time):
+	result = conn_lxml.rpc("""
+<create-subscription xmlns="urn:ietf:params:xml:ns:netconf:notification:1.0">
+ <startTime>%(start_time)s</startTime>
+</create-subscription>
+""" % {'start_time':start_time})
+	print lxml.etree.tostring(result)
+	assert(len(result.xpath('./ok'))==1)
+
+	events = []
+	while True:
+		notification = conn_lxml.receive()
+		assert(notification != None)
+		if len(notification.xpath('./replayComplete'))==1:
+			break
+		events.append(notification)
+	return events
+
+def main():
+	print("""
+#Description: Verify replay from the replay store after a restart
+#Procedure:
+#1 - Verify the server restarted with the last complete record in the
+#    store, the <netconf-config-change> for e599 (602) before the
+#    truncated <netconf-session-end>, and that the sequence-ids continue
+#    from it in a new segment started because of the segment age.
+#2 - Replay from 1970. Verify the stored <netconf-config-change> events
+#    are replayed in order up to e599 followed by the events of the
+#    restarted server and not by the partial <netconf-session-end>.
+#3 - Verify only the last 3 segments are kept.
+""")
+
+	user=os.getenv('USER')
+	port=830
+	server="127.0.0.1"
+
+	(conn, conn_lxml, session_id) = connect(server, port, user)
+
+	print("#1")
+	log = open("tmp/server2.log").read()
+	assert(re.search("ignoring [0-9]+ bytes of partial records", log) != None)
+	match = re.search("last sequence-id: ([0-9]+)", log)
+	assert(match != None)
+	last_msgid = int(match.group(1))
+	# <sysStartup>, <netconf-session-start> and 600 <netconf-config-change>
+	assert(last_msgid==602)
+	msgids = segments()
+	print msgids
+	assert(last_msgid+1 in msgids)
+
+	print("#2")
+	events = replay(conn_lxml, "1970-01-01T00:00:00Z")
+	names = []
+	for notification in events:
+		target = notification.xpath('./netconf-config-change/edit/target')
+		if len(target)==0:
+			break
+		names.append(int(target[0].text.split("'")[1][1:]))
+	print names
+	assert(len(names)>0)
+	assert(names==range(names[0], 600))
+	for notification in events[len(names):]:
+		assert(len(notification.xpath('./netconf-session-end'))==0)
+	assert(events[-1].xpath('./netconf-session-start/session-id')[0].text==session_id)
+
+	print("#3")
+	msgids = segments()
+	print msgids
+	assert(len(msgids)==3)
+
+	return(0)
+
+sys.exit(main())
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+
+def connect(server, port, user):
+	conn = litenc.litenc()
+	ret = conn.connect(server=server, port=port, user=user)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return None
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	ret = conn.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return None
+	conn_lxml=litenc_lxml.litenc_lxml(conn)
+	hello = conn_lxml.receive()
+	if hello == None:
+		print("[FAILED] Receiving <hello>")
+		return None
+	session_id = hello.xpath('./session-id')[0].text
+	print "[OK] Receiving <hello> session-id=%(session_id)s" % {'session_id':session_id}
+	return (conn, conn_lxml, session_id)
+
+def create_edit(conn_lxml, name):
+	result = conn_lxml.rpc("""
+<edit-config>
+ <target>
+  <running/>
+ </target>
+ <config>
+  <top xmlns="http://yuma123.org/ns/test-notification-replay-store">
+   <entry>
+    <name>%(name)s</name>
+   </entry>
+  </top>
+ </config>
+</edit-config>
+""" % {'name':name})
+	assert(len(result.xpath('./ok'))==1)
+
+def segments():
+	files = [f for f in os.listdir("tmp/eventlog") if f.startswith("notif-") and f.endswith(".seg")]
+	return sorted([int(f[len("notif-"):-len(".seg")]) for f in files])
+
+def main():
+	print("""
+#Description: Fill the replay store in --eventlog-dir
+#Procedure:
+#1 - Create 600 list entries with 600 <edit-config>.
+#2 - Verify the segments are rotated at --eventlog-segment-size and only
+#    the last --eventlog-segment-count segments are kept.
+""")
+
+	user=os.getenv('USER')
+	port=830
+	server="127.0.0.1"
+
+	print("#1")
+	(conn, conn_lxml, session_id) = connect(server, port, user)
+	for i in range(600):
+		create_edit(conn_lxml, "e%d" % i)
+
+	print("#2")
+	msgids = segments()
+	print msgids
+	assert(len(msgids)==3)
+	# the segment with the <netconf-session-start> (1) was deleted
+	assert(msgids[0]>1)
+	for msgid in msgids:
+		size = os.path.getsize("tmp/eventlog/notif-%010u.seg" % msgid)
+		assert(size<=65536)
+
+	return(0)
+
+sys.exit(main())
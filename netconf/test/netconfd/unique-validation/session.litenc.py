@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def edit(conn, config):
+	edit_config_rpc = """
+<edit-config>
+  <target>
+    <running/>
+  </target>
+  <default-operation>merge</default-operation>
+  <config>
+    <top xmlns="http://yuma123.org/ns/test-unique-validation" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0">
+%(config)s
+    </top>
+  </config>
+</edit-config>
+""" % {'config':config}
+	result = conn.rpc(edit_config_rpc)
+	print lxml.etree.tostring(result)
+	return result
+
+def unique_errors(result):
+	return [path.text for path in result.xpath("./rpc-error[error-app-tag='data-not-unique']/error-path")]
+
+def main():
+	print("""
+#Description: Verify the unique-stmt test over several leafs in a list
+#             with 2 keys reports each entry that has a later duplicate
+#             once, and skips the entries without all the unique leafs
+#Procedure:
+#1 - Create 7 entries with no duplicate a, b, sub/c tuple. Verify edit-config succeeds.
+#2 - Change the entries so x/1, y/1 and z/1 share a tuple (z/1 with b as 01),
+#    x/2 and z/2 share another one, and y/2 has no sub/c.
+#    Verify edit-config fails with unique errors for x/1, x/2 and y/1 only.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	print("#1")
+	result = edit(conn, """
+<entry><k1>x</k1><k2>1</k2><a>foo</a><b>1</b><sub><c>1</c></sub></entry>
+<entry><k1>x</k1><k2>2</k2><a>foo</a><b>1</b><sub><c>2</c></sub></entry>
+<entry><k1>y</k1><k2>1</k2><a>foo</a><b>2</b><sub><c>1</c></sub></entry>
+<entry><k1>y</k1><k2>2</k2><a>foo</a><b>1</b></entry>
+<entry><k1>z</k1><k2>1</k2><a>foo</a><b>3</b><sub><c>1</c></sub></entry>
+<entry><k1>z</k1><k2>2</k2><b>1</b><sub><c>2</c></sub></entry>
+<entry><k1>z</k1><k2>3</k2><a>bar</a><b>1</b><sub><c>1</c></sub></entry>
+""")
+	assert(len(result.xpath('./ok'))==1)
+
+	print("#2")
+	result = edit(conn, """
+<entry><k1>y</k1><k2>1</k2><b>1</b></entry>
+<entry><k1>z</k1><k2>1</k2><b>01</b></entry>
+<entry><k1>z</k1><k2>2</k2><a>foo</a></entry>
+""")
+	assert(len(result.xpath('./ok'))==0)
+	errors = unique_errors(result)
+	print errors
+	assert(len(errors)==3)
+	assert(sorted(errors)==sorted([
+		"/tuv:top/tuv:entry[tuv:k1='x'][tuv:k2='1']",
+		"/tuv:top/tuv:entry[tuv:k1='x'][tuv:k2='2']",
+		"/tuv:top/tuv:entry[tuv:k1='y'][tuv:k2='1']"]))
+
+	return 0
+
+sys.exit(main())
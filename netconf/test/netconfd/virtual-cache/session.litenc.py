@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+
+import time
+import sys, os
+sys.path.append("../../litenc")
+import litenc
+import litenc_lxml
+import lxml
+import argparse
+
+def get_count(conn):
+	get_rpc = """
+<get>
+  <filter type="subtree">
+    <state xmlns="http://yuma123.org/ns/test-virtual-cache"/>
+  </filter>
+</get>
+"""
+	result = conn.rpc(get_rpc)
+	print lxml.etree.tostring(result)
+	count = result.xpath('./data/state/get-count')
+	assert(len(count)==1)
+	return int(count[0].text)
+
+def check_count(conn, expected):
+	count = get_count(conn)
+	print "get-count=%u expected=%u" % (count, expected)
+	assert(count == expected)
+
+def main():
+	print("""
+#Description: Verify the ncx:cache-timeout and ncx:cache-stale-timeout
+#             timers of a virtual leaf. The leaf is the number of times
+#             its get callback was called, its cache timeout is 3s and
+#             its stale timeout is 10s.
+#Procedure:
+#1 - Read the leaf twice within the cache timeout. Verify the second
+#    read is served from the cache.
+#2 - Read the leaf after the cache timeout, within the stale timeout.
+#    Verify the stale value is returned.
+#3 - Read the leaf after the next housekeeping run. Verify the value
+#    was refreshed once and is served from the cache again.
+#4 - Read the leaf after the stale timeout. Verify the value is
+#    refreshed before it is returned.
+""")
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--server", help="server name e.g. 127.0.0.1 or server.com (127.0.0.1 if not specified)")
+	parser.add_argument("--user", help="username e.g. admin ($USER if not specified)")
+	parser.add_argument("--port", help="port e.g. 830 (830 if not specified)")
+	parser.add_argument("--password", help="password e.g. mypass123 (passwordless if not specified)")
+
+	args = parser.parse_args()
+
+	if(args.server==None or args.server==""):
+		server="127.0.0.1"
+	else:
+		server=args.server
+
+	if(args.port==None or args.port==""):
+		port=830
+	else:
+		port=int(args.port)
+
+	if(args.user==None or args.user==""):
+		user=os.getenv('USER')
+	else:
+		user=args.user
+
+	if(args.password==None or args.password==""):
+		password=None
+	else:
+		password=args.password
+
+	conn_raw = litenc.litenc()
+	ret = conn_raw.connect(server=server, port=port, user=user, password=password)
+	if ret != 0:
+		print "[FAILED] Connecting to server=%(server)s:" % {'server':server}
+		return(-1)
+	print "[OK] Connecting to server=%(server)s:" % {'server':server}
+	conn=litenc_lxml.litenc_lxml(conn_raw)
+	ret = conn_raw.send("""
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+ <capabilities>
+  <capability>urn:ietf:params:netconf:base:1.0</capability>
+ </capabilities>
+</hello>
+""")
+	if ret != 0:
+		print("[FAILED] Sending <hello>")
+		return(-1)
+	(ret, reply_xml)=conn_raw.receive()
+	if ret != 0:
+		print("[FAILED] Receiving <hello>")
+		return(-1)
+
+	print("#1")
+	count = get_count(conn)
+	time.sleep(1)
+	check_count(conn, count)
+
+	print("#2")
+	time.sleep(4)
+	check_count(conn, count)
+
+	print("#3")
+	time.sleep(2)
+	check_count(conn, count + 1)
+	check_count(conn, count + 1)
+
+	print("#4")
+	time.sleep(15)
+	check_count(conn, count + 2)
+	check_count(conn, count + 2)
+
+	return 0
+
+sys.exit(main())
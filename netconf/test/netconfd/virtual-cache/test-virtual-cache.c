@@ -0,0 +1,84 @@
+/*
+    module test-virtual-cache(based on test-virtual-cache.yang)
+ */
+
+#include <xmlstring.h>
+#include <assert.h>
+#include "procdefs.h"
+#include "agt.h"
+#include "agt_util.h"
+#include "ncx.h"
+#include "ncxmod.h"
+#include "ncxtypes.h"
+#include "status.h"
+#include "val.h"
+
+/* module static variables */
+static ncx_module_t *test_virtual_cache_mod;
+static uint32 get_count;
+
+/* Registered callback functions: get_get_count */
+
+static status_t
+    get_get_count(ses_cb_t *scb,
+                  getcb_mode_t cbmode,
+                  const val_value_t *vir_val,
+                  val_value_t *dst_val)
+{
+    if (cbmode != GETCB_GET_VALUE) {
+        return ERR_NCX_OPERATION_NOT_SUPPORTED;
+    }
+
+    get_count++;
+    VAL_UINT(dst_val) = get_count;
+    return NO_ERR;
+}
+
+/* The 3 mandatory callback functions: y_test_virtual_cache_init, y_test_virtual_cache_init2, y_test_virtual_cache_cleanup */
+
+status_t
+    y_test_virtual_cache_init (
+        const xmlChar *modname,
+        const xmlChar *revision)
+{
+    agt_profile_t *agt_profile;
+    status_t res;
+
+    agt_profile = agt_get_profile();
+
+    res = ncxmod_load_module(
+        "test-virtual-cache",
+        NULL,
+        &agt_profile->agt_savedevQ,
+        &test_virtual_cache_mod);
+    return res;
+}
+
+status_t y_test_virtual_cache_init2(void)
+{
+    obj_template_t *stateobj;
+    val_value_t *stateval;
+    val_value_t *childval;
+    status_t res;
+
+    stateobj = ncx_find_object(test_virtual_cache_mod, "state");
+    assert(stateobj != NULL);
+
+    res = agt_add_top_container(stateobj, &stateval);
+    if (res != NO_ERR) {
+        return res;
+    }
+
+    childval = agt_make_virtual_leaf(stateobj,
+                                     (const xmlChar *)"get-count",
+                                     get_get_count,
+                                     &res);
+    if (childval != NULL) {
+        val_add_child(childval, stateval);
+    }
+    return res;
+}
+
+void y_test_virtual_cache_cleanup (void)
+{
+}
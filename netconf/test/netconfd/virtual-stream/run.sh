@@ -0,0 +1,10 @@
+#!/bin/bash -e
+rm -rf tmp || true
+mkdir tmp
+rm /tmp/ncxserver.sock || true
+/usr/sbin/netconfd --module=test-virtual-stream --no-startup --superuser=$USER 1>tmp/netconfd.stdout 2>tmp/netconfd.stderr &
+NETCONFD_PID=$!
+sleep 1
+python session.py
+kill $NETCONFD_PID
+sleep 1
@@ -0,0 +1,27 @@
+from yangcli import yangcli
+from lxml import etree
+import yangrpc
+import sys
+import os
+
+conn = yangrpc.connect("127.0.0.1", 830, os.getenv('USER'), None, os.getenv('HOME')+"/.ssh/id_rsa.pub", os.getenv('HOME')+"/.ssh/id_rsa")
+if(conn==None):
+    print("Error: yangrpc failed to connect!")
+    sys.exit(1)
+
+namespaces={"vs":"http://yuma123.org/ns/test-virtual-stream"}
+
+result=yangcli(conn, "xget /counters")
+counters=result.xpath('./data/vs:counters/vs:counter', namespaces=namespaces)
+print(len(counters))
+assert(len(counters)==5000)
+value=result.xpath('./data/vs:counters/vs:counter[vs:id=4999]/vs:value', namespaces=namespaces)
+assert(value[0].text=="9998")
+
+result=yangcli(conn, "xget /counters/counter[id='17']")
+counters=result.xpath('./data/vs:counters/vs:counter', namespaces=namespaces)
+assert(len(counters)==1)
+name=result.xpath('./data/vs:counters/vs:counter/vs:name', namespaces=namespaces)
+assert(name[0].text=="counter17")
+
+print("Done.")
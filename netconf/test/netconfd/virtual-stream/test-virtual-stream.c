@@ -0,0 +1,138 @@
+/*
+    module test-virtual-stream(based on test-virtual-stream.yang)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <xmlstring.h>
+#include "procdefs.h"
+#include "agt.h"
+#include "agt_cb.h"
+#include "agt_util.h"
+#include "dlq.h"
+#include "getcb.h"
+#include "ncx.h"
+#include "ncxmod.h"
+#include "ncxtypes.h"
+#include "obj.h"
+#include "status.h"
+#include "val.h"
+#include "val_util.h"
+
+#define COUNTERS_NUM 5000
+
+/* module static variables */
+static ncx_module_t *test_virtual_stream_mod;
+
+typedef struct counters_cursor_t_ {
+    uint32 id;
+} counters_cursor_t;
+
+static status_t
+    get_counters(ses_cb_t *scb,
+                 getcb_mode_t cbmode,
+                 const val_value_t *vir_val,
+                 void **cursor,
+                 val_value_t **ret_val)
+{
+    counters_cursor_t *mycursor;
+    obj_template_t *counterobj;
+    val_value_t *counterval;
+    val_value_t *childval;
+    char namebuf[32];
+    status_t res;
+
+    *ret_val = NULL;
+    mycursor = (counters_cursor_t *)*cursor;
+
+    if (cbmode == GETCB_GET_DONE) {
+        free(mycursor);
+        *cursor = NULL;
+        return NO_ERR;
+    }
+    if (cbmode != GETCB_GET_NEXT) {
+        return ERR_NCX_OPERATION_NOT_SUPPORTED;
+    }
+
+    if (mycursor == NULL) {
+        mycursor = malloc(sizeof(counters_cursor_t));
+        if (mycursor == NULL) {
+            return ERR_INTERNAL_MEM;
+        }
+        mycursor->id = 0;
+        *cursor = mycursor;
+    }
+
+    if (mycursor->id >= COUNTERS_NUM) {
+        /* no more entries */
+        return NO_ERR;
+    }
+
+    counterval = agt_make_list(vir_val->obj, "counter", &res);
+    if (counterval == NULL) {
+        return res;
+    }
+    counterobj = counterval->obj;
+
+    childval = agt_make_uint_leaf(counterobj, "id", mycursor->id, &res);
+    assert(childval != NULL);
+    val_add_child(childval, counterval);
+
+    sprintf(namebuf, "counter%u", mycursor->id);
+    childval = agt_make_leaf(counterobj, "name",
+                             (const xmlChar *)namebuf, &res);
+    assert(childval != NULL);
+    val_add_child(childval, counterval);
+
+    childval = agt_make_uint64_leaf(counterobj, "value",
+                                    (uint64)mycursor->id * 2, &res);
+    assert(childval != NULL);
+    val_add_child(childval, counterval);
+
+    res = val_gen_index_chain(counterobj, counterval);
+    if (res != NO_ERR) {
+        val_free_value(counterval);
+        return res;
+    }
+
+    mycursor->id++;
+    *ret_val = counterval;
+    return NO_ERR;
+}
+
+/* The 3 mandatory callback functions: y_test_virtual_stream_init, y_test_virtual_stream_init2, y_test_virtual_stream_cleanup */
+
+status_t
+    y_test_virtual_stream_init (
+        const xmlChar *modname,
+        const xmlChar *revision)
+{
+    agt_profile_t *agt_profile;
+    status_t res;
+
+    agt_profile = agt_get_profile();
+
+    res = ncxmod_load_module(
+        "test-virtual-stream",
+        NULL,
+        &agt_profile->agt_savedevQ,
+        &test_virtual_stream_mod);
+    return res;
+}
+
+status_t y_test_virtual_stream_init2(void)
+{
+    obj_template_t *countersobj;
+
+    countersobj = ncx_find_object(test_virtual_stream_mod, "counters");
+    assert(countersobj != NULL);
+
+    return agt_add_top_virtual_stream(countersobj, get_counters);
+}
+
+void y_test_virtual_stream_cleanup (void)
+{
+}
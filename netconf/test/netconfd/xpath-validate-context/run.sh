@@ -0,0 +1,34 @@
+#!/bin/bash
+
+if [ "$RUN_WITH_CONFD" != "" ] ; then
+    # skipped test return value
+    exit 77
+fi
+
+rm -rf tmp || true
+mkdir tmp
+
+/usr/sbin/netconfd --validate-config-only --startup-error=stop --module=./test-xpath-validate-context.yang --no-startup 1>tmp/netconfd.stdout 2>tmp/netconfd.stderr
+RES=$?
+cat tmp/netconfd.stdout
+if [ "$RES" != "0" ] ; then
+    echo "Error: Failed to load test-xpath-validate-context.yang"
+    exit $RES
+fi
+
+# relative paths are validated against the schema node of the context
+if ! grep -q "'../nosuch > 0'" tmp/netconfd.stdout ; then
+    echo "Error: Did not detect the missing node in '../nosuch > 0'"
+    exit -1
+else
+    echo "OK: Detected the missing node in '../nosuch > 0'"
+fi
+
+if grep -q "'../a > 0'" tmp/netconfd.stdout ; then
+    echo "Error: Reported a problem with '../a > 0'"
+    exit -1
+else
+    echo "OK: No problem reported with '../a > 0'"
+fi
+
+exit 0
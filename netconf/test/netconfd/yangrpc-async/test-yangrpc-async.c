@@ -0,0 +1,118 @@
+/*
+ * Pipelines several <get> requests on one yangrpc session with
+ * yangrpc_async_exec and checks that all replies are received
+ * in order by yangrpc_async_poll.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ncx.h"
+#include "ncxmod.h"
+#include "val.h"
+#include "yangrpc.h"
+
+#define REQUESTS 16
+
+static unsigned int replies;
+static unsigned int reply_order[REQUESTS];
+
+static void reply_cb(yangrpc_cb_ptr_t yangrpc_cb_ptr, void* cookie, status_t res, val_value_t* reply_val)
+{
+    unsigned int* request_index = (unsigned int*)cookie;
+
+    assert(res==NO_ERR);
+    assert(reply_val!=NULL);
+    assert(val_find_child(reply_val, NULL, (const xmlChar *)"data")!=NULL);
+    assert(replies<REQUESTS);
+    reply_order[replies++] = *request_index;
+    val_free_value(reply_val);
+}
+
+int main(int argc, char* argv[])
+{
+    status_t res;
+    yangrpc_cb_ptr_t yangrpc_cb_ptr;
+    unsigned int request_index[REQUESTS];
+    unsigned int completed;
+    unsigned int i;
+    char* home;
+    char public_key[1024];
+    char private_key[1024];
+    ncx_module_t * ietf_netconf_mod;
+    obj_template_t* rpc_obj;
+    obj_template_t* input_obj;
+    obj_template_t* filter_obj;
+
+    val_value_t* request_val;
+    val_value_t* filter_val;
+    val_value_t* type_meta_val;
+    val_value_t* select_meta_val;
+
+    home = getenv("HOME");
+    assert(home!=NULL);
+    snprintf(public_key, sizeof(public_key), "%s/.ssh/id_rsa.pub", home);
+    snprintf(private_key, sizeof(private_key), "%s/.ssh/id_rsa", home);
+
+    res = yangrpc_init(NULL);
+    assert(res==NO_ERR);
+    /* argv[1] == optional extra yangcli connect args */
+    res = yangrpc_connect("127.0.0.1"/*server*/, 830/*port*/, getenv("USER")/*user*/, NULL/*password*/, public_key, private_key, (argc>1)?argv[1]:NULL, &yangrpc_cb_ptr);
+    assert(res==NO_ERR);
+
+    res = ncxmod_load_module ((const xmlChar *)"ietf-netconf", NULL, NULL, &ietf_netconf_mod);
+    assert(res==NO_ERR);
+
+    rpc_obj = ncx_find_object(ietf_netconf_mod, (const xmlChar *)"get");
+    assert(obj_is_rpc(rpc_obj));
+    input_obj = obj_find_child(rpc_obj, NULL, (const xmlChar *)"input");
+    assert(input_obj!=NULL);
+    filter_obj = obj_find_child(input_obj, NULL, (const xmlChar *)"filter");
+    assert(filter_obj!=NULL);
+
+    request_val = val_new_value();
+    val_init_from_template(request_val, rpc_obj);
+    filter_val = val_new_value();
+    val_init_from_template(filter_val, filter_obj);
+
+    type_meta_val = val_make_string(0, (const xmlChar *)"type", (const xmlChar *)"xpath");
+    select_meta_val = val_make_string(0, (const xmlChar *)"select", (const xmlChar *)"/netconf-state/sessions");
+
+    val_add_meta(select_meta_val, filter_val);
+    val_add_meta(type_meta_val, filter_val);
+    val_add_child(filter_val, request_val);
+
+    /* queue all requests before any reply is read */
+    for(i=0;i<REQUESTS;i++) {
+        request_index[i] = i;
+        res = yangrpc_async_exec(yangrpc_cb_ptr, request_val, reply_cb, &request_index[i]);
+        assert(res==NO_ERR);
+    }
+    assert(yangrpc_async_pending(yangrpc_cb_ptr)==REQUESTS);
+
+    while(replies<REQUESTS) {
+        res = yangrpc_async_poll(&yangrpc_cb_ptr, 1, -1, &completed);
+        assert(res==NO_ERR);
+    }
+    printf("%u replies\n", replies);
+
+    /* the replies come back in the order the requests were sent */
+    for(i=0;i<REQUESTS;i++) {
+        assert(reply_order[i]==i);
+    }
+    assert(yangrpc_async_pending(yangrpc_cb_ptr)==0);
+
+    /* nothing is outstanding, so polling without a timeout must not block */
+    alarm(10);
+    res = yangrpc_async_poll(&yangrpc_cb_ptr, 1, -1, &completed);
+    alarm(0);
+    assert(res==NO_ERR);
+    assert(completed==0);
+
+    val_free_value(request_val);
+
+    yangrpc_close(yangrpc_cb_ptr);
+    printf("Done.\n");
+    return 0;
+}
@@ -0,0 +1,50 @@
+#!/bin/bash -e
+
+rm -rf tmp || true
+mkdir -p tmp/modules
+
+cat > tmp/modules/test-index-a.yang <<END
+module test-index-a {
+  namespace "http://yuma123.org/ns/test-index-a";
+  prefix a;
+  import test-index-b { prefix b; }
+}
+END
+cat > tmp/modules/test-index-b.yang <<END
+module test-index-b {
+  namespace "http://yuma123.org/ns/test-index-b";
+  prefix b;
+}
+END
+
+export YUMA_MODCACHE=`pwd`/tmp/cache
+YANGDUMP="yangdump --modpath=`pwd`/tmp/modules --log-level=debug tmp/modules/test-index-a.yang"
+
+# the cache ends with the number of index lines
+$YANGDUMP > tmp/out.1 2>&1
+grep '^\*\*\* 0 Errors' tmp/out.1
+tail -n 1 $YUMA_MODCACHE | grep "^E `grep -c '^[RDF] ' $YUMA_MODCACHE`\$"
+if ls tmp/cache.* ; then
+  exit 1
+fi
+
+# a cache truncated before test-index-b.yang is rebuilt
+sed -i '/ test-index-b.yang$/,$d' $YUMA_MODCACHE
+$YANGDUMP > tmp/out.2 2>&1
+grep "ignoring bad module index cache" tmp/out.2
+grep '^\*\*\* 0 Errors' tmp/out.2
+grep ' test-index-b.yang$' $YUMA_MODCACHE
+
+# so is a cache with a wrong line count
+sed -i '/ test-index-b.yang$/d' $YUMA_MODCACHE
+$YANGDUMP > tmp/out.3 2>&1
+grep "ignoring bad module index cache" tmp/out.3
+grep '^\*\*\* 0 Errors' tmp/out.3
+grep ' test-index-b.yang$' $YUMA_MODCACHE
+
+# a complete cache is used as it is
+$YANGDUMP > tmp/out.4 2>&1
+if grep "ignoring bad module index cache" tmp/out.4 ; then
+  exit 1
+fi
+grep '^\*\*\* 0 Errors' tmp/out.4
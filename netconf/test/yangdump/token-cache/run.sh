@@ -0,0 +1,158 @@
+#!/bin/bash -e
+
+rm -rf tmp || true
+mkdir -p tmp/modules tmp/cache
+
+cat > tmp/modules/test-token-cache.yang <<'END'
+module test-token-cache {
+  yang-version 1.1;
+  namespace "http://yuma123.org/ns/test-token-cache";
+  prefix tc;
+
+  include test-token-cache-sub;
+
+  organization "yuma123.org";
+  description
+    "Part of the token-cache test. A " + 'concatenated "quoted" string'
+  + " with \"escapes\"\tand a line that is longer than the --warn-linelen used by the test.";
+
+  revision 2026-10-18 {
+    description "Initial version";
+  }
+
+  /* a block comment */
+  container top {
+    leaf b { type string { pattern '[a-z]+\d*'; } }  // a line comment
+  }
+}
+END
+cat > tmp/modules/test-token-cache-sub.yang <<'END'
+submodule test-token-cache-sub {
+  yang-version 1.1;
+  belongs-to test-token-cache { prefix tc; }
+  revision 2026-10-18;
+  leaf c { type int32 { range "1..10 | 20"; } }
+}
+END
+
+# run yangdump and keep its output, warnings and debug log as tmp/$1.*
+# (--format=yang and html keep the comments and bypass the token cache)
+function run_yangdump {
+  yangdump --modpath=`pwd`/tmp/modules --format=yin --warn-linelen=72 --output=tmp/$1.yin --log=tmp/$1.log --log-level=debug3 tmp/modules/test-token-cache.yang
+  grep -E '^(Warning|Error|\*\*\* [0-9]+ Errors)' tmp/$1.log > tmp/$1.warnings
+}
+
+# compare the output of run $1 with the uncached run $2
+function check_output {
+  diff tmp/$2.yin tmp/$1.yin
+  diff tmp/$2.warnings tmp/$1.warnings
+}
+
+unset YUMA_TKCACHE
+run_yangdump uncached
+grep '^Warning: line is' tmp/uncached.warnings
+
+export YUMA_TKCACHE=`pwd`/tmp/cache
+
+# cold cache: every file is tokenized and saved
+run_yangdump cold
+check_output cold uncached
+if grep "using token cache file" tmp/cold.log ; then
+  exit 1
+fi
+FILES=`ls tmp/cache/*.tkc | wc -l`
+[ $FILES -ge 2 ]
+
+# warm cache: every file is read from the cache and nothing is written
+touch tmp/marker
+sleep 1
+run_yangdump warm
+check_output warm uncached
+[ `grep -c "using token cache file" tmp/warm.log` = $FILES ]
+[ "`find tmp/cache -newer tmp/marker`" = "" ]
+
+# an edited file no longer matches its cache file
+sed -i 's/Initial version/Edited version/' tmp/modules/test-token-cache.yang
+YUMA_TKCACHE= run_yangdump edited-uncached
+run_yangdump edited
+check_output edited edited-uncached
+[ `grep -c "using token cache file" tmp/edited.log` = $(($FILES-1)) ]
+[ `ls tmp/cache/*.tkc | wc -l` = $(($FILES+1)) ]
+
+# a truncated cache file is ignored and written again
+TKC=`ls -t tmp/cache/*.tkc | head -n 1`
+SIZE=`stat -c %s $TKC`
+truncate -s $(($SIZE/2)) $TKC
+run_yangdump truncated
+check_output truncated edited-uncached
+grep "ignoring invalid token cache file '.*$TKC'" tmp/truncated.log
+[ `stat -c %s $TKC` = $SIZE ]
+
+# and used again by the next run
+run_yangdump rewritten
+check_output rewritten edited-uncached
+[ `grep -c "using token cache file" tmp/rewritten.log` = $FILES ]
+
+# a module with a multi-level import and include graph,
+# tokenized by 4 prefetch workers into a cold cache
+function make_module {
+  NAME=$1
+  shift
+  echo "module $NAME {" > tmp/jobs/$NAME.yang
+  echo "  namespace \"http://yuma123.org/ns/$NAME\";" >> tmp/jobs/$NAME.yang
+  echo "  prefix $NAME;" >> tmp/jobs/$NAME.yang
+  for stmt in "$@" ; do
+    echo "  $stmt" >> tmp/jobs/$NAME.yang
+  done
+  echo "  revision 2026-10-18;" >> tmp/jobs/$NAME.yang
+  echo "  leaf $NAME { type string; }" >> tmp/jobs/$NAME.yang
+  echo "}" >> tmp/jobs/$NAME.yang
+}
+function make_submodule {
+  NAME=$1
+  PARENT=$2
+  shift 2
+  echo "submodule $NAME {" > tmp/jobs/$NAME.yang
+  echo "  belongs-to $PARENT { prefix $PARENT; }" >> tmp/jobs/$NAME.yang
+  for stmt in "$@" ; do
+    echo "  $stmt" >> tmp/jobs/$NAME.yang
+  done
+  echo "  revision 2026-10-18;" >> tmp/jobs/$NAME.yang
+  echo "  leaf $NAME { type string; }" >> tmp/jobs/$NAME.yang
+  echo "}" >> tmp/jobs/$NAME.yang
+}
+
+mkdir -p tmp/jobs tmp/cache-serial tmp/cache-jobs
+make_module tcj "import tcj-b { prefix b; }" "import tcj-c { prefix c; }" "include tcj-sub;"
+make_submodule tcj-sub tcj "import tcj-e { prefix e; }"
+make_module tcj-b "import tcj-d { prefix d; }" "import tcj-e { prefix e; }"
+make_module tcj-c "import tcj-d { prefix d; }" "include tcj-c-sub;"
+make_submodule tcj-c-sub tcj-c "import tcj-f { prefix f; }"
+make_module tcj-d "import tcj-f { prefix f; }"
+make_module tcj-e
+make_module tcj-f
+
+function run_yangdump_jobs {
+  yangdump --modpath=`pwd`/tmp/jobs --format=yin --output=tmp/$1.yin --log=tmp/$1.log --log-level=debug3 tmp/jobs/tcj.yang
+  grep -E '^(Warning|Error|\*\*\* [0-9]+ Errors)' tmp/$1.log > tmp/$1.warnings
+}
+
+YUMA_TKCACHE=`pwd`/tmp/cache-serial run_yangdump_jobs serial
+if grep "ncxmod: prefetched" tmp/serial.log ; then
+  exit 1
+fi
+YUMA_TKCACHE=`pwd`/tmp/cache-jobs YUMA_LOAD_JOBS=4 run_yangdump_jobs jobs
+check_output jobs serial
+# all 7 files of the tcj graph are prefetched by more than 1 worker
+grep "ncxmod: prefetched [0-9]* modules for '.*tcj.yang' with [2-4] jobs" tmp/jobs.log
+[ `sed -n "s/.*prefetched \([0-9]*\) modules for '.*tcj.yang'.*/\1/p" tmp/jobs.log` = 7 ]
+# every file has the same cache entry as in the serial run
+diff <(ls tmp/cache-serial) <(ls tmp/cache-jobs)
+
+# a warm run reads all of them and writes nothing
+touch tmp/marker
+sleep 1
+YUMA_TKCACHE=`pwd`/tmp/cache-jobs YUMA_LOAD_JOBS=4 run_yangdump_jobs jobs-warm
+check_output jobs-warm serial
+[ `grep -c "using token cache file" tmp/jobs-warm.log` = `ls tmp/cache-jobs | wc -l` ]
+[ "`find tmp/cache-jobs -newer tmp/marker`" = "" ]